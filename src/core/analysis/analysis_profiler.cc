@@ -0,0 +1,76 @@
+#include "analysis_profiler.h"
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+
+namespace jumanpp {
+namespace core {
+namespace analysis {
+
+StringPiece stageName(AnalysisStage stage) {
+  switch (stage) {
+    case AnalysisStage::Reset:
+      return "reset";
+    case AnalysisStage::NodeSeeds:
+      return "seeds";
+    case AnalysisStage::Lattice:
+      return "lattice";
+    case AnalysisStage::Preprune:
+      return "preprune";
+    case AnalysisStage::Bootstrap:
+      return "bootstrap";
+    case AnalysisStage::Scores:
+      return "scores";
+    case AnalysisStage::GbeamScores:
+      return "gbeam";
+    case AnalysisStage::Rescore:
+      return "rescore";
+    case AnalysisStage::Output:
+      return "output";
+  }
+  return "unknown";
+}
+
+void AnalysisProfiler::reset() {
+  for (auto& s : stages_) {
+    s = StageProfile{};
+  }
+  numAnalyses_ = 0;
+}
+
+void AnalysisProfiler::report(std::ostream& os) const {
+  using util::perf::Counter;
+  double analyses = std::max<i64>(numAnalyses_, 1);
+  os << "Profile of " << numAnalyses_ << " analyses, average per analysis\n";
+  os << std::left << std::setw(12) << "stage" << std::right << std::setw(12)
+     << "time(us)";
+  for (int i = 0; i < util::perf::NumCounters; ++i) {
+    auto c = static_cast<Counter>(i);
+    if (counters_ != nullptr && counters_->available(c)) {
+      os << std::setw(16) << util::perf::counterName(c).str();
+    }
+  }
+  os << "\n";
+
+  for (int s = 0; s < NumAnalysisStages; ++s) {
+    auto& prof = stages_[s];
+    if (prof.calls == 0) {
+      continue;
+    }
+    os << std::left << std::setw(12)
+       << stageName(static_cast<AnalysisStage>(s)).str() << std::right
+       << std::fixed << std::setprecision(2) << std::setw(12)
+       << prof.seconds * 1e6 / analyses << std::setprecision(1);
+    for (int i = 0; i < util::perf::NumCounters; ++i) {
+      auto c = static_cast<Counter>(i);
+      if (counters_ != nullptr && counters_->available(c)) {
+        os << std::setw(16) << prof.counters[c] / analyses;
+      }
+    }
+    os << "\n";
+  }
+}
+
+}  // namespace analysis
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,98 @@
+#ifndef JUMANPP_ANALYSIS_PROFILER_H
+#define JUMANPP_ANALYSIS_PROFILER_H
+
+#include <chrono>
+#include <iosfwd>
+#include "util/perf_counters.h"
+
+namespace jumanpp {
+namespace core {
+namespace analysis {
+
+enum class AnalysisStage {
+  Reset,
+  NodeSeeds,
+  Lattice,
+  Preprune,
+  Bootstrap,
+  // feature computation and scoring with the full beam
+  Scores,
+  // feature computation and scoring with the global beam
+  GbeamScores,
+  // rescoring with additional (RNN) scorers
+  Rescore,
+  // not a part of the analysis, reported by users
+  Output,
+};
+
+constexpr int NumAnalysisStages = 9;
+
+StringPiece stageName(AnalysisStage stage);
+
+struct StageProfile {
+  i64 calls = 0;
+  double seconds = 0;
+  util::perf::CounterValues counters;
+};
+
+/**
+ * Accumulates time and (optionally) hardware counters spent in every
+ * stage of the analysis. Analyzer calls start() before the analysis and
+ * finish() after each of its stages, see Analyzer::setProfiler().
+ */
+class AnalysisProfiler {
+  using Clock = std::chrono::steady_clock;
+
+  const util::perf::PerfCounters* counters_;
+  StageProfile stages_[NumAnalysisStages];
+  i64 numAnalyses_ = 0;
+  Clock::time_point last_;
+  util::perf::CounterValues lastCounters_;
+
+ public:
+  explicit AnalysisProfiler(const util::perf::PerfCounters* counters = nullptr)
+      : counters_{counters} {}
+
+  void start() {
+    numAnalyses_ += 1;
+    if (counters_ != nullptr) {
+      counters_->read(&lastCounters_);
+    }
+    last_ = Clock::now();
+  }
+
+  /**
+   * Attributes everything since the previous call (or start) to the stage
+   */
+  void finish(AnalysisStage stage) {
+    auto now = Clock::now();
+    auto& prof = stages_[static_cast<int>(stage)];
+    prof.calls += 1;
+    prof.seconds += std::chrono::duration<double>(now - last_).count();
+    if (counters_ != nullptr) {
+      util::perf::CounterValues current;
+      counters_->read(&current);
+      prof.counters += current - lastCounters_;
+      lastCounters_ = current;
+    }
+    last_ = now;
+  }
+
+  const StageProfile& stage(AnalysisStage s) const {
+    return stages_[static_cast<int>(s)];
+  }
+  i64 numAnalyses() const { return numAnalyses_; }
+  const util::perf::PerfCounters* counters() const { return counters_; }
+  void reset();
+
+  /**
+   * Prints a table with per-analysis averages of every stage
+   */
+  void report(std::ostream& os) const;
+};
+
+}  // namespace analysis
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_ANALYSIS_PROFILER_H
@@ -0,0 +1,63 @@
+#include "analysis_profiler.h"
+#include <sstream>
+#include "testing/standalone_test.h"
+
+using namespace jumanpp::core::analysis;
+
+TEST_CASE("profiler accumulates stages") {
+  AnalysisProfiler prof;
+  for (int i = 0; i < 3; ++i) {
+    prof.start();
+    prof.finish(AnalysisStage::Reset);
+    prof.finish(AnalysisStage::Scores);
+  }
+  CHECK(prof.numAnalyses() == 3);
+  CHECK(prof.stage(AnalysisStage::Reset).calls == 3);
+  CHECK(prof.stage(AnalysisStage::Scores).calls == 3);
+  CHECK(prof.stage(AnalysisStage::Lattice).calls == 0);
+  CHECK(prof.stage(AnalysisStage::Scores).seconds >= 0);
+
+  std::stringstream ss;
+  prof.report(ss);
+  auto report = ss.str();
+  CHECK(report.find("reset") != std::string::npos);
+  CHECK(report.find("scores") != std::string::npos);
+  CHECK(report.find("lattice") == std::string::npos);
+
+  prof.reset();
+  CHECK(prof.numAnalyses() == 0);
+  CHECK(prof.stage(AnalysisStage::Reset).calls == 0);
+}
+
+TEST_CASE("profiler reads perf counters when they are available") {
+  jumanpp::util::perf::PerfCounters counters;
+  bool opened = counters.open().isOk();
+  AnalysisProfiler prof{&counters};
+  prof.start();
+  volatile int sum = 0;
+  for (int i = 0; i < 10000; ++i) {
+    sum += i;
+  }
+  prof.finish(AnalysisStage::Scores);
+  using jumanpp::util::perf::Counter;
+  auto& scores = prof.stage(AnalysisStage::Scores);
+  auto insns = scores.counters[Counter::Instructions];
+  if (opened && counters.available(Counter::Instructions)) {
+    CHECK(insns > 0);
+  } else {
+    CHECK(insns == 0);
+  }
+}
+
+TEST_CASE("profiler reports scoring stages separately") {
+  AnalysisProfiler prof;
+  prof.start();
+  prof.finish(AnalysisStage::GbeamScores);
+  prof.finish(AnalysisStage::Rescore);
+  std::stringstream ss;
+  prof.report(ss);
+  auto report = ss.str();
+  CHECK(report.find("gbeam") != std::string::npos);
+  CHECK(report.find("rescore") != std::string::npos);
+  CHECK(report.find("scores") == std::string::npos);
+}
@@ -39,17 +39,109 @@ Status Analyzer::initialize(AnalyzerImpl *impl, const ScorerDef *scorer) {
   JPP_RETURN_IF_ERROR(impl->initScorers(*scorer));
   ptr_ = impl;
   scorer_ = scorer;
+  impl->setProfiler(profiler_);
   return Status::Ok();
 }
 
+void Analyzer::setProfiler(AnalysisProfiler *profiler) {
+  profiler_ = profiler;
+  // scoring stages are reported by the implementation
+  if (ptr_ != nullptr) {
+    ptr_->setProfiler(profiler);
+  }
+}
+
 Status Analyzer::analyze(StringPiece input, ScorePlugin *plugin) {
+  return analyzeImpl(input, plugin, nullptr);
+}
+
+Status Analyzer::analyze(StringPiece input, const AnalysisBudget &budget,
+                         ScorePlugin *plugin) {
+  Status s = analyzeImpl(input, plugin, &budget);
+  ptr_->setBudget(nullptr);
+  return s;
+}
+
+Status Analyzer::analyzeEdited(StringPiece input, const InputEdit &edit) {
+  auto prof = profiler_;
+  if (prof != nullptr) {
+    prof->start();
+  }
+  JPP_RETURN_IF_ERROR(ptr_->resetForEditedInput(input, edit));
+  if (prof != nullptr) {
+    prof->finish(AnalysisStage::Reset);
+  }
+  return analyzeStages();
+}
+
+Status Analyzer::analyzeImpl(StringPiece input, ScorePlugin *plugin,
+                             const AnalysisBudget *budget) {
+  auto prof = profiler_;
+  if (prof != nullptr) {
+    prof->start();
+  }
   JPP_RETURN_IF_ERROR(ptr_->resetForInput(input));
   ptr_->setPlugin(plugin);
+  ptr_->setBudget(budget);
+  if (prof != nullptr) {
+    prof->finish(AnalysisStage::Reset);
+  }
+  return analyzeStages();
+}
+
+Status Analyzer::analyzeStages() {
+  auto prof = profiler_;
   JPP_RETURN_IF_ERROR(ptr_->prepareNodeSeeds());
+  if (prof != nullptr) {
+    prof->finish(AnalysisStage::NodeSeeds);
+  }
   JPP_RETURN_IF_ERROR(ptr_->buildLattice());
+  if (prof != nullptr) {
+    prof->finish(AnalysisStage::Lattice);
+  }
+  JPP_RETURN_IF_ERROR(ptr_->prepruneLattice(scorer_));
+  if (prof != nullptr) {
+    prof->finish(AnalysisStage::Preprune);
+  }
   JPP_RETURN_IF_ERROR(ptr_->bootstrapAnalysis());
-  JPP_RETURN_IF_ERROR(ptr_->computeScores(scorer_));
-  return Status::Ok();
+  if (prof != nullptr) {
+    prof->finish(AnalysisStage::Bootstrap);
+  }
+  return ptr_->computeScores(scorer_);
+}
+
+const AnalysisDegradation &Analyzer::degradation() const {
+  return ptr_->degradation();
+}
+
+const LatticePruneStats &Analyzer::pruneStats() const {
+  return ptr_->pruneStats();
+}
+
+const UnkSpanStats &Analyzer::unkStats() const { return ptr_->unkStats(); }
+
+IncrementalStats Analyzer::incrementalStats() const {
+  return ptr_->incrementalStats();
+}
+
+InputEdit InputEdit::between(StringPiece before, StringPiece after) {
+  auto minSize = std::min(before.size(), after.size());
+  size_t prefix = 0;
+  while (prefix < minSize && before[prefix] == after[prefix]) {
+    ++prefix;
+  }
+  size_t suffix = 0;
+  auto bsize = before.size();
+  auto asize = after.size();
+  while (suffix < minSize - prefix &&
+         before[bsize - suffix - 1] == after[asize - suffix - 1]) {
+    ++suffix;
+  }
+  InputEdit result;
+  result.start = prefix;
+  result.removed = before.size() - prefix - suffix;
+  result.inserted = after.size() - prefix - suffix;
+  return result;
 }
 
 Analyzer::Analyzer() {}
@@ -5,7 +5,10 @@
 #ifndef JUMANPP_ANALYZER_H
 #define JUMANPP_ANALYZER_H
 
+#include <chrono>
+#include "core/analysis/analysis_profiler.h"
 #include "core/analysis/output.h"
+#include "core/analysis/unk_maker_types.h"
 #include "core/core.h"
 
 namespace jumanpp {
@@ -19,12 +22,103 @@ struct AnalyzerConfig {
   i32 otherScorersTopN = 0;
   i32 rightGbeamCheck = 0;
   i32 rightGbeamSize = 0;
+  // When positive, global beam keeps only candidates which score
+  // not less than the best one minus margin.
+  // globalBeamSize is the maximum beam size in this case.
+  float globalBeamMargin = 0;
+  i32 globalBeamMinSize = 1;
+  // When positive, lattice is pruned before scoring: nodes which have
+  // unigram score lower than the best node of the same span minus margin
+  // are removed. Each span keeps at least one node.
+  // Experimental: the unigram scoring pass has cost more than it saved
+  // in measurements so far, so it is disabled by default.
+  float prepruneMargin = 0;
+  // Limits on unknown word spans, see UnkSpanLimits
+  UnkSpanLimits unkLimits;
   bool storeAllPatterns = false;
   i32 autoBeamStep = 0;
   i32 autoBeamBase = 0;
   i32 autoBeamMax = 0;
 };
 
+/**
+ * Results of lattice pre-pruning (see AnalyzerConfig::prepruneMargin)
+ */
+struct LatticePruneStats {
+  i32 nodesBefore = 0;
+  i32 nodesAfter = 0;
+
+  i32 numPruned() const { return nodesBefore - nodesAfter; }
+};
+
+/**
+ * An edit which produced a new input from the previously analyzed one:
+ * bytes [start, start + removed) were replaced with inserted bytes.
+ */
+struct InputEdit {
+  size_t start = 0;
+  size_t removed = 0;
+  size_t inserted = 0;
+
+  /**
+   * The smallest edit which changes before to after
+   */
+  static InputEdit between(StringPiece before, StringPiece after);
+};
+
+/**
+ * How much of the previous analysis was reused by Analyzer::analyzeEdited()
+ */
+struct IncrementalStats {
+  // leading codepoints which have their lattice boundaries reused
+  i32 reusedBoundaries = 0;
+  i32 totalBoundaries = 0;
+
+  bool reused() const { return reusedBoundaries > 0; }
+};
+
+/**
+ * Latency budget for a single analysis.
+ *
+ * Analyzer watches the progress over lattice boundaries and when
+ * the analysis is projected to miss the deadline, it degrades
+ * the rest of the sentence: global beams are halved (down to the minimums)
+ * and additional scorers (RNN) are skipped.
+ * Analysis without the global beam halves its beam instead.
+ * When the deadline passes while the lattice is built,
+ * scoring starts with the minimum beams.
+ */
+struct AnalysisBudget {
+  using Clock = std::chrono::steady_clock;
+
+  Clock::time_point deadline = Clock::time_point::max();
+  i32 minGlobalBeam = 1;
+  i32 minRightBeam = 1;
+  i32 minBeam = 1;
+
+  static AnalysisBudget after(std::chrono::microseconds duration) {
+    AnalysisBudget budget;
+    budget.deadline = Clock::now() + duration;
+    return budget;
+  }
+};
+
+/**
+ * Degradations which were applied to satisfy AnalysisBudget.
+ */
+struct AnalysisDegradation {
+  // First boundary with shrunk beams, -1 if beams were not shrunk
+  i32 boundary = -1;
+  i32 numShrinks = 0;
+  // Beam sizes which were used at the end of the analysis
+  i32 beamSize = 0;
+  i32 globalBeamSize = 0;
+  i32 rightGbeamSize = 0;
+  bool skippedScorers = false;
+
+  bool degraded() const { return numShrinks > 0 || skippedScorers; }
+};
+
 /**
  * Analyser depends on all core, so put it in pimpl idiom to reduce header
  * overload.
@@ -38,8 +132,13 @@ struct ScorerDef;
 
 class Analyzer {
   std::unique_ptr<AnalyzerImpl> pimpl_;
-  AnalyzerImpl* ptr_;
+  AnalyzerImpl* ptr_ = nullptr;
   const ScorerDef* scorer_;
+  AnalysisProfiler* profiler_ = nullptr;
+
+  Status analyzeImpl(StringPiece input, ScorePlugin* plugin,
+                     const AnalysisBudget* budget);
+  Status analyzeStages();
 
  public:
   Analyzer();
@@ -49,9 +148,38 @@ class Analyzer {
                     const ScoringConfig& sconf, const ScorerDef* scorer);
   Status initialize(AnalyzerImpl* impl, const ScorerDef* scorer);
   Status analyze(StringPiece input, ScorePlugin* plugin = nullptr);
+  /**
+   * Analyzes the input trying to finish before the budget deadline.
+   * Check degradation() for the applied degradations.
+   */
+  Status analyze(StringPiece input, const AnalysisBudget& budget,
+                 ScorePlugin* plugin = nullptr);
+  /**
+   * Analyzes the input which was produced by the edit
+   * from the previously analyzed one.
+   *
+   * Lattice boundaries and scores left of the edit are reused and only
+   * boundaries from the edit onward are recomputed, so the result is
+   * the same as of analyze(input).
+   * The full analysis is done when the previous one can not be reused:
+   * it was done with a plugin, a budget which degraded it,
+   * additional scorers, auto beam or lattice pruning.
+   */
+  Status analyzeEdited(StringPiece input, const InputEdit& edit);
+  IncrementalStats incrementalStats() const;
+  const AnalysisDegradation& degradation() const;
+  const LatticePruneStats& pruneStats() const;
+  const UnkSpanStats& unkStats() const;
   const OutputManager& output() const;
 
   const ScorerDef* scorer() const { return scorer_; }
+
+  /**
+   * Stages of all following analyses are reported to the profiler,
+   * nullptr disables profiling.
+   */
+  void setProfiler(AnalysisProfiler* profiler);
+  AnalysisProfiler* profiler() const { return profiler_; }
   AnalyzerImpl* impl() const { return ptr_; }
   const CoreHolder& core() const;
   ~Analyzer();
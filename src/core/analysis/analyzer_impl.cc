@@ -3,6 +3,7 @@
 //
 
 #include "core/analysis/analyzer_impl.h"
+#include <limits>
 #include "core/analysis/dictionary_node_creator.h"
 #include "core/analysis/innode_features.h"
 #include "core/analysis/score_api.h"
@@ -24,6 +25,71 @@ Status AnalyzerImpl::resetForInput(StringPiece input) {
   return Status::Ok();
 }
 
+bool AnalyzerImpl::canReuse(StringPiece input, const InputEdit& edit) const {
+  if (!reusable_) {
+    return false;
+  }
+  // memory of replaced boundaries is released only by a full reset
+  if (usedMemory() > 2 * baseMemory_) {
+    return false;
+  }
+  auto previous = input_.surface();
+  return std::equal(previous.begin(), previous.begin() + edit.start,
+                    input.begin());
+}
+
+Status AnalyzerImpl::resetForEditedInput(StringPiece input,
+                                         const InputEdit& edit) {
+  auto previous = input_.surface();
+  if (edit.start + edit.removed > previous.size() ||
+      previous.size() - edit.removed + edit.inserted != input.size()) {
+    return JPPS_INVALID_PARAMETER
+           << "edit at " << edit.start << " removing " << edit.removed
+           << " and inserting " << edit.inserted
+           << " bytes does not match previous input of " << previous.size()
+           << " bytes and new input of " << input.size() << " bytes";
+  }
+
+  if (!canReuse(input, edit)) {
+    return resetForInput(input);
+  }
+
+  // lattice, extra nodes and their memory are kept
+  sproc_ = nullptr;
+  plugin_ = nullptr;
+  budget_ = nullptr;
+  budgetCheckpointBoundary_ = 0;
+  budgetExpired_ = false;
+  degradation_ = AnalysisDegradation{};
+  pruneStats_ = LatticePruneStats{};
+  unkStats_ = UnkSpanStats{};
+  reusable_ = false;
+  reusedPositions_ = 0;
+  // kept unknown nodes must not point into the buffer which is overwritten
+  xtra_.detachUnkSurfaces(input_.surface());
+  JPP_RETURN_IF_ERROR(input_.reset(input));
+  latticeBldr_.resetKeepingSeeds(input_.numCodepoints());
+
+  auto begin = input_.surface().begin();
+  editPosition_ = 0;
+  for (auto& cp : input_.codepoints()) {
+    if (cp.bytes.end() - begin > edit.start) {
+      break;
+    }
+    ++editPosition_;
+  }
+  return Status::Ok();
+}
+
+void AnalyzerImpl::markReusable() {
+  reusable_ = plugin_ == nullptr && !degradation_.degraded() &&
+              scorers_.empty() && cfg_.prepruneMargin <= 0 &&
+              cfg_.autoBeamStep == 0;
+  if (baseMemory_ == 0) {
+    baseMemory_ = usedMemory();
+  }
+}
+
 AnalyzerImpl::AnalyzerImpl(const CoreHolder* core, const ScoringConfig& sconf,
                            const AnalyzerConfig& cfg)
     : cfg_{cfg},
@@ -38,6 +104,12 @@ AnalyzerImpl::AnalyzerImpl(const CoreHolder* core, const ScoringConfig& sconf,
       outputManager_{&xtra_, &core->dic(), &lattice_},
       compactor_{core->dic().entries()} {
   ngramStats_.initialze(&core->spec().features);
+  for (auto& f : core->spec().features.primitive) {
+    if (f.kind == spec::PrimitiveFeatureKind::Codepoint ||
+        f.kind == spec::PrimitiveFeatureKind::CodepointType) {
+      featureLookahead_ = std::max(featureLookahead_, f.references.at(0));
+    }
+  }
 }
 
 Status AnalyzerImpl::initScorers(const ScorerDef& cfg) {
@@ -99,12 +171,14 @@ Status AnalyzerImpl::makeNodeSeedsFromDic() {
 
 Status AnalyzerImpl::makeUnkNodes1() {
   auto& unk = core_->unkMakers();
-  analysis::UnkNodesContext unc{&xtra_, alloc(), dic().entries()};
+  analysis::UnkNodesContext unc{&xtra_, alloc(), dic().entries(),
+                                &cfg_.unkLimits, &unkStats_};
   for (auto& m : unk.stage1) {
     if (!m->spawnNodes(input_, &unc, &latticeBldr_)) {
       return Status::InvalidState() << "failed to create unk nodes";
     }
   }
+  checkBudgetExpired();
 
   return Status::Ok();
 }
@@ -115,12 +189,14 @@ bool AnalyzerImpl::checkLatticeConnectivity() {
 
 Status AnalyzerImpl::makeUnkNodes2() {
   auto& unk = core_->unkMakers();
-  analysis::UnkNodesContext unc{&xtra_, alloc(), dic().entries()};
+  analysis::UnkNodesContext unc{&xtra_, alloc(), dic().entries(),
+                                &cfg_.unkLimits, &unkStats_};
   for (auto& m : unk.stage2) {
     if (!m->spawnNodes(input_, &unc, &latticeBldr_)) {
       return Status::InvalidState() << "failed to create unk nodes (2)";
     }
   }
+  checkBudgetExpired();
 
   return Status::Ok();
 }
@@ -134,6 +210,13 @@ Status AnalyzerImpl::prepareNodeSeeds() {
       return Status::InvalidState() << "could not build lattice";
     }
   }
+  if (editPosition_ >= 0) {
+    auto limit = std::max(editPosition_ - featureLookahead_, 0);
+    reusedPositions_ = latticeBldr_.reusePrefix(
+        static_cast<LatticePosition>(limit), [this](EntryPtr a, EntryPtr b) {
+          return a == b || xtra_.sameUnk(a, b);
+        });
+  }
   JPP_RETURN_IF_ERROR(latticeBldr_.prepare());
   return Status::Ok();
 }
@@ -144,13 +227,20 @@ Status AnalyzerImpl::buildLattice() {
   LatticeConstructionContext lcc;
   InNodeFeatureComputer fc{core_->dic(), core_->features(), &xtra_, input_};
 
-  JPP_RETURN_IF_ERROR(latticeBldr_.makeBos(&lcc, &lattice_));
-  JPP_DCHECK_EQ(lattice_.createdBoundaryCount(), 2);
+  i32 first = reusedPositions_;
+  if (first == 0) {
+    lattice_.reset();
+    JPP_RETURN_IF_ERROR(latticeBldr_.makeBos(&lcc, &lattice_));
+  } else {
+    // two BOS boundaries and the reused ones
+    lattice_.truncate(static_cast<u32>(first + 2));
+  }
+  JPP_DCHECK_EQ(lattice_.createdBoundaryCount(), first + 2);
   i32 totalBnds = input_.numCodepoints();
 
   bool noStaticPattern = core_->features().patternStatic.get() == nullptr;
 
-  for (i32 boundary = 0; boundary < totalBnds; ++boundary) {
+  for (i32 boundary = first; boundary < totalBnds; ++boundary) {
     LatticeBoundary* bnd;
     JPP_RETURN_IF_ERROR(
         latticeBldr_.constructSingleBoundary(&lattice_, &bnd, boundary));
@@ -170,16 +260,97 @@ Status AnalyzerImpl::buildLattice() {
   if (noStaticPattern) {
     fc.patternFeaturesEos(&lattice_);
   }
-  JPP_RETURN_IF_ERROR(latticeBldr_.fillEnds(&lattice_));
+  JPP_RETURN_IF_ERROR(latticeBldr_.fillEnds(&lattice_, reusedPositions_));
   JPP_DCHECK_EQ(totalBnds + 3, lattice_.createdBoundaryCount());
+  checkBudgetExpired();
 
   return Status::Ok();
 }
 
+Status AnalyzerImpl::prepruneLattice(const ScorerDef* sconf) {
+  if (cfg_.prepruneMargin <= 0) {
+    return Status::Ok();
+  }
+
+  auto x = ScoreProcessor::make(this);
+  JPP_RETURN_IF_ERROR(std::move(x.first));
+  auto& proc = *x.second;
+
+  auto seeds = latticeBldr_.seeds();
+  pruneMask_.clear();
+  pruneMask_.resize(seeds.size(), false);
+  auto lowest = std::numeric_limits<Score>::lowest();
+  pruneBest_.clear();
+  pruneBest_.resize(input_.numCodepoints() + 1, lowest);
+
+  auto entries = dic().entries();
+  features::impl::PrimitiveFeatureContext pfc{&xtra_, dic().fields(), entries,
+                                              input_.codepoints()};
+
+  i32 numPruned = 0;
+  i32 totalBnds = input_.numCodepoints();
+  for (i32 boundary = 0; boundary < totalBnds; ++boundary) {
+    auto bndIdx = boundary + 2;
+    auto numNodes = lattice_.boundary(bndIdx)->localNodeCount();
+    if (numNodes < 2) {
+      continue;
+    }
+
+    proc.startBoundary(numNodes);
+    if (proc.patternIsStatic()) {
+      proc.computeT0All(bndIdx, sconf->feature, &pfc);
+    } else {
+      proc.applyT0(bndIdx, sconf->feature);
+    }
+    auto scores = proc.scores_.bufferT0();
+    auto offset = latticeBldr_.infoAt(boundary).firstNodeOffset;
+
+    // nodes of a boundary have the same start, so span == end
+    for (u32 i = 0; i < numNodes; ++i) {
+      auto& best = pruneBest_[seeds[offset + i].codepointEnd];
+      best = std::max(best, scores.at(i));
+    }
+    for (u32 i = 0; i < numNodes; ++i) {
+      auto best = pruneBest_[seeds[offset + i].codepointEnd];
+      if (scores.at(i) < best - cfg_.prepruneMargin) {
+        pruneMask_[offset + i] = true;
+        numPruned += 1;
+      }
+    }
+    for (u32 i = 0; i < numNodes; ++i) {
+      pruneBest_[seeds[offset + i].codepointEnd] = lowest;
+    }
+    lattice_.boundary(bndIdx)->removeStarts(pruneMask_, offset);
+  }
+
+  pruneStats_.nodesBefore = static_cast<i32>(seeds.size());
+  pruneStats_.nodesAfter = pruneStats_.nodesBefore - numPruned;
+  if (numPruned == 0) {
+    return Status::Ok();
+  }
+
+  // starts were compacted in place, only ends need to be filled again
+  JPP_DCHECK_EQ(reusedPositions_, 0);
+  JPP_RETURN_IF_ERROR(latticeBldr_.removeSeeds(pruneMask_));
+  lattice_.boundary(1)->resetEnds(1);
+  for (i32 boundary = 0; boundary <= totalBnds; ++boundary) {
+    auto& info = latticeBldr_.infoAt(boundary);
+    lattice_.boundary(boundary + 2)->resetEnds(info.endCount);
+  }
+  return latticeBldr_.fillEnds(&lattice_, 0);
+}
+
 Status AnalyzerImpl::bootstrapAnalysis() {
   auto x = ScoreProcessor::make(this);
   JPP_RETURN_IF_ERROR(std::move(x.first));
   sproc_ = x.second;
+  return resetScoringState();
+}
+
+Status AnalyzerImpl::resetScoringState() {
+  if (sproc_ == nullptr) {
+    return JPPS_INVALID_STATE << "analysis was not bootstrapped";
+  }
 
   // bootstrap beam pointers
   auto beam0 = lattice_.boundary(0)->starts()->beamData().data();
@@ -204,12 +375,15 @@ Status AnalyzerImpl::computeScoresFull(const ScorerDef* sconf) {
     return Status::Ok();
   }
 
-  for (i32 boundary = 2; boundary < bndCount; ++boundary) {
+  for (i32 boundary = 2 + reusedPositions_; boundary < bndCount; ++boundary) {
     JPP_CAPTURE(boundary);
     auto bnd = lattice_.boundary(boundary);
     JPP_DCHECK(bnd->endingsFilled());
     auto left = bnd->ends()->nodePtrs();
     auto& proc = *this->sproc_;
+    if (budget_ != nullptr) {
+      checkBudget(boundary);
+    }
 
     EntryBeam::initializeBlock(bnd->starts()->beamData().data());
 
@@ -259,13 +433,16 @@ Status AnalyzerImpl::computeScoresGbeam(const ScorerDef* sconf) {
 
   auto& proc = *this->sproc_;
 
-  for (i32 boundary = 2; boundary < bndCount; ++boundary) {
+  for (i32 boundary = 2 + reusedPositions_; boundary < bndCount; ++boundary) {
     JPP_CAPTURE(boundary);
     auto bnd = lattice_.boundary(boundary);
     if (bnd->localNodeCount() == 0) {
       continue;
     }
     JPP_DCHECK(bnd->endingsFilled());
+    if (budget_ != nullptr) {
+      checkBudget(boundary);
+    }
     proc.startBoundary(bnd->localNodeCount());
     if (proc.patternIsStatic()) {
       auto entries = dic().entries();
@@ -279,9 +456,21 @@ Status AnalyzerImpl::computeScoresGbeam(const ScorerDef* sconf) {
       proc.applyT0(boundary, sconf->feature);
     }
 
-    auto gbeam = proc.makeGlobalBeam(boundary, latticeConfig_.globalBeamSize);
+    i32 gbeamSize = latticeConfig_.globalBeamSize;
+    if (JPP_UNLIKELY(degradation_.numShrinks > 0)) {
+      gbeamSize = degradation_.globalBeamSize;
+    }
+    auto gbeam = proc.makeGlobalBeam(boundary, gbeamSize);
     proc.computeGbeamScores(boundary, gbeam, sconf->feature);
   }
+  profileStage(AnalysisStage::GbeamScores);
+
+  if (!scorers_.empty() && budget_ != nullptr &&
+      (degradation_.numShrinks > 0 ||
+       AnalysisBudget::Clock::now() >= budget_->deadline)) {
+    degradation_.skippedScorers = true;
+    return Status::Ok();
+  }
 
   if (!scorers_.empty()) {
     u32 idx = 1;
@@ -291,21 +480,103 @@ Status AnalyzerImpl::computeScoresGbeam(const ScorerDef* sconf) {
     }
     proc.adjustBeamScores(sconf->scoreWeights);
     proc.remakeEosBeam(sconf->scoreWeights);
+    profileStage(AnalysisStage::Rescore);
   }
 
   return Status::Ok();
 }
 
+void AnalyzerImpl::checkBudgetExpired() {
+  if (budget_ != nullptr && !budgetExpired_ &&
+      AnalysisBudget::Clock::now() >= budget_->deadline) {
+    budgetExpired_ = true;
+  }
+}
+
+void AnalyzerImpl::checkBudget(i32 boundary) {
+  using Clock = AnalysisBudget::Clock;
+  auto now = Clock::now();
+  if (budgetCheckpointBoundary_ == 0) {
+    budgetCheckpoint_ = now;
+    budgetCheckpointBoundary_ = boundary;
+    degradation_.beamSize = latticeConfig_.beamSize;
+    degradation_.globalBeamSize = latticeConfig_.globalBeamSize;
+    degradation_.rightGbeamSize = sproc_->rightGbeamSize_;
+    // the deadline has passed before scoring, there is nothing to estimate
+    if (budgetExpired_ && shrinkBudgetBeams(true)) {
+      degradation_.boundary = boundary;
+      degradation_.numShrinks += 1;
+    }
+    return;
+  }
+
+  auto remaining = lattice_.createdBoundaryCount() - boundary;
+  auto processed = boundary - budgetCheckpointBoundary_;
+  bool overdue = now >= budget_->deadline;
+  // two boundaries are needed for a reasonable estimate
+  if (!overdue && processed < 2) {
+    return;
+  }
+
+  auto perBoundary = (now - budgetCheckpoint_) / processed;
+  if (!overdue && now + perBoundary * remaining <= budget_->deadline) {
+    return;
+  }
+
+  if (!shrinkBudgetBeams(false)) {
+    return;  // already at minimum
+  }
+
+  if (degradation_.numShrinks == 0) {
+    degradation_.boundary = boundary;
+  }
+  degradation_.numShrinks += 1;
+  // estimate the speed of the shrunk beams from scratch
+  budgetCheckpoint_ = now;
+  budgetCheckpointBoundary_ = boundary;
+}
+
+bool AnalyzerImpl::shrinkBudgetBeams(bool toMinimum) {
+  auto shrink = [toMinimum](i32 cur, i32 min) {
+    return std::min(cur, toMinimum ? min : std::max(min, cur / 2));
+  };
+
+  if (cfg_.globalBeamSize <= 0) {
+    auto beam = shrink(degradation_.beamSize, budget_->minBeam);
+    if (beam == degradation_.beamSize) {
+      return false;
+    }
+    degradation_.beamSize = beam;
+    sproc_->fullBeamSize_ = static_cast<u32>(beam);
+    return true;
+  }
+
+  auto curGbeam = degradation_.globalBeamSize;
+  auto curRbeam = degradation_.rightGbeamSize;
+  auto gbeam = shrink(curGbeam, budget_->minGlobalBeam);
+  auto rbeam = shrink(curRbeam, budget_->minRightBeam);
+  if (gbeam == curGbeam && rbeam == curRbeam) {
+    return false;
+  }
+  degradation_.globalBeamSize = gbeam;
+  degradation_.rightGbeamSize = rbeam;
+  sproc_->rightGbeamSize_ = rbeam;
+  return true;
+}
+
 Status AnalyzerImpl::computeScores(const ScorerDef* sconf) {
   if (sproc_ == nullptr) {
     return JPPS_INVALID_STATE << "Analyzer was not initialized";
   }
   // LOG_TRACE() << "Scorer weights: " << VOut(sconf->scoreWeights);
   if (cfg().globalBeamSize <= 0) {
-    return computeScoresFull(sconf);
+    JPP_RETURN_IF_ERROR(computeScoresFull(sconf));
+    profileStage(AnalysisStage::Scores);
   } else {
-    return computeScoresGbeam(sconf);
+    JPP_RETURN_IF_ERROR(computeScoresGbeam(sconf));
   }
+  markReusable();
+  return Status::Ok();
 }
 
 bool AnalyzerImpl::setGlobalBeam(i32 leftBeam, i32 rightCheck, i32 rightBeam) {
@@ -325,7 +596,10 @@ bool AnalyzerImpl::setGlobalBeam(i32 leftBeam, i32 rightCheck, i32 rightBeam) {
     result = true;
   }
   if (result) {
-    sproc_ = nullptr;
+    if (sproc_ != nullptr && !sproc_->updateGlobalBeam()) {
+      sproc_ = nullptr;
+    }
+    reusable_ = false;
   }
   return result;
 }
@@ -335,6 +609,7 @@ bool AnalyzerImpl::setStoreAllPatterns(bool value) {
     return false;
   }
   cfg_.storeAllPatterns = value;
+  reusable_ = false;
   if (!cfg_.storeAllPatterns && core().features().patternStatic) {
     auto& fspec = core_->spec().features;
     latticeConfig_.numFeaturePatterns =
@@ -29,11 +29,39 @@ class AnalyzerImpl {
   LatticeBuilder latticeBldr_;
   ExtraNodesContext xtra_;
   OutputManager outputManager_;
-  ScoreProcessor* sproc_;
+  ScoreProcessor* sproc_ = nullptr;
   std::vector<std::unique_ptr<ScoreComputer>> scorers_;
   LatticeCompactor compactor_;
   NgramStats ngramStats_;
   ScorePlugin* plugin_ = nullptr;
+  AnalysisProfiler* profiler_ = nullptr;
+  const AnalysisBudget* budget_ = nullptr;
+  AnalysisBudget::Clock::time_point budgetCheckpoint_;
+  i32 budgetCheckpointBoundary_ = 0;
+  // the budget deadline passed before scoring
+  bool budgetExpired_ = false;
+  AnalysisDegradation degradation_;
+  LatticePruneStats pruneStats_;
+  UnkSpanStats unkStats_;
+  std::vector<bool> pruneMask_;
+  std::vector<Score> pruneBest_;
+  // lattice and seeds contain a complete analysis of input
+  // which can be reused by resetForEditedInput
+  bool reusable_ = false;
+  // first changed codepoint after resetForEditedInput, -1 otherwise
+  i32 editPosition_ = -1;
+  // lattice boundaries of these leading codepoints are not rebuilt
+  LatticePosition reusedPositions_ = 0;
+  // memory used by the last analysis from scratch
+  u64 baseMemory_ = 0;
+  // how far after their end node features look at the input
+  i32 featureLookahead_ = 0;
+
+  void checkBudget(i32 boundary);
+  void checkBudgetExpired();
+  bool shrinkBudgetBeams(bool toMinimum);
+  bool canReuse(StringPiece input, const InputEdit& edit) const;
+  void markReusable();
 
  public:
   AnalyzerImpl(const AnalyzerImpl&) = delete;
@@ -52,6 +80,16 @@ class AnalyzerImpl {
     alloc_->reset();
     sproc_ = nullptr;
     plugin_ = nullptr;
+    budget_ = nullptr;
+    budgetCheckpointBoundary_ = 0;
+    budgetExpired_ = false;
+    degradation_ = AnalysisDegradation{};
+    pruneStats_ = LatticePruneStats{};
+    unkStats_ = UnkSpanStats{};
+    reusable_ = false;
+    editPosition_ = -1;
+    reusedPositions_ = 0;
+    baseMemory_ = 0;
   }
 
   // This set of functions is internal
@@ -66,10 +104,40 @@ class AnalyzerImpl {
    * and can not be used in training.
    */
   Status resetForInput(StringPiece input);
+  /**
+   * Prepares the analysis of the input which was produced by the edit
+   * from the previously analyzed one.
+   * Following prepareNodeSeeds(), buildLattice() and computeScores()
+   * keep the lattice left of the edit.
+   * Calls resetForInput() if the previous analysis can not be reused.
+   */
+  Status resetForEditedInput(StringPiece input, const InputEdit& edit);
   Status prepareNodeSeeds();
   Status buildLattice();
+  /**
+   * Removes nodes with low unigram scores from the built lattice
+   * when enabled in config (see AnalyzerConfig::prepruneMargin).
+   * Nodes are removed from the lattice in place.
+   */
+  Status prepruneLattice(const ScorerDef* sconf);
   Status bootstrapAnalysis();
+  bool isBootstrapped() const { return sproc_ != nullptr; }
+  bool hasExtraScorers() const { return !scorers_.empty(); }
+  /**
+   * Prepares an already built and scored lattice to be scored once again,
+   * reusing the score processor from bootstrapAnalysis().
+   */
+  Status resetScoringState();
+  /**
+   * Reports Scores, GbeamScores and Rescore stages to the profiler if set.
+   */
   Status computeScores(const ScorerDef* sconf);
+  void setProfiler(AnalysisProfiler* profiler) { profiler_ = profiler; }
+  void profileStage(AnalysisStage stage) {
+    if (JPP_UNLIKELY(profiler_ != nullptr)) {
+      profiler_->finish(stage);
+    }
+  }
   Status computeScoresFull(const ScorerDef* sconf);
   Status computeScoresGbeam(const ScorerDef* sconf);
 
@@ -92,14 +160,34 @@ class AnalyzerImpl {
   }
 
   util::memory::PoolAlloc* alloc() const { return alloc_.get(); }
+  const util::memory::Manager& memoryManager() const { return memMgr_; }
   const NgramStats& ngramStats() const { return ngramStats_; }
   const AnalyzerConfig& cfg() const { return cfg_; }
   bool setGlobalBeam(i32 leftBeam, i32 rightCheck, i32 rightBeam);
   bool setStoreAllPatterns(bool value);
+  void setPrepruneMargin(float margin) {
+    cfg_.prepruneMargin = margin;
+    reusable_ = false;
+  }
+  void setUnkLimits(const UnkSpanLimits& limits) {
+    cfg_.unkLimits = limits;
+    reusable_ = false;
+  }
   const AnalysisInput& input() const { return input_; }
   i32 autoBeamSizes();
   ScorePlugin* plugin() const { return plugin_; }
   void setPlugin(ScorePlugin* plugin) { plugin_ = plugin; }
+  // The budget object should be alive until the scores are computed
+  void setBudget(const AnalysisBudget* budget) { budget_ = budget; }
+  const AnalysisDegradation& degradation() const { return degradation_; }
+  const LatticePruneStats& pruneStats() const { return pruneStats_; }
+  const UnkSpanStats& unkStats() const { return unkStats_; }
+  IncrementalStats incrementalStats() const {
+    IncrementalStats stats;
+    stats.reusedBoundaries = reusedPositions_;
+    stats.totalBoundaries = static_cast<i32>(input_.codepoints().size());
+    return stats;
+  }
 };
 
 }  // namespace analysis
@@ -0,0 +1,45 @@
+#include "core/analysis/batch_analyzer.h"
+
+namespace jumanpp {
+namespace core {
+namespace analysis {
+
+Status BatchAnalyzer::initialize(const CoreHolder* core,
+                                 const AnalyzerConfig& cfg,
+                                 const ScoringConfig& sconf,
+                                 const ScorerDef* scorer,
+                                 const BatchAnalyzerConfig& bconf) {
+  if (bconf.batchSize <= 0) {
+    return JPPS_INVALID_PARAMETER << "batch size must be positive, was "
+                                  << bconf.batchSize;
+  }
+
+  slots_.clear();
+  slots_.resize(static_cast<size_t>(bconf.batchSize));
+  for (auto& slot : slots_) {
+    slot.analyzer.reset(new Analyzer{});
+    JPP_RETURN_IF_ERROR(slot.analyzer->initialize(core, cfg, sconf, scorer));
+  }
+  numActive_ = 0;
+  return Status::Ok();
+}
+
+Status BatchAnalyzer::analyze(util::ArraySlice<StringPiece> inputs) {
+  if (inputs.size() > slots_.size()) {
+    return JPPS_INVALID_PARAMETER << "batch analyzer can process at most "
+                                  << slots_.size() << " inputs, passed "
+                                  << inputs.size();
+  }
+
+  numActive_ = static_cast<i32>(inputs.size());
+  for (i32 i = 0; i < numActive_; ++i) {
+    auto& slot = slots_[i];
+    slot.status = slot.analyzer->analyze(inputs[i]);
+  }
+
+  return Status::Ok();
+}
+
+}  // namespace analysis
+}  // namespace core
+}  // namespace jumanpp
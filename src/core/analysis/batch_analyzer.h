@@ -0,0 +1,56 @@
+#ifndef JUMANPP_BATCH_ANALYZER_H
+#define JUMANPP_BATCH_ANALYZER_H
+
+#include <memory>
+#include <vector>
+#include "core/analysis/analyzer.h"
+#include "util/array_slice.h"
+
+namespace jumanpp {
+namespace core {
+namespace analysis {
+
+struct BatchAnalyzerConfig {
+  // Maximum number of sentences in a batch
+  i32 batchSize = 4;
+};
+
+/**
+ * Analyzes several sentences with a single call.
+ *
+ * Each sentence of a batch gets its own analyzer, so results of all of them
+ * are available after the call.
+ * Results of each sentence are identical to the ones of Analyzer.
+ */
+class BatchAnalyzer {
+  struct Slot {
+    std::unique_ptr<Analyzer> analyzer;
+    Status status = Status::Ok();
+  };
+
+  std::vector<Slot> slots_;
+  i32 numActive_ = 0;
+
+ public:
+  Status initialize(const CoreHolder* core, const AnalyzerConfig& cfg,
+                    const ScoringConfig& sconf, const ScorerDef* scorer,
+                    const BatchAnalyzerConfig& bconf);
+
+  /**
+   * Analyzes inputs, there should be not more than batchSize of them.
+   * Failure of a single sentence does not stop analysis of others,
+   * check status(i) for each of them.
+   */
+  Status analyze(util::ArraySlice<StringPiece> inputs);
+
+  i32 batchSize() const { return static_cast<i32>(slots_.size()); }
+  i32 numActive() const { return numActive_; }
+  const Status& status(i32 idx) const { return slots_[idx].status; }
+  const Analyzer& analyzer(i32 idx) const { return *slots_[idx].analyzer; }
+};
+
+}  // namespace analysis
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_BATCH_ANALYZER_H
@@ -0,0 +1,191 @@
+#ifndef JUMANPP_BEAM_TOPK_H
+#define JUMANPP_BEAM_TOPK_H
+
+#include <cstring>
+#include "core/analysis/lattice_config.h"
+#include "util/common.hpp"
+#include "util/types.hpp"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace jumanpp {
+namespace core {
+namespace analysis {
+
+// Maximum k for which smallTopK can be used
+constexpr u32 MaxSmallTopK = 16;
+
+/**
+ * Keeps Width largest u64 keys pushed into it, sorted in descending order.
+ *
+ * A key is compared only with the k-th best key most of the time.
+ * A key which gets in is inserted without branches:
+ * every slot becomes the previous slot, the key or itself,
+ * with AVX2 four slots at a time.
+ * Empty slots contain zero, so zero keys are not distinguished from them.
+ */
+template <u32 Width>
+class SmallTopK {
+  static_assert(Width > 0 && Width <= MaxSmallTopK, "Width is too large");
+
+#ifdef __AVX2__
+  static constexpr bool UseAvx2 = Width % 4 == 0;
+#else
+  static constexpr bool UseAvx2 = false;
+#endif
+
+  alignas(32) u64 top_[Width];
+  u32 last_;
+  u64 threshold_ = 0;
+
+  JPP_ALWAYS_INLINE void insertScalar(u64 key) noexcept {
+    for (u32 j = Width - 1; j > 0; --j) {
+      u64 prev = top_[j - 1];
+      u64 cur = top_[j];
+      u64 lower = key > cur ? key : cur;
+      top_[j] = key > prev ? prev : lower;
+    }
+    top_[0] = key > top_[0] ? key : top_[0];
+  }
+
+#ifdef __AVX2__
+  JPP_ALWAYS_INLINE void insertAvx2(u64 key) noexcept {
+    // AVX2 has only signed 64-bit comparison
+    constexpr u64 SignBit = 0x8000'0000'0000'0000ULL;
+    auto sign = _mm256_set1_epi64x(static_cast<i64>(SignBit));
+    auto x = _mm256_set1_epi64x(static_cast<i64>(key ^ SignBit));
+    // slot before the first one is larger than anything
+    auto carry = _mm256_set1_epi64x(static_cast<i64>(~SignBit));
+    for (u32 r = 0; r < Width; r += 4) {
+      auto ptr = reinterpret_cast<__m256i*>(top_ + r);
+      auto v = _mm256_xor_si256(_mm256_load_si256(ptr), sign);
+      auto prev = _mm256_permute4x64_epi64(v, _MM_SHUFFLE(2, 1, 0, 0));
+      prev = _mm256_blend_epi32(prev, carry, 0x03);
+      carry = _mm256_permute4x64_epi64(v, _MM_SHUFFLE(3, 3, 3, 3));
+      auto gtCur = _mm256_cmpgt_epi64(x, v);
+      auto gtPrev = _mm256_cmpgt_epi64(x, prev);
+      auto lower = _mm256_blendv_epi8(v, x, gtCur);
+      auto result = _mm256_blendv_epi8(lower, prev, gtPrev);
+      _mm256_store_si256(ptr, _mm256_xor_si256(result, sign));
+    }
+  }
+#endif
+
+ public:
+  explicit SmallTopK(u32 k) noexcept : last_{k - 1} {
+    JPP_DCHECK_GT(k, 0);
+    JPP_DCHECK_LE(k, Width);
+    std::memset(top_, 0, sizeof(top_));
+  }
+
+  JPP_ALWAYS_INLINE void push(u64 key) noexcept {
+    if (JPP_LIKELY(key <= threshold_)) {
+      return;
+    }
+#ifdef __AVX2__
+    if (UseAvx2) {
+      insertAvx2(key);
+    } else {
+      insertScalar(key);
+    }
+#else
+    insertScalar(key);
+#endif
+    threshold_ = top_[last_];
+  }
+
+  const u64* keys() const noexcept { return top_; }
+
+  /**
+   * Selects min(k, size) largest keys produced by keyOf(0..size),
+   * writes them to result best first.
+   * @return number of selected keys
+   */
+  template <typename KeyFn>
+  static JPP_ALWAYS_INLINE u32 select(u32 size, u32 k, KeyFn keyOf,
+                                      u64* result) noexcept {
+    SmallTopK<Width> topk{k};
+    for (u32 i = 0; i < size; ++i) {
+      topk.push(keyOf(i));
+    }
+    u32 count = size < k ? size : k;
+    std::memcpy(result, topk.keys(), count * sizeof(u64));
+    return count;
+  }
+};
+
+/**
+ * Width of SmallTopK for the given k: a multiple of 4 to use AVX2.
+ */
+constexpr u32 smallTopKWidth(u32 k) { return k <= 4 ? 4 : (k + 3) / 4 * 4; }
+
+/**
+ * Selects min(k, size) largest keys produced by keyOf(0..size),
+ * best first, for runtime values of k <= MaxSmallTopK.
+ * @return number of selected keys
+ */
+template <typename KeyFn>
+inline u32 smallTopK(u32 size, u32 k, KeyFn keyOf, u64* result) noexcept {
+  JPP_DCHECK_LE(k, MaxSmallTopK);
+  if (k <= 4) {
+    return SmallTopK<4>::select(size, k, keyOf, result);
+  }
+  if (k <= 8) {
+    return SmallTopK<8>::select(size, k, keyOf, result);
+  }
+  return SmallTopK<16>::select(size, k, keyOf, result);
+}
+
+/**
+ * Maps scores to u32 with the same order.
+ */
+inline u32 orderedScoreBits(Score score) noexcept {
+  u32 value;
+  std::memcpy(&value, &score, sizeof(float));
+  return ((value & 0x8000'0000) != 0) ? ~value : value ^ 0x8000'0000;
+}
+
+inline Score scoreFromOrderedBits(u32 value) noexcept {
+  value = ((value & 0x8000'0000) == 0) ? ~value : value ^ 0x8000'0000;
+  float result;
+  std::memcpy(&result, &value, sizeof(float));
+  return result;
+}
+
+/**
+ * A key of an indexed score.
+ * Keys are ordered by score and then by the reverse index,
+ * so equal scores keep the original order.
+ */
+inline u64 scoreIndexKey(Score score, u32 index) noexcept {
+  return (static_cast<u64>(orderedScoreBits(score)) << 32) | ~index;
+}
+
+inline u32 indexOfScoreKey(u64 key) noexcept {
+  return ~static_cast<u32>(key);
+}
+
+/**
+ * Writes indices of at most K best scores to result, best first.
+ * Ties keep the original order.
+ * @return number of written indices, min(K, size)
+ */
+template <u32 K>
+inline u32 topKIndices(const Score* scores, u32 size, u32* result) {
+  constexpr u32 Width = smallTopKWidth(K);
+  u64 keys[Width];
+  auto count = SmallTopK<Width>::select(
+      size, K, [scores](u32 i) { return scoreIndexKey(scores[i], i); }, keys);
+  for (u32 i = 0; i < count; ++i) {
+    result[i] = indexOfScoreKey(keys[i]);
+  }
+  return count;
+}
+
+}  // namespace analysis
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_BEAM_TOPK_H
@@ -63,6 +63,45 @@ StringPiece ExtraNodesContext::unkString(i32 i) const {
   return StringPiece();
 }
 
+void ExtraNodesContext::detachUnkSurfaces(StringPiece input) {
+  char *copy = nullptr;
+  for (auto &node : extraNodes_) {
+    if (node->header.type != ExtraNodeType::Unknown) {
+      continue;
+    }
+    auto &surface = node->header.unk.surface;
+    if (surface.begin() < input.begin() || surface.end() > input.end()) {
+      continue;
+    }
+    if (copy == nullptr) {
+      copy = alloc_->allocateArray<char>(input.size());
+      std::copy(input.begin(), input.end(), copy);
+    }
+    auto start = copy + (surface.begin() - input.begin());
+    surface = StringPiece{start, start + surface.size()};
+  }
+}
+
+bool ExtraNodesContext::sameUnk(EntryPtr a, EntryPtr b) const {
+  if (!a.isSpecial() || !b.isSpecial()) {
+    return false;
+  }
+  auto n1 = node(a);
+  auto n2 = node(b);
+  if (n1->header.type != ExtraNodeType::Unknown ||
+      n2->header.type != ExtraNodeType::Unknown) {
+    return false;
+  }
+  auto &u1 = n1->header.unk;
+  auto &u2 = n2->header.unk;
+  if (u1.contentHash != u2.contentHash || u1.templatePtr != u2.templatePtr ||
+      u1.surface != u2.surface) {
+    return false;
+  }
+  auto size = numFields_ + numPlaceholders_;
+  return std::equal(n1->content, n1->content + size, n2->content);
+}
+
 }  // namespace analysis
 }  // namespace core
 }  // namespace jumanpp
\ No newline at end of file
@@ -135,6 +135,17 @@ class ExtraNodesContext {
   }
 
   StringPiece unkString(i32 i) const;
+
+  /**
+   * Copies the input and makes surfaces of unknown nodes which point into it
+   * point into the copy, so the nodes stay usable after the input changes
+   */
+  void detachUnkSurfaces(StringPiece input);
+
+  /**
+   * Checks that two unknown nodes have the same surface and data
+   */
+  bool sameUnk(EntryPtr a, EntryPtr b) const;
 };
 
 }  // namespace analysis
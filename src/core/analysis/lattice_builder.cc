@@ -38,6 +38,23 @@ Status LatticeBuilder::prepare() {
   return Status::Ok();
 }
 
+Status LatticeBuilder::removeSeeds(const std::vector<bool> &removed) {
+  if (removed.size() != seeds_.size()) {
+    return JPPS_INVALID_PARAMETER << "removal mask size " << removed.size()
+                                  << " was not equal to number of seeds "
+                                  << seeds_.size();
+  }
+  size_t kept = 0;
+  for (size_t i = 0; i < seeds_.size(); ++i) {
+    if (!removed[i]) {
+      seeds_[kept] = seeds_[i];
+      kept += 1;
+    }
+  }
+  seeds_.erase(seeds_.begin() + kept, seeds_.end());
+  return prepare();
+}
+
 bool LatticeBuilder::checkConnectability() {
   sortSeeds();
   connectible.clear();
@@ -117,14 +134,17 @@ Status LatticeBuilder::makeEos(LatticeConstructionContext *ctx,
   return Status::Ok();
 }
 
-Status LatticeBuilder::fillEnds(Lattice *l) {
-  // connect BOS nodes
-  l->boundary(1)->addEnd(LatticeNodePtr{0, 0});
-  l->boundary(2)->addEnd(LatticeNodePtr{1, 0});
+Status LatticeBuilder::fillEnds(Lattice *l, LatticePosition first) {
+  if (first == 0) {
+    // connect BOS nodes
+    l->boundary(1)->addEnd(LatticeNodePtr{0, 0});
+    l->boundary(2)->addEnd(LatticeNodePtr{1, 0});
+  }
 
   for (int i = 0; i < seeds_.size(); ++i) {
     auto &seed = seeds_[i];
-    if (seed.codepointStart == seed.codepointEnd) {
+    if (seed.codepointStart == seed.codepointEnd ||
+        seed.codepointEnd < first) {
       continue;
     }
     u32 idx = seed.codepointEnd + 2u;
@@ -97,6 +97,7 @@ class LatticeCompactor {
 
 class LatticeBuilder {
   std::vector<LatticeNodeSeed> seeds_;
+  std::vector<LatticeNodeSeed> previousSeeds_;
   std::vector<BoundaryInfo> boundaries_;
   std::vector<bool> connectible;
   LatticePosition maxBoundaries_;
@@ -111,18 +112,81 @@ class LatticeBuilder {
   bool checkConnectability();
   void reset(LatticePosition maxCodepoints);
 
+  /**
+   * Resets the builder keeping the current seeds for reusePrefix()
+   */
+  void resetKeepingSeeds(LatticePosition maxCodepoints) {
+    seeds_.swap(previousSeeds_);
+    reset(maxCodepoints);
+  }
+
+  /**
+   * Compares sorted seeds with the ones kept by resetKeepingSeeds().
+   * A leading position is reused when it and all positions before it
+   * have the same seeds in the same order, none of them ending after limit.
+   * Seeds of reused positions get entry pointers of the previous ones.
+   * @param sameEntry checks that two entry pointers describe the same node
+   * @return number of reused positions
+   */
+  template <typename SameEntry>
+  LatticePosition reusePrefix(LatticePosition limit, SameEntry sameEntry) {
+    LatticePosition reused = limit;
+    auto& prev = previousSeeds_;
+    size_t numCommon = std::min(seeds_.size(), prev.size());
+    size_t idx = 0;
+    for (; idx < numCommon; ++idx) {
+      auto& s = seeds_[idx];
+      auto& p = prev[idx];
+      auto start = std::min(s.codepointStart, p.codepointStart);
+      if (start >= reused) {
+        break;
+      }
+      if (s.codepointStart != p.codepointStart ||
+          s.codepointEnd != p.codepointEnd || s.codepointEnd > limit ||
+          !sameEntry(p.entryPtr, s.entryPtr)) {
+        reused = start;
+        break;
+      }
+    }
+    // one of seed arrays has ended
+    if (idx == numCommon) {
+      if (idx < seeds_.size()) {
+        reused = std::min(reused, seeds_[idx].codepointStart);
+      }
+      if (idx < prev.size()) {
+        reused = std::min(reused, prev[idx].codepointStart);
+      }
+    }
+    for (idx = 0; idx < seeds_.size(); ++idx) {
+      if (seeds_[idx].codepointStart >= reused) {
+        break;
+      }
+      seeds_[idx].entryPtr = prev[idx].entryPtr;
+    }
+    return reused;
+  }
+
   util::ArraySlice<LatticeNodeSeed> seeds() const {
     return {seeds_.data(), seeds_.size()};
   }
 
   Status prepare();
+  /**
+   * Removes seeds which are marked in the mask
+   * and recomputes boundary information.
+   */
+  Status removeSeeds(const std::vector<bool>& removed);
   void compactBoundary(i32 boundary, LatticeCompactor* compactor);
   Status constructSingleBoundary(Lattice* lattice, LatticeBoundary** result,
                                  i32 numBoundary);
   bool isAccessible(i32 boundary) const { return connectible[boundary]; }
   Status makeBos(LatticeConstructionContext* ctx, Lattice* lattice);
   Status makeEos(LatticeConstructionContext* ctx, Lattice* lattice);
-  Status fillEnds(Lattice* l);
+  /**
+   * Fills lattice boundaries with ending nodes.
+   * Boundaries before the first one were filled already.
+   */
+  Status fillEnds(Lattice* l, LatticePosition first = 0);
   const BoundaryInfo& infoAt(i32 boundary) const;
 
   u64 usedMemory() const {
@@ -27,8 +27,20 @@ Status Lattice::makeBoundary(const LatticeBoundaryConfig &lbc,
 
 void Lattice::reset() { boundaries.clear(); }
 
+void Lattice::truncate(u32 count) {
+  if (count < boundaries.size()) {
+    boundaries.resize(count);
+  }
+}
+
 void Lattice::hintSize(u32 size) { boundaries.reserve(size); }
 
+void Lattice::resetGlobalBeams() {
+  for (auto bnd : boundaries) {
+    bnd->ends()->resetGlobalBeam(alloc, lconf.globalBeamSize);
+  }
+}
+
 LatticeBoundary::LatticeBoundary(util::memory::PoolAlloc *alloc,
                                  const LatticeConfig &lc,
                                  const LatticeBoundaryConfig &lbc)
@@ -45,6 +57,45 @@ void LatticeBoundary::addEnd(LatticeNodePtr nodePtr) {
   ++currentEnding_;
 }
 
+void LatticeBoundary::removeStarts(const std::vector<bool> &removed,
+                                   size_t offset) {
+  auto &nodes = right_;
+  u32 kept = 0;
+  for (u32 i = 0; i < cfg_.beginNodes; ++i) {
+    if (removed[offset + i]) {
+      continue;
+    }
+    if (kept != i) {
+      nodes.nodeInfo_.at(kept) = nodes.nodeInfo_.at(i);
+      auto entries = nodes.entryDataStorage.row(kept);
+      util::copy_buffer(nodes.entryDataStorage.row(i), entries);
+      auto patterns = nodes.featurePatterns.row(kept);
+      util::copy_buffer(nodes.featurePatterns.row(i), patterns);
+    }
+    kept += 1;
+  }
+  if (kept == cfg_.beginNodes) {
+    return;
+  }
+  cfg_.beginNodes = kept;
+  nodes.nodeInfo_ = util::MutableArraySlice<NodeInfo>{nodes.nodeInfo_, 0, kept};
+  nodes.entryDataStorage = nodes.entryDataStorage.topRows(kept);
+  nodes.featurePatterns = nodes.featurePatterns.topRows(kept);
+  nodes.beam = nodes.beam.topRows(kept);
+  scores_.scores_ = util::ArraySlice<Score *>{scores_.scores_, 0, kept};
+}
+
+void LatticeBoundary::resetEnds(u32 numEnds) {
+  JPP_DCHECK_LE(numEnds, cfg_.endNodes);
+  cfg_.endNodes = numEnds;
+  left_.endingNodes_ =
+      util::MutableArraySlice<LatticeNodePtr>{left_.endingNodes_, 0, numEnds};
+  currentEnding_ = 0;
+  // score rows of nodes become shorter, they still fit into the allocation
+  scores_.numLeft_ = numEnds;
+  scores_.scoresPerItem_ = scores_.numBeam_ * numEnds * scores_.numScorers_;
+}
+
 LatticeBoundaryScores::LatticeBoundaryScores(util::memory::PoolAlloc *alloc,
                                              const LatticeConfig &lc,
                                              const LatticeBoundaryConfig &lbc)
@@ -100,9 +151,19 @@ LatticeLeftBoundary::LatticeLeftBoundary(util::memory::PoolAlloc *alloc,
                                          const LatticeConfig &lc,
                                          const LatticeBoundaryConfig &lbc) {
   endingNodes_ = alloc->allocateBuf<LatticeNodePtr>(lbc.endNodes);
-  if (lc.globalBeamSize > 0) {
-    globalBeam_ =
-        alloc->allocateBuf<const ConnectionBeamElement *>(lc.globalBeamSize);
+  globalBeamCapacity_ = 0;
+  resetGlobalBeam(alloc, lc.globalBeamSize);
+}
+
+void LatticeLeftBoundary::resetGlobalBeam(util::memory::PoolAlloc *alloc,
+                                          u32 size) {
+  if (size > globalBeamCapacity_) {
+    globalBeam_ = alloc->allocateBuf<const ConnectionBeamElement *>(size);
+    globalBeamCapacity_ = size;
+  } else {
+    // slices can not grow, make it from the whole buffer
+    globalBeam_ = util::MutableArraySlice<const ConnectionBeamElement *>{
+        globalBeam_.data(), size};
   }
 }
 
@@ -19,6 +19,7 @@ namespace analysis {
 class LatticeLeftBoundary {
   util::MutableArraySlice<LatticeNodePtr> endingNodes_;
   util::MutableArraySlice<const ConnectionBeamElement*> globalBeam_;
+  u32 globalBeamCapacity_;
   friend class LatticeBoundary;
 
  public:
@@ -39,6 +40,12 @@ class LatticeLeftBoundary {
     globalBeam_ = util::MutableArraySlice<const ConnectionBeamElement*>{
         globalBeam_, 0, size};
   }
+
+  /**
+   * Makes the global beam of the given size again,
+   * allocating it when it does not fit into the current one.
+   */
+  void resetGlobalBeam(util::memory::PoolAlloc* alloc, u32 size);
 };
 
 class LatticeRightBoundary {
@@ -99,6 +106,7 @@ class LatticeBoundaryScores final {
   u32 numScorers_;
 
   friend class NodeScores;
+  friend class LatticeBoundary;
 
  public:
   LatticeBoundaryScores(util::memory::PoolAlloc* alloc, const LatticeConfig& lc,
@@ -155,6 +163,21 @@ class LatticeBoundary {
   friend class Lattice;
 
   void addEnd(LatticeNodePtr nodePtr);
+
+  /**
+   * Removes starting nodes which are marked in the mask
+   * (starting from the offset), keeping the order of other nodes.
+   * Entry and pattern feature data of remaining nodes is moved,
+   * so this must be done before the nodes are scored.
+   * Memory of removed nodes is not reclaimed.
+   */
+  void removeStarts(const std::vector<bool>& removed, size_t offset);
+
+  /**
+   * Forgets ending nodes and shrinks their number,
+   * ends must be filled again after this.
+   */
+  void resetEnds(u32 numEnds);
 };
 
 class Lattice {
@@ -182,6 +205,15 @@ class Lattice {
   }
   void hintSize(u32 size);
   void reset();
+  /**
+   * Makes global beams of all boundaries match the current config.
+   * Needed when the config changes and the lattice is scored again.
+   */
+  void resetGlobalBeams();
+  /**
+   * Removes all boundaries starting from count
+   */
+  void truncate(u32 count);
   const LatticeConfig& config() { return lconf; }
   void updateConfig(const LatticeConfig& cfg) { lconf = cfg; }
   const u64* lastGbeamRaw() const { return lastGbeam_; }
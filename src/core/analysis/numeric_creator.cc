@@ -60,12 +60,22 @@ bool NumericUnkMaker::spawnNodes(const AnalysisInput &input,
   using dic::TraverseStatus;
   // Spawn the longest matting node
   auto &codepoints = input.codepoints();
+  auto maxLength = ctx->spanLimit(charClass_);
+  // end of the number which contains the current position
+  LatticePosition numberEnd = 0;
   for (LatticePosition i = 0; i < codepoints.size(); ++i) {
     auto trav = entries_.traversal();
     LatticePosition nextstep = i;
     TraverseStatus status = TraverseStatus::NoNode;
 
     auto length = FindLongestNumber(codepoints, i);  // returns character length
+    if (i >= numberEnd) {
+      numberEnd = i + length;
+    } else if (maxLength != 0 && length > maxLength) {
+      // a whole number is always a node, its suffixes are limited
+      ctx->recordLimitedSpans(1);
+      length = static_cast<LatticePosition>(maxLength);
+    }
     bool nonode = false;
     if (length > 0) {
       for (; nextstep < i + length; ++nextstep) {
@@ -18,7 +18,8 @@ class NumericTestEnv {
   StringField fld2;
 
  public:
-  NumericTestEnv(StringPiece csvData) {
+  NumericTestEnv(StringPiece csvData, i32 maxUnkLength = 0) {
+    tenv.aconf.unkLimits.maxLength = maxUnkLength;
     tenv.spec([](dsl::ModelSpecBuilder& specBldr) {
       auto& a = specBldr.field(1, "f1").strings().trieIndex();
       auto& b = specBldr.field(2, "f2").strings();
@@ -40,6 +41,8 @@ class NumericTestEnv {
     CHECK_OK(tenv.analyzer->makeUnkNodes1());
   }
 
+  const UnkSpanStats& stats() const { return tenv.analyzer->unkStats(); }
+
   size_t numNodeSeeds() const {
     return tenv.analyzer->latticeBuilder().seeds().size();
   }
@@ -283,3 +286,19 @@ TEST_CASE("emit sequence of numbers when dic has different tagged entry") {
   CHECK(env.contains("五十", 0, "l2", false));
   CHECK(env.numNodeSeeds() == 4);
 }
+
+TEST_CASE("unk span limits bound numeric nodes inside long numbers") {
+  NumericTestEnv env{"x,l1\nほげ,l2\n", 8};
+  std::string input;
+  for (int i = 0; i < 30; ++i) {
+    input += "１";
+  }
+  env.analyze(input);
+  CHECK(env.contains(input, 0, "l1"));
+  // "１" is 3 bytes in UTF-8
+  CHECK(env.contains(input.substr(0, 8 * 3), 1, "l1"));
+  CHECK_FALSE(env.contains(input.substr(0, 29 * 3), 1, "l1"));
+  CHECK(env.contains(input.substr(0, 8 * 3), 22, "l1"));
+  CHECK(env.numNodeSeeds() == 30);
+  CHECK(env.stats().limitedStarts == 21);
+}
@@ -239,6 +239,7 @@ std::pair<RnnNode*, RnnNode*> RnnIdContainer::addPrevChain(
     nodePtr->id = coord.rnnId;
     nodePtr->boundary = cptr->boundary;
     nodePtr->length = coord.length;
+    nodePtr->numPaths = 0;
     return std::make_pair(span.first, nodePtr);
   }
   return std::make_pair(prevPair.first->second, prevPair.first->second);
@@ -336,6 +337,7 @@ void RnnIdContainer::addBos() {
   bos0->boundary = 0;
   bos0->prev = nullptr;
   bos0->nextInBnd = nullptr;
+  bos0->numPaths = 0;
   auto bos1 = alloc_->allocate<RnnNode>();
   bos1->hash = 0xdeadbeef0000;
   bos1->id = 0;
@@ -343,6 +345,7 @@ void RnnIdContainer::addBos() {
   bos1->boundary = 1;
   bos1->nextInBnd = nullptr;
   bos1->prev = bos0;
+  bos1->numPaths = 0;
   boundaries_[1].node = bos1;
   boundaries_[1].nodeCnt = 1;
   RnnCoordinate bosCrd{1, 0, 0};
@@ -350,6 +353,54 @@ void RnnIdContainer::addBos() {
   nodeCache_[{1, 0}] = bosCrd;
 }
 
+void RnnIdContainer::markRescoredPath(const RnnScorePtr* eosScore) {
+  for (auto node = eosScore->rnn; node != nullptr; node = node->prev) {
+    node->numPaths += 1;
+  }
+}
+
+i32 RnnIdContainer::skipUnambiguous(i32 numRescored) {
+  i32 numSkipped = 0;
+  for (auto& bnd : boundaries_) {
+    RnnScorePtr* kept = nullptr;
+    i32 keptCnt = 0;
+    auto sc = bnd.scores;
+    while (sc != nullptr) {
+      auto next = sc->next;
+      auto numPaths = sc->rnn->numPaths;
+      if (numPaths == numRescored || numPaths == 0) {
+        sc->next = bnd.skipped;
+        bnd.skipped = sc;
+        numSkipped += 1;
+      } else {
+        sc->next = kept;
+        kept = sc;
+        keptCnt += 1;
+      }
+      sc = next;
+    }
+    bnd.scores = kept;
+    bnd.scoreCnt = keptCnt;
+
+    RnnNode* nodes = nullptr;
+    i32 nodeCnt = 0;
+    auto node = bnd.node;
+    while (node != nullptr) {
+      auto next = node->nextInBnd;
+      if (node->numPaths != 0) {
+        node->idx = nodeCnt;
+        node->nextInBnd = nodes;
+        nodes = node;
+        nodeCnt += 1;
+      }
+      node = next;
+    }
+    bnd.node = nodes;
+    bnd.nodeCnt = nodeCnt;
+  }
+  return numSkipped;
+}
+
 ConnectionPtr* RnnIdContainer::fakeConnection(
     const LatticeNodePtr& nodePtr, const ConnectionBeamElement* pElement,
     const BeamCandidate& candidate) {
@@ -108,6 +108,7 @@ struct RnnNode {
   RnnNode* prev;
   RnnNode* nextInBnd;
   u64 hash;
+  i32 numPaths;
 };
 
 struct RnnScorePtr {
@@ -119,6 +120,7 @@ struct RnnScorePtr {
 struct RnnBoundary {
   RnnNode* node = nullptr;
   RnnScorePtr* scores = nullptr;
+  RnnScorePtr* skipped = nullptr;
   i32 nodeCnt = 0;
   i32 scoreCnt = 0;
 };
@@ -152,6 +154,20 @@ class RnnIdContainer {
   RnnIdContainer(util::memory::PoolAlloc* alloc) noexcept : alloc_{alloc} {}
   RnnIdContainer(const RnnIdContainer&) = delete;
   void reset(u32 numBoundaries, u32 beamSize);
+  /**
+   * Marks a path which ends with the given EOS score for reranking.
+   */
+  void markRescoredPath(const RnnScorePtr* eosScore);
+  /**
+   * Moves scores of the nodes which do not need to be computed
+   * to the skipped lists of boundaries.
+   * Nodes which are shared by all marked paths add the same value
+   * to each of them so they do not need to be computed for reranking.
+   * Nodes which are not on any marked path are removed
+   * from the boundary node lists, their contexts are not computed.
+   * @return number of moved scores
+   */
+  i32 skipUnambiguous(i32 numRescored);
   const RnnBoundary& rnnBoundary(u32 bndIdx) const {
     JPP_DCHECK_IN(bndIdx, 0, boundaries_.size());
     return boundaries_[bndIdx];
@@ -14,13 +14,14 @@ bool RnnInferenceConfig::operator==(const RnnInferenceConfig &other) const {
   return nceBias == other.nceBias && unkConstantTerm == other.unkConstantTerm &&
          unkLengthPenalty == other.unkLengthPenalty &&
          perceptronWeight == other.perceptronWeight &&
-         rnnWeight == other.rnnWeight;
+         rnnWeight == other.rnnWeight &&
+         ambiguityMargin == other.ambiguityMargin;
 }
 
 bool RnnInferenceConfig::isDefault() const {
   return util::areAllDefault(nceBias, unkConstantTerm, unkLengthPenalty,
                              perceptronWeight, rnnWeight, eosSymbol, unkSymbol,
-                             rnnFields, fieldSeparator);
+                             rnnFields, fieldSeparator, ambiguityMargin);
 }
 
 std::ostream &operator<<(std::ostream &os, const RnnInferenceConfig &config) {
@@ -33,6 +34,7 @@ std::ostream &operator<<(std::ostream &os, const RnnInferenceConfig &config) {
      << "\nunkSymbol: " << config.unkSymbol
      << "\nrnnFields: " << VOut(config.rnnFields.value())
      << "\nfieldSeparator: " << config.fieldSeparator
+     << "\nambiguityMargin: " << config.ambiguityMargin
      << "\n~~~RNN CONFIG END~~~";
   return os;
 }
@@ -26,6 +26,11 @@ struct RnnInferenceConfig {
   util::Cfg<std::string> unkSymbol{"<unk>"};
   util::Cfg<std::vector<std::string>> rnnFields;
   util::Cfg<std::string> fieldSeparator{"_"};
+  // Rescore only EOS global beam candidates which are within this
+  // perceptron score margin of the best one, 0 rescores all of them.
+  // Other candidates stay in the beam after the rescored ones,
+  // ranked by their perceptron scores.
+  util::Cfg<float> ambiguityMargin = 0.0f;
 
   bool operator==(const RnnInferenceConfig &other) const;
   bool isDefault() const;
@@ -39,6 +44,7 @@ struct RnnInferenceConfig {
     unkSymbol.mergeWith(o.unkSymbol);
     rnnFields.mergeWith(o.rnnFields);
     fieldSeparator.mergeWith(o.fieldSeparator);
+    ambiguityMargin.mergeWith(o.ambiguityMargin);
   }
 
   friend std::ostream &operator<<(std::ostream &os,
@@ -3,6 +3,7 @@
 //
 
 #include "rnn_scorer_gbeam.h"
+#include <limits>
 #include "rnn/mikolov_rnn.h"
 #include "rnn_id_resolver.h"
 #include "util/logging.hpp"
@@ -235,8 +236,7 @@ struct GbeamRnnState {
       float score;
       auto rnnId = sc->rnn->id;
       if (rnnId == shared->resolver.unkId()) {
-        auto& cfg = shared->config;
-        score = cfg.unkConstantTerm + cfg.unkLengthPenalty * sc->rnn->length;
+        score = unkScore(sc->rnn);
       } else {
         score = slice.at(scoreIdx);
       }
@@ -246,9 +246,78 @@ struct GbeamRnnState {
     JPP_DCHECK_EQ(scoreIdx, rbnd.scoreCnt);
   }
 
+  float unkScore(const rnn::RnnNode* node) const {
+    auto& cfg = shared->config;
+    return cfg.unkConstantTerm + cfg.unkLengthPenalty * node->length;
+  }
+
+  float prefixScore(const ConnectionPtr* ptr) const {
+    float result = 0;
+    for (auto p = ptr->previous; p->boundary >= 2; p = p->previous) {
+      result += lat->boundary(p->boundary)->scores()->forPtr(*p).at(scorerIdx);
+    }
+    return result;
+  }
+
+  void copySkippedScores(const rnn::RnnBoundary& rbnd, u32 bndIdx) {
+    auto scoreStorage = lat->boundary(bndIdx)->scores();
+    for (auto sc = rbnd.skipped; sc != nullptr; sc = sc->next) {
+      auto ptr = sc->latPtr;
+      auto nodeScores = scoreStorage->nodeScores(ptr->right);
+      // common nodes of rescored paths do not change their ranking,
+      // paths which are not rescored have zero RNN score up to EOS
+      float score = 0;
+      auto prev = sc->rnn->prev;
+      if (sc->rnn->numPaths == 0 && prev != nullptr && prev->numPaths != 0) {
+        // the path leaves rescored ones here
+        score = -prefixScore(ptr);
+      }
+      nodeScores.beamLeft(ptr->beam, ptr->left).at(scorerIdx) = score;
+    }
+  }
+
+  /**
+   * Paths which were not rescored get the lowest RNN score
+   * of the rescored ones at EOS.
+   * They are ranked by their perceptron scores among themselves
+   * and after the rescored paths, which have better perceptron scores.
+   */
+  void shiftSkippedPaths(u32 eosIdx) {
+    auto& eos = container.rnnBoundary(eosIdx);
+    auto eosScores = lat->boundary(eosIdx)->scores()->nodeScores(0);
+    auto scoreOf = [&](const rnn::RnnScorePtr* sc) -> float& {
+      auto ptr = sc->latPtr;
+      return eosScores.beamLeft(ptr->beam, ptr->left).at(scorerIdx);
+    };
+
+    float lowest = 0;
+    bool hasRescored = false;
+    auto collect = [&](const rnn::RnnScorePtr* list) {
+      for (auto sc = list; sc != nullptr; sc = sc->next) {
+        if (sc->rnn->numPaths != 0) {
+          float score = prefixScore(sc->latPtr) + scoreOf(sc);
+          lowest = hasRescored ? std::min(lowest, score) : score;
+          hasRescored = true;
+        }
+      }
+    };
+    collect(eos.scores);
+    collect(eos.skipped);
+    if (!hasRescored) {
+      return;
+    }
+
+    for (auto sc = eos.skipped; sc != nullptr; sc = sc->next) {
+      if (sc->rnn->numPaths == 0) {
+        scoreOf(sc) += lowest;
+      }
+    }
+  }
+
   Status scoreBoundary(u32 bndIdx) {
     auto& rbnd = container.rnnBoundary(bndIdx);
-    if (rbnd.nodeCnt == 0) {
+    copySkippedScores(rbnd, bndIdx);
+    if (rbnd.nodeCnt == 0 || rbnd.scoreCnt == 0) {
       return Status::Ok();
     }
 
@@ -266,6 +335,41 @@ struct GbeamRnnState {
     return Status::Ok();
   }
 
+  /**
+   * Marks EOS global beam candidates which have perceptron path score
+   * within the margin of the best one for rescoring.
+   * Other candidates stay in the beam, but only nodes of the marked
+   * paths are computed by the RNN.
+   * @return number of marked candidates
+   */
+  i32 selectAmbiguousPaths(float margin) {
+    auto eosIdx = lat->createdBoundaryCount() - 1;
+    auto& eos = container.rnnBoundary(eosIdx);
+    auto localScores = lat->boundary(eosIdx)->scores()->nodeScores(0);
+    auto pathScore = [&](const rnn::RnnScorePtr* sc) {
+      auto ptr = sc->latPtr;
+      // underlying object IS ConnectionBeamElement
+      auto prev = reinterpret_cast<const ConnectionBeamElement*>(ptr->previous);
+      return prev->totalScore +
+             localScores.beamLeft(ptr->beam, ptr->left).at(0);
+    };
+
+    Score best = std::numeric_limits<Score>::lowest();
+    for (auto sc = eos.scores; sc != nullptr; sc = sc->next) {
+      best = std::max(best, pathScore(sc));
+    }
+
+    i32 marked = 0;
+    for (auto sc = eos.scores; sc != nullptr; sc = sc->next) {
+      if (pathScore(sc) >= best - margin) {
+        container.markRescoredPath(sc);
+        marked += 1;
+      }
+    }
+    container.skipUnambiguous(marked);
+    return marked;
+  }
+
   Status scoreLattice(Lattice* l, const ExtraNodesContext* xtra) {
     this->lat = l;
     this->xtra = xtra;
@@ -273,14 +377,27 @@ struct GbeamRnnState {
     alloc->reset();
     auto numBnd = l->createdBoundaryCount() - 1;
     allocateState();
+
     JPP_RETURN_IF_ERROR(
         shared->resolver.resolveIdsAtGbeam(&container, l, xtra));
-    for (u32 bndIdx = 2; bndIdx < numBnd; ++bndIdx) {
-      JPP_RIE_MSG(computeContext(bndIdx), "bnd=" << bndIdx);
+    float margin = shared->config.ambiguityMargin;
+    bool ambiguous = true;
+    if (margin > 0) {
+      // only spans where the rescored paths diverge are computed,
+      // the common prefix keeps perceptron-only scores
+      ambiguous = selectAmbiguousPaths(margin) > 1;
+    }
+    if (ambiguous) {
+      for (u32 bndIdx = 2; bndIdx < numBnd; ++bndIdx) {
+        JPP_RIE_MSG(computeContext(bndIdx), "bnd=" << bndIdx);
+      }
     }
     for (u32 bndIdx = 2; bndIdx <= numBnd; ++bndIdx) {
       JPP_RIE_MSG(scoreBoundary(bndIdx), "bnd=" << bndIdx);
     }
+    if (margin > 0) {
+      shiftSkippedPaths(numBnd);
+    }
     return Status::Ok();
   }
 };
@@ -3,6 +3,7 @@
 //
 
 #include "rnn_scorer.h"
+#include <algorithm>
 #include <fstream>
 #include "core/env.h"
 #include "core/impl/graphviz_format.h"
@@ -241,3 +242,115 @@ TEST_CASE("RNN holder serializes and deserializes") {
   a::RnnScorerGbeamFactory rnnHolder2;
   REQUIRE_OK(rnnHolder2.load(modelInfo));
 }
+
+namespace {
+
+struct RankedPath {
+  std::vector<u32> nodes;
+  float score;
+};
+
+std::vector<RankedPath> eosBeamPaths(const a::Lattice* lattice) {
+  auto eos = lattice->boundary(lattice->createdBoundaryCount() - 1);
+  std::vector<RankedPath> result;
+  for (auto& el : eos->starts()->beamData()) {
+    if (a::EntryBeam::isFake(el)) {
+      break;
+    }
+    RankedPath path;
+    path.score = el.totalScore;
+    for (auto ptr = el.ptr.previous; ptr->boundary >= 2; ptr = ptr->previous) {
+      path.nodes.push_back((static_cast<u32>(ptr->boundary) << 16) |
+                           ptr->right);
+    }
+    result.push_back(path);
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST_CASE("RNN rescores only ambiguous paths with a margin") {
+  RnnScorerEnv env{
+      "newsan,12\nn,14\newsan,13\nnew,1\nnews,2\nsan,3\na,4\nan,5\n"
+      "apple,6\news,7\nne,20\npple,8\nwsa,9\np,10\nle,11\n"};
+  core::analysis::rnn::RnnInferenceConfig ric;
+  ric.rnnFields = {"a"};
+  ric.fieldSeparator = ",";
+
+  auto analyze = [&](a::RnnScorerGbeamFactory* holder) {
+    a::ScorerDef scorerDef{};
+    scorerDef.scoreWeights.push_back(1.0f);
+    scorerDef.feature = &env.perceptron;
+    if (holder != nullptr) {
+      scorerDef.scoreWeights.push_back(1.0f);
+      scorerDef.others.push_back(holder);
+    }
+    auto scoreCfg = env.scoreCfg;
+    scoreCfg.numScorers = static_cast<i32>(scorerDef.scoreWeights.size());
+    a::AnalyzerImpl impl{env.jppEnv.coreHolder(), scoreCfg, env.anaCfg};
+    REQUIRE_OK(impl.initScorers(scorerDef));
+    REQUIRE(impl.resetForInput("newsanapple"));
+    REQUIRE_OK(impl.prepareNodeSeeds());
+    REQUIRE_OK(impl.buildLattice());
+    REQUIRE_OK(impl.bootstrapAnalysis());
+    REQUIRE_OK(impl.computeScores(&scorerDef));
+    auto paths = eosBeamPaths(impl.lattice());
+    REQUIRE(paths.size() >= 2);
+    for (auto& p : paths) {
+      CHECK(!std::isnan(p.score));
+    }
+    return paths;
+  };
+  auto analyzeWithMargin = [&](float margin) {
+    ric.ambiguityMargin = margin;
+    a::RnnScorerGbeamFactory holder;
+    REQUIRE_OK(holder.make("rnn/testlm", env.jppEnv.coreHolder()->dic(), ric));
+    return analyze(&holder);
+  };
+
+  auto perceptron = analyze(nullptr);
+  auto full = analyzeWithMargin(0);
+  auto wide = analyzeWithMargin(1e6f);
+  auto narrow = analyzeWithMargin(1e-6f);
+  CHECK(wide.size() == full.size());
+  CHECK(wide[0].nodes == full[0].nodes);
+  // candidates which are not rescored stay in the beam
+  CHECK(narrow.size() == full.size());
+  CHECK(narrow[0].nodes == perceptron[0].nodes);
+  // and they are ranked by perceptron scores only
+  REQUIRE(narrow.size() == perceptron.size());
+  for (size_t i = 0; i < narrow.size(); ++i) {
+    CHECK(narrow[i].nodes == perceptron[i].nodes);
+  }
+
+  // rescore all paths up to the winner of full rescoring
+  float gap = perceptron[0].score - perceptron[1].score;
+  for (auto& p : perceptron) {
+    if (p.nodes == full[0].nodes) {
+      gap = std::max(gap, perceptron[0].score - p.score);
+    }
+  }
+  auto ambiguous = analyzeWithMargin(gap + 1e-3f);
+  CHECK(ambiguous.size() == full.size());
+  CHECK(ambiguous[0].nodes == full[0].nodes);
+
+  // paths out of the margin keep their perceptron order
+  auto threshold = perceptron[0].score - (gap + 1e-3f);
+  std::vector<std::vector<u32>> skipped;
+  for (auto& p : perceptron) {
+    if (p.score < threshold) {
+      skipped.push_back(p.nodes);
+    }
+  }
+  std::vector<std::vector<u32>> skippedOrder;
+  for (auto& p : ambiguous) {
+    if (std::find(skipped.begin(), skipped.end(), p.nodes) != skipped.end()) {
+      skippedOrder.push_back(p.nodes);
+    } else {
+      // and go after the rescored ones
+      CHECK(skippedOrder.empty());
+    }
+  }
+  CHECK(skippedOrder == skipped);
+}
@@ -42,12 +42,14 @@ ScoreProcessor::ScoreProcessor(AnalyzerImpl *analyzer)
   auto &lcfg = lattice_->config();
   beamCandidates_ =
       alloc->allocateBuf<BeamCandidate>(maxEnds * lcfg.beamSize, 64);
+  fullBeamSize_ = lcfg.beamSize;
 
   analyzer->core().features().ngramPartial->allocateBuffers(&featureBuffer_,
                                                             runStats_, alloc);
   util::fill(featureBuffer_.valueBuffer1, 0);
 
   globalBeamSize_ = analyzer->cfg().globalBeamSize;
+  rightGbeamSize_ = analyzer->cfg().rightGbeamSize;
   if (globalBeamSize_ > 0) {
     t1PtrData_.reserve(globalBeamSize_);
     globalBeam_ =
@@ -60,7 +62,9 @@ ScoreProcessor::ScoreProcessor(AnalyzerImpl *analyzer)
         alloc->allocate2d<u64>(globalBeamSize_, lcfg.numFeaturePatterns);
     gbeamScoreBuf_ = alloc->allocateBuf<Score>(globalBeamSize_);
     beamIdxBuffer_ = alloc->allocateBuf<u32>(globalBeamSize_);
+    gbeamCapacity_ = globalBeamSize_;
     if (cfg_->rightGbeamCheck > 0) {
+      rightCheckCapacity_ = cfg_->rightGbeamCheck;
       t0prescores_ =
           alloc->allocate2d<Score>(cfg_->rightGbeamCheck, maxNodes, 64);
       t0cutoffBuffer_ = alloc->allocateBuf<Score>(maxNodes);
@@ -73,6 +77,17 @@ ScoreProcessor::ScoreProcessor(AnalyzerImpl *analyzer)
   plugin_ = analyzer->plugin();
 }
 
+bool ScoreProcessor::updateGlobalBeam() {
+  auto gbeam = cfg_->globalBeamSize;
+  if (gbeam > gbeamCapacity_ ||
+      (gbeam > 0 && cfg_->rightGbeamCheck > rightCheckCapacity_)) {
+    return false;
+  }
+  globalBeamSize_ = gbeam;
+  rightGbeamSize_ = cfg_->rightGbeamSize;
+  return true;
+}
+
 void ScoreProcessor::copyFeatureScores(i32 left, i32 beam,
                                        LatticeBoundaryScores *bndconn) {
   bndconn->importBeamScore(left, 0, beam, scores_.bufferT2());
@@ -192,6 +207,17 @@ u32 fillBeamCandidates(Lattice *l, LatticeBoundary *bnd, NodeScores scores,
 
 util::ArraySlice<BeamCandidate> processBeamCandidates(
     util::MutableArraySlice<BeamCandidate> candidates, u32 maxBeam) {
+  if (maxBeam > 0 && maxBeam <= MaxSmallTopK) {
+    auto data = candidates.data();
+    u64 keys[MaxSmallTopK];
+    auto count = smallTopK(static_cast<u32>(candidates.size()), maxBeam,
+                           [data](u32 i) { return data[i].data_; }, keys);
+    for (u32 i = 0; i < count; ++i) {
+      data[i].data_ = keys[i];
+    }
+    return util::ArraySlice<BeamCandidate>{candidates, 0, count};
+  }
+
   auto comp = std::greater<>();
   if (candidates.size() > maxBeam * 2) {
     u32 maxElems = maxBeam * 2;
@@ -207,6 +233,19 @@ util::ArraySlice<BeamCandidate> processBeamCandidates(
 
 }  // namespace
 
+util::ArraySlice<BeamCandidate> cutByScoreMargin(
+    util::ArraySlice<BeamCandidate> sorted, Score margin, u32 minSize) {
+  if (sorted.size() <= minSize) {
+    return sorted;
+  }
+  auto threshold = sorted.at(0).score() - margin;
+  auto end = std::partition_point(
+      sorted.begin() + minSize, sorted.end(),
+      [threshold](const BeamCandidate &c) { return c.score() >= threshold; });
+  auto size = static_cast<size_t>(std::distance(sorted.begin(), end));
+  return util::ArraySlice<BeamCandidate>{sorted, 0, size};
+}
+
 void ScoreProcessor::makeBeams(i32 boundary, LatticeBoundary *bnd,
                                const ScorerDef *sc) {
   auto myNodes = bnd->localNodeCount();
@@ -220,7 +259,7 @@ void ScoreProcessor::makeBeams(i32 boundary, LatticeBoundary *bnd,
     auto cnt =
         fillBeamCandidates(lattice_, bnd, scores->nodeScores(node), sc, cands);
     util::MutableArraySlice<BeamCandidate> candSlice{cands, 0, cnt};
-    auto res = processBeamCandidates(candSlice, maxBeam);
+    auto res = processBeamCandidates(candSlice, fullBeamSize_);
 
     auto beamElems = beamData.row(node);
     // fill the beam
@@ -265,6 +304,10 @@ util::ArraySlice<BeamCandidate> ScoreProcessor::makeGlobalBeam(i32 bndIdx,
   }
   util::MutableArraySlice<BeamCandidate> slice{globalBeam_, 0, count};
   auto res = processBeamCandidates(slice, maxElems);
+  if (cfg_->globalBeamMargin > 0) {
+    res = cutByScoreMargin(res, cfg_->globalBeamMargin,
+                           static_cast<u32>(cfg_->globalBeamMinSize));
+  }
   // std::cerr << maxElems << ":" << VOut(slice) << "\n";
   auto gbptrs = ends->globalBeam();
   if (gbptrs.size() > 0) {
@@ -284,6 +327,26 @@ util::ArraySlice<BeamCandidate> ScoreProcessor::makeGlobalBeam(i32 bndIdx,
 void ScoreProcessor::computeGbeamScores(i32 bndIdx,
                                         util::ArraySlice<BeamCandidate> gbeam,
                                         FeatureScorer *features) {
+  auto beamSize = lattice_->config().beamSize;
+  auto rightCheck = cfg_->rightGbeamCheck;
+  // specializations for the commonly used configurations
+  if (beamSize == 5 && rightCheck == 1) {
+    computeGbeamScoresImpl<5, 1>(bndIdx, gbeam, features);
+  } else if (beamSize == 5) {
+    computeGbeamScoresImpl<5, 0>(bndIdx, gbeam, features);
+  } else if (beamSize == 3 && rightCheck == 1) {
+    computeGbeamScoresImpl<3, 1>(bndIdx, gbeam, features);
+  } else if (beamSize == 3) {
+    computeGbeamScoresImpl<3, 0>(bndIdx, gbeam, features);
+  } else {
+    computeGbeamScoresImpl<0, 0>(bndIdx, gbeam, features);
+  }
+}
+
+template <u32 BeamSize, u32 RightCheck>
+void ScoreProcessor::computeGbeamScoresImpl(
+    i32 bndIdx, util::ArraySlice<BeamCandidate> gbeam,
+    FeatureScorer *features) {
   auto bnd = lattice_->boundary(bndIdx);
   auto t1Ptrs = dedupT1(bndIdx, gbeam);
   util::Sliceable<u64> t1data = gatherT1();
@@ -293,13 +356,23 @@ void ScoreProcessor::computeGbeamScores(i32 bndIdx,
   auto t0data = right->patternFeatureData();
   util::MutableArraySlice<Score> result{gbeamScoreBuf_, 0, gbeam.size()};
 
-  if (cfg_->rightGbeamCheck > 0) {
+  auto makeBeam = [&](i32 t0idx, util::ArraySlice<BeamCandidate> beam) {
+    if (BeamSize == 0) {
+      makeT0Beam(bndIdx, t0idx, beam, result);
+    } else {
+      makeT0BeamStatic<BeamSize>(bndIdx, t0idx, beam, result);
+    }
+  };
+
+  auto rightCheck =
+      RightCheck == 0 ? cfg_->rightGbeamCheck : static_cast<i32>(RightCheck);
+  if (rightCheck > 0) {
     // we cut off right elements as well
 
-    auto size = static_cast<size_t>(cfg_->rightGbeamCheck);
+    auto size = static_cast<size_t>(rightCheck);
     auto fullBeamApplySize =
         std::min<size_t>({size, bnd->localNodeCount(), gbeam.size()});
-    auto toKeep = std::min<size_t>(static_cast<u32>(cfg_->rightGbeamSize),
+    auto toKeep = std::min<size_t>(static_cast<u32>(rightGbeamSize_),
                                    bnd->localNodeCount());
     size_t remainingItems =
         std::max<size_t>(gbeam.size() - fullBeamApplySize, 0);
@@ -314,16 +387,31 @@ void ScoreProcessor::computeGbeamScores(i32 bndIdx,
 
     computeT0Prescores(gbeam, features);
     applyPluginToPrescores(bndIdx, gbeamHead);
-    makeT0cutoffBeam(static_cast<u32>(fullBeamApplySize), toKeep);
+    makeT0cutoffBeamImpl<RightCheck>(static_cast<u32>(fullBeamApplySize),
+                                     toKeep);
+
+    auto copyPrescores = [&](u32 t0idx) {
+      if (RightCheck == 0) {
+        for (int i = 0; i < fullBeamApplySize; ++i) {
+          result.at(i) = t0prescores_.row(i).at(t0idx);
+        }
+      } else {
+        // fullBeamApplySize <= RightCheck
+        auto dst = result.data();
+        for (u32 i = 0; i < RightCheck; ++i) {
+          if (i < fullBeamApplySize) {
+            dst[i] = t0prescores_.row(i).data()[t0idx];
+          }
+        }
+      }
+    };
 
     auto t0pos = 0;
     // first, we process elements which require feature/score computation
     for (; t0pos < toKeep; ++t0pos) {
       auto t0idx = t0cutoffIdxBuffer_.at(t0pos);
       auto t0 = t0data.row(t0idx);
-      for (int i = 0; i < fullBeamApplySize; ++i) {
-        result.at(i) = t0prescores_.row(i).at(t0idx);
-      }
+      copyPrescores(t0idx);
       copyT0Scores(bndIdx, t0idx, gbeamHead, result, 0);
       if (t1PtrTail.size() > 0) {
         auto t0Score = scores_.bufferT0().at(t0idx);
@@ -332,17 +420,15 @@ void ScoreProcessor::computeGbeamScores(i32 bndIdx,
         applyPluginToGbeam(bndIdx, t0idx, gbeamTail, resultTail);
         copyT0Scores(bndIdx, t0idx, gbeamTail, resultTail, t0Score);
       }
-      makeT0Beam(bndIdx, t0idx, gbeam, result);
+      makeBeam(t0idx, gbeam);
     }
 
     // then we form beams for the remaining items
     for (; t0pos < t0data.numRows(); ++t0pos) {
       auto t0idx = t0cutoffIdxBuffer_.at(t0pos);
-      for (int i = 0; i < fullBeamApplySize; ++i) {
-        result.at(i) = t0prescores_.row(i).at(t0idx);
-      }
+      copyPrescores(t0idx);
       copyT0Scores(bndIdx, t0idx, gbeamHead, result, 0);
-      makeT0Beam(bndIdx, t0idx, gbeamHead, result);
+      makeBeam(t0idx, gbeamHead);
     }
 
   } else {
@@ -355,7 +441,7 @@ void ScoreProcessor::computeGbeamScores(i32 bndIdx,
       auto t0Score = scores_.bufferT0().at(t0idx);
       applyPluginToGbeam(bndIdx, t0idx, gbeam, result);
       copyT0Scores(bndIdx, t0idx, gbeam, result, t0Score);
-      makeT0Beam(bndIdx, t0idx, gbeam, result);
+      makeBeam(t0idx, gbeam);
     }
   }
 }
@@ -428,14 +514,27 @@ void ScoreProcessor::makeT0Beam(i32 bndIdx, i32 t0idx,
                                 util::MutableArraySlice<Score> scores) {
   auto maxBeam = lattice_->config().beamSize;
   util::MutableArraySlice<u32> idxes{beamIdxBuffer_, 0, gbeam.size()};
-  std::iota(idxes.begin(), idxes.end(), 0);
-  auto comp = [&scores](u32 i1, u32 i2) { return scores[i1] > scores[i2]; };
   auto itr = idxes.end();
-  auto partitionBoundary = maxBeam * 4 / 3;
-  if (idxes.size() > partitionBoundary) {
-    itr = util::partition(idxes.begin(), itr, comp, maxBeam, partitionBoundary);
+  if (maxBeam <= MaxSmallTopK) {
+    auto scoreData = scores.data();
+    u64 keys[MaxSmallTopK];
+    auto count = smallTopK(
+        static_cast<u32>(gbeam.size()), maxBeam,
+        [scoreData](u32 i) { return scoreIndexKey(scoreData[i], i); }, keys);
+    for (u32 i = 0; i < count; ++i) {
+      idxes[i] = indexOfScoreKey(keys[i]);
+    }
+    itr = idxes.begin() + count;
+  } else {
+    std::iota(idxes.begin(), idxes.end(), 0);
+    auto comp = [&scores](u32 i1, u32 i2) { return scores[i1] > scores[i2]; };
+    auto partitionBoundary = maxBeam * 4 / 3;
+    if (idxes.size() > partitionBoundary) {
+      itr = util::partition(idxes.begin(), itr, comp, maxBeam,
+                            partitionBoundary);
+    }
+    std::sort(idxes.begin(), itr, comp);
   }
-  std::sort(idxes.begin(), itr, comp);
 
   auto start = lattice_->boundary(bndIdx)->starts();
   auto beam = start->beamData().row(t0idx);
@@ -468,7 +567,43 @@ void ScoreProcessor::makeT0Beam(i32 bndIdx, i32 t0idx,
   }
 }
 
+template <u32 BeamSize>
+void ScoreProcessor::makeT0BeamStatic(i32 bndIdx, i32 t0idx,
+                                      util::ArraySlice<BeamCandidate> gbeam,
+                                      util::MutableArraySlice<Score> scores) {
+  JPP_DCHECK_EQ(lattice_->config().beamSize, BeamSize);
+  JPP_DCHECK_LE(gbeam.size(), scores.size());
+  u32 idxes[BeamSize];
+  auto count = topKIndices<BeamSize>(scores.data(),
+                                     static_cast<u32>(gbeam.size()), idxes);
+
+  auto start = lattice_->boundary(bndIdx)->starts();
+  auto beam = start->beamData().row(t0idx).data();
+  const auto ends = lattice_->boundary(bndIdx)->ends();
+  auto gbeamNodes = ends->globalBeam().data();
+  auto gbeamData = gbeam.data();
+  auto scoreData = scores.data();
+
+  for (u32 i = 0; i < count; ++i) {
+    auto idx = idxes[i];
+    auto &prev = gbeamData[idx];
+    ConnectionPtr cp{static_cast<u16>(bndIdx), prev.left(),
+                     static_cast<u16>(t0idx), prev.beam(),
+                     &gbeamNodes[idx]->ptr};
+    beam[i] = ConnectionBeamElement{cp, scoreData[idx]};
+  }
+
+  for (u32 i = count; i < BeamSize; ++i) {
+    std::memset(&beam[i], 0xff, sizeof(ConnectionBeamElement));
+  }
+}
+
 void ScoreProcessor::makeT0cutoffBeam(u32 fullAnalysis, u32 rightBeam) {
+  makeT0cutoffBeamImpl<0>(fullAnalysis, rightBeam);
+}
+
+template <u32 RightCheck>
+void ScoreProcessor::makeT0cutoffBeamImpl(u32 fullAnalysis, u32 rightBeam) {
   auto slice = t0prescores_.topRows(fullAnalysis);
   auto curElemCnt = featureBuffer_.currentElems;
 
@@ -480,15 +615,50 @@ void ScoreProcessor::makeT0cutoffBeam(u32 fullAnalysis, u32 rightBeam) {
   }
 
   util::MutableArraySlice<Score> cutoffScores{t0cutoffBuffer_, 0, curElemCnt};
-  for (int i = 0; i < curElemCnt; ++i) {
-    Score s = 0;
-    for (int j = 0; j < fullAnalysis; ++j) {
-      s += slice.row(j).at(i);
+  if (RightCheck == 1) {
+    // single row, it is already the sum
+    JPP_DCHECK_LE(fullAnalysis, 1);
+    if (fullAnalysis == 1) {
+      std::copy_n(slice.row(0).data(), curElemCnt, cutoffScores.data());
+    } else {
+      std::fill_n(cutoffScores.data(), curElemCnt, 0);
+    }
+  } else {
+    for (int i = 0; i < curElemCnt; ++i) {
+      Score s = 0;
+      for (int j = 0; j < fullAnalysis; ++j) {
+        s += slice.row(j).at(i);
+      }
+      cutoffScores.at(i) = s;
     }
-    cutoffScores.at(i) = s;
   }
-  auto comp = [&](u32 a, u32 b) {
-    return cutoffScores.at(a) > cutoffScores.at(b);
+  auto scoreData = cutoffScores.data();
+  if (rightBeam > 0 && rightBeam <= MaxSmallTopK) {
+    // best elements first, then the rest in the original order
+    auto keyOf = [scoreData](u32 i) { return scoreIndexKey(scoreData[i], i); };
+    u64 keys[MaxSmallTopK];
+    auto count = smallTopK(curElemCnt, rightBeam, keyOf, keys);
+    // curElemCnt > rightBeam > 0 here, so there is at least one key
+    JPP_DCHECK_GT(count, 0);
+    if (JPP_UNLIKELY(count == 0)) {
+      return;
+    }
+    auto idxData = idxBuf.data();
+    for (u32 i = 0; i < count; ++i) {
+      idxData[i] = indexOfScoreKey(keys[i]);
+    }
+    auto threshold = keys[count - 1];
+    for (u32 i = 0; i < curElemCnt; ++i) {
+      if (keyOf(i) < threshold) {
+        idxData[count] = i;
+        ++count;
+      }
+    }
+    return;
+  }
+
+  auto comp = [scoreData](u32 a, u32 b) {
+    return scoreData[a] > scoreData[b];
   };
   std::nth_element(idxBuf.begin(), idxBuf.begin() + rightBeam, idxBuf.end(),
                    comp);
@@ -6,6 +6,7 @@
 #define JUMANPP_SCORE_PROCESSOR_H
 
 #include <util/flatmap.h>
+#include "core/analysis/beam_topk.h"
 #include "core/analysis/lattice_config.h"
 #include "core/analysis/ngram_computations.h"
 #include "core/analysis/score_api.h"
@@ -87,11 +88,7 @@ struct BeamCandidate {
       : data_{pack(score, left, beam)} {}
 
   Score score() const noexcept {
-    u32 value = static_cast<u32>(data_ >> 32);
-    value = ((value & 0x8000'0000) == 0) ? ~value : value ^ 0x8000'0000;
-    float result;
-    std::memcpy(&result, &value, sizeof(float));
-    return result;
+    return scoreFromOrderedBits(static_cast<u32>(data_ >> 32));
   }
 
   u16 left() const noexcept { return static_cast<u16>(data_ >> 16); }
@@ -107,15 +104,20 @@ struct BeamCandidate {
   }
 
   static u64 pack(Score score, u16 left, u16 beam) noexcept {
-    u32 value;
-    std::memcpy(&value, &score, sizeof(float));
-    value = ((value & 0x8000'0000) != 0) ? ~value : value ^ 0x8000'0000;
+    auto value = orderedScoreBits(score);
     return (static_cast<u64>(value) << 32) | (left << 16) | beam;
   }
 };
 
 std::ostream& operator<<(std::ostream& os, BeamCandidate bc);
 
+/**
+ * Cuts sorted (best first) beam candidates which are further than margin
+ * from the best one, keeping at least minSize of them.
+ */
+util::ArraySlice<BeamCandidate> cutByScoreMargin(
+    util::ArraySlice<BeamCandidate> sorted, Score margin, u32 minSize);
+
 struct ScoreProcessor {
   i32 beamSize_ = 0;
   util::ArraySlice<ConnectionBeamElement> beamPtrs_;
@@ -131,6 +133,13 @@ struct ScoreProcessor {
 
   const AnalyzerConfig* cfg_;
   i32 globalBeamSize_;
+  i32 rightGbeamSize_;
+  // beams of the full analysis are cut to this size,
+  // it is smaller than the lattice one when the analysis is degraded
+  u32 fullBeamSize_;
+  // global beam buffers were allocated for these sizes
+  i32 gbeamCapacity_ = 0;
+  i32 rightCheckCapacity_ = 0;
   util::MutableArraySlice<BeamCandidate> globalBeam_;
   util::FlatMap<LatticeNodePtr, u32> t1PtrData_;
   util::MutableArraySlice<u32> t1positions_;
@@ -149,6 +158,13 @@ struct ScoreProcessor {
 
   i32 activeBeamSize() const { return beamSize_; }
 
+  /**
+   * Switches to the current global beam config of the analyzer.
+   * @return false if buffers are too small for it
+   * and a new processor must be made
+   */
+  bool updateGlobalBeam();
+
   void resolveBeamAt(i32 boundary, i32 position);
   void startBoundary(u32 currentNodes);
   void applyT0(i32 boundary, FeatureScorer* features);
@@ -165,6 +181,14 @@ struct ScoreProcessor {
   void computeGbeamScores(i32 bndIdx, util::ArraySlice<BeamCandidate> gbeam,
                           FeatureScorer* features);
 
+  // Global beam scoring loop, specialized for the beam size and the
+  // right check size. Zero template arguments mean that the value is
+  // taken from the runtime configuration.
+  template <u32 BeamSize, u32 RightCheck>
+  void computeGbeamScoresImpl(i32 bndIdx,
+                              util::ArraySlice<BeamCandidate> gbeam,
+                              FeatureScorer* features);
+
   util::ArraySlice<u32> dedupT1(i32 bndIdx,
                                 util::ArraySlice<BeamCandidate> gbeam);
   util::Sliceable<u64> gatherT1();
@@ -175,10 +199,16 @@ struct ScoreProcessor {
                     util::MutableArraySlice<Score> scores, Score t0Score);
   void makeT0Beam(i32 bndIdx, i32 t0idx, util::ArraySlice<BeamCandidate> gbeam,
                   util::MutableArraySlice<Score> scores);
+  template <u32 BeamSize>
+  void makeT0BeamStatic(i32 bndIdx, i32 t0idx,
+                        util::ArraySlice<BeamCandidate> gbeam,
+                        util::MutableArraySlice<Score> scores);
 
   void computeT0Prescores(util::ArraySlice<BeamCandidate> gbeam,
                           FeatureScorer* scorer);
   void makeT0cutoffBeam(u32 fullAnalysis, u32 rightBeam);
+  template <u32 RightCheck>
+  void makeT0cutoffBeamImpl(u32 fullAnalysis, u32 rightBeam);
   bool patternIsStatic() const { return patternStatic_ != nullptr; }
   void computeUniOnlyPatterns(i32 bndIdx,
                               features::impl::PrimitiveFeatureContext* pfc);
@@ -3,6 +3,7 @@
 //
 
 #include "score_processor.h"
+#include <random>
 #include "testing/standalone_test.h"
 
 using namespace jumanpp::core::analysis;
@@ -110,4 +111,73 @@ TEST_CASE("beam candidates are compared correctly by coordinates") {
   CHECK(bc3 > bc1);
   CHECK(bc3 > bc2);
   CHECK(bc3 < bc4);
-}
\ No newline at end of file
+}
+
+TEST_CASE("score margin cuts beam candidates") {
+  std::vector<BeamCandidate> cands{{2.0f, 0, 0}, {1.5f, 1, 0}, {1.0f, 0, 1},
+                                   {0.2f, 2, 0}, {-1.0f, 1, 1}};
+  CHECK(cutByScoreMargin(cands, 0.6f, 1).size() == 2);
+  CHECK(cutByScoreMargin(cands, 1.0f, 1).size() == 3);
+  CHECK(cutByScoreMargin(cands, 0.1f, 1).size() == 1);
+  CHECK(cutByScoreMargin(cands, 0.1f, 4).size() == 4);
+  CHECK(cutByScoreMargin(cands, 10.0f, 1).size() == 5);
+  CHECK(cutByScoreMargin(cands, 0.1f, 10).size() == 5);
+}
+
+TEST_CASE("top k indices are sorted by score") {
+  Score scores[] = {0.5f, 3.0f, -1.0f, 2.0f, 3.0f, 1.0f, 0.0f};
+  u32 result[5];
+  CHECK(topKIndices<5>(scores, 7, result) == 5);
+  CHECK(result[0] == 1);
+  CHECK(result[1] == 4);
+  CHECK(result[2] == 3);
+  CHECK(result[3] == 5);
+  CHECK(result[4] == 0);
+  CHECK(topKIndices<5>(scores, 3, result) == 3);
+  CHECK(result[0] == 1);
+  CHECK(result[1] == 0);
+  CHECK(result[2] == 2);
+  CHECK(topKIndices<1>(scores, 7, result) == 1);
+  CHECK(result[0] == 1);
+}
+
+namespace {
+
+template <typename T>
+std::vector<T> sortedPrefix(std::vector<T> data, u32 k) {
+  std::sort(data.begin(), data.end(), std::greater<T>());
+  data.resize(std::min<size_t>(k, data.size()));
+  return data;
+}
+
+}  // namespace
+
+TEST_CASE("small top k selects the same keys as sorting") {
+  std::mt19937_64 rng{0xdeadbeef};
+  for (u32 size : {0, 1, 3, 5, 10, 17, 50, 200}) {
+    for (u32 k = 1; k <= MaxSmallTopK; ++k) {
+      CAPTURE(size);
+      CAPTURE(k);
+      std::vector<u64> data(size);
+      for (auto& x : data) {
+        // few distinct high bits, so there are a lot of near-duplicates
+        x = ((rng() % 7) << 40) | (rng() & 0xffff'ffff) | 1;
+      }
+      u64 result[MaxSmallTopK];
+      auto count =
+          smallTopK(size, k, [&data](u32 i) { return data[i]; }, result);
+      auto expected = sortedPrefix(data, k);
+      REQUIRE(count == expected.size());
+      CHECK(std::vector<u64>(result, result + count) == expected);
+    }
+  }
+}
+
+TEST_CASE("score keys are ordered by score and then by index") {
+  CHECK(scoreIndexKey(1.0f, 0) > scoreIndexKey(0.5f, 0));
+  CHECK(scoreIndexKey(-1.0f, 0) > scoreIndexKey(-2.0f, 0));
+  CHECK(scoreIndexKey(0.0f, 0) > scoreIndexKey(-0.5f, 0));
+  CHECK(scoreIndexKey(1.0f, 1) > scoreIndexKey(1.0f, 2));
+  CHECK(indexOfScoreKey(scoreIndexKey(-3.0f, 12345)) == 12345);
+  CHECK(scoreFromOrderedBits(orderedScoreBits(-3.5f)) == -3.5f);
+}
@@ -0,0 +1,310 @@
+#include "core/analysis/streaming_analyzer.h"
+#include <algorithm>
+#include "core/analysis/analyzer_impl.h"
+
+namespace jumanpp {
+namespace core {
+namespace analysis {
+
+namespace {
+
+bool isPathNode(const ConnectionPtr* ptr) {
+  // 0 and 1 are BOS
+  return ptr != nullptr && ptr->boundary >= 2;
+}
+
+const NodeInfo& nodeInfo(const Lattice* lattice, const ConnectionPtr* ptr) {
+  return lattice->boundary(ptr->boundary)->starts()->nodeInfo().at(ptr->right);
+}
+
+// Perceptron features look only at the two last nodes of a path, so the
+// future can prefer only the best entry of a node beam among the ones which
+// have the same previous node. Other entries matter only for n-best output.
+// Extra scorers (RNN) look at the whole path, so this does not hold for them.
+bool isBestForState(util::ArraySlice<ConnectionBeamElement> beam, size_t idx) {
+  auto prev = beam.at(idx).ptr.previous->latticeNodePtr();
+  for (size_t i = 0; i < idx; ++i) {
+    auto& other = beam.at(i);
+    if (!EntryBeam::isFake(other) &&
+        other.ptr.previous->latticeNodePtr() == prev) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+Status StreamingAnalyzer::initialize(Analyzer* analyzer,
+                                     const StreamingConfig& config) {
+  if (config.rightContext < 0) {
+    return JPPS_INVALID_PARAMETER << "right context can not be negative, was "
+                                  << config.rightContext;
+  }
+  if (config.maxBuffered <= config.rightContext) {
+    return JPPS_INVALID_PARAMETER
+           << "maximum buffered codepoints (" << config.maxBuffered
+           << ") must be greater than the right context ("
+           << config.rightContext << ")";
+  }
+  analyzer_ = analyzer;
+  config_ = config;
+  runClasses_.clear();
+  for (auto& unk : analyzer->impl()->core().spec().unkCreators) {
+    if (unk.type == spec::UnkMakerType::Chunking ||
+        unk.type == spec::UnkMakerType::Numeric) {
+      runClasses_.push_back(unk.charClass);
+    }
+  }
+  reset();
+  return Status::Ok();
+}
+
+void StreamingAnalyzer::reset() {
+  buffer_.clear();
+  bufferedCodepoints_ = 0;
+  pending_.clear();
+  pendingStart_ = 0;
+  finished_ = false;
+  dirty_ = false;
+  analyzed_ = false;
+  analyzedSize_ = 0;
+  streamOffset_ = 0;
+  tokens_.clear();
+  stats_ = StreamingStats{};
+}
+
+void StreamingAnalyzer::push(StringPiece text) {
+  pending_.append(text.begin(), text.end());
+}
+
+bool StreamingAnalyzer::fillBuffer() {
+  auto maxBytes = analyzer_->impl()->cfg().maxInputBytes;
+  auto begin = reinterpret_cast<const u8*>(pending_.data());
+  auto end = begin + pending_.size();
+  auto pos = begin + pendingStart_;
+  auto start = pos;
+  auto numCodepoints = bufferedCodepoints_;
+  bool full = false;
+  while (pos < end) {
+    auto cp = chars::getCodepoint(pos, end);
+    i32 length = cp.utf8Length;
+    if (length == 0) {
+      // the rest of a codepoint can be pushed later
+      if (end - pos < 4 && !finished_) {
+        break;
+      }
+      // invalid sequences are reported by the analysis
+      length = 1;
+    }
+    if (numCodepoints >= config_.maxBuffered ||
+        buffer_.size() + (pos - start) + length > maxBytes) {
+      full = true;
+      break;
+    }
+    pos += length;
+    numCodepoints += 1;
+  }
+
+  if (pos != start) {
+    buffer_.append(reinterpret_cast<const char*>(start), pos - start);
+    bufferedCodepoints_ = numCodepoints;
+    dirty_ = true;
+  }
+
+  pendingStart_ = static_cast<size_t>(pos - begin);
+  if (pendingStart_ == pending_.size()) {
+    pending_.clear();
+    pendingStart_ = 0;
+  }
+  return full || numCodepoints >= config_.maxBuffered;
+}
+
+Status StreamingAnalyzer::analyzeBuffer() {
+  stats_.analyses += 1;
+  stats_.maxBufferedCodepoints =
+      std::max(stats_.maxBufferedCodepoints, bufferedCodepoints_);
+  if (analyzed_) {
+    // the buffer only grew since the last analysis
+    InputEdit edit;
+    edit.start = analyzedSize_;
+    edit.inserted = buffer_.size() - analyzedSize_;
+    JPP_RETURN_IF_ERROR(analyzer_->analyzeEdited(buffer_, edit));
+  } else {
+    JPP_RETURN_IF_ERROR(analyzer_->analyze(buffer_));
+  }
+  analyzed_ = true;
+  analyzedSize_ = buffer_.size();
+  dirty_ = false;
+  return Status::Ok();
+}
+
+Status StreamingAnalyzer::next() {
+  tokens_.clear();
+  bool full = fillBuffer();
+  if (bufferedCodepoints_ == 0) {
+    return Status::Ok();
+  }
+
+  bool last = finished_ && pending_.empty();
+  if (dirty_ || !analyzed_) {
+    JPP_RETURN_IF_ERROR(analyzeBuffer());
+  } else if (!last) {
+    return Status::Ok();
+  }
+
+  if (last) {
+    fillPath(bestPath());
+    if (path_.empty()) {
+      return JPPS_INVALID_STATE << "analysis of the buffer had no path";
+    }
+    emitPath(path_.size());
+    return Status::Ok();
+  }
+
+  // an unknown word at the end of the buffer can start to the left
+  // of the right context and grow when more text is appended
+  i32 liveStart = std::min(bufferedCodepoints_ - config_.rightContext,
+                           openUnkStart());
+  if (liveStart > 0) {
+    auto count = findConfluence(liveStart);
+    if (count > 0) {
+      stats_.confluences += 1;
+      emitPath(count);
+      return Status::Ok();
+    }
+  }
+
+  if (full) {
+    stats_.forcedCuts += 1;
+    fillPath(bestPath());
+    if (path_.empty()) {
+      return JPPS_INVALID_STATE << "analysis of the buffer had no path";
+    }
+    auto lattice = analyzer_->impl()->lattice();
+    size_t count = 1;
+    while (count < path_.size() &&
+           nodeInfo(lattice, path_[count]).end() <= liveStart) {
+      count += 1;
+    }
+    emitPath(count);
+  }
+  return Status::Ok();
+}
+
+const ConnectionPtr* StreamingAnalyzer::bestPath() const {
+  auto lattice = analyzer_->impl()->lattice();
+  auto eos = lattice->boundary(lattice->createdBoundaryCount() - 1);
+  auto& top = eos->starts()->beamData().at(0);
+  if (EntryBeam::isFake(top)) {
+    return nullptr;
+  }
+  return top.ptr.previous;
+}
+
+void StreamingAnalyzer::fillPath(const ConnectionPtr* tip) {
+  path_.clear();
+  for (auto ptr = tip; isPathNode(ptr); ptr = ptr->previous) {
+    path_.push_back(ptr);
+  }
+  std::reverse(path_.begin(), path_.end());
+}
+
+i32 StreamingAnalyzer::openUnkStart() const {
+  auto& codepoints = analyzer_->impl()->input().codepoints();
+  i32 start = bufferedCodepoints_;
+  for (auto cls : runClasses_) {
+    i32 pos = bufferedCodepoints_;
+    while (pos > 0 && codepoints[pos - 1].hasClass(cls)) {
+      pos -= 1;
+    }
+    start = std::min(start, pos);
+  }
+  return start;
+}
+
+size_t StreamingAnalyzer::findConfluence(i32 liveStart) {
+  auto lattice = analyzer_->impl()->lattice();
+  // with extra scorers any beam entry can become the best one
+  bool allEntries = analyzer_->impl()->hasExtraScorers();
+  size_t common = 0;
+  bool first = true;
+  // nodes which end at boundary b end at codepoint b - 2
+  for (i32 bnd = liveStart + 2; bnd <= bufferedCodepoints_ + 2; ++bnd) {
+    auto ends = lattice->boundary(bnd)->ends()->nodePtrs();
+    for (auto& node : ends) {
+      auto starts = lattice->boundary(node.boundary)->starts();
+      auto beam = starts->beamData().row(node.position);
+      for (size_t i = 0; i < beam.size(); ++i) {
+        auto& el = beam.at(i);
+        if (EntryBeam::isFake(el) ||
+            (!allEntries && !isBestForState(beam, i))) {
+          continue;
+        }
+        if (first) {
+          fillPath(&el.ptr);
+          common = path_.size();
+          first = false;
+          continue;
+        }
+        // paths go back to the decreasing boundaries,
+        // find the last element of the common prefix which is on this path
+        const ConnectionPtr* ptr = &el.ptr;
+        size_t idx = common;
+        while (idx > 0 && isPathNode(ptr) && ptr != path_[idx - 1]) {
+          auto bnd = ptr->boundary;
+          auto pathBnd = path_[idx - 1]->boundary;
+          if (bnd >= pathBnd) {
+            ptr = ptr->previous;
+          }
+          if (bnd <= pathBnd) {
+            idx -= 1;
+          }
+        }
+        common = isPathNode(ptr) ? idx : 0;
+        if (common == 0) {
+          return 0;
+        }
+      }
+    }
+  }
+
+  // emit only tokens which end before the live ones
+  while (common > 0 &&
+         nodeInfo(lattice, path_[common - 1]).end() > liveStart) {
+    common -= 1;
+  }
+  return common;
+}
+
+void StreamingAnalyzer::emitPath(size_t count) {
+  if (count == 0) {
+    return;
+  }
+  auto impl = analyzer_->impl();
+  auto lattice = impl->lattice();
+  auto& input = impl->input();
+  for (size_t i = 0; i < count; ++i) {
+    auto ptr = path_[i];
+    auto& info = nodeInfo(lattice, ptr);
+    StreamToken token;
+    token.node = ptr->latticeNodePtr();
+    token.surface = input.surface(info.start(), info.end());
+    token.offset = streamOffset_ + info.start();
+    tokens_.push_back(token);
+  }
+
+  i32 numCodepoints = nodeInfo(lattice, path_[count - 1]).end();
+  auto numBytes = input.surface(0, numCodepoints).size();
+  buffer_.erase(0, numBytes);
+  bufferedCodepoints_ -= numCodepoints;
+  streamOffset_ += numCodepoints;
+  stats_.emittedTokens += count;
+  stats_.emittedCodepoints += numCodepoints;
+  analyzed_ = false;
+  dirty_ = true;
+}
+
+}  // namespace analysis
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,141 @@
+#ifndef JUMANPP_STREAMING_ANALYZER_H
+#define JUMANPP_STREAMING_ANALYZER_H
+
+#include <string>
+#include <vector>
+#include "core/analysis/analyzer.h"
+#include "util/array_slice.h"
+#include "util/characters.h"
+
+namespace jumanpp {
+namespace core {
+namespace analysis {
+
+struct StreamingConfig {
+  // Tokens are emitted only when they end at least this number
+  // of codepoints before the end of the buffered text.
+  // It should be larger than the longest word, so appending text
+  // would not change the emitted tokens.
+  i32 rightContext = 16;
+  // When the buffered text reaches this number of codepoints and
+  // there is no confluence, tokens of the best path are emitted anyway.
+  i32 maxBuffered = 256;
+};
+
+struct StreamToken {
+  // node in the lattice of StreamingAnalyzer::analyzer()
+  LatticeNodePtr node;
+  StringPiece surface;
+  // codepoint offset of the token from the start of the stream
+  i64 offset;
+};
+
+struct StreamingStats {
+  i64 emittedTokens = 0;
+  i64 emittedCodepoints = 0;
+  // number of analyses of the buffered text
+  i32 analyses = 0;
+  // emissions at the points where all live paths join
+  i32 confluences = 0;
+  // emissions because of the full buffer
+  i32 forcedCuts = 0;
+  i32 maxBufferedCodepoints = 0;
+};
+
+/**
+ * Analyzes a stream of text without sentence boundaries.
+ *
+ * Pushed text is buffered and analyzed as a single sentence.
+ * Live paths are the best beam entries for each pair of last two nodes
+ * of all nodes which end inside the right context of the buffer:
+ * only they can be extended by the text which is not pushed yet.
+ * When all of them share a prefix (there is a confluence),
+ * tokens of the prefix are emitted and removed from the buffer,
+ * so the next analysis starts from the confluence point
+ * and reuses the arena memory of the analyzer.
+ * The analysis after the confluence starts from BOS, so n-gram features
+ * do not see the emitted tokens.
+ * Extra scorers (RNN) look at whole paths, so with them every beam entry
+ * of the nodes in the right context is a live path.
+ * A run of characters at the end of the buffer which can become a single
+ * unknown word (e.g. katakana or numbers) can be extended by the appended
+ * text, so only tokens which end before the run are emitted.
+ *
+ * Text appended to the buffer without emissions is analyzed
+ * with Analyzer::analyzeEdited().
+ * The buffer never grows larger than StreamingConfig::maxBuffered,
+ * which bounds both the latency and the memory usage.
+ */
+class StreamingAnalyzer {
+  StreamingConfig config_;
+  Analyzer* analyzer_ = nullptr;
+  // text of the current analysis
+  std::string buffer_;
+  i32 bufferedCodepoints_ = 0;
+  // pushed text which does not fit into the buffer yet
+  std::string pending_;
+  size_t pendingStart_ = 0;
+  bool finished_ = false;
+  // buffer_ differs from the analyzed text
+  bool dirty_ = false;
+  // the analyzed text was a prefix of buffer_
+  bool analyzed_ = false;
+  size_t analyzedSize_ = 0;
+  i64 streamOffset_ = 0;
+  std::vector<StreamToken> tokens_;
+  std::vector<const ConnectionPtr*> path_;
+  // character classes of chunking and numeric unknown word makers
+  std::vector<chars::CharacterClass> runClasses_;
+  StreamingStats stats_;
+
+  // returns true when the buffer can not take more text
+  bool fillBuffer();
+  Status analyzeBuffer();
+  const ConnectionPtr* bestPath() const;
+  // start of the run of characters at the end of the buffer
+  // which can become a single unknown word
+  i32 openUnkStart() const;
+  void fillPath(const ConnectionPtr* tip);
+  // returns the number of common path elements of all live paths
+  size_t findConfluence(i32 liveStart);
+  void emitPath(size_t count);
+
+ public:
+  /**
+   * The analyzer should not be used by anything else while streaming.
+   */
+  Status initialize(Analyzer* analyzer, const StreamingConfig& config);
+
+  /**
+   * Appends text to the end of the stream.
+   */
+  void push(StringPiece text);
+
+  /**
+   * There will be no more text, next() emits everything what is left.
+   */
+  void finish() { finished_ = true; }
+
+  /**
+   * Analyzes the buffered text and emits tokens which are not going
+   * to change, tokens() are empty when more text is needed.
+   * Emitted tokens are valid until the next call of next().
+   */
+  Status next();
+
+  util::ArraySlice<StreamToken> tokens() const { return tokens_; }
+  const Analyzer& analyzer() const { return *analyzer_; }
+  const StreamingStats& stats() const { return stats_; }
+  i32 bufferedCodepoints() const { return bufferedCodepoints_; }
+
+  /**
+   * Drops all buffered text, the next pushed text starts a new stream.
+   */
+  void reset();
+};
+
+}  // namespace analysis
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_STREAMING_ANALYZER_H
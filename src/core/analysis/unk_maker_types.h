@@ -30,6 +30,42 @@ struct UnkMakersInfo {
   std::vector<UnkMakerInfo> makers;
 };
 
+/**
+ * Limits on spans of chunking unknown words.
+ *
+ * A run of N characters of the same class produces O(N^2) unknown word
+ * candidates. With a limit, spans which are longer than it are created
+ * only when they end at the end of the run.
+ * Numeric unknown words inside a longer number are cut to the limit,
+ * the whole number is always created.
+ */
+struct UnkSpanLimits {
+  // in codepoints, non-positive values disable the limit
+  i32 maxLength = 0;
+  // limits for unk makers of specific character classes,
+  // the first one which intersects with a maker class is used
+  std::vector<std::pair<chars::CharacterClass, i32>> classLengths;
+
+  i32 lengthFor(chars::CharacterClass cls) const {
+    for (auto& p : classLengths) {
+      if ((p.first & cls) != chars::CharacterClass::FAMILY_OTHERS) {
+        return p.second;
+      }
+    }
+    return maxLength;
+  }
+};
+
+/**
+ * How often UnkSpanLimits were applied in a single analysis
+ */
+struct UnkSpanStats {
+  // start positions which had their spans limited
+  i32 limitedStarts = 0;
+  // spans which were not created
+  i32 skippedSpans = 0;
+};
+
 }  // namespace analysis
 }  // namespace core
 }  // namespace jumanpp
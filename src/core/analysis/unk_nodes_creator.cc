@@ -20,30 +20,40 @@ bool ChunkingUnkMaker::spawnNodes(const AnalysisInput& input,
                                   UnkNodesContext* ctx,
                                   LatticeBuilder* lattice) const {
   auto& codepoints = input.codepoints();
+  auto maxLength = ctx->spanLimit(charClass_);
+  // end of the current run of charClass_ characters
+  LatticePosition runEnd = 0;
   for (LatticePosition i = 0; i < codepoints.size(); ++i) {
     auto& codept = codepoints[i];
     if (!codept.hasClass(charClass_)) {
       continue;
     }
 
+    if (i >= runEnd) {
+      runEnd = i;
+      while (runEnd < codepoints.size() &&
+             codepoints[runEnd].hasClass(charClass_)) {
+        ++runEnd;
+      }
+    }
+
     auto trav = entries_.traversal();
-    for (LatticePosition j = i; j < codepoints.size(); ++j) {
+    for (LatticePosition j = i; j < runEnd; ++j) {
       auto& cp = codepoints[j];
-      if (!cp.hasClass(charClass_)) {
-        break;
-      }
       auto status = trav.step(cp.bytes);
       using dic::TraverseStatus;
 
       switch (status) {
         case TraverseStatus::NoNode: {
-          for (; j < codepoints.size(); ++j) {
-            if (!codepoints[j].hasClass(charClass_)) {
-              j = codepoints.size();
-              break;
-            }
+          for (; j < runEnd; ++j) {
             LatticePosition start = i;
             LatticePosition end = (LatticePosition)(j + 1);
+            if (maxLength != 0 && end - start > maxLength && end != runEnd) {
+              // too long spans are created only at the end of the run
+              ctx->recordLimitedSpans(runEnd - end);
+              end = runEnd;
+              j = static_cast<LatticePosition>(runEnd - 1);
+            }
             auto ptr = ctx->makePtr(input.surface(start, end), info_, true);
             lattice->appendSeed(ptr, start, end);
           }
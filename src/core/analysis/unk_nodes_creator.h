@@ -42,14 +42,40 @@ class UnkNodesContext {
   ExtraNodesContext* xtra_;
   util::memory::PoolAlloc* alloc_;
   dic::DictionaryEntries entries_;
+  const UnkSpanLimits* limits_;
+  UnkSpanStats* stats_;
 
  public:
   UnkNodesContext(ExtraNodesContext* xtra, util::memory::PoolAlloc* alloc,
-                  dic::DictionaryEntries entries)
-      : xtra_{xtra}, alloc_{alloc}, entries_{entries} {}
+                  dic::DictionaryEntries entries,
+                  const UnkSpanLimits* limits = nullptr,
+                  UnkSpanStats* stats = nullptr)
+      : xtra_{xtra},
+        alloc_{alloc},
+        entries_{entries},
+        limits_{limits},
+        stats_{stats} {}
 
   util::memory::PoolAlloc* alloc() const { return alloc_; }
 
+  /**
+   * Maximum length of unk spans for a character class, 0 if unlimited
+   */
+  i32 spanLimit(chars::CharacterClass cls) const {
+    if (limits_ == nullptr) {
+      return 0;
+    }
+    auto length = limits_->lengthFor(cls);
+    return length > 0 ? length : 0;
+  }
+
+  void recordLimitedSpans(i32 skipped) {
+    if (stats_ != nullptr) {
+      stats_->limitedStarts += 1;
+      stats_->skippedSpans += skipped;
+    }
+  }
+
   EntryPtr makePtr(StringPiece surface, const UnkNodeConfig& conf,
                    bool notPrefix);
 
@@ -16,7 +16,8 @@ class UnkNodeTestEnv {
   StringField fldb;
 
  public:
-  UnkNodeTestEnv(StringPiece csvData) {
+  UnkNodeTestEnv(StringPiece csvData, i32 maxUnkLength = 0) {
+    tenv.aconf.unkLimits.maxLength = maxUnkLength;
     tenv.spec([](dsl::ModelSpecBuilder& specBldr) {
       auto& a = specBldr.field(1, "a").strings().trieIndex();
       specBldr.field(2, "b").strings();
@@ -37,6 +38,8 @@ class UnkNodeTestEnv {
     CHECK_OK(tenv.analyzer->makeUnkNodes1());
   }
 
+  const UnkSpanStats& stats() const { return tenv.analyzer->unkStats(); }
+
   size_t numNodeSeeds() const {
     return tenv.analyzer->latticeBuilder().seeds().size();
   }
@@ -108,4 +111,39 @@ TEST_CASE("chunked unks do not go over different classes") {
   CHECK(env.contains("dx", 0, "b"));
   CHECK(env.contains("1", 2, "c"));
   CHECK(env.numNodeSeeds() == 5);
-}
\ No newline at end of file
+}
+
+TEST_CASE("long unk spans are created only at the end of class runs") {
+  UnkNodeTestEnv env{"x,a\nxa,b\n", 2};
+  env.analyze("abcd1");
+  CHECK(env.contains("a", 0, "a"));
+  CHECK(env.contains("ab", 0, "a"));
+  CHECK_FALSE(env.contains("abc", 0, "a"));
+  CHECK(env.contains("abcd", 0, "a"));
+  CHECK(env.contains("bc", 1, "a"));
+  CHECK(env.contains("bcd", 1, "a"));
+  CHECK(env.contains("cd", 2, "a"));
+  CHECK(env.contains("d", 3, "a"));
+  CHECK(env.numNodeSeeds() == 9);
+  CHECK(env.stats().limitedStarts == 1);
+  CHECK(env.stats().skippedSpans == 1);
+}
+
+TEST_CASE("unk span limits bound the number of nodes of long runs") {
+  UnkNodeTestEnv env{"x,a\nxa,b\n", 8};
+  std::string input(500, 'a');
+  env.analyze(input);
+  // 8 short spans and one span to the end of the run for every start
+  CHECK(env.numNodeSeeds() < 500 * 9);
+  CHECK(env.contains(input, 0, "a"));
+  CHECK(env.stats().limitedStarts == 500 - 9);
+}
+
+TEST_CASE("unk span limits can be set for character classes") {
+  UnkSpanLimits limits;
+  limits.maxLength = 5;
+  limits.classLengths.emplace_back(chars::CharacterClass::KATAKANA, 10);
+  CHECK(limits.lengthFor(chars::CharacterClass::KATAKANA) == 10);
+  CHECK(limits.lengthFor(chars::CharacterClass::FAMILY_KANA) == 10);
+  CHECK(limits.lengthFor(chars::CharacterClass::ALPH) == 5);
+}
@@ -0,0 +1,399 @@
+#include "jumanpp_api.h"
+#include <algorithm>
+#include <exception>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "core/analysis/analyzer_impl.h"
+#include "core/env.h"
+#include "core/spec/spec_hashing.h"
+#include "jpp_jumandic_cg.h"
+
+using namespace jumanpp;
+
+struct jumanpp_model {
+  core::JumanppEnv env;
+};
+
+struct jumanpp_analyzer {
+  const jumanpp_model* model;
+  core::analysis::Analyzer analyzer;
+  // dictionary entry indices of the fields
+  std::vector<i32> fieldIndices;
+  std::vector<jumanpp_string> sentences;
+  std::vector<jumanpp_status> statuses;
+  // morphemes of sentence i are [offsets[i], offsets[i + 1])
+  std::vector<size_t> offsets;
+  std::vector<jumanpp_morpheme> morphemes;
+  std::vector<int32_t> values;
+};
+
+namespace {
+
+thread_local std::string lastError;
+
+jumanpp_status fail(jumanpp_status code, const Status& status) {
+  std::stringstream ss;
+  ss << status;
+  lastError = ss.str();
+  return code;
+}
+
+jumanpp_status fail(jumanpp_status code, StringPiece message) {
+  lastError = message.str();
+  return code;
+}
+
+// Exceptions must not cross C boundary
+template <typename Fn>
+jumanpp_status guarded(Fn fn) {
+  try {
+    return fn();
+  } catch (std::exception& e) {
+    return fail(JUMANPP_ERROR, StringPiece::fromCString(e.what()));
+  }
+}
+
+jumanpp_field_type fieldType(core::spec::FieldType type) {
+  switch (type) {
+    case core::spec::FieldType::String:
+      return JUMANPP_FIELD_STRING;
+    case core::spec::FieldType::Int:
+      return JUMANPP_FIELD_INT;
+    case core::spec::FieldType::StringList:
+      return JUMANPP_FIELD_STRING_LIST;
+    case core::spec::FieldType::StringKVList:
+      return JUMANPP_FIELD_KV_LIST;
+    default:
+      return JUMANPP_FIELD_ERROR;
+  }
+}
+
+const core::dic::FieldsHolder& fieldsOf(const jumanpp_model* model) {
+  return model->env.coreHolder()->dic().fields();
+}
+
+bool validField(const jumanpp_model* model, int32_t field) {
+  return model != nullptr && field >= 0 &&
+         field < fieldsOf(model).totalFields();
+}
+
+bool validSentence(const jumanpp_analyzer* analyzer, size_t sentence) {
+  return analyzer != nullptr && sentence < analyzer->sentences.size();
+}
+
+Status collectTopPath(jumanpp_analyzer* ana) {
+  auto impl = ana->analyzer.impl();
+  auto lattice = impl->lattice();
+  auto& output = ana->analyzer.output();
+  auto walker = output.nodeWalker();
+  auto& input = impl->input();
+  auto base = input.surface().begin();
+  auto& codepoints = input.codepoints();
+
+  auto first = ana->morphemes.size();
+  auto eos = lattice->boundary(lattice->createdBoundaryCount() - 1);
+  auto ptr = eos->starts()->beamData().at(0).ptr.previous;
+  while (ptr != nullptr && ptr->boundary >= 2) {
+    auto& info =
+        lattice->boundary(ptr->boundary)->starts()->nodeInfo().at(ptr->right);
+    if (!output.locate(ptr->latticeNodePtr(), &walker) || !walker.next()) {
+      return JPPS_INVALID_STATE << "failed to locate a node of the top path";
+    }
+    jumanpp_morpheme m;
+    m.begin = static_cast<uint32_t>(
+        codepoints[info.start()].bytes.begin() - base);
+    m.end =
+        static_cast<uint32_t>(codepoints[info.end() - 1].bytes.end() - base);
+    ana->morphemes.push_back(m);
+    for (auto idx : ana->fieldIndices) {
+      i32 value = 0;
+      walker.valueOf(idx, &value);
+      ana->values.push_back(value);
+    }
+    ptr = ptr->previous;
+  }
+
+  // path is collected from the end
+  auto numFields = ana->fieldIndices.size();
+  std::reverse(ana->morphemes.begin() + first, ana->morphemes.end());
+  auto numNodes = ana->morphemes.size() - first;
+  auto values = ana->values.data() + first * numFields;
+  for (size_t i = 0; i < numNodes / 2; ++i) {
+    auto j = numNodes - i - 1;
+    std::swap_ranges(values + i * numFields, values + (i + 1) * numFields,
+                     values + j * numFields);
+  }
+  return Status::Ok();
+}
+
+Status analyzeSentence(jumanpp_analyzer* ana, StringPiece input) {
+  if (input.empty()) {
+    // there is no lattice for an empty sentence
+    return Status::Ok();
+  }
+  try {
+    JPP_RETURN_IF_ERROR(ana->analyzer.analyze(input));
+    return collectTopPath(ana);
+  } catch (std::exception& e) {
+    // results of other sentences are still valid
+    return JPPS_INVALID_STATE << "analysis failed: " << e.what();
+  }
+}
+
+}  // namespace
+
+extern "C" {
+
+int32_t jumanpp_api_version(void) { return JUMANPP_API_VERSION; }
+
+const char* jumanpp_last_error(void) { return lastError.c_str(); }
+
+jumanpp_status jumanpp_model_load(const char* path, jumanpp_model** result) {
+  if (path == nullptr || result == nullptr) {
+    return fail(JUMANPP_INVALID_ARGUMENT, "path and result must not be NULL");
+  }
+  return guarded([&]() {
+    std::unique_ptr<jumanpp_model> model{new jumanpp_model};
+    Status s = model->env.loadModel(StringPiece::fromCString(path));
+    if (!s) {
+      return fail(JUMANPP_ERROR, s);
+    }
+    // features generated for the jumandic spec are used when the model
+    // has it, as in the jumanpp binary; other models use dynamic features
+    jumanpp_generated::JumandicStatic jumandic;
+    const core::features::StaticFeatureFactory* features = nullptr;
+    if (core::spec::hashSpec(model->env.spec()) == jumandic.runtimeHash()) {
+      features = &jumandic;
+    }
+    s = model->env.initFeatures(features);
+    if (!s) {
+      return fail(JUMANPP_ERROR, s);
+    }
+    if (!model->env.hasPerceptronModel()) {
+      return fail(JUMANPP_ERROR, "the model was not trained");
+    }
+    *result = model.release();
+    return JUMANPP_OK;
+  });
+}
+
+void jumanpp_model_free(jumanpp_model* model) { delete model; }
+
+int32_t jumanpp_model_num_fields(const jumanpp_model* model) {
+  if (model == nullptr) {
+    return 0;
+  }
+  return static_cast<int32_t>(fieldsOf(model).totalFields());
+}
+
+const char* jumanpp_model_field_name(const jumanpp_model* model,
+                                     int32_t field) {
+  if (!validField(model, field)) {
+    return nullptr;
+  }
+  // points to a std::string of the spec, so it is zero-terminated
+  return fieldsOf(model).at(field).name.char_begin();
+}
+
+jumanpp_field_type jumanpp_model_field_type(const jumanpp_model* model,
+                                            int32_t field) {
+  if (!validField(model, field)) {
+    return JUMANPP_FIELD_ERROR;
+  }
+  return fieldType(fieldsOf(model).at(field).columnType);
+}
+
+int32_t jumanpp_model_field_index(const jumanpp_model* model,
+                                  const char* name) {
+  if (model == nullptr || name == nullptr) {
+    return -1;
+  }
+  auto& fields = fieldsOf(model);
+  for (i32 i = 0; i < fields.totalFields(); ++i) {
+    if (fields.at(i).name == StringPiece::fromCString(name)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+jumanpp_status jumanpp_model_string(const jumanpp_model* model, int32_t field,
+                                    int32_t value, jumanpp_string* result) {
+  if (!validField(model, field) || result == nullptr) {
+    return fail(JUMANPP_INVALID_ARGUMENT, "invalid field or result");
+  }
+  auto& fld = fieldsOf(model).at(field);
+  if (fld.columnType != core::spec::FieldType::String) {
+    return fail(JUMANPP_INVALID_ARGUMENT, "field is not a string field");
+  }
+  auto position = static_cast<ptrdiff_t>(value) << fld.alignPower;
+  if (value < 0 || position >= fld.strings.data().size()) {
+    return fail(JUMANPP_INVALID_ARGUMENT, "string id is out of range");
+  }
+  StringPiece sp;
+  if (!fld.strings.readAt(value, &sp)) {
+    return fail(JUMANPP_ERROR, "failed to read a string from the model");
+  }
+  result->data = sp.char_begin();
+  result->length = sp.size();
+  return JUMANPP_OK;
+}
+
+void jumanpp_analyzer_config_default(jumanpp_analyzer_config* config) {
+  if (config == nullptr) {
+    return;
+  }
+  config->beam_size = 5;
+  config->global_beam = 6;
+  config->right_check = 1;
+  config->right_beam = 5;
+  config->max_input_bytes = 4 * 1024;
+}
+
+jumanpp_status jumanpp_analyzer_create(const jumanpp_model* model,
+                                       const jumanpp_analyzer_config* config,
+                                       jumanpp_analyzer** result) {
+  if (model == nullptr || result == nullptr) {
+    return fail(JUMANPP_INVALID_ARGUMENT, "model and result must not be NULL");
+  }
+  jumanpp_analyzer_config conf;
+  jumanpp_analyzer_config_default(&conf);
+  if (config != nullptr) {
+    conf = *config;
+  }
+  if (conf.beam_size <= 0 || conf.max_input_bytes <= 0) {
+    return fail(JUMANPP_INVALID_ARGUMENT,
+                "beam size and maximum input size must be positive");
+  }
+
+  return guarded([&]() {
+    core::analysis::AnalyzerConfig acfg;
+    acfg.globalBeamSize = conf.global_beam;
+    acfg.rightGbeamCheck = conf.right_check;
+    acfg.rightGbeamSize = conf.right_beam;
+    acfg.maxInputBytes = static_cast<size_t>(conf.max_input_bytes);
+
+    std::unique_ptr<jumanpp_analyzer> ana{new jumanpp_analyzer};
+    ana->model = model;
+    Status s = model->env.makeAnalyzer(&ana->analyzer, acfg, conf.beam_size);
+    if (!s) {
+      return fail(JUMANPP_ERROR, s);
+    }
+    auto& fields = fieldsOf(model);
+    for (i32 i = 0; i < fields.totalFields(); ++i) {
+      ana->fieldIndices.push_back(fields.at(i).idxInEntry);
+    }
+    *result = ana.release();
+    return JUMANPP_OK;
+  });
+}
+
+void jumanpp_analyzer_free(jumanpp_analyzer* analyzer) { delete analyzer; }
+
+jumanpp_status jumanpp_analyze_batch(jumanpp_analyzer* analyzer,
+                                     const jumanpp_string* sentences,
+                                     size_t count) {
+  if (analyzer == nullptr || (sentences == nullptr && count != 0)) {
+    return fail(JUMANPP_INVALID_ARGUMENT, "invalid analyzer or sentences");
+  }
+  return guarded([&]() {
+    auto ana = analyzer;
+    ana->sentences.assign(sentences, sentences + count);
+    ana->statuses.clear();
+    ana->offsets.clear();
+    ana->morphemes.clear();
+    ana->values.clear();
+    ana->offsets.push_back(0);
+
+    auto result = JUMANPP_OK;
+    for (size_t i = 0; i < count; ++i) {
+      auto& sent = sentences[i];
+      Status s = analyzeSentence(ana, StringPiece{sent.data, sent.length});
+      if (!s) {
+        // drop a partially collected path
+        auto first = ana->offsets.back();
+        ana->morphemes.resize(first);
+        ana->values.resize(first * ana->fieldIndices.size());
+        if (result == JUMANPP_OK) {
+          fail(JUMANPP_ANALYSIS_FAILED, s);
+          result = JUMANPP_ANALYSIS_FAILED;
+        }
+        ana->statuses.push_back(JUMANPP_ANALYSIS_FAILED);
+      } else {
+        ana->statuses.push_back(JUMANPP_OK);
+      }
+      ana->offsets.push_back(ana->morphemes.size());
+    }
+    return result;
+  });
+}
+
+size_t jumanpp_result_num_sentences(const jumanpp_analyzer* analyzer) {
+  if (analyzer == nullptr) {
+    return 0;
+  }
+  return analyzer->sentences.size();
+}
+
+jumanpp_status jumanpp_result_status(const jumanpp_analyzer* analyzer,
+                                     size_t sentence) {
+  if (!validSentence(analyzer, sentence)) {
+    return JUMANPP_INVALID_ARGUMENT;
+  }
+  return analyzer->statuses[sentence];
+}
+
+const jumanpp_morpheme* jumanpp_result_morphemes(
+    const jumanpp_analyzer* analyzer, size_t sentence, size_t* count) {
+  if (!validSentence(analyzer, sentence)) {
+    if (count != nullptr) {
+      *count = 0;
+    }
+    return nullptr;
+  }
+  auto start = analyzer->offsets[sentence];
+  if (count != nullptr) {
+    *count = analyzer->offsets[sentence + 1] - start;
+  }
+  return analyzer->morphemes.data() + start;
+}
+
+const int32_t* jumanpp_result_values(const jumanpp_analyzer* analyzer,
+                                     size_t sentence) {
+  if (!validSentence(analyzer, sentence)) {
+    return nullptr;
+  }
+  auto start = analyzer->offsets[sentence];
+  return analyzer->values.data() + start * analyzer->fieldIndices.size();
+}
+
+jumanpp_status jumanpp_result_string(const jumanpp_analyzer* analyzer,
+                                     size_t sentence, size_t morpheme,
+                                     int32_t field, jumanpp_string* result) {
+  if (!validSentence(analyzer, sentence) ||
+      !validField(analyzer->model, field) || result == nullptr) {
+    return fail(JUMANPP_INVALID_ARGUMENT, "invalid sentence, field or result");
+  }
+  auto start = analyzer->offsets[sentence];
+  auto end = analyzer->offsets[sentence + 1];
+  if (morpheme >= end - start) {
+    return fail(JUMANPP_INVALID_ARGUMENT, "invalid morpheme index");
+  }
+  if (fieldsOf(analyzer->model).at(field).columnType !=
+      core::spec::FieldType::String) {
+    return fail(JUMANPP_INVALID_ARGUMENT, "field is not a string field");
+  }
+  auto idx = start + morpheme;
+  auto value = analyzer->values[idx * analyzer->fieldIndices.size() + field];
+  if (value < 0) {
+    // strings which are not in the dictionary are the morpheme surface
+    auto& m = analyzer->morphemes[idx];
+    result->data = analyzer->sentences[sentence].data + m.begin;
+    result->length = m.end - m.begin;
+    return JUMANPP_OK;
+  }
+  return jumanpp_model_string(analyzer->model, field, value, result);
+}
+
+}  // extern "C"
@@ -0,0 +1,166 @@
+#ifndef JUMANPP_API_H
+#define JUMANPP_API_H
+
+/*
+ * C API of Juman++, exported from libjumanpp.
+ *
+ * A model is loaded once and can be shared by any number of analyzers,
+ * which can be used from different threads (one thread per analyzer).
+ * Analysis results are exposed without copying or formatting:
+ * each morpheme is a byte span of the input sentence and
+ * a row of raw dictionary field values.
+ * String values point either to the model memory or to the input sentence.
+ *
+ * Functions which can fail return jumanpp_status, the message of the last
+ * error in the current thread is available from jumanpp_last_error().
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(JPP_API_BUILD)
+#define JUMANPP_API __declspec(dllexport)
+#else
+#define JUMANPP_API __declspec(dllimport)
+#endif
+#else
+#define JUMANPP_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JUMANPP_API_VERSION 1
+
+typedef enum jumanpp_status {
+  JUMANPP_OK = 0,
+  JUMANPP_INVALID_ARGUMENT = 1,
+  JUMANPP_ANALYSIS_FAILED = 2,
+  JUMANPP_ERROR = 3
+} jumanpp_status;
+
+typedef enum jumanpp_field_type {
+  JUMANPP_FIELD_ERROR = 0,
+  JUMANPP_FIELD_STRING = 1,
+  JUMANPP_FIELD_INT = 2,
+  JUMANPP_FIELD_STRING_LIST = 3,
+  JUMANPP_FIELD_KV_LIST = 4
+} jumanpp_field_type;
+
+typedef struct jumanpp_model jumanpp_model;
+typedef struct jumanpp_analyzer jumanpp_analyzer;
+
+/* A non-owning, not zero-terminated string */
+typedef struct jumanpp_string {
+  const char* data;
+  size_t length;
+} jumanpp_string;
+
+/* A morpheme of the analysis result: [begin, end) bytes of the sentence */
+typedef struct jumanpp_morpheme {
+  uint32_t begin;
+  uint32_t end;
+} jumanpp_morpheme;
+
+typedef struct jumanpp_analyzer_config {
+  int32_t beam_size;
+  int32_t global_beam;
+  int32_t right_check;
+  int32_t right_beam;
+  /* maximum size of a sentence in bytes */
+  int32_t max_input_bytes;
+} jumanpp_analyzer_config;
+
+JUMANPP_API int32_t jumanpp_api_version(void);
+
+/* Message of the last failed call in this thread, never NULL */
+JUMANPP_API const char* jumanpp_last_error(void);
+
+/*
+ * Loads a trained model. An RNN which was embedded into the model
+ * (jumanpp_train --rnn-model) is loaded as well and is used with
+ * the parameters stored together with it.
+ * Separate RNN model files and changing RNN parameters
+ * are not supported by this API.
+ * Models of the jumandic spec use the same compiled features as
+ * the jumanpp binary, other models use slower dynamic features.
+ */
+JUMANPP_API jumanpp_status jumanpp_model_load(const char* path,
+                                              jumanpp_model** result);
+/* Must be called after all analyzers of the model were freed */
+JUMANPP_API void jumanpp_model_free(jumanpp_model* model);
+
+JUMANPP_API int32_t jumanpp_model_num_fields(const jumanpp_model* model);
+/* Returns NULL for invalid field indices */
+JUMANPP_API const char* jumanpp_model_field_name(const jumanpp_model* model,
+                                                 int32_t field);
+JUMANPP_API jumanpp_field_type
+jumanpp_model_field_type(const jumanpp_model* model, int32_t field);
+/* Returns -1 if there is no such field */
+JUMANPP_API int32_t jumanpp_model_field_index(const jumanpp_model* model,
+                                              const char* name);
+
+/* Fills the configuration with the defaults of the jumanpp binary */
+JUMANPP_API void jumanpp_analyzer_config_default(
+    jumanpp_analyzer_config* config);
+
+/* config can be NULL, defaults are used in that case */
+JUMANPP_API jumanpp_status jumanpp_analyzer_create(
+    const jumanpp_model* model, const jumanpp_analyzer_config* config,
+    jumanpp_analyzer** result);
+JUMANPP_API void jumanpp_analyzer_free(jumanpp_analyzer* analyzer);
+
+/*
+ * Analyzes count sentences. Results replace the results of the
+ * previous call and stay valid until the next call.
+ * Sentence memory is NOT copied and must stay alive while results are used.
+ *
+ * A failure to analyze one sentence does not stop the batch:
+ * the function returns JUMANPP_ANALYSIS_FAILED, the failed sentence
+ * has no morphemes and jumanpp_result_status reports its error.
+ */
+JUMANPP_API jumanpp_status jumanpp_analyze_batch(
+    jumanpp_analyzer* analyzer, const jumanpp_string* sentences,
+    size_t count);
+
+JUMANPP_API size_t jumanpp_result_num_sentences(
+    const jumanpp_analyzer* analyzer);
+JUMANPP_API jumanpp_status jumanpp_result_status(
+    const jumanpp_analyzer* analyzer, size_t sentence);
+
+/*
+ * Morphemes of the sentence, their number is written to count.
+ * The pointer is valid until the next analysis.
+ */
+JUMANPP_API const jumanpp_morpheme* jumanpp_result_morphemes(
+    const jumanpp_analyzer* analyzer, size_t sentence, size_t* count);
+
+/*
+ * Raw field values of the sentence morphemes:
+ * a row-major [count x jumanpp_model_num_fields] matrix.
+ * For string fields values are string ids in the model,
+ * negative values mean that the string is the morpheme surface.
+ * This holds only for string fields: values of integer fields are
+ * the integers themselves and can be negative, values of list fields
+ * are offsets in the model list storage.
+ */
+JUMANPP_API const int32_t* jumanpp_result_values(
+    const jumanpp_analyzer* analyzer, size_t sentence);
+
+/* Value of a string field of a morpheme, without copying */
+JUMANPP_API jumanpp_status jumanpp_result_string(
+    const jumanpp_analyzer* analyzer, size_t sentence, size_t morpheme,
+    int32_t field, jumanpp_string* result);
+
+/* Resolves a string id of a string field, value must not be negative */
+JUMANPP_API jumanpp_status jumanpp_model_string(const jumanpp_model* model,
+                                                int32_t field, int32_t value,
+                                                jumanpp_string* result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // JUMANPP_API_H
@@ -0,0 +1,185 @@
+#include "jumanpp_api.h"
+#include <cstring>
+#include "core/impl/perceptron_io.h"
+#include "testing/test_analyzer.h"
+#include "util/serialization.h"
+
+using namespace jumanpp;
+using namespace jumanpp::core;
+
+namespace {
+
+// the first row is the unk template, it is not indexed by the trie
+constexpr StringPiece dicData =
+    "ZZZ,z\n"
+    "XXX,a\n"
+    "YYY,b\n"
+    "XXXYYY,c\n";
+
+class ApiTestEnv {
+  TempFile file_;
+  util::CodedBuffer perceptronInfo_;
+  std::vector<float> weights_;
+
+ public:
+  jumanpp_model* model = nullptr;
+
+  ApiTestEnv() : weights_(1024) {
+    spec::AnalysisSpec aspec;
+    spec::dsl::ModelSpecBuilder bldr;
+    auto& a = bldr.field(1, "a").strings().trieIndex();
+    auto& b = bldr.field(2, "b").strings();
+    bldr.unk("katakana", 1)
+        .chunking(chars::CharacterClass::KATAKANA)
+        .outputTo({a});
+    bldr.unigram({a, b});
+    bldr.bigram({a}, {a});
+    REQUIRE_OK(bldr.build(&aspec));
+
+    dic::DictionaryBuilder dicBldr;
+    REQUIRE_OK(dicBldr.importSpec(&aspec));
+    REQUIRE_OK(dicBldr.importCsv("test", dicData));
+
+    model::ModelInfo info;
+    info.parts.emplace_back();
+    REQUIRE_OK(dicBldr.fillModelPart(&info.parts.back()));
+
+    for (size_t i = 0; i < weights_.size(); ++i) {
+      weights_[i] = static_cast<float>(i % 7) * 0.1f - 0.3f;
+    }
+    PerceptronInfo pi{10};
+    util::serialization::Saver saver{&perceptronInfo_};
+    saver.save(pi);
+    model::ModelPart part;
+    part.kind = model::ModelPartKind::Perceprton;
+    part.data.push_back(perceptronInfo_.contents());
+    auto chars = reinterpret_cast<const char*>(weights_.data());
+    part.data.push_back(
+        StringPiece{chars, chars + weights_.size() * sizeof(float)});
+    info.parts.push_back(part);
+
+    model::ModelSaver modelSaver;
+    REQUIRE_OK(modelSaver.open(file_.name()));
+    REQUIRE_OK(modelSaver.save(info));
+
+    REQUIRE(jumanpp_model_load(file_.name().c_str(), &model) == JUMANPP_OK);
+  }
+
+  ~ApiTestEnv() { jumanpp_model_free(model); }
+};
+
+std::string stringOf(const jumanpp_analyzer* ana, size_t sent, size_t morph,
+                     int32_t field) {
+  jumanpp_string result;
+  auto status = jumanpp_result_string(ana, sent, morph, field, &result);
+  if (status != JUMANPP_OK) {
+    return "<error>";
+  }
+  return std::string{result.data, result.length};
+}
+
+}  // namespace
+
+TEST_CASE("api exposes model fields") {
+  ApiTestEnv env;
+  CHECK(jumanpp_api_version() == JUMANPP_API_VERSION);
+  REQUIRE(jumanpp_model_num_fields(env.model) == 2);
+  CHECK(std::strcmp(jumanpp_model_field_name(env.model, 0), "a") == 0);
+  CHECK(std::strcmp(jumanpp_model_field_name(env.model, 1), "b") == 0);
+  CHECK(jumanpp_model_field_name(env.model, 2) == nullptr);
+  CHECK(jumanpp_model_field_type(env.model, 1) == JUMANPP_FIELD_STRING);
+  CHECK(jumanpp_model_field_index(env.model, "b") == 1);
+  CHECK(jumanpp_model_field_index(env.model, "c") == -1);
+}
+
+TEST_CASE("api analyzes a batch of sentences") {
+  ApiTestEnv env;
+  jumanpp_analyzer* ana = nullptr;
+  REQUIRE(jumanpp_analyzer_create(env.model, nullptr, &ana) == JUMANPP_OK);
+
+  std::string data = "XXXYYYXXXアイウXXX";
+  jumanpp_string sents[] = {
+      {data.data(), 6}, {data.data() + 6, data.size() - 6}, {data.data(), 0}};
+  REQUIRE(jumanpp_analyze_batch(ana, sents, 3) == JUMANPP_OK);
+  REQUIRE(jumanpp_result_num_sentences(ana) == 3);
+
+  for (size_t s = 0; s < 3; ++s) {
+    CAPTURE(s);
+    CHECK(jumanpp_result_status(ana, s) == JUMANPP_OK);
+    size_t count = 0;
+    auto morphs = jumanpp_result_morphemes(ana, s, &count);
+    auto values = jumanpp_result_values(ana, s);
+    u32 position = 0;
+    for (size_t m = 0; m < count; ++m) {
+      CAPTURE(m);
+      CHECK(morphs[m].begin == position);
+      CHECK(morphs[m].begin < morphs[m].end);
+      position = morphs[m].end;
+      std::string surface{sents[s].data + morphs[m].begin,
+                          morphs[m].end - morphs[m].begin};
+      // field a is the surface, both for dictionary and unknown words
+      CHECK(stringOf(ana, s, m, 0) == surface);
+      bool inDictionary = surface[0] == 'X' || surface[0] == 'Y';
+      if (!inDictionary) {
+        CHECK(values[m * 2] < 0);
+      } else {
+        CHECK(values[m * 2] >= 0);
+        jumanpp_string str;
+        REQUIRE(jumanpp_model_string(env.model, 0, values[m * 2], &str) ==
+                JUMANPP_OK);
+        CHECK(std::string(str.data, str.length) == surface);
+      }
+    }
+    CHECK(position == sents[s].length);
+  }
+
+  size_t count = 0;
+  jumanpp_result_morphemes(ana, 2, &count);
+  CHECK(count == 0);
+  jumanpp_string unused;
+  CHECK(jumanpp_result_string(ana, 2, 0, 0, &unused) ==
+        JUMANPP_INVALID_ARGUMENT);
+  CHECK(jumanpp_result_morphemes(ana, 3, &count) == nullptr);
+
+  jumanpp_analyzer_free(ana);
+}
+
+TEST_CASE("api reports failed sentences and continues the batch") {
+  ApiTestEnv env;
+  jumanpp_analyzer_config conf;
+  jumanpp_analyzer_config_default(&conf);
+  conf.max_input_bytes = 8;
+  jumanpp_analyzer* ana = nullptr;
+  REQUIRE(jumanpp_analyzer_create(env.model, &conf, &ana) == JUMANPP_OK);
+  jumanpp_analyzer* other = nullptr;
+  REQUIRE(jumanpp_analyzer_create(env.model, nullptr, &other) == JUMANPP_OK);
+
+  std::string data = "XXXYYYXXXYYY";
+  jumanpp_string sents[] = {{data.data(), data.size()}, {data.data(), 3}};
+  CHECK(jumanpp_analyze_batch(ana, sents, 2) == JUMANPP_ANALYSIS_FAILED);
+  CHECK(std::strlen(jumanpp_last_error()) > 0);
+  CHECK(jumanpp_result_status(ana, 0) == JUMANPP_ANALYSIS_FAILED);
+  CHECK(jumanpp_result_status(ana, 1) == JUMANPP_OK);
+  size_t count = 1;
+  jumanpp_result_morphemes(ana, 0, &count);
+  CHECK(count == 0);
+  jumanpp_result_morphemes(ana, 1, &count);
+  CHECK(count == 1);
+  CHECK(stringOf(ana, 1, 0, 1) == "a");
+
+  // analyzers of the same model are independent
+  CHECK(jumanpp_analyze_batch(other, sents, 2) == JUMANPP_OK);
+  CHECK(jumanpp_result_status(ana, 0) == JUMANPP_ANALYSIS_FAILED);
+
+  jumanpp_analyzer_free(other);
+  jumanpp_analyzer_free(ana);
+}
+
+TEST_CASE("api reports model loading errors") {
+  jumanpp_model* model = nullptr;
+  CHECK(jumanpp_model_load("/this/file/does/not/exist", &model) ==
+        JUMANPP_ERROR);
+  CHECK(model == nullptr);
+  CHECK(std::strlen(jumanpp_last_error()) > 0);
+  CHECK(jumanpp_model_load(nullptr, &model) == JUMANPP_INVALID_ARGUMENT);
+}
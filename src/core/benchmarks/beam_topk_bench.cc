@@ -0,0 +1,89 @@
+#define BENCHPRESS_CONFIG_MAIN
+
+#include <algorithm>
+#include <benchpress/benchpress.hpp>
+#include <functional>
+#include <random>
+#include <vector>
+#include "core/analysis/beam_topk.h"
+#include "util/stl_util.h"
+
+using namespace jumanpp;
+using namespace jumanpp::core::analysis;
+
+// a local beam is selected from 10-100 candidates,
+// a global beam from a few hundred
+volatile u32 numCandidates = 50;
+volatile u32 numGlobalCandidates = 300;
+volatile u32 beamSize = 5;
+volatile u32 globalBeamSize = 16;
+constexpr u32 NumInputs = 1000;
+
+struct Inputs {
+  std::vector<std::vector<u64>> keys;
+
+  explicit Inputs(u32 size) {
+    std::mt19937_64 rng{0xfeed};
+    keys.resize(NumInputs);
+    for (auto& k : keys) {
+      k.resize(size);
+      for (auto& x : k) {
+        x = rng();
+      }
+    }
+  }
+};
+
+JPP_NO_INLINE u64 partitionSort(std::vector<u64>* buffer,
+                                const std::vector<u64>& keys, u32 k) {
+  buffer->assign(keys.begin(), keys.end());
+  auto comp = std::greater<u64>();
+  auto b = buffer->begin();
+  auto e = buffer->end();
+  if (buffer->size() > k * 2) {
+    e = util::partition(b, e, comp, k, k * 2);
+  }
+  std::sort(b, e, comp);
+  return buffer->at(k - 1);
+}
+
+JPP_NO_INLINE u64 smallTopKCopy(std::vector<u64>* buffer,
+                                const std::vector<u64>& keys, u32 k) {
+  // the old code copied candidates as well, keep it fair
+  buffer->assign(keys.begin(), keys.end());
+  u64 result[MaxSmallTopK];
+  auto data = buffer->data();
+  auto count = smallTopK(static_cast<u32>(buffer->size()), k,
+                         [data](u32 i) { return data[i]; }, result);
+  return result[count - 1];
+}
+
+template <typename Fn>
+void runBench(benchpress::context* ctx, u32 size, u32 k, Fn fn) {
+  Inputs inputs{size};
+  std::vector<u64> buffer;
+  u64 sum = 0;
+  ctx->reset_timer();
+  for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+    for (auto& keys : inputs.keys) {
+      sum += fn(&buffer, keys, k);
+    }
+  }
+  benchpress::escape(&sum);
+}
+
+BENCHMARK("beam-partition-sort", [](benchpress::context* ctx) {
+  runBench(ctx, numCandidates, beamSize, partitionSort);
+});
+
+BENCHMARK("beam-small-topk", [](benchpress::context* ctx) {
+  runBench(ctx, numCandidates, beamSize, smallTopKCopy);
+});
+
+BENCHMARK("global-beam-partition-sort", [](benchpress::context* ctx) {
+  runBench(ctx, numGlobalCandidates, globalBeamSize, partitionSort);
+});
+
+BENCHMARK("global-beam-small-topk", [](benchpress::context* ctx) {
+  runBench(ctx, numGlobalCandidates, globalBeamSize, smallTopKCopy);
+});
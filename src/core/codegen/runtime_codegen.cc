@@ -0,0 +1,262 @@
+#include "runtime_codegen.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "core/codegen/feature_codegen.h"
+#include "core/spec/spec_hashing.h"
+#include "core_config.h"
+#include "core_version.h"
+#include "pathie-cpp/include/path.hpp"
+#include "util/murmur_hash.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define JPP_RUNTIME_CODEGEN 1
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace jumanpp {
+namespace core {
+namespace features {
+namespace codegen {
+
+namespace {
+
+constexpr const char* EntryFunction = "jpp_runtime_static_features";
+using EntryFunctionType = const StaticFeatureFactory* (*)();
+
+std::string hexString(u64 value) {
+  char buffer[17];
+  std::snprintf(buffer, sizeof(buffer), "%016llx",
+                static_cast<unsigned long long>(value));
+  return buffer;
+}
+
+u64 hashString(u64 seed, StringPiece data) {
+  return util::hashing::murmurhash3_memory(data.ubegin(), data.uend(), seed);
+}
+
+std::vector<std::string> splitFlags(const std::string& flags) {
+  std::vector<std::string> result;
+  std::istringstream iss{flags};
+  std::string flag;
+  while (iss >> flag) {
+    result.push_back(flag);
+  }
+  return result;
+}
+
+Status writeEntry(const std::string& filename, StringPiece header,
+                  StringPiece className) {
+  std::ofstream ofs{filename};
+  ofs << "#include \"" << header << "\"\n\n"
+      << "extern \"C\" const jumanpp::core::features::StaticFeatureFactory* "
+      << EntryFunction << "() {\n"
+      << "  static jumanpp_generated::" << className << " factory;\n"
+      << "  return &factory;\n"
+      << "}\n";
+  if (!ofs) {
+    return JPPS_INVALID_STATE << "failed to write " << filename;
+  }
+  return Status::Ok();
+}
+
+std::string readLog(const std::string& filename) {
+  std::ifstream ifs{filename};
+  std::string result{std::istreambuf_iterator<char>{ifs},
+                     std::istreambuf_iterator<char>{}};
+  constexpr size_t MaxLength = 4096;
+  if (result.size() > MaxLength) {
+    result.resize(MaxLength);
+    result += "...";
+  }
+  return result;
+}
+
+#ifdef JPP_RUNTIME_CODEGEN
+
+Status runCompiler(const std::vector<std::string>& args,
+                   const std::string& logFile) {
+  std::vector<char*> argv;
+  for (auto& a : args) {
+    argv.push_back(const_cast<char*>(a.c_str()));
+  }
+  argv.push_back(nullptr);
+
+  auto pid = fork();
+  if (pid < 0) {
+    return JPPS_INVALID_STATE << "failed to start the compiler " << args[0];
+  }
+  if (pid == 0) {
+    auto log = open(logFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (log >= 0) {
+      dup2(log, STDOUT_FILENO);
+      dup2(log, STDERR_FILENO);
+      close(log);
+    }
+    execvp(argv[0], argv.data());
+    _exit(127);
+  }
+
+  int status = 0;
+  if (waitpid(pid, &status, 0) != pid) {
+    return JPPS_INVALID_STATE << "failed to wait for the compiler " << args[0];
+  }
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    return JPPS_INVALID_STATE << "compiler " << args[0]
+                              << " failed, output:\n"
+                              << readLog(logFile);
+  }
+  return Status::Ok();
+}
+
+#endif  // JPP_RUNTIME_CODEGEN
+
+}  // namespace
+
+RuntimeCodegenConfig::RuntimeCodegenConfig()
+    : compiler{JPP_RUNTIME_CXX_COMPILER}, flags{JPP_RUNTIME_CXX_FLAGS} {}
+
+RuntimeFeatures::~RuntimeFeatures() {
+#ifdef JPP_RUNTIME_CODEGEN
+  if (handle_ != nullptr) {
+    dlclose(handle_);
+  }
+#endif
+}
+
+Status RuntimeFeatures::initialize(const RuntimeCodegenConfig& config,
+                                   const spec::AnalysisSpec& spec) {
+#ifdef JPP_RUNTIME_CODEGEN
+  if (handle_ != nullptr) {
+    return JPPS_INVALID_STATE << "runtime features were already loaded from "
+                              << library_;
+  }
+  if (config.cacheDirectory.empty()) {
+    return JPPS_INVALID_PARAMETER
+           << "cache directory for runtime features was not specified";
+  }
+
+  auto specHash = spec::hashSpec(spec);
+  auto buildHash = hashString(0x5512ae2fd0c1ULL, JPP_VERSION_STRING);
+  buildHash = hashString(buildHash, JPP_RUNTIME_BUILD_ID);
+  buildHash = hashString(buildHash, config.compiler);
+  buildHash = hashString(buildHash, config.flags);
+
+  Pathie::Path cacheDir{config.cacheDirectory};
+  try {
+    cacheDir.mktree();
+  } catch (std::exception& e) {
+    return JPPS_INVALID_PARAMETER << "failed to create cache directory "
+                                  << config.cacheDirectory << ": " << e.what();
+  }
+
+  auto library = cacheDir.join("features_" + hexString(specHash) + "_" +
+                               hexString(buildHash).substr(0, 8) + ".so");
+  library_ = library.str();
+  fromCache_ = library.exists();
+  if (!fromCache_) {
+    JPP_RETURN_IF_ERROR(compile(config, spec, library_));
+  }
+  return load(library_, specHash);
+#else
+  return JPPS_NOT_IMPLEMENTED
+         << "runtime feature compilation is supported only on POSIX systems";
+#endif
+}
+
+Status RuntimeFeatures::compile(const RuntimeCodegenConfig& config,
+                                const spec::AnalysisSpec& spec,
+                                const std::string& library) {
+#ifdef JPP_RUNTIME_CODEGEN
+  // every process builds in its own directory,
+  // the library appears in the cache with an atomic rename
+  auto pid = std::to_string(getpid());
+  Pathie::Path workDir{library + "." + pid + ".tmp"};
+  try {
+    workDir.mktree();
+  } catch (std::exception& e) {
+    return JPPS_INVALID_STATE << "failed to create directory " << workDir.str()
+                              << ": " << e.what();
+  }
+
+  FeatureCodegenConfig cgconf;
+  cgconf.baseDirectory = workDir.str();
+  cgconf.filename = "runtime_features";
+  cgconf.className = "RuntimeFeatures";
+  StaticFeatureCodegen codegen{cgconf, spec};
+  Status s = codegen.generateAndWrite();
+  auto entry = workDir.join("entry.cc").str();
+  if (s) {
+    s = writeEntry(entry, "runtime_features.h", cgconf.className);
+  }
+
+  auto output = workDir.join("features.so").str();
+  if (s) {
+    std::vector<std::string> args{config.compiler};
+    for (auto& flag : splitFlags(config.flags)) {
+      args.push_back(flag);
+    }
+    args.push_back("-I" + workDir.str());
+    args.push_back("-o");
+    args.push_back(output);
+    args.push_back(workDir.join("runtime_features.cc").str());
+    args.push_back(entry);
+    s = runCompiler(args, workDir.join("compiler.log").str());
+  }
+
+  if (s && std::rename(output.c_str(), library.c_str()) != 0) {
+    s = JPPS_INVALID_STATE << "failed to move compiled features to "
+                           << library;
+  }
+
+  if (s) {
+    try {
+      workDir.rmtree();
+    } catch (std::exception&) {
+      // leftovers do not prevent using the library
+    }
+  }
+
+  JPP_RIE_MSG(std::move(s), "failed to compile features in " << workDir.str());
+  return Status::Ok();
+#else
+  return JPPS_NOT_IMPLEMENTED;
+#endif
+}
+
+Status RuntimeFeatures::load(const std::string& library, u64 specHash) {
+#ifdef JPP_RUNTIME_CODEGEN
+  auto handle = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (handle == nullptr) {
+    return JPPS_INVALID_STATE << "failed to load " << library << ": "
+                              << dlerror();
+  }
+  auto entry = reinterpret_cast<EntryFunctionType>(
+      dlsym(handle, EntryFunction));
+  if (entry == nullptr) {
+    dlclose(handle);
+    return JPPS_INVALID_STATE << library << " did not have function "
+                              << EntryFunction;
+  }
+  auto factory = entry();
+  if (factory->runtimeHash() != specHash) {
+    auto hash = factory->runtimeHash();
+    dlclose(handle);
+    return JPPS_INVALID_STATE << library << " was generated for spec hash "
+                              << hash << " instead of " << specHash;
+  }
+  handle_ = handle;
+  factory_ = factory;
+  return Status::Ok();
+#else
+  return JPPS_NOT_IMPLEMENTED;
+#endif
+}
+
+}  // namespace codegen
+}  // namespace features
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,67 @@
+#ifndef JUMANPP_RUNTIME_CODEGEN_H
+#define JUMANPP_RUNTIME_CODEGEN_H
+
+#include "core/features_api.h"
+#include "core/spec/spec_types.h"
+
+namespace jumanpp {
+namespace core {
+namespace features {
+namespace codegen {
+
+struct RuntimeCodegenConfig {
+  // compiled libraries are stored here and reused by later runs
+  std::string cacheDirectory;
+  // defaults are the compiler and include paths of this build
+  std::string compiler;
+  std::string flags;
+
+  RuntimeCodegenConfig();
+};
+
+/**
+ * Static features for a spec which is known only at runtime.
+ *
+ * The code is generated by StaticFeatureCodegen, compiled into a shared
+ * library by the system compiler and loaded with dlopen.
+ * Libraries are cached by spec hash, binary version, build identity
+ * (git commit and build options) and compiler flags.
+ *
+ * Generated code needs headers from the source tree this binary was built
+ * from and resolves a few symbols from the loading executable,
+ * which must export them (ENABLE_EXPORTS in CMake).
+ * Available only on POSIX systems.
+ */
+class RuntimeFeatures {
+  void* handle_ = nullptr;
+  const StaticFeatureFactory* factory_ = nullptr;
+  std::string library_;
+  bool fromCache_ = false;
+
+  Status compile(const RuntimeCodegenConfig& config,
+                 const spec::AnalysisSpec& spec, const std::string& library);
+  Status load(const std::string& library, u64 specHash);
+
+ public:
+  RuntimeFeatures() = default;
+  RuntimeFeatures(const RuntimeFeatures&) = delete;
+  RuntimeFeatures& operator=(const RuntimeFeatures&) = delete;
+  ~RuntimeFeatures();
+
+  /**
+   * Loads a cached library for the spec or generates and compiles it.
+   */
+  Status initialize(const RuntimeCodegenConfig& config,
+                    const spec::AnalysisSpec& spec);
+
+  const StaticFeatureFactory* factory() const { return factory_; }
+  const std::string& library() const { return library_; }
+  bool fromCache() const { return fromCache_; }
+};
+
+}  // namespace codegen
+}  // namespace features
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_RUNTIME_CODEGEN_H
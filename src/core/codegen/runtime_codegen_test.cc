@@ -0,0 +1,112 @@
+#include "core/codegen/runtime_codegen.h"
+#include <array>
+#include "cg_2_spec.h"
+#include "core/impl/feature_impl_combine.h"
+#include "core/spec/spec_hashing.h"
+#include "pathie-cpp/include/path.hpp"
+#include "testing/test_analyzer.h"
+
+using namespace jumanpp::testing;
+using namespace jumanpp::core::spec::dsl;
+using namespace jumanpp;
+namespace cg = jumanpp::core::features::codegen;
+
+namespace {
+
+constexpr size_t NumNgrams = 14;
+constexpr size_t NumExamples = 10;
+constexpr size_t NumFeatures = 5;
+
+template <typename T, size_t N>
+util::Sliceable<T> slice(std::array<T, N>* slc, size_t rows) {
+  util::MutableArraySlice<T> mas{slc->data(), N};
+  return util::Sliceable<T>{mas, slc->size() / rows, rows};
+}
+
+struct NgramInput {
+  std::array<u32, NumNgrams * NumExamples> result;
+  std::array<u64, NumFeatures * NumExamples> t0;
+  std::array<u64, NumFeatures> t1;
+  std::array<u64, NumFeatures> t2;
+
+  NgramInput() {
+    for (int f = 0; f < NumFeatures; ++f) {
+      for (int ex = 0; ex < NumExamples; ++ex) {
+        t0.at(f + ex * NumFeatures) = 10000 + 1000 * f + ex * 2;
+      }
+      t1.at(f) = 20000 + f * 2;
+      t2.at(f) = 30000 + f * 2;
+    }
+  }
+
+  core::features::impl::NgramFeatureData features() {
+    util::MutableArraySlice<u64> t1s{&t1};
+    util::MutableArraySlice<u64> t2s{&t2};
+    return {slice(&result, NumExamples), t2s, t1s, slice(&t0, NumExamples)};
+  }
+};
+
+class CacheDirectory {
+  TempFile name_;
+
+ public:
+  const std::string& name() const { return name_.name(); }
+
+  ~CacheDirectory() { Pathie::Path{name_.name()}.rmtree(); }
+};
+
+}  // namespace
+
+TEST_CASE("runtime compiled features are the same as dynamic ones") {
+  TestEnv env;
+  env.spec([](ModelSpecBuilder& msb) {
+    jumanpp::codegentest::CgTwoSpecFactory::fillSpec(msb);
+  });
+  env.importDic("a,b,c\nc,d,e\nf,g,h\n");
+
+  CacheDirectory cache;
+  cg::RuntimeCodegenConfig conf;
+  conf.cacheDirectory = cache.name();
+  cg::RuntimeFeatures features;
+  REQUIRE_OK(features.initialize(conf, env.restoredDic.spec));
+  CHECK_FALSE(features.fromCache());
+  REQUIRE(features.factory() != nullptr);
+  CHECK(features.factory()->runtimeHash() ==
+        core::spec::hashSpec(env.restoredDic.spec));
+
+  JumanppEnv jenv;
+  env.loadEnv(&jenv);
+  REQUIRE_OK(jenv.initFeatures(features.factory()));
+  auto& fs = jenv.coreHolder()->features();
+  REQUIRE(fs.ngramStatic != nullptr);
+  REQUIRE(fs.patternStatic != nullptr);
+
+  NgramInput dynamic;
+  NgramInput compiled;
+  auto d1 = dynamic.features();
+  auto d2 = compiled.features();
+  fs.ngramDynamic->applyBatch(&d1);
+  fs.ngramStatic->applyBatch(&d2);
+  CHECK(dynamic.result == compiled.result);
+
+  cg::RuntimeFeatures cached;
+  REQUIRE_OK(cached.initialize(conf, env.restoredDic.spec));
+  CHECK(cached.fromCache());
+  CHECK(cached.library() == features.library());
+}
+
+TEST_CASE("runtime compilation reports compiler errors") {
+  TestEnv env;
+  env.spec([](ModelSpecBuilder& msb) {
+    jumanpp::codegentest::CgTwoSpecFactory::fillSpec(msb);
+  });
+  env.importDic("a,b,c\n");
+
+  CacheDirectory cache;
+  cg::RuntimeCodegenConfig conf;
+  conf.cacheDirectory = cache.name();
+  conf.flags += " -include nonexistent_header.h";
+  cg::RuntimeFeatures features;
+  CHECK_FALSE(features.initialize(conf, env.restoredDic.spec));
+  CHECK(features.factory() == nullptr);
+}
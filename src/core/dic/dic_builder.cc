@@ -85,14 +85,18 @@ void Serialize(Arch &a, BuiltDictionary &o) {
   a &o.spec;
 }
 
+void BuiltDictionary::saveMetadata(util::CodedBuffer *result) const {
+  util::serialization::Saver saver{result};
+  saver.save(*this);
+}
+
 Status DictionaryBuilder::fillModelPart(model::ModelPart *part,
                                         StringPiece comment) {
   if (!dic_) {
     return Status::InvalidState() << "dictionary is not built yet";
   }
 
-  util::serialization::Saver dicDataSaver{&storage_->builtDicData};
-  dicDataSaver.save(*dic_);
+  dic_->saveMetadata(&storage_->builtDicData);
 
   part->kind = model::ModelPartKind::Dictionary;
   part->comment = comment.str();
@@ -9,6 +9,7 @@
 #include <vector>
 #include "core/impl/model_format.h"
 #include "core/spec/spec_types.h"
+#include "util/coded_io.h"
 #include "util/status.hpp"
 
 namespace jumanpp {
@@ -41,6 +42,12 @@ struct BuiltDictionary {
   spec::AnalysisSpec spec;
   i64 timestamp = 0;
   Status restoreDictionary(const model::ModelInfo& info);
+
+  /**
+   * Saves the serialized metadata (including the spec) to the buffer.
+   * It is the first chunk of the dictionary model part.
+   */
+  void saveMetadata(util::CodedBuffer* result) const;
 };
 
 struct DictionaryBuilderStorage;
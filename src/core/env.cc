@@ -112,6 +112,19 @@ void JumanppEnv::setAutoBeam(i32 base, i32 step, i32 max) {
   analyzerConfig_.autoBeamMax = max;
 }
 
+void JumanppEnv::setGlobalBeamMargin(float margin, i32 minBeam) {
+  analyzerConfig_.globalBeamMargin = margin;
+  analyzerConfig_.globalBeamMinSize = minBeam;
+}
+
+void JumanppEnv::setPrepruneMargin(float margin) {
+  analyzerConfig_.prepruneMargin = margin;
+}
+
+void JumanppEnv::setUnkLimits(const analysis::UnkSpanLimits& limits) {
+  analyzerConfig_.unkLimits = limits;
+}
+
 void JumanppEnv::fillVersion(VersionInfo* result) const {
   result->binary = JPP_VERSION_STRING.str();
   using model::ModelPartKind;
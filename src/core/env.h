@@ -6,6 +6,7 @@
 #define JUMANPP_ENV_H
 
 #include "core/analysis/analyzer.h"
+#include "core/analysis/batch_analyzer.h"
 #include "core/analysis/perceptron.h"
 #include "core/analysis/rnn_scorer_gbeam.h"
 #include "core/impl/model_io.h"
@@ -50,12 +51,35 @@ class JumanppEnv {
   void setRnnHolder(analysis::RnnScorerGbeamFactory* holder);
 
   Status makeAnalyzer(analysis::Analyzer* result) const {
+    return makeAnalyzer(result, analyzerConfig_, scoringConf_.beamSize);
+  }
+
+  /**
+   * Makes an analyzer which uses the given configuration instead of the one
+   * of this environment. Analyzers share the model in both cases.
+   */
+  Status makeAnalyzer(analysis::Analyzer* result,
+                      const analysis::AnalyzerConfig& config,
+                      i32 beamSize) const {
+    if (!hasPerceptronModel()) {
+      return Status::InvalidState()
+             << "loaded model (" << modelFile_.name() << ") was not trained";
+    }
+    ScoringConfig scoring = scoringConf_;
+    scoring.beamSize = beamSize;
+    JPP_RETURN_IF_ERROR(
+        result->initialize(coreHolder(), config, scoring, &scorers_));
+    return Status::Ok();
+  }
+
+  Status makeBatchAnalyzer(analysis::BatchAnalyzer* result,
+                           const analysis::BatchAnalyzerConfig& bconf) const {
     if (!hasPerceptronModel()) {
       return Status::InvalidState()
              << "loaded model (" << modelFile_.name() << ") was not trained";
     }
     JPP_RETURN_IF_ERROR(result->initialize(coreHolder(), analyzerConfig_,
-                                           scoringConf_, &scorers_));
+                                           scoringConf_, &scorers_, bconf));
     return Status::Ok();
   }
 
@@ -63,6 +87,9 @@ class JumanppEnv {
 
   void setGlobalBeam(i32 globalBeam, i32 rightCheck, i32 rightBeam);
   void setAutoBeam(i32 base, i32 step, i32 max);
+  void setGlobalBeamMargin(float margin, i32 minBeam);
+  void setPrepruneMargin(float margin);
+  void setUnkLimits(const analysis::UnkSpanLimits& limits);
 
   const analysis::FeatureScorer* featureScorer() const { return &perceptron_; }
 
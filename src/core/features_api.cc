@@ -4,6 +4,7 @@
 
 #include "features_api.h"
 #include "core/core.h"
+#include "core/impl/feature_impl_bytecode.h"
 #include "core/impl/feature_impl_combine.h"
 #include "core/impl/feature_impl_compute.h"
 #include "core/impl/feature_impl_ngram_partial.h"
@@ -19,7 +20,7 @@ Status makeFeatures(const CoreHolder &info, const StaticFeatureFactory *sff,
                     FeatureHolder *result) {
   impl::FeatureConstructionContext fcc{&info.dic().fields()};
   auto &runtimeFeatures = info.spec().features;
-  auto dynPattern = new impl::PatternDynamicApplyImpl;
+  auto dynPattern = new impl::PatternBytecodeApplyImpl;
   result->patternDynamic.reset(dynPattern);
   JPP_RETURN_IF_ERROR(dynPattern->initialize(&fcc, info.spec().features));
 
@@ -0,0 +1,279 @@
+#include "feature_impl_bytecode.h"
+
+namespace jumanpp {
+namespace core {
+namespace features {
+namespace impl {
+
+constexpr u32 PatternBytecodeApplyImpl::BlockSize;
+constexpr u32 PatternBytecodeApplyImpl::MaxRegisters;
+constexpr u32 PatternBytecodeApplyImpl::NoCondition;
+
+struct PatternBytecodeApplyImpl::Block {
+  PrimitiveFeatureContext* pfc;
+  u32 size;
+  const NodeInfo* infos[BlockSize];
+  util::ArraySlice<i32> entries[BlockSize];
+  util::MutableArraySlice<u64> results[BlockSize];
+  u64 hashes[BlockSize];
+  u64 registers[MaxRegisters * BlockSize];
+
+  u64* reg(u32 idx) noexcept { return registers + idx * BlockSize; }
+};
+
+namespace {
+
+template <typename Impl>
+Status addPrimitive(FeatureConstructionContext* ctx,
+                    const spec::PrimitiveFeatureDescriptor& f, u32 reg,
+                    std::vector<Impl>* ops) {
+  ops->emplace_back();
+  auto& op = ops->back();
+  op.reg = reg;
+  JPP_RIE_MSG(op.impl.initialize(ctx, f),
+              "failed to initialize feature: " << f.name);
+  return Status::Ok();
+}
+
+template <typename Op, typename Block>
+inline JPP_ALWAYS_INLINE void evalPrimitives(const std::vector<Op>& ops,
+                                             Block* block) noexcept {
+  for (auto& op : ops) {
+    auto reg = block->reg(op.reg);
+    for (u32 i = 0; i < block->size; ++i) {
+      reg[i] = op.impl.access(block->pfc, *block->infos[i], block->entries[i]);
+    }
+  }
+}
+
+}  // namespace
+
+Status PatternBytecodeApplyImpl::compileCompute(
+    const spec::FeaturesSpec& spec) {
+  auto numPrims = spec.primitive.size();
+  auto addOperand = [&](i32 prim) -> Status {
+    if (prim < 0 || prim >= numPrims) {
+      return JPPS_INVALID_PARAMETER << "a primitive feature idx=" << prim
+                                    << " was not available";
+    }
+    operands_.push_back(static_cast<u32>(prim));
+    return Status::Ok();
+  };
+
+  for (auto& cf : spec.computation) {
+    ComputeOp op;
+    JPP_CAPTURE(cf.name);
+    if (cf.trueBranch.empty() && cf.falseBranch.empty()) {
+      op.condition = NoCondition;
+      op.trueBegin = static_cast<u32>(operands_.size());
+      JPP_RETURN_IF_ERROR(addOperand(cf.primitiveFeature));
+      op.trueEnd = static_cast<u32>(operands_.size());
+      op.falseBegin = op.falseEnd = op.trueEnd;
+    } else {
+      JPP_RETURN_IF_ERROR(addOperand(cf.primitiveFeature));
+      op.condition = operands_.back();
+      operands_.pop_back();
+      op.trueBegin = static_cast<u32>(operands_.size());
+      for (auto p : cf.trueBranch) {
+        JPP_RETURN_IF_ERROR(addOperand(p));
+      }
+      op.trueEnd = op.falseBegin = static_cast<u32>(operands_.size());
+      for (auto p : cf.falseBranch) {
+        JPP_RETURN_IF_ERROR(addOperand(p));
+      }
+      op.falseEnd = static_cast<u32>(operands_.size());
+    }
+    compute_.push_back(op);
+  }
+
+  for (auto& pf : spec.pattern) {
+    for (auto ref : pf.references) {
+      if (ref < 0 || ref >= compute_.size()) {
+        return JPPS_INVALID_PARAMETER
+               << "compute feature is out of bound: " << ref
+               << " for pattern " << pf.index;
+      }
+    }
+  }
+  return Status::Ok();
+}
+
+Status PatternBytecodeApplyImpl::compileProgram(
+    FeatureConstructionContext* ctx, const spec::FeaturesSpec& spec,
+    u32 firstPattern, Program* program) {
+  std::vector<bool> used(spec.primitive.size(), false);
+  for (u32 i = firstPattern; i < spec.pattern.size(); ++i) {
+    auto& pf = spec.pattern[i];
+    PatternOp op;
+    auto u32idx = static_cast<u32>(pf.index);
+    op.seed = fh{}
+                  .mix(u32idx)
+                  .mix(pf.references.size())
+                  .mix(PatternFeatureSeed)
+                  .result();
+    op.index = u32idx;
+    op.computeBegin = static_cast<u32>(patternCompute_.size());
+    for (auto ref : pf.references) {
+      patternCompute_.push_back(static_cast<u32>(ref));
+      auto& cop = compute_[ref];
+      if (cop.condition != NoCondition) {
+        used[cop.condition] = true;
+      }
+      for (u32 j = cop.trueBegin; j < cop.falseEnd; ++j) {
+        used[operands_[j]] = true;
+      }
+    }
+    op.computeEnd = static_cast<u32>(patternCompute_.size());
+    program->patterns.push_back(op);
+  }
+
+  for (u32 reg = 0; reg < spec.primitive.size(); ++reg) {
+    if (!used[reg]) {
+      continue;
+    }
+    auto& f = spec.primitive[reg];
+    auto& p = *program;
+    switch (f.kind) {
+      case PrimitiveFeatureKind::Copy:
+        JPP_RETURN_IF_ERROR(addPrimitive(ctx, f, reg, &p.copy));
+        break;
+      case PrimitiveFeatureKind::SingleBit:
+        JPP_RETURN_IF_ERROR(addPrimitive(ctx, f, reg, &p.shiftMask));
+        break;
+      case PrimitiveFeatureKind::Provided:
+        JPP_RETURN_IF_ERROR(addPrimitive(ctx, f, reg, &p.provided));
+        break;
+      case PrimitiveFeatureKind::ByteLength:
+        JPP_RETURN_IF_ERROR(addPrimitive(ctx, f, reg, &p.byteLength));
+        break;
+      case PrimitiveFeatureKind::CodepointSize:
+        JPP_RETURN_IF_ERROR(addPrimitive(ctx, f, reg, &p.codepointLength));
+        break;
+      case PrimitiveFeatureKind::SurfaceCodepointSize:
+        JPP_RETURN_IF_ERROR(addPrimitive(ctx, f, reg, &p.surfaceLength));
+        break;
+      case PrimitiveFeatureKind::Codepoint:
+        JPP_RETURN_IF_ERROR(addPrimitive(ctx, f, reg, &p.codepoint));
+        break;
+      case PrimitiveFeatureKind::CodepointType:
+        JPP_RETURN_IF_ERROR(addPrimitive(ctx, f, reg, &p.codepointType));
+        break;
+      default:
+        return JPPS_NOT_IMPLEMENTED << "Could not create feature: " << f.name
+                                    << " its type was not supported";
+    }
+  }
+  return Status::Ok();
+}
+
+Status PatternBytecodeApplyImpl::initialize(FeatureConstructionContext* ctx,
+                                            const spec::FeaturesSpec& spec) {
+  JPP_RETURN_IF_ERROR(reference_.initialize(ctx, spec));
+  if (spec.primitive.size() > MaxRegisters) {
+    fallback_ = true;
+    return Status::Ok();
+  }
+  JPP_RETURN_IF_ERROR(compileCompute(spec));
+  JPP_RETURN_IF_ERROR(compileProgram(ctx, spec, 0, &all_));
+  auto uniOnlyFirst =
+      static_cast<u32>(spec.pattern.size() - spec.numUniOnlyPats);
+  JPP_RETURN_IF_ERROR(compileProgram(ctx, spec, uniOnlyFirst, &uniOnly_));
+  return Status::Ok();
+}
+
+void PatternBytecodeApplyImpl::evaluateBlock(const Program& program,
+                                             Block* block) const noexcept {
+  evalPrimitives(program.copy, block);
+  evalPrimitives(program.shiftMask, block);
+  evalPrimitives(program.provided, block);
+  evalPrimitives(program.byteLength, block);
+  evalPrimitives(program.codepointLength, block);
+  evalPrimitives(program.surfaceLength, block);
+  evalPrimitives(program.codepoint, block);
+  evalPrimitives(program.codepointType, block);
+
+  auto size = block->size;
+  auto hashes = block->hashes;
+  for (auto& pat : program.patterns) {
+    for (u32 i = 0; i < size; ++i) {
+      hashes[i] = pat.seed;
+    }
+    for (u32 c = pat.computeBegin; c < pat.computeEnd; ++c) {
+      auto& op = compute_[patternCompute_[c]];
+      if (op.condition == NoCondition) {
+        for (u32 o = op.trueBegin; o < op.trueEnd; ++o) {
+          auto reg = block->reg(operands_[o]);
+          for (u32 i = 0; i < size; ++i) {
+            hashes[i] = fh{hashes[i]}.mix(reg[i]).result();
+          }
+        }
+      } else {
+        auto cond = block->reg(op.condition);
+        for (u32 i = 0; i < size; ++i) {
+          u32 begin = op.falseBegin;
+          u32 end = op.falseEnd;
+          if (cond[i] != 0) {
+            begin = op.trueBegin;
+            end = op.trueEnd;
+          }
+          fh hash{hashes[i]};
+          for (u32 o = begin; o < end; ++o) {
+            hash = hash.mix(block->reg(operands_[o])[i]);
+          }
+          hashes[i] = hash.result();
+        }
+      }
+    }
+    for (u32 i = 0; i < size; ++i) {
+      block->results[i].at(pat.index) = hashes[i];
+    }
+  }
+}
+
+void PatternBytecodeApplyImpl::evaluate(const Program& program,
+                                        PrimitiveFeatureContext* pfc,
+                                        PrimitiveFeatureData* data) const
+    noexcept {
+  Block block;
+  block.pfc = pfc;
+  block.size = 0;
+  while (data->next()) {
+    auto idx = block.size;
+    block.infos[idx] = &data->nodeInfo();
+    block.entries[idx] = data->entryData();
+    block.results[idx] = data->featureData();
+    block.size += 1;
+    if (block.size == BlockSize) {
+      evaluateBlock(program, &block);
+      block.size = 0;
+    }
+  }
+  if (block.size != 0) {
+    evaluateBlock(program, &block);
+  }
+}
+
+void PatternBytecodeApplyImpl::applyBatch(PrimitiveFeatureContext* pfc,
+                                          PrimitiveFeatureData* data) const
+    noexcept {
+  if (JPP_UNLIKELY(fallback_)) {
+    reference_.applyBatch(pfc, data);
+    return;
+  }
+  evaluate(all_, pfc, data);
+}
+
+void PatternBytecodeApplyImpl::applyUniOnly(PrimitiveFeatureContext* pfc,
+                                            PrimitiveFeatureData* data) const
+    noexcept {
+  if (JPP_UNLIKELY(fallback_)) {
+    reference_.applyUniOnly(pfc, data);
+    return;
+  }
+  evaluate(uniOnly_, pfc, data);
+}
+
+}  // namespace impl
+}  // namespace features
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,115 @@
+#ifndef JUMANPP_FEATURE_IMPL_BYTECODE_H
+#define JUMANPP_FEATURE_IMPL_BYTECODE_H
+
+#include "core/impl/feature_impl_pattern.h"
+
+namespace jumanpp {
+namespace core {
+namespace features {
+namespace impl {
+
+/**
+ * Pattern features of a spec compiled into flat instruction arrays.
+ *
+ * Nodes are processed in blocks of BlockSize.
+ * Primitive features are grouped by their kind and evaluated
+ * for the whole block into registers (a register per primitive feature).
+ * Then every pattern feature is mixed from the registers,
+ * looping over the block for every computation feature.
+ * There are no virtual calls per node and feature,
+ * unlike PatternDynamicApplyImpl.
+ *
+ * Computes the same values as PatternDynamicApplyImpl
+ * and falls back to it if a spec has too many primitive features.
+ */
+class PatternBytecodeApplyImpl final : public PatternFeatureApply {
+ public:
+  static constexpr u32 BlockSize = 8;
+  static constexpr u32 MaxRegisters = 256;
+
+ private:
+  static constexpr u32 NoCondition = ~0u;
+
+  template <typename Impl>
+  struct PrimitiveOp {
+    u32 reg;
+    Impl impl;
+  };
+
+  // A computation feature.
+  // Mixes [trueBegin, trueEnd) registers of operands_ into the hash
+  // if the condition register is not zero and [falseBegin, falseEnd)
+  // otherwise. Features without a condition always mix the true range.
+  struct ComputeOp {
+    u32 condition;
+    u32 trueBegin;
+    u32 trueEnd;
+    u32 falseBegin;
+    u32 falseEnd;
+  };
+
+  // A pattern feature.
+  // Starts from the seed and mixes [computeBegin, computeEnd) computation
+  // features of patternCompute_, then stores the result to index.
+  struct PatternOp {
+    u64 seed;
+    u32 index;
+    u32 computeBegin;
+    u32 computeEnd;
+  };
+
+  struct Program {
+    std::vector<PrimitiveOp<CopyPrimFeatureImpl>> copy;
+    std::vector<PrimitiveOp<ShiftMaskPrimFeatureImpl>> shiftMask;
+    std::vector<PrimitiveOp<ProvidedPrimFeatureImpl>> provided;
+    std::vector<PrimitiveOp<ByteLengthPrimFeatureImpl>> byteLength;
+    std::vector<PrimitiveOp<CodepointLengthPrimFeatureImpl>> codepointLength;
+    std::vector<PrimitiveOp<SurfaceCodepointLengthPrimFeatureImpl>>
+        surfaceLength;
+    std::vector<PrimitiveOp<CodepointFeatureImpl>> codepoint;
+    std::vector<PrimitiveOp<CodepointTypeFeatureImpl>> codepointType;
+    std::vector<PatternOp> patterns;
+  };
+
+  struct Block;
+
+  PatternDynamicApplyImpl reference_;
+  std::vector<ComputeOp> compute_;
+  std::vector<u32> operands_;
+  std::vector<u32> patternCompute_;
+  Program all_;
+  Program uniOnly_;
+  bool fallback_ = false;
+
+  Status compileCompute(const spec::FeaturesSpec& spec);
+  Status compileProgram(FeatureConstructionContext* ctx,
+                        const spec::FeaturesSpec& spec, u32 firstPattern,
+                        Program* program);
+
+  void evaluate(const Program& program, PrimitiveFeatureContext* pfc,
+                PrimitiveFeatureData* data) const noexcept;
+  void evaluateBlock(const Program& program, Block* block) const noexcept;
+
+ public:
+  Status initialize(FeatureConstructionContext* ctx,
+                    const spec::FeaturesSpec& spec);
+
+  void applyBatch(PrimitiveFeatureContext* pfc,
+                  PrimitiveFeatureData* data) const noexcept override;
+
+  void applyUniOnly(PrimitiveFeatureContext* pfc,
+                    PrimitiveFeatureData* data) const noexcept override;
+
+  const PrimitiveFeatureImpl* primitive(i32 idx) const override {
+    return reference_.primitive(idx);
+  }
+
+  bool usesFallback() const noexcept { return fallback_; }
+};
+
+}  // namespace impl
+}  // namespace features
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_FEATURE_IMPL_BYTECODE_H
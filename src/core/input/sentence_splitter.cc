@@ -0,0 +1,155 @@
+#include "core/input/sentence_splitter.h"
+#include <algorithm>
+#include <cstring>
+#include "util/characters.h"
+
+namespace jumanpp {
+namespace core {
+namespace input {
+
+constexpr u8 SentenceSplitter::Terminator;
+constexpr u8 SentenceSplitter::Closer;
+constexpr u8 SentenceSplitter::Newline;
+
+namespace {
+
+Status splitCodepoints(StringPiece data, std::vector<std::string>* result) {
+  std::vector<chars::InputCodepoint> codepoints;
+  JPP_RETURN_IF_ERROR(chars::preprocessRawData(data, &codepoints));
+  result->clear();
+  for (auto& cp : codepoints) {
+    result->push_back(cp.bytes.str());
+  }
+  return Status::Ok();
+}
+
+bool isContinuation(char c) { return (static_cast<u8>(c) & 0xc0) == 0x80; }
+
+}  // namespace
+
+SentenceSplitter::SentenceSplitter() {
+  std::fill(std::begin(leadBytes_), std::end(leadBytes_), 0);
+}
+
+Status SentenceSplitter::initialize(const SentenceSplitterConfig& config) {
+  JPP_RETURN_IF_ERROR(splitCodepoints(config.terminators, &terminators_));
+  JPP_RETURN_IF_ERROR(splitCodepoints(config.closers, &closers_));
+  std::fill(std::begin(leadBytes_), std::end(leadBytes_), 0);
+  for (auto& t : terminators_) {
+    if (t == "\n" || t == "\r") {
+      return JPPS_INVALID_PARAMETER
+             << "newlines can not be sentence terminators";
+    }
+    leadBytes_[static_cast<u8>(t[0])] |= Terminator;
+  }
+  for (auto& c : closers_) {
+    leadBytes_[static_cast<u8>(c[0])] |= Closer;
+  }
+  splitOnNewline_ = config.splitOnNewline;
+  if (splitOnNewline_) {
+    leadBytes_[static_cast<u8>('\n')] |= Newline;
+  }
+  maxBytes_ = config.maxBytes;
+  return Status::Ok();
+}
+
+size_t SentenceSplitter::matchAt(const std::vector<std::string>& patterns,
+                                 StringPiece data, size_t pos) {
+  auto left = data.size() - pos;
+  for (auto& p : patterns) {
+    if (p.size() <= left &&
+        std::memcmp(data.char_begin() + pos, p.data(), p.size()) == 0) {
+      return p.size();
+    }
+  }
+  return 0;
+}
+
+void SentenceSplitter::emit(StringPiece sentence,
+                            std::vector<StringPiece>* result) const {
+  while (maxBytes_ != 0 && sentence.size() > maxBytes_) {
+    size_t cut = maxBytes_;
+    while (cut > 0 && isContinuation(sentence[cut])) {
+      cut -= 1;
+    }
+    if (cut == 0) {
+      // not UTF-8, the analysis reports it
+      cut = maxBytes_;
+    }
+    result->push_back(sentence.take(cut));
+    sentence = sentence.from(cut);
+  }
+  if (!sentence.empty()) {
+    result->push_back(sentence);
+  }
+}
+
+void SentenceSplitter::split(StringPiece document,
+                             std::vector<StringPiece>* result) {
+  result->clear();
+  if (!splitOnNewline_) {
+    buffer_.clear();
+    for (auto c : document) {
+      if (c != '\n' && c != '\r') {
+        buffer_.push_back(c);
+      }
+    }
+    document = buffer_;
+  }
+
+  auto data = document.ubegin();
+  size_t size = document.size();
+  size_t start = 0;
+  size_t pos = 0;
+  while (pos < size) {
+    auto flags = leadBytes_[data[pos]];
+    if (JPP_LIKELY(flags == 0)) {
+      pos += 1;
+      continue;
+    }
+
+    if (flags & Newline) {
+      size_t end = pos;
+      if (end > start && data[end - 1] == '\r') {
+        end -= 1;
+      }
+      emit(document.slice(start, end), result);
+      pos += 1;
+      start = pos;
+      continue;
+    }
+
+    size_t length = 0;
+    if (flags & Terminator) {
+      length = matchAt(terminators_, document, pos);
+    }
+    if (length == 0) {
+      pos += 1;
+      continue;
+    }
+    pos += length;
+
+    // closing brackets and repeated terminators stay with the sentence
+    while (pos < size) {
+      auto next = leadBytes_[data[pos]];
+      length = 0;
+      if (next & Terminator) {
+        length = matchAt(terminators_, document, pos);
+      }
+      if (length == 0 && (next & Closer)) {
+        length = matchAt(closers_, document, pos);
+      }
+      if (length == 0) {
+        break;
+      }
+      pos += length;
+    }
+    emit(document.slice(start, pos), result);
+    start = pos;
+  }
+  emit(document.slice(start, size), result);
+}
+
+}  // namespace input
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,67 @@
+#ifndef JUMANPP_SENTENCE_SPLITTER_H
+#define JUMANPP_SENTENCE_SPLITTER_H
+
+#include <string>
+#include <vector>
+#include "util/status.hpp"
+#include "util/string_piece.h"
+
+namespace jumanpp {
+namespace core {
+namespace input {
+
+struct SentenceSplitterConfig {
+  // A sentence ends after any of these characters
+  std::string terminators = "。！？";
+  // These characters right after a terminator belong to the same sentence
+  std::string closers = "」』）)”’";
+  // A newline ends a sentence, otherwise newlines are removed
+  bool splitOnNewline = true;
+  // Longer sentences are cut at a codepoint boundary, 0 is no limit
+  size_t maxBytes = 0;
+};
+
+/**
+ * Splits a document into sentences.
+ *
+ * The document is scanned as raw UTF-8 bytes:
+ * only bytes which can start a terminator, a closer or a newline
+ * are looked at further, everything else is skipped by a single
+ * table lookup.
+ * Empty sentences are not produced.
+ */
+class SentenceSplitter {
+  static constexpr u8 Terminator = 1;
+  static constexpr u8 Closer = 2;
+  static constexpr u8 Newline = 4;
+
+  u8 leadBytes_[256];
+  std::vector<std::string> terminators_;
+  std::vector<std::string> closers_;
+  bool splitOnNewline_ = true;
+  size_t maxBytes_ = 0;
+  // document without newlines
+  std::string buffer_;
+
+  // returns the length of a pattern which is at pos or 0
+  static size_t matchAt(const std::vector<std::string>& patterns,
+                        StringPiece data, size_t pos);
+  void emit(StringPiece sentence, std::vector<StringPiece>* result) const;
+
+ public:
+  SentenceSplitter();
+
+  Status initialize(const SentenceSplitterConfig& config);
+
+  /**
+   * Sentences point into the document or, when newlines are removed,
+   * into the internal buffer which is valid until the next call.
+   */
+  void split(StringPiece document, std::vector<StringPiece>* result);
+};
+
+}  // namespace input
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_SENTENCE_SPLITTER_H
@@ -0,0 +1,76 @@
+#include "core/input/sentence_splitter.h"
+#include "testing/standalone_test.h"
+
+using namespace jumanpp;
+using namespace jumanpp::core::input;
+
+namespace {
+
+std::vector<std::string> splitWith(SentenceSplitter* splitter,
+                                   StringPiece document) {
+  std::vector<StringPiece> pieces;
+  splitter->split(document, &pieces);
+  std::vector<std::string> result;
+  for (auto& p : pieces) {
+    result.push_back(p.str());
+  }
+  return result;
+}
+
+std::vector<std::string> split(StringPiece document,
+                               const SentenceSplitterConfig& config) {
+  SentenceSplitter splitter;
+  REQUIRE_OK(splitter.initialize(config));
+  return splitWith(&splitter, document);
+}
+
+}  // namespace
+
+TEST_CASE("sentence splitter splits on terminators and newlines") {
+  SentenceSplitterConfig conf;
+  auto res = split("今日は晴れ。明日は雨！本当？\nはい\r\n\nいいえ", conf);
+  std::vector<std::string> expected{"今日は晴れ。", "明日は雨！", "本当？",
+                                    "はい", "いいえ"};
+  CHECK(res == expected);
+}
+
+TEST_CASE("sentence splitter keeps closers and repeated terminators") {
+  SentenceSplitterConfig conf;
+  auto res = split("「行く。」と言った！？（笑）。)終わり", conf);
+  std::vector<std::string> expected{"「行く。」", "と言った！？",
+                                    "（笑）。)", "終わり"};
+  CHECK(res == expected);
+}
+
+TEST_CASE("sentence splitter can join lines") {
+  SentenceSplitterConfig conf;
+  conf.splitOnNewline = false;
+  auto res = split("これは長い\r\n文です。次の\n文", conf);
+  std::vector<std::string> expected{"これは長い文です。", "次の文"};
+  CHECK(res == expected);
+}
+
+TEST_CASE("sentence splitter cuts long sentences at codepoint boundaries") {
+  SentenceSplitterConfig conf;
+  conf.maxBytes = 7;
+  auto res = split("あいうえおab。", conf);
+  std::vector<std::string> expected{"あい", "うえ", "おab", "。"};
+  CHECK(res == expected);
+}
+
+TEST_CASE("sentence splitter uses configured terminators") {
+  SentenceSplitterConfig conf;
+  conf.terminators = ".";
+  conf.closers = "";
+  SentenceSplitter splitter;
+  REQUIRE_OK(splitter.initialize(conf));
+  std::vector<std::string> expected{"a.", "b。c"};
+  CHECK(splitWith(&splitter, "a.b。c") == expected);
+  CHECK(splitWith(&splitter, "").empty());
+  CHECK(splitWith(&splitter, "\n\n").empty());
+
+  conf.terminators = "\n";
+  CHECK_FALSE(splitter.initialize(conf));
+  conf.terminators = "\xff";
+  CHECK_FALSE(splitter.initialize(conf));
+}
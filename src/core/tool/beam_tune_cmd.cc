@@ -0,0 +1,331 @@
+#include "beam_tune_cmd.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include "core/analysis/analyzer_impl.h"
+#include "core/env.h"
+#include "core/training/full_example.h"
+#include "util/logging.hpp"
+#include "util/mmap.h"
+
+namespace jumanpp {
+namespace core {
+namespace tool {
+
+bool BeamTuneSetting::valid() const {
+  if (beam <= 0 || globalBeam < 0 || rightCheck < 0 || rightBeam < 0 ||
+      autoStep < 0) {
+    return false;
+  }
+  if ((rightCheck == 0) != (rightBeam == 0)) {
+    return false;
+  }
+  if (globalBeam == 0) {
+    return rightCheck == 0 && autoStep == 0;
+  }
+  return true;
+}
+
+std::string BeamTuneSetting::name() const {
+  std::stringstream ss;
+  ss << beam << ":" << globalBeam << ":" << rightCheck << ":" << rightBeam
+     << ":" << autoStep;
+  return ss.str();
+}
+
+double BeamTuneResult::speed() const {
+  return sentences / std::max(seconds, 1e-9);
+}
+
+double BeamTuneResult::sentenceAccuracy() const {
+  return sentences == 0 ? 0 : (double)matchedSentences / sentences;
+}
+
+double BeamTuneResult::nodeF1() const {
+  double precision = sysNodes == 0 ? 0 : (double)matchedNodes / sysNodes;
+  double recall = goldNodes == 0 ? 0 : (double)matchedNodes / goldNodes;
+  if (precision + recall == 0) {
+    return 0;
+  }
+  return 2 * precision * recall / (precision + recall);
+}
+
+std::vector<BeamTuneSetting> enumerateSettings(const BeamTuneConfig& config) {
+  std::vector<BeamTuneSetting> result;
+  BeamTuneSetting s;
+  for (auto beam : config.beams) {
+    s.beam = beam;
+    for (auto gbeam : config.globalBeams) {
+      s.globalBeam = gbeam;
+      for (auto rcheck : config.rightChecks) {
+        s.rightCheck = rcheck;
+        for (auto rbeam : config.rightBeams) {
+          s.rightBeam = rbeam;
+          for (auto step : config.autoSteps) {
+            s.autoStep = step;
+            if (s.valid()) {
+              result.push_back(s);
+            }
+          }
+        }
+      }
+    }
+  }
+  return result;
+}
+
+std::vector<size_t> paretoFrontier(util::ArraySlice<BeamTuneResult> results) {
+  std::vector<size_t> order;
+  for (size_t i = 0; i < results.size(); ++i) {
+    order.push_back(i);
+  }
+  // fastest first, more accurate first among equally fast ones
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    auto& r1 = results[a];
+    auto& r2 = results[b];
+    if (r1.speed() != r2.speed()) {
+      return r1.speed() > r2.speed();
+    }
+    if (r1.nodeF1() != r2.nodeF1()) {
+      return r1.nodeF1() > r2.nodeF1();
+    }
+    return a < b;
+  });
+
+  std::vector<size_t> frontier;
+  double bestF1 = -1;
+  for (auto idx : order) {
+    auto f1 = results[idx].nodeF1();
+    if (f1 > bestF1) {
+      frontier.push_back(idx);
+      bestF1 = f1;
+    }
+  }
+  return frontier;
+}
+
+namespace {
+
+namespace t = ::jumanpp::core::training;
+
+struct PathNode {
+  i32 start;
+  i32 end;
+  std::vector<i32> values;
+  // strings of values which are not in the dictionary
+  std::vector<StringPiece> unknowns;
+};
+
+class BeamTuner {
+  JumanppEnv env_;
+  input::TrainFieldsIndex tio_;
+  t::FullExampleReader reader_;
+  util::FullyMappedFile corpus_;
+  std::vector<t::FullyAnnotatedExample> examples_;
+  // StringField is not movable
+  std::vector<std::unique_ptr<analysis::StringField>> fields_;
+  std::vector<PathNode> path_;
+
+  Status loadCorpus(const BeamTuneConfig& config) {
+    JPP_RETURN_IF_ERROR(corpus_.open(config.corpusFile));
+    reader_.setTrainingIo(&tio_);
+    reader_.setFilename(config.corpusFile);
+    if (config.csvCorpus) {
+      JPP_RETURN_IF_ERROR(reader_.initCsv(corpus_.contents()));
+    } else {
+      JPP_RETURN_IF_ERROR(reader_.initDoubleCsv(corpus_.contents()));
+    }
+    while (true) {
+      t::FullyAnnotatedExample ex;
+      JPP_RETURN_IF_ERROR(reader_.readFullExample(&ex));
+      if (reader_.finished() && ex.numNodes() == 0) {
+        break;
+      }
+      if (ex.numNodes() != 0) {
+        examples_.push_back(std::move(ex));
+      }
+    }
+    if (examples_.empty()) {
+      return JPPS_INVALID_PARAMETER << "corpus " << config.corpusFile
+                                    << " did not contain any sentences";
+    }
+    return Status::Ok();
+  }
+
+  Status topPath(const analysis::Analyzer& ana) {
+    path_.clear();
+    auto lattice = ana.impl()->lattice();
+    auto& output = ana.output();
+    auto walker = output.nodeWalker();
+
+    auto eos = lattice->boundary(lattice->createdBoundaryCount() - 1);
+    auto ptr = eos->starts()->beamData().at(0).ptr.previous;
+    while (ptr != nullptr && ptr->boundary >= 2) {
+      auto& info =
+          lattice->boundary(ptr->boundary)->starts()->nodeInfo().at(ptr->right);
+      PathNode node{info.start(), info.end(), {}, {}};
+      if (!output.locate(ptr->latticeNodePtr(), &walker) || !walker.next()) {
+        return JPPS_INVALID_STATE << "failed to locate a node of the top path";
+      }
+      for (auto& fld : fields_) {
+        auto value = fld->pointer(walker);
+        node.values.push_back(value);
+        node.unknowns.push_back(value < 0 ? (*fld)[walker] : StringPiece{});
+      }
+      path_.push_back(std::move(node));
+      ptr = ptr->previous;
+    }
+    std::reverse(path_.begin(), path_.end());
+    return Status::Ok();
+  }
+
+  static bool nodeMatches(const t::FullyAnnotatedExample& ex,
+                          const t::ExampleNode& gold, const PathNode& node) {
+    for (size_t i = 0; i < node.values.size(); ++i) {
+      auto value = gold.data[i];
+      if (value >= 0 || node.values[i] >= 0) {
+        if (value != node.values[i]) {
+          return false;
+        }
+      } else if (ex.unknownString(value) != node.unknowns[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void compare(const t::FullyAnnotatedExample& ex, BeamTuneResult* result) {
+    i64 matched = 0;
+    size_t sysIdx = 0;
+    i32 numGold = ex.numNodes();
+    for (i32 i = 0; i < numGold; ++i) {
+      auto g = ex.nodeAt(i);
+      while (sysIdx < path_.size() && path_[sysIdx].start < g.position) {
+        ++sysIdx;
+      }
+      if (sysIdx == path_.size()) {
+        break;
+      }
+      // top path nodes do not overlap, so the same span is the same node
+      auto& n = path_[sysIdx];
+      if (n.start == g.position && n.end == g.position + g.length &&
+          nodeMatches(ex, g, n)) {
+        matched += 1;
+      }
+    }
+    result->sentences += 1;
+    result->goldNodes += numGold;
+    result->sysNodes += path_.size();
+    result->matchedNodes += matched;
+    result->matchedSentences +=
+        matched == numGold && path_.size() == static_cast<size_t>(numGold);
+  }
+
+ public:
+  Status initialize(const BeamTuneConfig& config) {
+    JPP_RETURN_IF_ERROR(env_.loadModel(config.modelFile));
+    JPP_RETURN_IF_ERROR(env_.initFeatures(config.staticFeatures));
+    JPP_RETURN_IF_ERROR(tio_.initialize(*env_.coreHolder()));
+    for (size_t i = 0; i < tio_.fields().size(); ++i) {
+      fields_.emplace_back(new analysis::StringField);
+    }
+    JPP_RETURN_IF_ERROR(loadCorpus(config));
+    LOG_INFO() << "loaded " << examples_.size() << " sentences from "
+               << config.corpusFile;
+    return Status::Ok();
+  }
+
+  Status evaluate(const BeamTuneSetting& setting, i32 repeats,
+                  BeamTuneResult* result) {
+    result->setting = setting;
+    env_.setBeamSize(static_cast<u32>(setting.beam));
+    env_.setGlobalBeam(setting.globalBeam, setting.rightCheck,
+                       setting.rightBeam);
+    if (setting.autoStep > 0) {
+      env_.setAutoBeam(setting.beam, setting.autoStep, setting.globalBeam);
+    } else {
+      env_.setAutoBeam(0, 0, 0);
+    }
+
+    analysis::Analyzer ana;
+    JPP_RETURN_IF_ERROR(env_.makeAnalyzer(&ana));
+    auto trainFields = tio_.fields();
+    for (size_t i = 0; i < trainFields.size(); ++i) {
+      JPP_RETURN_IF_ERROR(
+          ana.output().stringField(trainFields[i].name, fields_[i].get()));
+    }
+    for (i32 rep = 0; rep < repeats; ++rep) {
+      for (auto& ex : examples_) {
+        auto start = std::chrono::steady_clock::now();
+        JPP_RIE_MSG(ana.analyze(ex.surface()), ex.surface());
+        auto end = std::chrono::steady_clock::now();
+        result->seconds += std::chrono::duration<double>(end - start).count();
+        if (rep == 0) {
+          JPP_RETURN_IF_ERROR(topPath(ana));
+          compare(ex, result);
+        }
+      }
+    }
+    result->seconds /= repeats;
+    return Status::Ok();
+  }
+};
+
+void printHeader(std::ostream& os) {
+  os << std::left << std::setw(20) << "beam:gb:rc:rb:auto" << std::right
+     << std::setw(10) << "time(ms)" << std::setw(12) << "sent/s"
+     << std::setw(10) << "sent-acc" << std::setw(10) << "node-f1"
+     << "\n";
+}
+
+void printResult(std::ostream& os, const BeamTuneResult& r) {
+  os << std::left << std::setw(20) << r.setting.name() << std::right
+     << std::fixed << std::setprecision(2) << std::setw(10) << r.seconds * 1000
+     << std::setw(12) << r.speed() << std::setprecision(4) << std::setw(10)
+     << r.sentenceAccuracy() << std::setw(10) << r.nodeF1() << "\n";
+}
+
+}  // namespace
+
+int beamTuneCommandImpl(const BeamTuneConfig& config) {
+  auto settings = enumerateSettings(config);
+  if (settings.empty()) {
+    LOG_ERROR() << "there were no valid beam settings to evaluate";
+    return 1;
+  }
+
+  BeamTuner tuner;
+  Status s = tuner.initialize(config);
+  if (!s) {
+    LOG_ERROR() << "failed to initialize: " << s;
+    return 1;
+  }
+
+  auto repeats = std::max(config.repeats, 1);
+  std::vector<BeamTuneResult> results;
+  printHeader(std::cout);
+  for (auto& setting : settings) {
+    BeamTuneResult result;
+    s = tuner.evaluate(setting, repeats, &result);
+    if (!s) {
+      LOG_ERROR() << "failed to evaluate " << setting.name() << ": " << s;
+      return 1;
+    }
+    printResult(std::cout, result);
+    results.push_back(result);
+  }
+
+  std::cout << "\nPareto frontier (speed vs node F1):\n";
+  printHeader(std::cout);
+  for (auto idx : paretoFrontier(results)) {
+    printResult(std::cout, results[idx]);
+  }
+  return 0;
+}
+
+}  // namespace tool
+}  // namespace core
+}  // namespace jumanpp
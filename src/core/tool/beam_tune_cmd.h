@@ -0,0 +1,85 @@
+#ifndef JUMANPP_BEAM_TUNE_CMD_H
+#define JUMANPP_BEAM_TUNE_CMD_H
+
+#include <string>
+#include <vector>
+#include "util/array_slice.h"
+#include "util/types.hpp"
+
+namespace jumanpp {
+namespace core {
+
+namespace features {
+class StaticFeatureFactory;
+}  // namespace features
+
+namespace tool {
+
+struct BeamTuneSetting {
+  i32 beam = 5;
+  i32 globalBeam = 0;
+  i32 rightCheck = 0;
+  i32 rightBeam = 0;
+  i32 autoStep = 0;
+
+  /**
+   * Right beam is used only together with the right check and
+   * both of them, as well as the automatic beam, need the global beam.
+   */
+  bool valid() const;
+  std::string name() const;
+};
+
+struct BeamTuneResult {
+  BeamTuneSetting setting;
+  i64 sentences = 0;
+  i64 matchedSentences = 0;
+  i64 goldNodes = 0;
+  i64 sysNodes = 0;
+  i64 matchedNodes = 0;
+  double seconds = 0;
+
+  double speed() const;
+  double sentenceAccuracy() const;
+  double nodeF1() const;
+};
+
+struct BeamTuneConfig {
+  std::string modelFile;
+  std::string corpusFile;
+  bool csvCorpus = false;
+  std::vector<i32> beams{3, 5};
+  std::vector<i32> globalBeams{0, 3, 6, 10};
+  std::vector<i32> rightChecks{0, 1};
+  std::vector<i32> rightBeams{0, 5};
+  std::vector<i32> autoSteps{0};
+  i32 repeats = 1;
+  // generated features for the model spec, dynamic ones are used if null
+  const features::StaticFeatureFactory* staticFeatures = nullptr;
+};
+
+/**
+ * All valid combinations of parameter values from the config.
+ */
+std::vector<BeamTuneSetting> enumerateSettings(const BeamTuneConfig& config);
+
+/**
+ * Indices of results which are not dominated by other results:
+ * there is no other result which is both faster and more accurate (node F1).
+ * A result which is only as accurate as a faster one is dominated,
+ * of equal results the first one is kept.
+ * Indices are sorted by speed, fastest first.
+ */
+std::vector<size_t> paretoFrontier(util::ArraySlice<BeamTuneResult> results);
+
+/**
+ * Analyzes a gold corpus with every beam setting using a single loaded model
+ * and prints speed and accuracy of each one with the speed/accuracy frontier.
+ */
+int beamTuneCommandImpl(const BeamTuneConfig& config);
+
+}  // namespace tool
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_BEAM_TUNE_CMD_H
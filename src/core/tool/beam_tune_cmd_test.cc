@@ -0,0 +1,85 @@
+#include "beam_tune_cmd.h"
+#include "testing/standalone_test.h"
+
+using namespace jumanpp;
+using namespace jumanpp::core::tool;
+
+namespace {
+
+BeamTuneResult resultOf(double seconds, i64 matchedNodes) {
+  BeamTuneResult r;
+  r.sentences = 100;
+  r.seconds = seconds;
+  r.goldNodes = 100;
+  r.sysNodes = 100;
+  r.matchedNodes = matchedNodes;
+  return r;
+}
+
+}  // namespace
+
+TEST_CASE("beam settings without global beam do not use right check") {
+  BeamTuneConfig conf;
+  conf.beams = {3, 5};
+  conf.globalBeams = {0, 6};
+  conf.rightChecks = {0, 1};
+  conf.rightBeams = {0, 5};
+  conf.autoSteps = {0, 2};
+  auto settings = enumerateSettings(conf);
+  // without the global beam: 1 setting, with it: 2 right checks x 2 steps
+  REQUIRE(settings.size() == 2 * (1 + 2 * 2));
+  CHECK(settings[0].name() == "3:0:0:0:0");
+  CHECK(settings[1].name() == "3:6:0:0:0");
+  CHECK(settings[2].name() == "3:6:0:0:2");
+  CHECK(settings[3].name() == "3:6:1:5:0");
+  CHECK(settings[4].name() == "3:6:1:5:2");
+  CHECK(settings[5].name() == "5:0:0:0:0");
+  for (auto& s : settings) {
+    CAPTURE(s.name());
+    CHECK(s.valid());
+  }
+}
+
+TEST_CASE("beam settings skip invalid values") {
+  BeamTuneConfig conf;
+  conf.beams = {0, -1, 1};
+  conf.globalBeams = {-2, 0};
+  conf.rightChecks = {0};
+  conf.rightBeams = {0};
+  conf.autoSteps = {0};
+  auto settings = enumerateSettings(conf);
+  REQUIRE(settings.size() == 1);
+  CHECK(settings[0].name() == "1:0:0:0:0");
+
+  conf.beams.clear();
+  CHECK(enumerateSettings(conf).empty());
+}
+
+TEST_CASE("pareto frontier drops dominated results") {
+  std::vector<BeamTuneResult> results{
+      resultOf(2.0, 90),  // 0: on the frontier
+      resultOf(1.0, 80),  // 1: fastest
+      resultOf(3.0, 85),  // 2: slower and less accurate than 0
+      resultOf(4.0, 95),  // 3: most accurate
+      resultOf(1.5, 75),  // 4: slower and less accurate than 1
+  };
+  auto frontier = paretoFrontier(results);
+  CHECK(frontier == std::vector<size_t>{1, 0, 3});
+}
+
+TEST_CASE("pareto frontier keeps one of tied results") {
+  std::vector<BeamTuneResult> results{
+      resultOf(2.0, 90),  // 0: same speed as 2, less accurate
+      resultOf(1.0, 90),  // 1: faster with the same accuracy as 2
+      resultOf(2.0, 92),  // 2
+      resultOf(1.0, 90),  // 3: equal to 1
+      resultOf(3.0, 92),  // 4: as accurate as 2 but slower
+  };
+  auto frontier = paretoFrontier(results);
+  CHECK(frontier == std::vector<size_t>{1, 2});
+}
+
+TEST_CASE("pareto frontier of no results is empty") {
+  std::vector<BeamTuneResult> results;
+  CHECK(paretoFrontier(results).empty());
+}
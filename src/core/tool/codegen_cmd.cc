@@ -4,6 +4,8 @@
 
 #include "codegen_cmd.h"
 #include "core/codegen/feature_codegen.h"
+#include "core/dic/dic_builder.h"
+#include "core/impl/model_io.h"
 #include "core/spec/spec_parser.h"
 #include "pathie-cpp/include/path.hpp"
 
@@ -31,6 +33,20 @@ Status generateStaticFeatures(StringPiece specFile, StringPiece baseName,
   return Status::Ok();
 }
 
+Status loadNativeFeatures(StringPiece modelFile,
+                          const features::codegen::RuntimeCodegenConfig& config,
+                          features::codegen::RuntimeFeatures* result) {
+  model::FilesystemModel model;
+  model::ModelInfo info;
+  dic::BuiltDictionary dic;
+  JPP_RETURN_IF_ERROR(model.open(modelFile));
+  JPP_RETURN_IF_ERROR(model.load(&info));
+  JPP_RETURN_IF_ERROR(dic.restoreDictionary(info));
+  JPP_RIE_MSG(result->initialize(config, dic.spec),
+              "failed to make native features for " << modelFile);
+  return Status::Ok();
+}
+
 }  // namespace tool
 }  // namespace core
 }  // namespace jumanpp
\ No newline at end of file
@@ -5,6 +5,7 @@
 #ifndef JUMANPP_T9_CODEGEN_CMD_H
 #define JUMANPP_T9_CODEGEN_CMD_H
 
+#include "core/codegen/runtime_codegen.h"
 #include "util/status.hpp"
 #include "util/string_piece.h"
 
@@ -15,6 +16,14 @@ namespace tool {
 Status generateStaticFeatures(StringPiece specFile, StringPiece baseName,
                               StringPiece className);
 
+/**
+ * Loads native features for the spec of a model from the cache directory,
+ * generating and compiling them if they were not there.
+ */
+Status loadNativeFeatures(StringPiece modelFile,
+                          const features::codegen::RuntimeCodegenConfig& config,
+                          features::codegen::RuntimeFeatures* result);
+
 }  // namespace tool
 }  // namespace core
 }  // namespace jumanpp
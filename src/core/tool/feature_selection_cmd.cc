@@ -0,0 +1,242 @@
+#include "feature_selection_cmd.h"
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include "core/env.h"
+#include "core/tool/train_cmd.h"
+#include "core/training/feature_selection.h"
+#include "util/format.h"
+#include "util/logging.hpp"
+
+namespace jumanpp {
+namespace core {
+namespace tool {
+
+namespace {
+
+namespace t = ::jumanpp::core::training;
+
+u32 exponentOf(size_t size) {
+  u32 exp = 0;
+  while ((size_t{1} << exp) < size) {
+    exp += 1;
+  }
+  return exp;
+}
+
+t::TrainingArguments evaluationArgs(const t::TrainingArguments& args,
+                                    const JumanppEnv& env) {
+  t::TrainingArguments result = args;
+  auto& weights = env.featureScorer()->weights();
+  result.trainingConfig.featureNumberExponent = exponentOf(weights.size());
+  result.prefetchBatches = 0;
+  return result;
+}
+
+struct EvaluatedModel {
+  t::EvaluationResult result;
+  size_t numNgrams = 0;
+  size_t numPatterns = 0;
+};
+
+class SelectionEvaluator {
+  t::TrainingArguments args_;
+  t::TrainingEnv exec_;
+  JumanppEnv* env_;
+
+ public:
+  SelectionEvaluator(const t::TrainingArguments& args, JumanppEnv* env)
+      : args_{evaluationArgs(args, *env)}, exec_{args_, env}, env_{env} {}
+
+  Status initialize() {
+    JPP_RETURN_IF_ERROR(exec_.initFeatures(args_.staticFeatures));
+    JPP_RETURN_IF_ERROR(exec_.initOther());
+    return exec_.loadInput(args_.corpusFilename);
+  }
+
+  Status evaluate(EvaluatedModel* result,
+                  const t::EvaluationCallback& callback = {}) {
+    analysis::HashedFeaturePerceptron perceptron{
+        env_->featureScorer()->weights().weights};
+    analysis::ScorerDef sconf;
+    sconf.feature = &perceptron;
+    sconf.scoreWeights.push_back(1.0f);
+    JPP_RETURN_IF_ERROR(exec_.evaluate(&sconf, &result->result, callback));
+    auto& fspec = env_->spec().features;
+    result->numNgrams = fspec.ngram.size();
+    result->numPatterns = fspec.pattern.size();
+    return Status::Ok();
+  }
+};
+
+Status loadTrainedModel(JumanppEnv* env, const t::TrainingArguments& args) {
+  env->setBeamSize(static_cast<u32>(args.trainingConfig.beamSize));
+  JPP_RETURN_IF_ERROR(env->loadModel(args.modelFilename));
+  if (!env->hasPerceptronModel()) {
+    return JPPS_INVALID_PARAMETER << "model [" << args.modelFilename
+                                  << "] was not trained";
+  }
+  return Status::Ok();
+}
+
+void printRanking(const spec::AnalysisSpec& spec,
+                  const t::NgramImportance& importance, size_t numKept) {
+  auto ranking = importance.ranking();
+  auto norm = std::max<i64>(importance.numGoldNodes(), 1);
+  std::cout << "Rank\tIndex\tGold mass\tMargin\tPattern\n";
+  for (size_t i = 0; i < ranking.size(); ++i) {
+    auto& s = ranking[i];
+    if (i == numKept) {
+      std::cout << "---- features below are removed ----\n";
+    }
+    std::cout << fmt::format("{0}\t{1}\t{2:.5f}\t{3:.5f}\t", i + 1, s.index,
+                             s.goldMass / norm, s.margin / norm)
+              << t::describeNgram(spec, s.index) << "\n";
+  }
+  std::cout << std::flush;
+}
+
+Status makeReducedModel(const JumanppEnv& env, const spec::AnalysisSpec& spec,
+                        StringPiece filename) {
+  auto original = env.modelInfoCopy();
+  dic::BuiltDictionary dic;
+  JPP_RETURN_IF_ERROR(dic.restoreDictionary(original));
+  dic.spec = spec;
+  util::CodedBuffer metadata;
+  dic.saveMetadata(&metadata);
+
+  // only the dictionary is kept, the model needs to be trained
+  model::ModelInfo reduced;
+  for (auto& part : original.parts) {
+    if (part.kind == model::ModelPartKind::Dictionary) {
+      reduced.parts.push_back(part);
+      reduced.parts.back().data[0] = metadata.contents();
+    }
+  }
+
+  model::ModelSaver saver;
+  JPP_RIE_MSG(saver.open(filename), "failed to open file " << filename);
+  return saver.save(reduced);
+}
+
+void reportModel(StringPiece name, const EvaluatedModel& model) {
+  auto& r = model.result;
+  LOG_INFO() << name << ": ngram features=" << model.numNgrams
+             << " patterns=" << model.numPatterns
+             << " sentence accuracy=" << r.sentenceAccuracy()
+             << " field accuracy=" << r.fieldAccuracy()
+             << " scoring time=" << r.seconds << "s ("
+             << (r.seconds > 0 ? r.numSentences / r.seconds : 0)
+             << " sents/s)";
+}
+
+}  // namespace
+
+int featureSelectionCommandImpl(const training::TrainingArguments& args,
+                                const FeatureSelectionConfig& config) {
+  if (args.corpusFilename.empty()) {
+    LOG_ERROR() << "corpus to evaluate features on was not specified";
+    return 1;
+  }
+
+  core::JumanppEnv env;
+  Status s = loadTrainedModel(&env, args);
+  if (!s) {
+    LOG_ERROR() << "failed to read model from disk: " << s;
+    return 1;
+  }
+
+  auto& spec = env.spec();
+  auto numNgrams = spec.features.ngram.size();
+  t::NgramImportance importance{numNgrams};
+  EvaluatedModel original;
+  SelectionEvaluator eval{args, &env};
+  auto& weights = env.featureScorer()->weights();
+  s = eval.initialize();
+  if (s) {
+    s = eval.evaluate(&original, [&](const t::OwningFullTrainer& trainer) {
+      importance.add(trainer.trainer().lossCalculator(), weights);
+    });
+  }
+  if (!s) {
+    LOG_ERROR() << "failed to evaluate the model on [" << args.corpusFilename
+                << "]: " << s;
+    return 1;
+  }
+
+  size_t numKept = config.keepCount > 0
+                       ? static_cast<size_t>(config.keepCount)
+                       : static_cast<size_t>(
+                             std::ceil(config.keepRatio * numNgrams));
+  numKept = std::max<size_t>(std::min(numKept, numNgrams), 1);
+  printRanking(spec, importance, numKept);
+
+  if (args.outputFilename.empty()) {
+    return 0;
+  }
+
+  std::vector<i32> keep;
+  auto ranking = importance.ranking();
+  for (size_t i = 0; i < numKept; ++i) {
+    keep.push_back(ranking[i].index);
+  }
+  spec::AnalysisSpec reducedSpec;
+  s = t::makeReducedSpec(spec, keep, &reducedSpec);
+  if (!s) {
+    LOG_ERROR() << "failed to create a reduced spec: " << s;
+    return 1;
+  }
+
+  if (config.trainCorpus.empty()) {
+    s = makeReducedModel(env, reducedSpec, args.outputFilename);
+    if (!s) {
+      LOG_ERROR() << "failed to save the reduced model: " << s;
+      return 1;
+    }
+    LOG_INFO() << "Reduced seed model with " << numKept << " of " << numNgrams
+               << " ngram features was saved to " << args.outputFilename;
+    return 0;
+  }
+
+  t::TrainingArguments trainArgs = args;
+  trainArgs.modelFilename = args.outputFilename + ".seed";
+  trainArgs.corpusFilename = config.trainCorpus;
+  // generated features were made for the original spec
+  trainArgs.staticFeatures = nullptr;
+  trainArgs.trainingConfig.featureNumberExponent = exponentOf(weights.size());
+  s = makeReducedModel(env, reducedSpec, trainArgs.modelFilename);
+  if (!s) {
+    LOG_ERROR() << "failed to save the reduced seed model: " << s;
+    return 1;
+  }
+  int retval = trainCommandImpl(trainArgs);
+  std::remove(trainArgs.modelFilename.c_str());
+  if (retval != 0) {
+    return retval;
+  }
+
+  t::TrainingArguments reducedArgs = args;
+  reducedArgs.modelFilename = args.outputFilename;
+  core::JumanppEnv reducedEnv;
+  EvaluatedModel reduced;
+  s = loadTrainedModel(&reducedEnv, reducedArgs);
+  if (s) {
+    SelectionEvaluator reducedEval{reducedArgs, &reducedEnv};
+    s = reducedEval.initialize();
+    if (s) {
+      s = reducedEval.evaluate(&reduced);
+    }
+  }
+  if (!s) {
+    LOG_ERROR() << "failed to evaluate the reduced model: " << s;
+    return 1;
+  }
+
+  reportModel("Original", original);
+  reportModel("Reduced", reduced);
+  return 0;
+}
+
+}  // namespace tool
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,35 @@
+#ifndef JUMANPP_FEATURE_SELECTION_CMD_H
+#define JUMANPP_FEATURE_SELECTION_CMD_H
+
+#include "core/training/training_env.h"
+
+namespace jumanpp {
+namespace core {
+namespace tool {
+
+struct FeatureSelectionConfig {
+  // ratio of ngram features to keep
+  float keepRatio = 0.75f;
+  // number of ngram features to keep, overrides the ratio if positive
+  i32 keepCount = 0;
+  // reduced model is trained on this corpus if it is not empty
+  std::string trainCorpus;
+};
+
+/**
+ * Ranks ngram features of a trained model by their contribution
+ * to path scores on the corpus and creates a model with the best ones.
+ *
+ * Feature hashes depend on feature numbers, so the reduced model
+ * is a seed model which needs to be trained.
+ * If a training corpus is specified, the reduced model is trained
+ * and compared with the original one on accuracy and scoring speed.
+ */
+int featureSelectionCommandImpl(const training::TrainingArguments& args,
+                                const FeatureSelectionConfig& config);
+
+}  // namespace tool
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_FEATURE_SELECTION_CMD_H
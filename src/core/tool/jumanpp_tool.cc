@@ -15,8 +15,11 @@
 
 #include <chrono>
 #include "core/dic/progress.h"
+#include "core/tool/beam_tune_cmd.h"
 #include "core/tool/codegen_cmd.h"
+#include "core/tool/feature_selection_cmd.h"
 #include "core/tool/index_cmd.h"
+#include "core/tool/prune_cmd.h"
 #include "core/tool/train_cmd.h"
 #include "core/training/training_env.h"
 #include "rnn/rnn_arg_parse.h"
@@ -39,7 +42,22 @@ void copyValue(T1& out, args::Base& flag, const T1& val) {
   }
 }
 
-enum class ToolMode { Index, Train, EmbedRnn, StaticFeatures };
+template <typename T>
+void copyList(std::vector<T>& out, args::ValueFlagList<T>& flag) {
+  if (flag) {
+    out = flag.Get();
+  }
+}
+
+enum class ToolMode {
+  Index,
+  Train,
+  EmbedRnn,
+  StaticFeatures,
+  Prune,
+  SelectFeatures,
+  TuneBeam
+};
 
 namespace t = ::jumanpp::core::training;
 
@@ -47,8 +65,12 @@ struct JumanppToolArgs {
   std::string specFile;
   std::string dictFile;
   std::string comment;
+  core::features::codegen::RuntimeCodegenConfig nativeConfig;
 
   t::TrainingArguments trainArgs;
+  t::WeightPruningConfig pruneConfig;
+  core::tool::FeatureSelectionConfig selectionConfig;
+  core::tool::BeamTuneConfig beamTuneConfig;
 
   ToolMode mode;
 
@@ -72,6 +94,18 @@ struct JumanppToolArgs {
                            "Embed a RNN into a trained model"};
     args::Command staticFeatures{commandGroup, "static-features",
                                  "Generate a C++ code for feature processing"};
+    args::Command prune{commandGroup, "prune",
+                        "Prune small weights of a trained model and store "
+                        "them in a smaller table"};
+    args::Command selectFeatures{
+        commandGroup, "select-features",
+        "Rank ngram features of a trained model by their contribution to "
+        "the score margin of gold paths on a corpus and create a model with "
+        "the best ones"};
+    args::Command tuneBeam{
+        commandGroup, "tune-beam",
+        "Measure speed and accuracy of beam settings on an annotated corpus "
+        "and show the best speed/accuracy tradeoffs"};
 
     args::HelpFlag help{globalParams,
                         "Help",
@@ -86,6 +120,18 @@ struct JumanppToolArgs {
 
     args::ValueFlag<std::string> comment{
         globalParams, "STRING", "Comment to embed in model", {"comment"}};
+    args::ValueFlag<std::string> nativeFeatures{
+        globalParams,
+        "DIR",
+        "Generate and compile native feature code for the model spec, "
+        "caching compiled libraries in DIR (for commands using a model)",
+        {"native-features"}};
+    args::ValueFlag<std::string> nativeCompiler{
+        globalParams,
+        "PATH",
+        "C++ compiler for native features, the one which built this binary "
+        "by default",
+        {"native-compiler"}};
     args::ValueFlag<std::string> modelOutput{globalParams,
                                              "FILE",
                                              "Output results here",
@@ -125,6 +171,11 @@ struct JumanppToolArgs {
                               "CSV",
                               "Training corpus is in csv format",
                               {"csv-corpus-format"}};
+    args::Flag storeScwState{
+        ioGroup,
+        "Store SCW",
+        "Store SCW state in the output model, it is used by --warm-start",
+        {"store-scw"}};
 
     args::Group trainingParams{train, "Training parameters"};
 
@@ -171,6 +222,11 @@ struct JumanppToolArgs {
                                    "stopping epsilon (1e-3)",
                                    {"epsilon"},
                                    1e-3f};
+    args::Flag warmStart{trainingParams,
+                         "Warm start",
+                         "Continue training from weights of the input model "
+                         "instead of random ones",
+                         {"warm-start"}};
 
     args::Group gbeam{train, "Boundary (Global) Beam Settings"};
     args::ValueFlag<i32> minLeftGbeam{
@@ -198,6 +254,131 @@ struct JumanppToolArgs {
         {"rnn-model"}};
     RnnArgs rnnArgs{embedRnn};
 
+    args::Group pruneIo{prune, "Input/Output"};
+    args::ValueFlag<std::string> pruneModel{
+        pruneIo, "FILENAME", "Trained model to prune", {"model-input"}};
+    args::ValueFlag<std::string> pruneCorpus{
+        pruneIo,
+        "FILENAME",
+        "Annotated corpus to measure accuracy before and after pruning",
+        {"corpus"}};
+    args::Flag pruneCorpusCsv{pruneIo,
+                              "CSV",
+                              "Corpus is in csv format",
+                              {"csv-corpus-format"}};
+
+    args::Group pruneParams{prune, "Pruning parameters"};
+    t::WeightPruningConfig pruneCfg;
+    args::ValueFlag<float> pruneThreshold{
+        pruneParams,
+        "VALUE",
+        "Zero weights with absolute value lesser than VALUE, 0 default",
+        {"threshold"},
+        pruneCfg.threshold};
+    args::ValueFlag<float> pruneRatio{
+        pruneParams,
+        "RATIO",
+        "Zero this ratio of non-zero weights with smallest absolute values, "
+        "overrides threshold",
+        {"prune-ratio"},
+        pruneCfg.pruneRatio};
+    args::ValueFlag<i32> pruneSize{
+        pruneParams,
+        "SIZE",
+        "Resulting table will have 2^SIZE weights, selected automatically "
+        "by default",
+        {"size"},
+        pruneCfg.targetExponent};
+    args::ValueFlag<float> pruneCollisions{
+        pruneParams,
+        "RATIO",
+        "Automatic size selection: max ratio of non-zero weights which share "
+        "a slot with others, 0.01 default",
+        {"max-collisions"},
+        pruneCfg.maxCollisionRatio};
+    args::ValueFlag<u32> pruneBeam{
+        pruneParams, "BEAM", "Beam size for evaluation, 5 default", {"beam"},
+        5};
+
+    args::Group selIo{selectFeatures, "Input/Output"};
+    args::ValueFlag<std::string> selModel{selIo,
+                                          "FILENAME",
+                                          "Trained model to rank features of",
+                                          {"model-input"}};
+    args::ValueFlag<std::string> selCorpus{
+        selIo,
+        "FILENAME",
+        "Annotated corpus to rank features and measure accuracy on",
+        {"corpus"}};
+    args::ValueFlag<std::string> selTrainCorpus{
+        selIo,
+        "FILENAME",
+        "Train the reduced model on this corpus and compare it with the "
+        "original one, otherwise the output is a seed model",
+        {"train-corpus"}};
+    args::Flag selCorpusCsv{selIo,
+                            "CSV",
+                            "Corpora are in csv format",
+                            {"csv-corpus-format"}};
+
+    args::Group selParams{selectFeatures, "Selection parameters"};
+    core::tool::FeatureSelectionConfig selCfg;
+    args::ValueFlag<float> selKeepRatio{
+        selParams,
+        "RATIO",
+        "Ratio of ngram features to keep, 0.75 default",
+        {"keep-ratio"},
+        selCfg.keepRatio};
+    args::ValueFlag<i32> selKeepCount{
+        selParams,
+        "N",
+        "Number of ngram features to keep, overrides the ratio",
+        {"keep"},
+        selCfg.keepCount};
+    args::ValueFlag<u32> selBeam{
+        selParams, "BEAM", "Beam size, 5 default", {"beam"}, 5};
+    args::ValueFlag<u32> selBatch{
+        selParams, "BATCH", "Training batch size, 1 default", {"batch"}, 1};
+    args::ValueFlag<u32> selThreads{
+        selParams, "THREADS", "# of training threads, 1 default", {"threads"},
+        1};
+    args::ValueFlag<u32> selEpochs{selParams,
+                                   "EPOCHS",
+                                   "max # of training epochs (1)",
+                                   {"max-epochs"},
+                                   1};
+
+    args::Group tuneIo{tuneBeam, "Input/Output"};
+    args::ValueFlag<std::string> tuneModel{
+        tuneIo, "FILENAME", "Trained model", {"model-input"}};
+    args::ValueFlag<std::string> tuneCorpus{
+        tuneIo, "FILENAME", "Annotated corpus", {"corpus"}};
+    args::Flag tuneCorpusCsv{tuneIo,
+                             "CSV",
+                             "Corpus is in csv format",
+                             {"csv-corpus-format"}};
+
+    args::Group tuneParams{
+        tuneBeam,
+        "Evaluated values, all combinations are tried. "
+        "Flags can be repeated."};
+    args::ValueFlagList<i32> tuneBeams{
+        tuneParams, "N", "Local beam size (3, 5)", {"beam"}};
+    args::ValueFlagList<i32> tuneGlobalBeams{
+        tuneParams, "N", "Global beam size (0, 3, 6, 10)", {"global-beam"}};
+    args::ValueFlagList<i32> tuneRightChecks{
+        tuneParams, "N", "Global beam right check (0, 1)", {"right-check"}};
+    args::ValueFlagList<i32> tuneRightBeams{
+        tuneParams, "N", "Global beam right beam (0, 5)", {"right-beam"}};
+    args::ValueFlagList<i32> tuneAutoSteps{
+        tuneParams,
+        "N",
+        "Automatic beam step, 0 disables automatic beam (0)",
+        {"auto-step"}};
+    args::ValueFlag<i32> tuneRepeats{
+        tuneParams, "N", "Number of passes over the corpus (1)", {"repeat"},
+        1};
+
     args::ValueFlag<std::string> cgClassName{
         staticFeatures,
         "NAME",
@@ -230,11 +411,16 @@ struct JumanppToolArgs {
     copyValue(result->mode, train, ToolMode::Train);
     copyValue(result->mode, embedRnn, ToolMode::EmbedRnn);
     copyValue(result->mode, staticFeatures, ToolMode::StaticFeatures);
+    copyValue(result->mode, prune, ToolMode::Prune);
+    copyValue(result->mode, selectFeatures, ToolMode::SelectFeatures);
+    copyValue(result->mode, tuneBeam, ToolMode::TuneBeam);
 
     copyValue(result->specFile, specFile);
     copyValue(result->dictFile, dictFile);
     copyValue(result->comment, comment);
     copyValue(result->comment, cgClassName);
+    copyValue(result->nativeConfig.cacheDirectory, nativeFeatures);
+    copyValue(result->nativeConfig.compiler, nativeCompiler);
 
     auto trg = &result->trainArgs;
     trg->trainingConfig.beamSize = beamSize.Get();
@@ -257,6 +443,8 @@ struct JumanppToolArgs {
     trg->batchMaxIterations = maxBatchIters.Get();
     trg->maxEpochs = maxEpochs.Get();
     trg->batchLossEpsilon = epsilon.Get();
+    trg->warmStart = warmStart.Get();
+    trg->storeScwState = storeScwState.Get();
     trg->rnnConfig = rnnArgs.config();
     trg->scwDumpDirectory = scwDumpDir.Get();
     trg->scwDumpPrefix = scwDumpPrefix.Get();
@@ -269,6 +457,49 @@ struct JumanppToolArgs {
     trg->globalBeam.fullFirstIter = firstIterFull.Get();
     trg->comment = result->comment;
 
+    if (prune) {
+      trg->modelFilename = pruneModel.Get();
+      trg->corpusFilename = pruneCorpus.Get();
+      trg->trainingConfig.beamSize = pruneBeam.Get();
+      if (pruneCorpusCsv) {
+        trg->trainingConfig.inputFormat = core::training::InputFormat::Csv;
+      }
+      auto pcf = &result->pruneConfig;
+      pcf->threshold = pruneThreshold.Get();
+      pcf->pruneRatio = pruneRatio.Get();
+      pcf->targetExponent = pruneSize.Get();
+      pcf->maxCollisionRatio = pruneCollisions.Get();
+    }
+
+    if (selectFeatures) {
+      trg->modelFilename = selModel.Get();
+      trg->corpusFilename = selCorpus.Get();
+      trg->trainingConfig.beamSize = selBeam.Get();
+      trg->batchSize = selBatch.Get();
+      trg->numThreads = selThreads.Get();
+      trg->maxEpochs = selEpochs.Get();
+      if (selCorpusCsv) {
+        trg->trainingConfig.inputFormat = core::training::InputFormat::Csv;
+      }
+      auto scf = &result->selectionConfig;
+      scf->keepRatio = selKeepRatio.Get();
+      scf->keepCount = selKeepCount.Get();
+      scf->trainCorpus = selTrainCorpus.Get();
+    }
+
+    if (tuneBeam) {
+      auto tcf = &result->beamTuneConfig;
+      tcf->modelFile = tuneModel.Get();
+      tcf->corpusFile = tuneCorpus.Get();
+      tcf->csvCorpus = tuneCorpusCsv.Get();
+      copyList(tcf->beams, tuneBeams);
+      copyList(tcf->globalBeams, tuneGlobalBeams);
+      copyList(tcf->rightChecks, tuneRightChecks);
+      copyList(tcf->rightBeams, tuneRightBeams);
+      copyList(tcf->autoSteps, tuneAutoSteps);
+      tcf->repeats = tuneRepeats.Get();
+    }
+
     return Status::Ok();
   }
 };
@@ -312,6 +543,32 @@ void invokeTrain(const t::TrainingArguments& args) {
   exit(retval);
 }
 
+void loadNativeFeatures(JumanppToolArgs* args,
+                        core::features::codegen::RuntimeFeatures* features) {
+  if (args->nativeConfig.cacheDirectory.empty()) {
+    return;
+  }
+  std::string modelFile;
+  switch (args->mode) {
+    case ToolMode::Train:
+    case ToolMode::Prune:
+    case ToolMode::SelectFeatures:
+      modelFile = args->trainArgs.modelFilename;
+      break;
+    case ToolMode::TuneBeam:
+      modelFile = args->beamTuneConfig.modelFile;
+      break;
+    default:
+      return;
+  }
+  dieOnError(core::tool::loadNativeFeatures(modelFile, args->nativeConfig,
+                                            features));
+  LOG_INFO() << "using native features from " << features->library()
+             << (features->fromCache() ? " (cached)" : "");
+  args->trainArgs.staticFeatures = features->factory();
+  args->beamTuneConfig.staticFeatures = features->factory();
+}
+
 void invokeTool(const JumanppToolArgs& args) {
   switch (args.mode) {
     case ToolMode::Index: {
@@ -333,6 +590,13 @@ void invokeTool(const JumanppToolArgs& args) {
     case ToolMode::Train:
       invokeTrain(args.trainArgs);
       return;
+    case ToolMode::Prune:
+      exit(core::tool::pruneCommandImpl(args.trainArgs, args.pruneConfig));
+    case ToolMode::SelectFeatures:
+      exit(core::tool::featureSelectionCommandImpl(args.trainArgs,
+                                                   args.selectionConfig));
+    case ToolMode::TuneBeam:
+      exit(core::tool::beamTuneCommandImpl(args.beamTuneConfig));
     case ToolMode::StaticFeatures:
       dieOnError(core::tool::generateStaticFeatures(
           args.specFile, args.trainArgs.outputFilename, args.comment));
@@ -351,6 +615,8 @@ int main(int argc, const char* argv[]) {
     return 1;
   }
 
+  core::features::codegen::RuntimeFeatures nativeFeatures;
+  loadNativeFeatures(&args, &nativeFeatures);
   invokeTool(args);
 
   return 0;
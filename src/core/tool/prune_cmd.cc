@@ -0,0 +1,143 @@
+#include "prune_cmd.h"
+#include "core/env.h"
+#include "util/logging.hpp"
+
+namespace jumanpp {
+namespace core {
+namespace tool {
+
+namespace {
+
+namespace t = ::jumanpp::core::training;
+
+t::TrainingArguments evaluationArgs(const t::TrainingArguments& args,
+                                    u32 sizeExponent) {
+  t::TrainingArguments result = args;
+  result.trainingConfig.featureNumberExponent = sizeExponent;
+  result.prefetchBatches = 0;
+  return result;
+}
+
+class PruningEvaluator {
+  t::TrainingArguments args_;
+  t::TrainingEnv exec_;
+
+ public:
+  PruningEvaluator(const t::TrainingArguments& args, u32 sizeExponent,
+                   JumanppEnv* env)
+      : args_{evaluationArgs(args, sizeExponent)}, exec_{args_, env} {}
+
+  Status initialize() {
+    JPP_RETURN_IF_ERROR(exec_.initFeatures(args_.staticFeatures));
+    JPP_RETURN_IF_ERROR(exec_.initOther());
+    return exec_.loadInput(args_.corpusFilename);
+  }
+
+  Status evaluate(util::ArraySlice<float> weights, StringPiece name) {
+    analysis::HashedFeaturePerceptron perceptron{weights};
+    analysis::ScorerDef sconf;
+    sconf.feature = &perceptron;
+    sconf.scoreWeights.push_back(1.0f);
+
+    t::EvaluationResult result;
+    JPP_RETURN_IF_ERROR(exec_.evaluate(&sconf, &result));
+    LOG_INFO() << name << ": sentences=" << result.numSentences
+               << " sentence accuracy=" << result.sentenceAccuracy()
+               << " field accuracy=" << result.fieldAccuracy();
+    return Status::Ok();
+  }
+};
+
+int saveModel(const t::TrainingArguments& args,
+              const core::model::ModelInfo& model) {
+  core::model::ModelSaver saver;
+  Status s = saver.open(args.outputFilename);
+  if (!s) {
+    LOG_ERROR() << "failed to open file [" << args.outputFilename
+                << "] for saving model: " << s;
+    return 1;
+  }
+
+  LOG_INFO() << "Writing the model to file: " << args.outputFilename;
+  s = saver.save(model);
+  if (!s) {
+    LOG_ERROR() << "failed to save model: " << s;
+    return 1;
+  }
+  LOG_INFO() << "Model saved successfully";
+
+  return 0;
+}
+
+}  // namespace
+
+int pruneCommandImpl(const training::TrainingArguments& args,
+                     const training::WeightPruningConfig& config) {
+  core::JumanppEnv env;
+  env.setBeamSize(static_cast<u32>(args.trainingConfig.beamSize));
+
+  Status s = env.loadModel(args.modelFilename);
+  if (!s) {
+    LOG_ERROR() << "failed to read model from disk: " << s;
+    return 1;
+  }
+
+  if (!env.hasPerceptronModel()) {
+    LOG_ERROR() << "model [" << args.modelFilename << "] was not trained";
+    return 1;
+  }
+
+  auto& modelWeights = env.featureScorer()->weights();
+  std::vector<float> original;
+  original.reserve(modelWeights.size());
+  for (size_t i = 0; i < modelWeights.size(); ++i) {
+    original.push_back(modelWeights.at(i));
+  }
+
+  t::WeightPruner pruner{original};
+  s = pruner.prune(config);
+  if (!s) {
+    LOG_ERROR() << "failed to prune weights: " << s;
+    return 1;
+  }
+
+  auto& stats = pruner.stats();
+  LOG_INFO() << "Zeroed weights with magnitude < " << stats.threshold << ": "
+             << stats.nonzeroBefore << " -> " << stats.nonzeroAfter
+             << " non-zero weights";
+  LOG_INFO() << "Weight table size: " << stats.originalSize << " -> "
+             << stats.resultSize << ", " << stats.collisions
+             << " weights share a slot with others";
+
+  if (!args.corpusFilename.empty()) {
+    u32 exponent = 0;
+    while ((size_t{1} << exponent) < original.size()) {
+      exponent += 1;
+    }
+    PruningEvaluator eval{args, exponent, &env};
+    s = eval.initialize();
+    if (s) {
+      s = eval.evaluate(original, "Original");
+    }
+    if (s) {
+      s = eval.evaluate(pruner.weights(), "Pruned");
+    }
+    if (!s) {
+      LOG_ERROR() << "failed to evaluate weights on ["
+                  << args.corpusFilename << "]: " << s;
+      return 1;
+    }
+  }
+
+  if (args.outputFilename.empty()) {
+    return 0;
+  }
+
+  auto model = env.modelInfoCopy();
+  pruner.exportModel(&model);
+  return saveModel(args, model);
+}
+
+}  // namespace tool
+}  // namespace core
+}  // namespace jumanpp
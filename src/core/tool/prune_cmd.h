@@ -0,0 +1,22 @@
+#ifndef JUMANPP_PRUNE_CMD_H
+#define JUMANPP_PRUNE_CMD_H
+
+#include "core/training/training_env.h"
+#include "core/training/weight_pruning.h"
+
+namespace jumanpp {
+namespace core {
+namespace tool {
+
+/**
+ * Prunes and compacts perceptron weights of a trained model.
+ * If a corpus is specified, accuracy is reported before and after pruning.
+ */
+int pruneCommandImpl(const training::TrainingArguments& args,
+                     const training::WeightPruningConfig& config);
+
+}  // namespace tool
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_PRUNE_CMD_H
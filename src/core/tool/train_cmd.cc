@@ -70,7 +70,7 @@ int doTrainJpp(const t::TrainingArguments& args, core::JumanppEnv& env) {
 
   t::TrainingEnv exec{args, &env};
 
-  Status s = exec.initFeatures(nullptr);
+  Status s = exec.initFeatures(args.staticFeatures);
 
   if (!s) {
     LOG_ERROR() << "failed to initialize features: " << s;
@@ -0,0 +1,110 @@
+#include "batch_loader.h"
+
+namespace jumanpp {
+namespace core {
+namespace training {
+
+Status PrefetchingBatchLoader::initialize(const TrainerFullConfig& tfc,
+                                          const analysis::ScorerDef* sconf,
+                                          i32 batchSize, i32 numBatches) {
+  stop();
+  batches_.clear();
+  for (i32 i = 0; i < numBatches; ++i) {
+    std::unique_ptr<Batch> batch{new Batch};
+    for (i32 j = 0; j < batchSize; ++j) {
+      auto trainer =
+          std::unique_ptr<OwningFullTrainer>(new OwningFullTrainer{tfc});
+      JPP_RETURN_IF_ERROR(trainer->initAnalyzer(sconf));
+      batch->trainers.emplace_back(std::move(trainer));
+    }
+    batches_.emplace_back(std::move(batch));
+  }
+  // one more slot for the stop marker
+  free_.initialize(numBatches + 1);
+  ready_.initialize(numBatches + 1);
+  return Status::Ok();
+}
+
+void PrefetchingBatchLoader::run() {
+  while (true) {
+    auto batch = free_.waitFor();
+    if (batch == nullptr) {
+      return;
+    }
+
+    batch->numRead = 0;
+    batch->status = Status::Ok();
+    for (auto& tr : batch->trainers) {
+      tr->reset();
+      batch->status = tr->readExample(reader_);
+      if (!batch->status || reader_->finished()) {
+        break;
+      }
+      batch->numRead += 1;
+    }
+    bool last = !batch->status || reader_->finished();
+    batch->last = last;
+
+    // the batch belongs to the training thread after this point
+    while (!ready_.offer(std::move(batch))) {
+      std::this_thread::yield();
+    }
+    if (last) {
+      return;
+    }
+  }
+}
+
+Status PrefetchingBatchLoader::start(FullExampleReader* reader) {
+  if (!isInitialized()) {
+    return JPPS_INVALID_STATE << "batch loader was not initialized";
+  }
+  stop();
+
+  Batch* batch;
+  while (free_.recieve(&batch)) {
+    // drain leftovers of the previous run
+  }
+  while (ready_.recieve(&batch)) {
+  }
+  for (auto& b : batches_) {
+    free_.offer(b.get());
+  }
+
+  reader_ = reader;
+  finished_ = false;
+  try {
+    thread_ = std::thread{PrefetchingBatchLoader::runMain, this};
+  } catch (std::system_error& e) {
+    finished_ = true;
+    return JPPS_INVALID_STATE << "failed to start batch loader: " << e.code()
+                              << " msg: " << e.what();
+  }
+  return Status::Ok();
+}
+
+Status PrefetchingBatchLoader::nextBatch(TrainerBatch* batch) {
+  if (finished_) {
+    return JPPS_INVALID_STATE << "batch loader has already finished";
+  }
+  auto loaded = ready_.waitFor();
+  finished_ = loaded->last;
+  Status status = std::move(loaded->status);
+  // trainers of the previous batch are not used anymore,
+  // they will receive the batch after the next one
+  batch->swapFullTrainers(&loaded->trainers, loaded->numRead);
+  free_.offer(std::move(loaded));
+  return status;
+}
+
+void PrefetchingBatchLoader::stop() {
+  if (thread_.joinable()) {
+    free_.offer(nullptr);
+    thread_.join();
+  }
+  finished_ = true;
+}
+
+}  // namespace training
+}  // namespace core
+}  // namespace jumanpp
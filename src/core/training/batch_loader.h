@@ -0,0 +1,73 @@
+#ifndef JUMANPP_BATCH_LOADER_H
+#define JUMANPP_BATCH_LOADER_H
+
+#include <memory>
+#include <thread>
+#include <vector>
+#include "core/training/trainer.h"
+#include "util/bounded_queue.h"
+
+namespace jumanpp {
+namespace core {
+namespace training {
+
+/**
+ * Reads full examples of the next batches in a background thread,
+ * while the current batch is being trained.
+ *
+ * Examples are parsed into spare trainer sets which are swapped
+ * with the active trainers of TrainerBatch.
+ * Memory is bounded by the number of prefetched batches.
+ */
+class PrefetchingBatchLoader {
+  struct Batch {
+    std::vector<std::unique_ptr<OwningFullTrainer>> trainers;
+    i32 numRead = 0;
+    bool last = false;
+    Status status = Status::Ok();
+  };
+
+  std::vector<std::unique_ptr<Batch>> batches_;
+  util::bounded_queue<Batch*> free_;
+  util::bounded_queue<Batch*> ready_;
+  FullExampleReader* reader_ = nullptr;
+  std::thread thread_;
+  bool finished_ = true;
+
+  void run();
+  static void runMain(PrefetchingBatchLoader* ctx) { ctx->run(); }
+
+ public:
+  PrefetchingBatchLoader() = default;
+  PrefetchingBatchLoader(const PrefetchingBatchLoader&) = delete;
+  ~PrefetchingBatchLoader() { stop(); }
+
+  Status initialize(const TrainerFullConfig& tfc,
+                    const analysis::ScorerDef* sconf, i32 batchSize,
+                    i32 numBatches);
+
+  bool isInitialized() const { return !batches_.empty(); }
+
+  /**
+   * Starts reading examples from the reader in background
+   * until the reader is finished.
+   * The reader must not be used by anybody else before the loader is
+   * finished or stopped.
+   */
+  Status start(FullExampleReader* reader);
+
+  /**
+   * Waits for the next prefetched batch and makes it active.
+   */
+  Status nextBatch(TrainerBatch* batch);
+
+  bool finished() const { return finished_; }
+
+  void stop();
+};
+
+}  // namespace training
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_BATCH_LOADER_H
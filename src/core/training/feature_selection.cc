@@ -0,0 +1,156 @@
+#include "feature_selection.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace jumanpp {
+namespace core {
+namespace training {
+
+NgramImportance::NgramImportance(size_t numNgrams) : stats_(numNgrams) {
+  for (size_t i = 0; i < numNgrams; ++i) {
+    stats_[i].index = static_cast<i32>(i);
+  }
+}
+
+void NgramImportance::add(const LossCalculator& loss,
+                          const analysis::WeightBuffer& weights) {
+  auto gold = loss.goldNgramFeatures();
+  JPP_DCHECK_EQ(gold.rowSize(), stats_.size());
+  u32 mask = static_cast<u32>(weights.size() - 1);
+
+  // the competitor is the best path which is not the gold one
+  loss.top1NgramFeatures(&topFeatures_);
+  auto goldData = gold.data();
+  bool topIsGold = topFeatures_.size() == goldData.size() &&
+                   std::equal(topFeatures_.begin(), topFeatures_.end(),
+                              goldData.begin());
+  if (topIsGold && !loss.pathNgramFeatures(1, &topFeatures_)) {
+    // there is no other path, features do not change the result
+    topFeatures_.clear();
+  }
+  bool hasCompetitor = !topFeatures_.empty();
+
+  for (size_t row = 0; row < gold.numRows(); ++row) {
+    auto feats = gold.row(row);
+    for (size_t p = 0; p < stats_.size(); ++p) {
+      auto w = weights.at(feats.at(p) & mask);
+      stats_[p].goldMass += std::abs(w);
+      if (hasCompetitor) {
+        stats_[p].margin += w;
+      }
+    }
+  }
+  numGoldNodes_ += gold.numRows();
+
+  util::ConstSliceable<u32> top{topFeatures_, stats_.size(),
+                                topFeatures_.size() / stats_.size()};
+  for (size_t row = 0; row < top.numRows(); ++row) {
+    auto feats = top.row(row);
+    for (size_t p = 0; p < stats_.size(); ++p) {
+      stats_[p].margin -= weights.at(feats.at(p) & mask);
+    }
+  }
+}
+
+std::vector<NgramPatternStats> NgramImportance::ranking() const {
+  return rankNgrams(stats_);
+}
+
+std::vector<NgramPatternStats> rankNgrams(
+    util::ArraySlice<NgramPatternStats> stats) {
+  std::vector<NgramPatternStats> result{stats.begin(), stats.end()};
+  std::stable_sort(result.begin(), result.end(),
+                   [](const NgramPatternStats& a, const NgramPatternStats& b) {
+                     if (a.margin != b.margin) {
+                       return a.margin > b.margin;
+                     }
+                     return a.goldMass > b.goldMass;
+                   });
+  return result;
+}
+
+std::string describeNgram(const spec::AnalysisSpec& spec, i32 ngramIdx) {
+  auto& fspec = spec.features;
+  std::stringstream ss;
+  for (auto patIdx : fspec.ngram.at(ngramIdx).references) {
+    ss << "[";
+    bool first = true;
+    for (auto compIdx : fspec.pattern.at(patIdx).references) {
+      if (!first) {
+        ss << ", ";
+      }
+      first = false;
+      ss << fspec.computation.at(compIdx).name;
+    }
+    ss << "]";
+  }
+  return ss.str();
+}
+
+Status makeReducedSpec(const spec::AnalysisSpec& original,
+                       util::ArraySlice<i32> keepNgrams,
+                       spec::AnalysisSpec* result) {
+  auto& ofeat = original.features;
+  std::vector<char> keep(ofeat.ngram.size(), 0);
+  for (auto idx : keepNgrams) {
+    if (idx < 0 || idx >= ofeat.ngram.size()) {
+      return JPPS_INVALID_PARAMETER << "ngram feature index " << idx
+                                    << " is out of bounds, there are only "
+                                    << ofeat.ngram.size() << " features";
+    }
+    keep[idx] = 1;
+  }
+
+  // patterns are grouped by their usage (see SpecCompiler),
+  // so they keep their original order and usage bits
+  std::vector<i32> patternMap(ofeat.pattern.size(), -1);
+  for (size_t i = 0; i < ofeat.ngram.size(); ++i) {
+    if (!keep[i]) {
+      continue;
+    }
+    for (auto pat : ofeat.ngram[i].references) {
+      patternMap.at(pat) = 0;
+    }
+  }
+
+  *result = original;
+  auto& rfeat = result->features;
+  rfeat.pattern.clear();
+  rfeat.numUniOnlyPats = 0;
+  for (auto& pat : ofeat.pattern) {
+    if (patternMap[pat.index] == -1) {
+      continue;
+    }
+    auto newIdx = static_cast<i32>(rfeat.pattern.size());
+    patternMap[pat.index] = newIdx;
+    rfeat.pattern.push_back(pat);
+    rfeat.pattern.back().index = newIdx;
+    if (pat.usage == 0x1) {
+      rfeat.numUniOnlyPats += 1;
+    }
+  }
+
+  rfeat.ngram.clear();
+  for (size_t i = 0; i < ofeat.ngram.size(); ++i) {
+    if (!keep[i]) {
+      continue;
+    }
+    spec::NgramFeatureDescriptor nf;
+    nf.index = static_cast<i32>(rfeat.ngram.size());
+    for (auto pat : ofeat.ngram[i].references) {
+      nf.references.push_back(patternMap[pat]);
+    }
+    rfeat.ngram.push_back(std::move(nf));
+  }
+
+  if (rfeat.ngram.empty()) {
+    return JPPS_INVALID_PARAMETER << "reduced spec must have ngram features";
+  }
+
+  return Status::Ok();
+}
+
+}  // namespace training
+}  // namespace core
+}  // namespace jumanpp
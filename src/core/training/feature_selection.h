@@ -0,0 +1,74 @@
+#ifndef JUMANPP_FEATURE_SELECTION_H
+#define JUMANPP_FEATURE_SELECTION_H
+
+#include <string>
+#include <vector>
+#include "core/analysis/score_api.h"
+#include "core/spec/spec_types.h"
+#include "core/training/loss.h"
+
+namespace jumanpp {
+namespace core {
+namespace training {
+
+struct NgramPatternStats {
+  i32 index = 0;
+  // sum of absolute weights of the feature on gold path nodes
+  double goldMass = 0;
+  // sum of differences of the feature weights between the gold path and
+  // the best other path (top1 or, if top1 is gold, the second best one),
+  // positive values mean that the feature helps to select the gold path
+  double margin = 0;
+};
+
+/**
+ * Measures contributions of ngram feature patterns
+ * to path scores of analyzed examples.
+ */
+class NgramImportance {
+  std::vector<NgramPatternStats> stats_;
+  std::vector<u32> topFeatures_;
+  i64 numGoldNodes_ = 0;
+
+ public:
+  explicit NgramImportance(size_t numNgrams);
+
+  void add(const LossCalculator& loss, const analysis::WeightBuffer& weights);
+
+  i64 numGoldNodes() const { return numGoldNodes_; }
+  util::ArraySlice<NgramPatternStats> stats() const { return stats_; }
+
+  /**
+   * Ngram patterns sorted by their contribution to the score margin,
+   * see rankNgrams.
+   */
+  std::vector<NgramPatternStats> ranking() const;
+};
+
+/**
+ * Sorts ngram patterns by decreasing score margin: patterns which separate
+ * gold paths from their competitors the most come first, patterns which
+ * favor wrong paths come last. Ties are broken by the gold score mass.
+ */
+std::vector<NgramPatternStats> rankNgrams(
+    util::ArraySlice<NgramPatternStats> stats);
+
+/**
+ * Human-readable description of the ngram pattern, e.g. [pos][pos, subpos]
+ */
+std::string describeNgram(const spec::AnalysisSpec& spec, i32 ngramIdx);
+
+/**
+ * Makes a spec which has only the listed ngram features.
+ * Pattern features which are not used anymore are removed as well.
+ * Features are renumbered, so a model with such spec needs to be retrained.
+ */
+Status makeReducedSpec(const spec::AnalysisSpec& original,
+                       util::ArraySlice<i32> keepNgrams,
+                       spec::AnalysisSpec* result);
+
+}  // namespace training
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_FEATURE_SELECTION_H
@@ -0,0 +1,161 @@
+#include "feature_selection.h"
+#include "scw.h"
+#include "trainer.h"
+#include "training_test_common.h"
+
+namespace {
+class SelectionEnv : public GoldExampleEnv {
+ public:
+  core::training::TrainFieldsIndex tio;
+  core::training::FullExampleReader rdr;
+  Trainer trainer;
+
+  static TrainingConfig testConf() {
+    TrainingConfig tc;
+    tc.featureNumberExponent = 12;
+    return tc;
+  }
+
+  SelectionEnv(StringPiece dic)
+      : GoldExampleEnv(dic),
+        trainer{anaImpl(), &env.originalSpec.training, testConf()} {
+    REQUIRE_OK(tio.initialize(core()));
+    rdr.setTrainingIo(&tio);
+  }
+
+  void parseMrph(StringPiece data) {
+    REQUIRE_OK(rdr.initDoubleCsv(data));
+    REQUIRE_OK(rdr.readFullExample(&trainer.example()));
+  }
+
+  i32 ngramIndex(StringPiece description) {
+    auto& ngrams = spec().features.ngram;
+    for (i32 i = 0; i < ngrams.size(); ++i) {
+      if (describeNgram(spec(), i) == description) {
+        return i;
+      }
+    }
+    return -1;
+  }
+};
+}  // namespace
+
+TEST_CASE("ngram features are described with their field names") {
+  SelectionEnv env{"もも,N,0\nも,PRT,1\n"};
+  CHECK(env.ngramIndex("[a, b]") != -1);
+  CHECK(env.ngramIndex("[a][a]") != -1);
+  CHECK(env.ngramIndex("[b][b]") != -1);
+  CHECK(env.ngramIndex("[a, b][a, b]") != -1);
+  CHECK(env.ngramIndex("[a][a][a]") != -1);
+}
+
+TEST_CASE("reduced spec has renumbered features") {
+  SelectionEnv env{"もも,N,0\nも,PRT,1\n"};
+  auto& original = env.spec();
+  std::vector<i32> keep{env.ngramIndex("[b][b]"), env.ngramIndex("[a, b]")};
+  core::spec::AnalysisSpec reduced;
+  REQUIRE_OK(makeReducedSpec(original, keep, &reduced));
+  auto& rf = reduced.features;
+  REQUIRE(rf.ngram.size() == 2);
+  for (i32 i = 0; i < rf.ngram.size(); ++i) {
+    CHECK(rf.ngram[i].index == i);
+  }
+  // [a] pattern is not used anymore
+  CHECK(rf.pattern.size() == original.features.pattern.size() - 1);
+  for (i32 i = 0; i < rf.pattern.size(); ++i) {
+    CHECK(rf.pattern[i].index == i);
+  }
+  std::vector<std::string> names;
+  for (i32 i = 0; i < rf.ngram.size(); ++i) {
+    names.push_back(describeNgram(reduced, i));
+  }
+  // original order is preserved
+  if (keep[0] < keep[1]) {
+    CHECK(names == std::vector<std::string>{"[b][b]", "[a, b]"});
+  } else {
+    CHECK(names == std::vector<std::string>{"[a, b]", "[b][b]"});
+  }
+  CHECK(rf.numUniOnlyPats == 0);
+}
+
+TEST_CASE("reduced spec rejects invalid indices") {
+  SelectionEnv env{"もも,N,0\nも,PRT,1\n"};
+  core::spec::AnalysisSpec reduced;
+  std::vector<i32> invalid{100};
+  CHECK_FALSE(makeReducedSpec(env.spec(), invalid, &reduced));
+  std::vector<i32> empty;
+  CHECK_FALSE(makeReducedSpec(env.spec(), empty, &reduced));
+}
+
+TEST_CASE("ngram importance counts gold path nodes") {
+  SelectionEnv env{"もも,N,0\nも,PRT,1\n"};
+  env.parseMrph("もも_N_0 も_PRT_1 もも_N_0\n");
+  SoftConfidenceWeighted scw{SelectionEnv::testConf()};
+  REQUIRE(env.trainer.prepare());
+  REQUIRE(env.trainer.compute(scw.scorers()));
+  NgramImportance imp{env.spec().features.ngram.size()};
+  imp.add(env.trainer.lossCalculator(), scw.scorers()->feature->weights());
+  // 3 nodes + EOS
+  CHECK(imp.numGoldNodes() == 4);
+  CHECK(imp.stats().size() == env.spec().features.ngram.size());
+  for (auto& s : imp.stats()) {
+    CHECK(s.goldMass >= 0);
+  }
+  imp.add(env.trainer.lossCalculator(), scw.scorers()->feature->weights());
+  CHECK(imp.numGoldNodes() == 8);
+}
+
+TEST_CASE("ngram importance is positive after training") {
+  SelectionEnv env{"もも,N,0\nも,PRT,1\n"};
+  env.parseMrph("もも_N_0 も_PRT_1 もも_N_0\n");
+  SoftConfidenceWeighted scw{SelectionEnv::testConf()};
+  REQUIRE(env.trainer.prepare());
+  for (int i = 0; i < 10; ++i) {
+    REQUIRE(env.trainer.compute(scw.scorers()));
+    env.trainer.computeTrainingLoss();
+    scw.update(env.trainer.lossValue(), env.trainer.featureDiff());
+  }
+  REQUIRE(env.trainer.compute(scw.scorers()));
+  env.trainer.computeTrainingLoss();
+  REQUIRE(env.trainer.lossValue() == 0);
+  NgramImportance imp{env.spec().features.ngram.size()};
+  imp.add(env.trainer.lossCalculator(), scw.scorers()->feature->weights());
+  double total = 0;
+  double totalMargin = 0;
+  for (auto& s : imp.stats()) {
+    total += s.goldMass;
+    totalMargin += s.margin;
+  }
+  CHECK(total > 0);
+  // top1 path is the gold one, margin is measured against the second one
+  CHECK(totalMargin > 0);
+  auto ranking = imp.ranking();
+  for (size_t i = 1; i < ranking.size(); ++i) {
+    CHECK(ranking[i - 1].margin >= ranking[i].margin);
+  }
+}
+
+TEST_CASE("ngram ranking uses the score margin instead of the gold mass") {
+  std::vector<NgramPatternStats> stats(4);
+  for (i32 i = 0; i < 4; ++i) {
+    stats[i].index = i;
+  }
+  // large weights which favor wrong paths as much as the gold one
+  stats[0].goldMass = 10;
+  stats[0].margin = 0;
+  // small weights which separate gold paths
+  stats[1].goldMass = 1;
+  stats[1].margin = 2;
+  // features which favor wrong paths
+  stats[2].goldMass = 5;
+  stats[2].margin = -3;
+  stats[3].goldMass = 2;
+  stats[3].margin = 0;
+  auto ranking = rankNgrams(stats);
+  std::vector<i32> order;
+  for (auto& s : ranking) {
+    order.push_back(s.index);
+  }
+  // by the gold mass it would be 0, 2, 3, 1
+  CHECK(order == std::vector<i32>{1, 0, 3, 2});
+}
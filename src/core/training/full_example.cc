@@ -9,6 +9,19 @@ namespace core {
 namespace training {
 
 Status FullExampleReader::readFullExample(FullyAnnotatedExample *result) {
+  while (true) {
+    exampleLine_ = csv_.lineNumber();
+    JPP_RETURN_IF_ERROR(readNextExample(result));
+    bool ours = exampleIdx_ % numShards_ == shard_;
+    exampleIdx_ += 1;
+    if (ours || finished_) {
+      return Status::Ok();
+    }
+    result->reset();
+  }
+}
+
+Status FullExampleReader::readNextExample(FullyAnnotatedExample *result) {
   result->data_.clear();
   result->lengths_.clear();
 
@@ -32,6 +45,7 @@ Status FullExampleReader::initCsv(StringPiece data) {
   mode_ = DataReaderMode::SimpleCsv;
   csv_ = util::CsvReader();
   finished_ = false;
+  exampleIdx_ = 0;
   return csv_.initFromMemory(data);
 }
 
@@ -48,6 +62,7 @@ Status FullExampleReader::initDoubleCsv(StringPiece data, char tokenSep,
   csv_ = util::CsvReader{tokenSep};
   csv2_ = util::CsvReader{fieldSep};
   finished_ = false;
+  exampleIdx_ = 0;
   return csv_.initFromMemory(data);
 }
 
@@ -71,6 +71,15 @@ class FullyAnnotatedExample {
 
   i32 numNodes() const { return static_cast<i32>(lengths_.size()); }
 
+  /**
+   * String of a field value which is not present in the dictionary
+   * (negative values of node data)
+   */
+  StringPiece unknownString(i32 value) const {
+    JPP_DCHECK_LT(value, 0);
+    return strings_[~value];
+  }
+
   StringPiece comment() const { return comment_; }
 
   void reset() {
@@ -103,6 +112,12 @@ class FullExampleReader {
   char doubleFldSep_;
   StringPiece filename_;
   util::CharBuffer<> charBuffer_;
+  u32 shard_ = 0;
+  u32 numShards_ = 1;
+  u64 exampleIdx_ = 0;
+  i64 exampleLine_ = 0;
+
+  Status readNextExample(FullyAnnotatedExample* result);
 
   Status readSingleExampleFragment(const util::CsvReader& csv,
                                    FullyAnnotatedExample* result);
@@ -117,15 +132,30 @@ class FullExampleReader {
   bool finished() const { return finished_; }
   Status readFullExampleDblCsv(FullyAnnotatedExample* result);
   Status readFullExampleCsv(FullyAnnotatedExample* result);
+  /**
+   * Reads the next example of the current shard.
+   */
   Status readFullExample(FullyAnnotatedExample* result);
 
+  /**
+   * Use only every numShards-th example of the input, starting from shard.
+   */
+  void setShard(u32 shard, u32 numShards) {
+    JPP_DCHECK_LT(shard, numShards);
+    shard_ = shard;
+    numShards_ = numShards;
+  }
+
   i64 lineNumber() const { return csv_.lineNumber(); }
+  // line number before the last read example
+  i64 exampleLineNumber() const { return exampleLine_; }
 
   void resetInput(StringPiece data) {
     Status s = csv_.initFromMemory(data);
     JPP_DCHECK(s);
     charBuffer_.reset();
     finished_ = false;
+    exampleIdx_ = 0;
   }
 
   void setFilename(StringPiece filename) { filename_ = filename; }
@@ -4,6 +4,7 @@
 
 #include "loss.h"
 
+#include <algorithm>
 #include <numeric>
 #include "core/analysis/unk_nodes_creator.h"
 #include "core/impl/feature_computer.h"
@@ -475,6 +476,38 @@ void LossCalculator::computeGoldScores(const analysis::ScorerDef* scores) {
                    goldScores.begin());
 }
 
+bool LossCalculator::pathNgramFeatures(u32 rank,
+                                       std::vector<u32>* result) const {
+  auto lattice = analyzer->lattice();
+  auto eosBnd = lattice->boundary(lattice->createdBoundaryCount() - 1);
+  auto eosBeam = eosBnd->starts()->beamData().row(0);
+  if (rank >= eosBeam.size() || analysis::EntryBeam::isFake(eosBeam[rank])) {
+    result->clear();
+    return false;
+  }
+  std::vector<analysis::LatticeNodePtr> nodes;
+  const analysis::ConnectionPtr* ptr = &eosBeam[rank].ptr;
+  for (; ptr != nullptr && ptr->boundary >= 2; ptr = ptr->previous) {
+    nodes.push_back(ptr->latticeNodePtr());
+  }
+  std::reverse(nodes.begin(), nodes.end());
+
+  auto numNgrams = analyzer->core().spec().features.ngram.size();
+  result->resize(nodes.size() * numNgrams);
+  if (nodes.empty()) {
+    return true;
+  }
+  NgramFeaturesComputer nefc{lattice, analyzer->core().features()};
+  util::Sliceable<u32> ngrams{result, numNgrams, nodes.size()};
+  auto nfr = NgramFeatureRef::init(nodes[0]);
+  nefc.calculateNgramFeatures(nfr, ngrams.row(0));
+  for (size_t idx = 1; idx < nodes.size(); ++idx) {
+    nfr = nfr.next(nodes[idx]);
+    nefc.calculateNgramFeatures(nfr, ngrams.row(idx));
+  }
+  return true;
+}
+
 std::string LossCalculator::compDump() const {
   std::stringstream ss;
   for (auto& c : comparison) {
@@ -156,6 +156,29 @@ class LossCalculator {
 
   util::ArraySlice<ScoredFeature> featureDiff() const { return scored; }
 
+  /**
+   * Ngram features of gold nodes, a row for each node and EOS.
+   * Filled by resolveGold().
+   */
+  util::ConstSliceable<u32> goldNgramFeatures() const {
+    auto numNgrams = analyzer->core().spec().features.ngram.size();
+    return {rawGoldFeatures, numNgrams, rawGoldFeatures.size() / numNgrams};
+  }
+
+  /**
+   * Computes ngram features of nodes of the top1 path in the same format.
+   */
+  void top1NgramFeatures(std::vector<u32>* result) const {
+    pathNgramFeatures(0, result);
+  }
+
+  /**
+   * Computes ngram features of the path which ends in the EOS beam
+   * element with the given rank (0 is the top1 path).
+   * @return false if the beam has no such path
+   */
+  bool pathNgramFeatures(u32 rank, std::vector<u32>* result) const;
+
   GoldenPath& goldPath() { return gold; }
   const GoldenPath& goldPath() const { return gold; }
 };
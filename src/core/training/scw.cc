@@ -3,6 +3,7 @@
 //
 
 #include "scw.h"
+#include <algorithm>
 #include <cmath>
 #include <random>
 #include "core/impl/model_io.h"
@@ -124,11 +125,71 @@ Status SoftConfidenceWeighted::validate() const {
 
 struct ScwData {
   util::CodedBuffer cbuf;
+  util::CodedBuffer stateBuf;
 };
 
+struct ScwDumpInfo {
+  u32 featureExponent;
+  float C;
+  float phi;
+};
+
+template <typename Arch>
+void Serialize(Arch& a, ScwDumpInfo& sdi) {
+  a& sdi.featureExponent;
+  a& sdi.C;
+  a& sdi.phi;
+}
+
+namespace {
+
+void removeParts(model::ModelInfo* model, model::ModelPartKind kind) {
+  auto& parts = model->parts;
+  parts.erase(std::remove_if(parts.begin(), parts.end(),
+                             [kind](const model::ModelPart& p) {
+                               return p.kind == kind;
+                             }),
+              parts.end());
+}
+
+StringPiece floatMemory(const std::vector<float>& data) {
+  auto ptr = reinterpret_cast<const char*>(data.data());
+  return StringPiece{ptr, ptr + data.size() * sizeof(float)};
+}
+
+util::ArraySlice<float> asFloats(StringPiece memory) {
+  auto ptr = reinterpret_cast<const float*>(memory.data());
+  return util::ArraySlice<float>{ptr, memory.size() / sizeof(float)};
+}
+
+// weight table of the smaller size is repeated to fill the larger one,
+// scorers use hash & (size - 1) so scores stay the same
+Status expandInto(util::ArraySlice<float> source, std::vector<float>* target,
+                  StringPiece what) {
+  if (source.size() > target->size() ||
+      !util::memory::IsPowerOf2(source.size())) {
+    return JPPS_INVALID_PARAMETER
+           << what << " of the model has " << source.size()
+           << " entries, which is not a power of 2 not larger than "
+           << target->size() << " (size of the training table)";
+  }
+  auto mask = source.size() - 1;
+  for (size_t i = 0; i < target->size(); ++i) {
+    (*target)[i] = source[i & mask];
+  }
+  return Status::Ok();
+}
+
+}  // namespace
+
 void SoftConfidenceWeighted::exportModel(model::ModelInfo* model,
                                          StringPiece comment) {
-  data_.reset(new ScwData);
+  if (!data_) {
+    data_.reset(new ScwData);
+  }
+  // the input model could be already trained
+  removeParts(model, model::ModelPartKind::Perceprton);
+  data_->cbuf.reset();
   util::serialization::Saver svr{&data_->cbuf};
   PerceptronInfo pi;
 
@@ -151,21 +212,90 @@ void SoftConfidenceWeighted::exportModel(model::ModelInfo* model,
   model->parts.push_back(std::move(part));
 }
 
-SoftConfidenceWeighted::~SoftConfidenceWeighted() = default;
+void SoftConfidenceWeighted::exportState(model::ModelInfo* model) {
+  if (!data_) {
+    data_.reset(new ScwData);
+  }
+  removeParts(model, model::ModelPartKind::ScwDump);
+  data_->stateBuf.reset();
+  util::serialization::Saver svr{&data_->stateBuf};
+  ScwDumpInfo dumpInfo{featureExponent_, static_cast<float>(C),
+                       static_cast<float>(phi)};
+  svr.save(dumpInfo);
 
-struct ScwDumpInfo {
-  u32 featureExponent;
-  float C;
-  float phi;
-};
+  model::ModelPart part;
+  part.kind = model::ModelPartKind::ScwDump;
+  part.data.push_back(data_->stateBuf.contents());
+  part.data.push_back(floatMemory(usableWeights));
+  part.data.push_back(floatMemory(matrixDiagonal));
+  model->parts.push_back(std::move(part));
+}
 
-template <typename Arch>
-void Serialize(Arch& a, ScwDumpInfo& sdi) {
-  a& sdi.featureExponent;
-  a& sdi.C;
-  a& sdi.phi;
+Status SoftConfidenceWeighted::warmStart(const model::ModelInfo& model) {
+  util::ArraySlice<float> weights;
+  util::ArraySlice<float> diag;
+
+  analysis::HashedFeaturePerceptron saved;
+  if (model.firstPartOf(model::ModelPartKind::Perceprton) != nullptr) {
+    JPP_RETURN_IF_ERROR(saved.load(model));
+    weights = saved.weights().weights;
+  }
+
+  auto dump = model.firstPartOf(model::ModelPartKind::ScwDump);
+  if (dump != nullptr) {
+    if (dump->data.size() != 3) {
+      return JPPS_INVALID_PARAMETER
+             << "SCW dump in the model did not have exactly three parts";
+    }
+    util::serialization::Loader ldr{dump->data[0]};
+    ScwDumpInfo dumpInfo{};
+    if (!ldr.load(&dumpInfo)) {
+      return JPPS_INVALID_PARAMETER << "failed to load SCW dump information";
+    }
+    if (dumpInfo.C != C || dumpInfo.phi != phi) {
+      LOG_WARN() << "SCW parameters of the model (C=" << dumpInfo.C
+                 << ", phi=" << dumpInfo.phi
+                 << ") are different from the current ones";
+    }
+    auto dumpWeights = asFloats(dump->data[1]);
+    auto dumpDiag = asFloats(dump->data[2]);
+    if (dumpDiag.size() != dumpWeights.size() ||
+        (!weights.empty() && dumpWeights.size() != weights.size())) {
+      // e.g. perceptron was pruned after the state was stored
+      LOG_WARN() << "SCW state of the model with " << dumpWeights.size()
+                 << " weights and " << dumpDiag.size()
+                 << " diagonal values does not match the perceptron of "
+                 << weights.size() << " weights and was ignored";
+    } else {
+      if (weights.empty()) {
+        weights = dumpWeights;
+      }
+      diag = dumpDiag;
+    }
+  }
+
+  if (weights.empty()) {
+    return JPPS_INVALID_PARAMETER
+           << "model had neither perceptron weights nor SCW state";
+  }
+
+  JPP_RETURN_IF_ERROR(expandInto(weights, &usableWeights, "weight table"));
+  if (diag.empty()) {
+    std::fill(matrixDiagonal.begin(), matrixDiagonal.end(), 1.0f);
+  } else {
+    JPP_RETURN_IF_ERROR(expandInto(diag, &matrixDiagonal, "SCW diagonal"));
+  }
+
+  LOG_INFO() << "Warm start: initialized " << usableWeights.size()
+             << " weights from a table of " << weights.size()
+             << (diag.empty() ? ", SCW diagonal was reset"
+                              : ", SCW diagonal was restored");
+  warmStarted_ = true;
+  return Status::Ok();
 }
 
+SoftConfidenceWeighted::~SoftConfidenceWeighted() = default;
+
 void SoftConfidenceWeighted::dumpModel(StringPiece directory,
                                        StringPiece prefix, i32 number) {
   char filename[512];
@@ -175,27 +305,7 @@ void SoftConfidenceWeighted::dumpModel(StringPiece directory,
   if (retval <= 0) return;
 
   model::ModelInfo mnfo{};
-  ScwDumpInfo dumpInfo{featureExponent_, static_cast<float>(C),
-                       static_cast<float>(phi)};
-  util::serialization::Saver svr{};
-  svr.save(dumpInfo);
-
-  model::ModelPart part;
-  part.kind = model::ModelPartKind::ScwDump;
-  part.data.push_back(svr.result());
-
-  auto weightsPtr = reinterpret_cast<const char*>(usableWeights.data());
-  StringPiece weightsMemory{weightsPtr,
-                            weightsPtr + usableWeights.size() * sizeof(float)};
-
-  auto diagonalPtr = reinterpret_cast<const char*>(matrixDiagonal.data());
-  StringPiece diagMemory{diagonalPtr,
-                         diagonalPtr + matrixDiagonal.size() * sizeof(float)};
-
-  part.data.push_back(weightsMemory);
-  part.data.push_back(diagMemory);
-
-  mnfo.parts.push_back(part);
+  exportState(&mnfo);
 
   model::ModelSaver modelSvr;
   auto fname = StringPiece{filename, filename + retval};
@@ -33,6 +33,7 @@ class SoftConfidenceWeighted {
 
   u32 featureExponent_;
   u32 randomSeed_;
+  bool warmStarted_ = false;
 
   analysis::HashedFeaturePerceptron perceptron;
   analysis::ScorerDef sconf;
@@ -59,9 +60,30 @@ class SoftConfidenceWeighted {
   void update(float loss, util::ArraySlice<ScoredFeature> features);
   const analysis::ScorerDef* scorers() const { return &sconf; }
   void exportModel(model::ModelInfo* model, StringPiece comment = EMPTY_SP);
+
+  /**
+   * Adds SCW state (weights and the matrix diagonal) to the model
+   * as a ScwDump part, so the training can be continued from it later.
+   */
+  void exportState(model::ModelInfo* model);
+
+  /**
+   * Initializes weights from the perceptron of the model and,
+   * if the model has a ScwDump part, the matrix diagonal from it.
+   * Without the perceptron weights are taken from the ScwDump part.
+   * ScwDump of a different size than the perceptron is ignored.
+   * A smaller table is expanded (weight i goes to all slots j with
+   * j & (size - 1) == i), so scores stay the same.
+   */
+  Status warmStart(const model::ModelInfo& model);
+  bool warmStarted() const { return warmStarted_; }
   void dumpModel(StringPiece directory, StringPiece prefix, i32 number);
   u64 substractInitValues();
   u64 numWeights() const { return usableWeights.size(); }
+  util::MutableArraySlice<float> weights() { return &usableWeights; }
+  util::MutableArraySlice<float> diagonal() { return &matrixDiagonal; }
+  util::ArraySlice<float> weights() const { return usableWeights; }
+  util::ArraySlice<float> diagonal() const { return matrixDiagonal; }
   ~SoftConfidenceWeighted();
 };
 
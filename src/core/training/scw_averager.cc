@@ -0,0 +1,281 @@
+#include "scw_averager.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include "util/logging.hpp"
+#include "util/memory.hpp"
+
+#if !defined(_WIN32_WINNT)
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace jumanpp {
+namespace core {
+namespace training {
+
+struct ScwSharedHeader {
+  std::atomic<u32> arrived{0};
+  std::atomic<u32> generation{0};
+  std::atomic<u32> failed{0};
+  // process which has created the segment, children are forked from it
+  i64 owner = 0;
+};
+
+namespace {
+
+constexpr size_t HeaderSize = 64;
+
+size_t flagsOffset() { return HeaderSize; }
+
+size_t lossesOffset(u32 numWorkers) {
+  return flagsOffset() + util::memory::Align(numWorkers * sizeof(u32), 8);
+}
+
+size_t slotsOffset(u32 numWorkers) {
+  return util::memory::Align(
+      lossesOffset(numWorkers) + numWorkers * sizeof(double), 64);
+}
+
+size_t slotSize(u64 numWeights) { return numWeights * 2 * sizeof(float); }
+
+size_t resultOffset(u32 numWorkers, u64 numWeights) {
+  return slotsOffset(numWorkers) + numWorkers * slotSize(numWeights);
+}
+
+}  // namespace
+
+Status ScwSharedSegment::initialize(u32 numWorkers, u64 numWeights) {
+  static_assert(sizeof(ScwSharedHeader) <= HeaderSize,
+                "header must fit into reserved space");
+  if (base_ != nullptr) {
+    return JPPS_INVALID_STATE << "shared segment was already initialized";
+  }
+  if (numWorkers == 0) {
+    return JPPS_INVALID_PARAMETER << "number of workers must be positive";
+  }
+  size_t size = resultOffset(numWorkers, numWeights) + slotSize(numWeights);
+#if defined(_WIN32_WINNT)
+  return JPPS_NOT_IMPLEMENTED
+         << "shared memory training segments are not supported on Windows";
+#else
+  void* addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED) {
+    return JPPS_INVALID_STATE << "failed to create shared segment of " << size
+                              << " bytes: " << std::strerror(errno);
+  }
+  base_ = addr;
+  size_ = size;
+  numWorkers_ = numWorkers;
+  numWeights_ = numWeights;
+  auto hdr = new (base_) ScwSharedHeader{};
+  hdr->owner = ::getpid();
+  return Status::Ok();
+#endif
+}
+
+ScwSharedSegment::~ScwSharedSegment() {
+#if !defined(_WIN32_WINNT)
+  if (base_ != nullptr) {
+    ::munmap(base_, size_);
+  }
+#endif
+}
+
+ScwSharedHeader* ScwSharedSegment::header() const {
+  return reinterpret_cast<ScwSharedHeader*>(base_);
+}
+
+u32* ScwSharedSegment::doneFlags() const {
+  return reinterpret_cast<u32*>(static_cast<char*>(base_) + flagsOffset());
+}
+
+double* ScwSharedSegment::losses() const {
+  return reinterpret_cast<double*>(static_cast<char*>(base_) +
+                                   lossesOffset(numWorkers_));
+}
+
+util::MutableArraySlice<float> ScwSharedSegment::slot(u32 worker) const {
+  auto ptr = static_cast<char*>(base_) + slotsOffset(numWorkers_) +
+             worker * slotSize(numWeights_);
+  return {reinterpret_cast<float*>(ptr), numWeights_ * 2};
+}
+
+util::MutableArraySlice<float> ScwSharedSegment::result() const {
+  auto ptr =
+      static_cast<char*>(base_) + resultOffset(numWorkers_, numWeights_);
+  return {reinterpret_cast<float*>(ptr), numWeights_ * 2};
+}
+
+Status ScwAverager::checkProcesses() const {
+#if !defined(_WIN32_WINNT)
+  auto owner = segment_->header()->owner;
+  // workers which are threads of a single process share its pid
+  if (::getpid() != owner && ::getppid() != owner) {
+    return JPPS_INVALID_STATE << "training worker #0 with pid " << owner
+                              << " has exited";
+  }
+  for (auto child : children_) {
+    siginfo_t info;
+    info.si_pid = 0;
+    // WNOWAIT leaves the exit status for waitTrainingWorkers
+    int ret = ::waitid(P_PID, static_cast<id_t>(child), &info,
+                       WEXITED | WNOHANG | WNOWAIT);
+    if (ret < 0 || info.si_pid != 0) {
+      return JPPS_INVALID_STATE << "training worker with pid " << child
+                                << " has exited";
+    }
+  }
+#endif
+  return Status::Ok();
+}
+
+Status ScwAverager::barrier() {
+  auto hdr = segment_->header();
+  u32 gen = hdr->generation.load(std::memory_order_acquire);
+  u32 arrived = hdr->arrived.fetch_add(1, std::memory_order_acq_rel) + 1;
+  if (arrived == numWorkers()) {
+    hdr->arrived.store(0, std::memory_order_relaxed);
+    hdr->generation.fetch_add(1, std::memory_order_release);
+    return Status::Ok();
+  }
+
+  for (u32 spins = 0; hdr->generation.load(std::memory_order_acquire) == gen;
+       ++spins) {
+    if (hdr->failed.load(std::memory_order_relaxed) != 0) {
+      return JPPS_INVALID_STATE << "another training worker has failed";
+    }
+    // other workers can be in the middle of a batch, do not burn their CPU
+    if (spins < 1000) {
+      std::this_thread::yield();
+      continue;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    // a crashed worker never arrives, check that everyone is alive
+    // once in ~100ms
+    if (spins % 1000 == 0) {
+      Status alive = checkProcesses();
+      // it could have arrived and finished while we were checking
+      if (!alive &&
+          hdr->generation.load(std::memory_order_acquire) == gen) {
+        abort();
+        return alive;
+      }
+    }
+  }
+  return Status::Ok();
+}
+
+Status ScwAverager::merge(SoftConfidenceWeighted* scw, bool done, double loss,
+                          ScwMergeResult* result) {
+  auto weights = scw->weights();
+  auto diagonal = scw->diagonal();
+  u64 numWeights = segment_->numWeights();
+  if (weights.size() != numWeights || diagonal.size() != numWeights) {
+    return JPPS_INVALID_PARAMETER
+           << "SCW has " << weights.size()
+           << " weights, shared segment was created for " << numWeights;
+  }
+
+  auto slot = segment_->slot(worker_);
+  std::copy(weights.begin(), weights.end(), slot.begin());
+  std::copy(diagonal.begin(), diagonal.end(), slot.begin() + numWeights);
+  segment_->doneFlags()[worker_] = done ? 1 : 0;
+  segment_->losses()[worker_] = loss;
+
+  JPP_RETURN_IF_ERROR(barrier());
+
+  // each worker averages its own part of the values
+  u32 nworkers = numWorkers();
+  u64 total = numWeights * 2;
+  u64 part = (total + nworkers - 1) / nworkers;
+  u64 begin = std::min<u64>(part * worker_, total);
+  u64 end = std::min<u64>(begin + part, total);
+  auto merged = segment_->result();
+  for (u64 i = begin; i < end; ++i) {
+    double sum = 0;
+    for (u32 w = 0; w < nworkers; ++w) {
+      sum += segment_->slot(w)[i];
+    }
+    merged[i] = static_cast<float>(sum / nworkers);
+  }
+
+  // flags and losses can be overwritten only after the next barrier
+  result->allDone = true;
+  result->totalLoss = 0;
+  for (u32 w = 0; w < nworkers; ++w) {
+    result->allDone &= segment_->doneFlags()[w] != 0;
+    result->totalLoss += segment_->losses()[w];
+  }
+
+  JPP_RETURN_IF_ERROR(barrier());
+
+  std::copy(merged.begin(), merged.begin() + numWeights, weights.begin());
+  std::copy(merged.begin() + numWeights, merged.end(), diagonal.begin());
+  return Status::Ok();
+}
+
+void ScwAverager::abort() {
+  segment_->header()->failed.store(1, std::memory_order_relaxed);
+}
+
+Status spawnTrainingWorkers(u32 numWorkers, u32* workerIdx,
+                            std::vector<i64>* children) {
+  *workerIdx = 0;
+  children->clear();
+#if defined(_WIN32_WINNT)
+  if (numWorkers > 1) {
+    return JPPS_NOT_IMPLEMENTED
+           << "multi-process training is not supported on Windows";
+  }
+#else
+  // buffered output would be duplicated in children otherwise
+  std::cout.flush();
+  std::cerr.flush();
+  std::fflush(nullptr);
+  for (u32 i = 1; i < numWorkers; ++i) {
+    pid_t pid = ::fork();
+    if (pid < 0) {
+      return JPPS_INVALID_STATE << "failed to fork training worker #" << i
+                                << ": " << std::strerror(errno);
+    }
+    if (pid == 0) {
+      *workerIdx = i;
+      children->clear();
+      return Status::Ok();
+    }
+    children->push_back(pid);
+  }
+#endif
+  return Status::Ok();
+}
+
+Status waitTrainingWorkers(const std::vector<i64>& children) {
+#if !defined(_WIN32_WINNT)
+  i32 failed = 0;
+  for (auto child : children) {
+    int status = 0;
+    if (::waitpid(static_cast<pid_t>(child), &status, 0) < 0) {
+      failed += 1;
+      continue;
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      LOG_ERROR() << "training worker with pid " << child
+                  << " has failed, status=" << status;
+      failed += 1;
+    }
+  }
+  if (failed != 0) {
+    return JPPS_INVALID_STATE << failed << " training workers have failed";
+  }
+#endif
+  return Status::Ok();
+}
+
+}  // namespace training
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,111 @@
+#ifndef JUMANPP_SCW_AVERAGER_H
+#define JUMANPP_SCW_AVERAGER_H
+
+#include <atomic>
+#include <vector>
+#include "core/training/scw.h"
+#include "util/status.hpp"
+
+namespace jumanpp {
+namespace core {
+namespace training {
+
+struct ScwSharedHeader;
+
+/**
+ * Memory segment which is shared between training workers.
+ * It must be created before worker processes are forked.
+ *
+ * Every worker has a slot for its weights and matrix diagonal,
+ * the averaged values are stored in a separate result area.
+ */
+class ScwSharedSegment {
+  void* base_ = nullptr;
+  size_t size_ = 0;
+  u32 numWorkers_ = 0;
+  u64 numWeights_ = 0;
+
+ public:
+  ScwSharedSegment() = default;
+  ScwSharedSegment(const ScwSharedSegment&) = delete;
+  ~ScwSharedSegment();
+
+  Status initialize(u32 numWorkers, u64 numWeights);
+
+  u32 numWorkers() const { return numWorkers_; }
+  u64 numWeights() const { return numWeights_; }
+
+  ScwSharedHeader* header() const;
+  u32* doneFlags() const;
+  double* losses() const;
+  util::MutableArraySlice<float> slot(u32 worker) const;
+  util::MutableArraySlice<float> result() const;
+};
+
+struct ScwMergeResult {
+  bool allDone;
+  double totalLoss;
+};
+
+/**
+ * Data-parallel SCW training: each worker trains on its own shard
+ * of the corpus and periodically replaces its weights and
+ * matrix diagonal with the average over all workers.
+ *
+ * Merges are synchronous. All workers must perform the same number
+ * of merges, so workers which have finished an epoch keep merging
+ * until every worker has finished it as well.
+ * The sum is always computed in the worker order,
+ * so every worker gets bit-identical values.
+ */
+class ScwAverager {
+  ScwSharedSegment* segment_;
+  u32 worker_;
+  std::vector<i64> children_;
+
+  Status checkProcesses() const;
+  Status barrier();
+
+ public:
+  ScwAverager(ScwSharedSegment* segment, u32 worker)
+      : segment_{segment}, worker_{worker} {}
+
+  u32 worker() const { return worker_; }
+  u32 numWorkers() const { return segment_->numWorkers(); }
+
+  Status merge(SoftConfidenceWeighted* scw, bool done, double loss,
+               ScwMergeResult* result);
+
+  /**
+   * Worker processes forked by spawnTrainingWorkers.
+   * A merge fails instead of waiting forever when any of them
+   * (or the parent of a forked worker) has exited.
+   */
+  void watchChildren(const std::vector<i64>& children) {
+    children_ = children;
+  }
+
+  /**
+   * Notifies other workers that this one has failed,
+   * so they do not wait for it forever.
+   */
+  void abort();
+};
+
+/**
+ * Forks numWorkers - 1 child processes.
+ * Worker index is 0 for the calling process.
+ */
+Status spawnTrainingWorkers(u32 numWorkers, u32* workerIdx,
+                            std::vector<i64>* children);
+
+/**
+ * Waits for forked workers, returns error if any of them has failed.
+ */
+Status waitTrainingWorkers(const std::vector<i64>& children);
+
+}  // namespace training
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_SCW_AVERAGER_H
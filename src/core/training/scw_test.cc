@@ -0,0 +1,100 @@
+#include "scw.h"
+#include "testing/standalone_test.h"
+
+using namespace jumanpp;
+using namespace jumanpp::core;
+using namespace jumanpp::core::training;
+
+namespace {
+TrainingConfig configOfSize(u32 exponent) {
+  TrainingConfig tc;
+  tc.featureNumberExponent = exponent;
+  return tc;
+}
+
+void fillState(SoftConfidenceWeighted* scw) {
+  auto w = scw->weights();
+  auto d = scw->diagonal();
+  for (size_t i = 0; i < w.size(); ++i) {
+    w[i] = 0.1f * i;
+    d[i] = 1.0f / (i + 1);
+  }
+}
+}  // namespace
+
+TEST_CASE("scw can be warm-started from a trained model") {
+  SoftConfidenceWeighted original{configOfSize(4)};
+  fillState(&original);
+  model::ModelInfo info;
+  original.exportModel(&info);
+
+  SoftConfidenceWeighted warm{configOfSize(4)};
+  CHECK_FALSE(warm.warmStarted());
+  REQUIRE_OK(warm.warmStart(info));
+  CHECK(warm.warmStarted());
+  for (size_t i = 0; i < warm.numWeights(); ++i) {
+    CHECK(warm.weights()[i] == original.weights()[i]);
+    CHECK(warm.diagonal()[i] == 1.0f);
+  }
+}
+
+TEST_CASE("scw warm start restores the diagonal from the stored state") {
+  SoftConfidenceWeighted original{configOfSize(4)};
+  fillState(&original);
+  model::ModelInfo info;
+  original.exportModel(&info);
+  original.exportState(&info);
+  // exporting again does not duplicate parts
+  original.exportModel(&info);
+  original.exportState(&info);
+  CHECK(info.parts.size() == 2);
+
+  SoftConfidenceWeighted warm{configOfSize(4)};
+  REQUIRE_OK(warm.warmStart(info));
+  for (size_t i = 0; i < warm.numWeights(); ++i) {
+    CHECK(warm.weights()[i] == original.weights()[i]);
+    CHECK(warm.diagonal()[i] == original.diagonal()[i]);
+  }
+}
+
+TEST_CASE("scw warm start expands a smaller table") {
+  SoftConfidenceWeighted original{configOfSize(3)};
+  fillState(&original);
+  model::ModelInfo info;
+  original.exportState(&info);
+
+  SoftConfidenceWeighted warm{configOfSize(5)};
+  REQUIRE_OK(warm.warmStart(info));
+  for (size_t i = 0; i < warm.numWeights(); ++i) {
+    CHECK(warm.weights()[i] == original.weights()[i & 7]);
+    CHECK(warm.diagonal()[i] == original.diagonal()[i & 7]);
+  }
+}
+
+TEST_CASE("scw warm start fails on a larger table or an untrained model") {
+  SoftConfidenceWeighted original{configOfSize(5)};
+  model::ModelInfo info;
+  original.exportModel(&info);
+
+  SoftConfidenceWeighted warm{configOfSize(4)};
+  CHECK_FALSE(warm.warmStart(info));
+  model::ModelInfo empty;
+  CHECK_FALSE(warm.warmStart(empty));
+}
+
+TEST_CASE("scw warm start ignores the state of a different table") {
+  SoftConfidenceWeighted large{configOfSize(4)};
+  fillState(&large);
+  SoftConfidenceWeighted small{configOfSize(3)};
+  fillState(&small);
+  model::ModelInfo info;
+  small.exportModel(&info);
+  large.exportState(&info);
+
+  SoftConfidenceWeighted warm{configOfSize(4)};
+  REQUIRE_OK(warm.warmStart(info));
+  for (size_t i = 0; i < warm.numWeights(); ++i) {
+    CHECK(warm.weights()[i] == small.weights()[i & 7]);
+    CHECK(warm.diagonal()[i] == 1.0f);
+  }
+}
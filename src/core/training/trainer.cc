@@ -44,9 +44,20 @@ Status Trainer::prepare() {
   JPP_RETURN_IF_ERROR(analyzer->buildLattice());
   JPP_RETURN_IF_ERROR(analyzer->bootstrapAnalysis());
   JPP_RETURN_IF_ERROR(loss_.resolveGold());
+  prepared_ = true;
   return Status::Ok();
 }
 
+Status Trainer::reusePrepared() {
+  // global beam could have been changed after the lattice was scored,
+  // the lattice and the gold path stay valid
+  analyzer->lattice()->resetGlobalBeams();
+  if (!analyzer->isBootstrapped()) {
+    return analyzer->bootstrapAnalysis();
+  }
+  return analyzer->resetScoringState();
+}
+
 void Trainer::computeTrainingLoss() {
   i32 usedSteps = -1;
   switch (config_.mode) {
@@ -87,12 +98,17 @@ Status TrainerBatch::initialize(const TrainerFullConfig &tfc,
     trainers_.emplace_back(std::move(trainer));
   }
   seed_ = tfc.trainingConfig->randomSeed;
+  cacheLattices_ = tfc.trainingConfig->cacheLattices;
+  batchSize_ = numTrainers;
   config_ = tfc;
   scorerDef_ = sconf;
   return Status::Ok();
 }
 
 Status TrainerBatch::readFullBatch(FullExampleReader *rdr) {
+  if (cacheLattices_) {
+    return readCachedBatch(rdr);
+  }
   indices_.clear();
   current_ = 0;
   int trIdx = 0;
@@ -109,6 +125,110 @@ Status TrainerBatch::readFullBatch(FullExampleReader *rdr) {
   return Status::Ok();
 }
 
+bool TrainerBatch::cacheOverLimit() {
+  auto limit = config_.trainingConfig->latticeCacheLimit;
+  if (limit == 0) {
+    return false;
+  }
+  // examples of the previous batch were prepared by now
+  for (i32 i = 0; i < current_; ++i) {
+    cachedBytes_ += trainers_[batchStart_ + i]->allocatedMemory();
+  }
+  if (cachedBytes_ <= limit) {
+    return false;
+  }
+
+  LOG_WARN() << "lattices of " << batchStart_ + current_ << " examples use "
+             << cachedBytes_ << " bytes, more than the limit of " << limit
+             << ", lattices will not be cached";
+  cacheLattices_ = false;
+  if (trainers_.size() > batchSize_) {
+    trainers_.resize(batchSize_);
+  }
+  batchStart_ = 0;
+  current_ = 0;
+  numCached_ = 0;
+  cachedBytes_ = 0;
+  return true;
+}
+
+Status TrainerBatch::readCachedBatch(FullExampleReader *rdr) {
+  indices_.clear();
+  if (!cacheFilled_ && cacheOverLimit()) {
+    return readFullBatch(rdr);
+  }
+  batchStart_ += current_;
+  current_ = 0;
+  if (cacheFilled_) {
+    current_ = std::min(batchSize_, numCached_ - batchStart_);
+    return Status::Ok();
+  }
+
+  for (int i = 0; i < batchSize_; ++i) {
+    size_t trIdx = batchStart_ + i;
+    if (trIdx >= trainers_.size()) {
+      auto trainer =
+          std::unique_ptr<OwningFullTrainer>(new OwningFullTrainer{config_});
+      JPP_RETURN_IF_ERROR(trainer->initAnalyzer(scorerDef_));
+      trainers_.emplace_back(std::move(trainer));
+    }
+    auto &tr = trainers_[trIdx];
+    tr->reset();
+    JPP_RETURN_IF_ERROR(tr->readExample(rdr));
+    if (rdr->finished()) {
+      inputRead_ = true;
+      break;
+    }
+    current_ += 1;
+  }
+  numCached_ = batchStart_ + current_;
+
+  return Status::Ok();
+}
+
+void TrainerBatch::swapFullTrainers(
+    std::vector<std::unique_ptr<OwningFullTrainer>> *trainers, i32 numActive) {
+  JPP_DCHECK(!cacheLattices_);
+  JPP_DCHECK_LE(numActive, trainers->size());
+  trainers_.swap(*trainers);
+  indices_.clear();
+  batchStart_ = 0;
+  current_ = numActive;
+}
+
+bool TrainerBatch::inputFinished(const FullExampleReader &rdr) const {
+  if (cacheFilled_) {
+    return batchStart_ + current_ >= numCached_;
+  }
+  return rdr.finished();
+}
+
+void TrainerBatch::rewindCache() {
+  if (cacheLattices_ && inputRead_) {
+    cacheFilled_ = true;
+  } else {
+    // the first pass did not finish, examples will be read once again
+    numCached_ = 0;
+  }
+  batchStart_ = 0;
+  current_ = 0;
+}
+
+void TrainerBatch::dropCache() {
+  if (trainers_.size() > batchSize_) {
+    trainers_.resize(batchSize_);
+  }
+  // a new input is cached again even if the previous one did not fit
+  cacheLattices_ = config_.trainingConfig != nullptr &&
+                   config_.trainingConfig->cacheLattices;
+  cachedBytes_ = 0;
+  cacheFilled_ = false;
+  inputRead_ = false;
+  batchStart_ = 0;
+  current_ = 0;
+  numCached_ = 0;
+}
+
 void TrainerBatch::shuffleData(bool usePartial) {
   if (usePartial) {
     totalTrainers_ = activeFullTrainers() + partialTrainerts_.size();
@@ -160,7 +280,7 @@ ITrainer *TrainerBatch::trainer(i32 idx) const {
   auto idx2 = indices_[idx];
   if (idx2 >= 0) {
     JPP_DCHECK_IN(idx2, 0, activeFullTrainers());
-    return trainers_[idx2].get();
+    return trainers_[batchStart_ + idx2].get();
   } else {
     auto idx3 = ~idx2;
     JPP_DCHECK_IN(idx3, 0, partialTrainerts_.size());
@@ -169,9 +289,8 @@ ITrainer *TrainerBatch::trainer(i32 idx) const {
 }
 
 void OwningFullTrainer::setGlobalBeam(const GlobalBeamTrainConfig &cfg) {
-  if (analyzer_.setGlobalBeam(cfg.leftBeam, cfg.rightCheck, cfg.rightBeam)) {
-    trainer_.resetState();
-  }
+  // a cached lattice is scored with the new config by prepare()
+  analyzer_.setGlobalBeam(cfg.leftBeam, cfg.rightCheck, cfg.rightBeam);
 }
 }  // namespace training
 }  // namespace core
@@ -24,6 +24,7 @@ class Trainer {
   TrainingConfig config_;
   float currentLoss_;
   bool addedGoldNodes_;
+  bool prepared_ = false;
 
  public:
   Trainer(analysis::AnalyzerImpl* analyzer, const spec::TrainingSpec* spec,
@@ -43,6 +44,7 @@ class Trainer {
     loss_.goldPath().reset();
     adapter_.reset();
     addedGoldNodes_ = false;
+    prepared_ = false;
   }
 
   FullyAnnotatedExample& example() { return example_; }
@@ -50,6 +52,14 @@ class Trainer {
 
   Status prepare();
 
+  /**
+   * Lattice and gold path of the example were already built by prepare()
+   * and can be scored again.
+   */
+  bool isPrepared() const { return prepared_; }
+
+  Status reusePrepared();
+
   Status compute(const analysis::ScorerDef* sconf);
 
   void computeTrainingLoss();
@@ -62,6 +72,7 @@ class Trainer {
 
   GoldenPath& goldenPath() { return loss_.goldPath(); }
   const GoldenPath& goldenPath() const { return loss_.goldPath(); }
+  const LossCalculator& lossCalculator() const { return loss_; }
 
   bool wasGoldAdded() const { return addedGoldNodes_; }
 };
@@ -69,12 +80,14 @@ class Trainer {
 class OwningFullTrainer final : public ITrainer {
   analysis::AnalyzerImpl analyzer_;
   Trainer trainer_;
+  bool cacheLattice_;
 
  public:
   explicit OwningFullTrainer(const TrainerFullConfig& conf)
       : analyzer_{conf.core, ScoringConfig{conf.trainingConfig->beamSize, 1},
                   *conf.analyzerConfig},
-        trainer_{&analyzer_, conf.trainingSpec, *conf.trainingConfig} {}
+        trainer_{&analyzer_, conf.trainingSpec, *conf.trainingConfig},
+        cacheLattice_{conf.trainingConfig->cacheLattices} {}
 
   void reset() { trainer_.reset(); }
 
@@ -83,13 +96,15 @@ class OwningFullTrainer final : public ITrainer {
   }
 
   Status readExample(FullExampleReader* rdr) {
-    auto num = rdr->lineNumber();
     Status s = rdr->readFullExample(&trainer_.example());
-    trainer_.example().setInfo(rdr->filename(), num);
+    trainer_.example().setInfo(rdr->filename(), rdr->exampleLineNumber());
     return s;
   }
 
   Status prepare() override {
+    if (cacheLattice_ && trainer_.isPrepared()) {
+      return trainer_.reusePrepared();
+    }
     trainer_.resetState();
     return trainer_.prepare();
   }
@@ -127,17 +142,34 @@ class OwningFullTrainer final : public ITrainer {
 
   const Trainer& trainer() const { return trainer_; }
 
+  u64 allocatedMemory() const { return analyzer_.allocatedMemory(); }
+
   void setGlobalBeam(const GlobalBeamTrainConfig& cfg) override;
 };
 
 class TrainerBatch {
-  TrainerFullConfig config_;
+  TrainerFullConfig config_{};
   const analysis::ScorerDef* scorerDef_;
   std::vector<std::unique_ptr<OwningFullTrainer>> trainers_;
   std::vector<std::unique_ptr<OwningPartialTrainer>> partialTrainerts_;
   std::vector<i32> indices_;
-  i32 current_;
+  i32 current_ = 0;
   i32 totalTrainers_;
+  i32 batchSize_ = 0;
+  // lattice cache: trainers_ keep all examples of the input,
+  // current batch is [batchStart_, batchStart_ + current_)
+  bool cacheLattices_ = false;
+  bool cacheFilled_ = false;
+  bool inputRead_ = false;
+  i32 batchStart_ = 0;
+  i32 numCached_ = 0;
+  // memory of cached examples before the current batch
+  u64 cachedBytes_ = 0;
+
+  Status readCachedBatch(FullExampleReader* rdr);
+  // stops caching when the cache uses too much memory,
+  // examples are read into the shared trainers from then on
+  bool cacheOverLimit();
   u32 seed_ = 0xdeadbeef;
   i32 numShuffles_ = 0;
 
@@ -146,13 +178,36 @@ class TrainerBatch {
                     const analysis::ScorerDef* sconf, i32 numTrainers);
 
   Status readFullBatch(FullExampleReader* rdr);
+
+  /**
+   * With lattice caching, all examples are read from the reader
+   * during the first epoch and are served from the cache afterwards.
+   * If the cache grows over TrainingConfig::latticeCacheLimit
+   * during the first epoch, caching is disabled for this input.
+   */
+  bool inputFinished(const FullExampleReader& rdr) const;
+  void rewindCache();
+  void dropCache();
+  i32 cachedExamples() const { return cacheFilled_ ? numCached_ : 0; }
   Status readPartialExamples(input::PartialExampleReader* reader);
 
   void cleanParital() { partialTrainerts_.clear(); }
 
+  /**
+   * Replaces full example trainers with the given ones,
+   * first numActive of them contain examples of the new batch.
+   */
+  void swapFullTrainers(
+      std::vector<std::unique_ptr<OwningFullTrainer>>* trainers,
+      i32 numActive);
+
   void shuffleData(bool usePartial);
 
   ITrainer* trainer(i32 idx) const;
+  OwningFullTrainer* fullTrainer(i32 idx) const {
+    JPP_DCHECK_IN(idx, 0, activeFullTrainers());
+    return trainers_[batchStart_ + idx].get();
+  }
 
   i32 activeFullTrainers() const { return current_; }
   i32 totalTrainers() const {
@@ -3,6 +3,9 @@
 //
 
 #include "training_env.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
 #include "core/env.h"
 #include "util/debug_output.h"
 #include "util/logging.hpp"
@@ -12,10 +15,33 @@ namespace core {
 namespace training {
 
 Status TrainingEnv::trainOneEpoch() {
+  Status s = trainEpochImpl();
+  if (!s && averager_ != nullptr) {
+    averager_->abort();
+  }
+  return s;
+}
+
+Status TrainingEnv::mergeWeights(bool epochDone, double* loss) {
+  ScwMergeResult merged;
+  do {
+    JPP_RETURN_IF_ERROR(averager_->merge(&scw_, epochDone, *loss, &merged));
+  } while (epochDone && !merged.allDone);
+  if (epochDone) {
+    *loss = merged.totalLoss;
+  }
+  return Status::Ok();
+}
+
+Status TrainingEnv::trainEpochImpl() {
   double lastLoss = 0.f;
   double lossSum = 0.0f;
   i32 firstTrainer = 0;
-  while (!fullReader_.finished()) {
+  u32 numBatches = 0;
+  if (loader_.isInitialized() && !trainers_.inputFinished(fullReader_)) {
+    JPP_RETURN_IF_ERROR(loader_.start(&fullReader_));
+  }
+  while (!inputFinished()) {
     JPP_RETURN_IF_ERROR(readOneBatch());
     prepareTrainers();
     if (trainers_.totalTrainers() <= 0) {
@@ -36,21 +62,140 @@ Status TrainingEnv::trainOneEpoch() {
     }
     lossSum += lastLoss;
     firstTrainer += trainers_.totalTrainers();
+    numBatches += 1;
+    if (averager_ != nullptr && args_.mergeInterval > 0 &&
+        numBatches % args_.mergeInterval == 0) {
+      JPP_RETURN_IF_ERROR(mergeWeights(false, &lossSum));
+    }
   }
+  loader_.stop();
 
-  if (firstEpoch_) {
+  if (averager_ != nullptr) {
+    // workers with shorter shards keep merging until everybody finishes
+    JPP_RETURN_IF_ERROR(mergeWeights(true, &lossSum));
+  }
+
+  // warm-started weights were not initialized randomly
+  if (firstEpoch_ && !scw_.warmStarted()) {
     auto zeroed = scw_.substractInitValues();
     auto total = scw_.numWeights();
     auto ratio = float(zeroed) / total;
     LOG_DEBUG() << "Zeroed " << zeroed << " features of " << total << " ("
                 << ratio * 100 << "%)";
-    firstEpoch_ = false;
   }
+  firstEpoch_ = false;
 
   totalLoss_ = lossSum;
   return Status::Ok();
 }
 
+namespace {
+
+// Compares the top path of a plain analysis with the gold path
+// in the same way as LossCalculator does for training.
+float topPathLoss(const analysis::Lattice* top, const analysis::Lattice* gold,
+                  const GoldenPath& goldPath, const spec::TrainingSpec& spec) {
+  std::vector<const analysis::ConnectionPtr*> topPath;
+  auto eos = top->boundary(top->createdBoundaryCount() - 1);
+  auto ptr = eos->starts()->beamData().at(0).ptr.previous;
+  for (; ptr != nullptr && ptr->boundary >= 2; ptr = ptr->previous) {
+    topPath.push_back(ptr);
+  }
+  std::reverse(topPath.begin(), topPath.end());
+
+  float fullWeight = 0;
+  for (auto& f : spec.fields) {
+    fullWeight += f.weight;
+  }
+
+  auto goldNodes = goldPath.nodes();
+  size_t topIdx = 0;
+  size_t goldIdx = 0;
+  float loss = 0;
+  // EOS always matches
+  i32 steps = 1;
+  while (topIdx < topPath.size() || goldIdx < goldNodes.size()) {
+    steps += 1;
+    auto topBnd = topIdx < topPath.size() ? topPath[topIdx]->boundary
+                                          : std::numeric_limits<u16>::max();
+    auto goldBnd = goldIdx < goldNodes.size()
+                       ? goldNodes[goldIdx].boundary
+                       : std::numeric_limits<u16>::max();
+    if (topBnd != goldBnd) {
+      loss += fullWeight;
+      if (topBnd < goldBnd) {
+        topIdx += 1;
+      } else {
+        goldIdx += 1;
+      }
+      continue;
+    }
+    auto topNode = topPath[topIdx];
+    auto goldNode = goldNodes[goldIdx];
+    auto topData =
+        top->boundary(topBnd)->starts()->entryData().row(topNode->right);
+    auto goldData =
+        gold->boundary(goldBnd)->starts()->entryData().row(goldNode.position);
+    for (auto& f : spec.fields) {
+      if (topData[f.fieldIdx] != goldData[f.fieldIdx]) {
+        loss += f.weight;
+      }
+    }
+    topIdx += 1;
+    goldIdx += 1;
+  }
+  return loss / (steps * fullWeight);
+}
+
+}  // namespace
+
+Status TrainingEnv::evaluate(const analysis::ScorerDef* sconf,
+                             EvaluationResult* result,
+                             const EvaluationCallback& callback) {
+  // gold nodes are added to lattices of trainers,
+  // so the input is analyzed with a separate analyzer
+  analysis::Analyzer plain;
+  ScoringConfig scoring{args_.trainingConfig.beamSize, sconf->numScorers()};
+  JPP_RETURN_IF_ERROR(
+      plain.initialize(env_->coreHolder(), aconf_, scoring, sconf));
+  auto& spec = env_->spec().training;
+
+  resetInput();
+  *result = EvaluationResult{};
+  while (!trainers_.inputFinished(fullReader_)) {
+    JPP_RETURN_IF_ERROR(trainers_.readFullBatch(&fullReader_));
+    for (i32 i = 0; i < trainers_.activeFullTrainers(); ++i) {
+      auto trainer = trainers_.fullTrainer(i);
+      // gold path is resolved in the lattice of the trainer
+      Status s = trainer->prepare();
+      if (s && callback) {
+        s = trainer->compute(sconf);
+      }
+      JPP_RIE_MSG(std::move(s), "failed to process example on line #"
+                                    << trainer->exampleInfo().line);
+
+      auto start = std::chrono::steady_clock::now();
+      Status analyzed = plain.analyze(trainer->trainer().example().surface());
+      auto end = std::chrono::steady_clock::now();
+      result->seconds += std::chrono::duration<double>(end - start).count();
+
+      float loss = 1;
+      if (analyzed) {
+        loss = topPathLoss(plain.impl()->lattice(), trainer->lattice(),
+                           trainer->trainer().goldenPath(), spec);
+      }
+      result->numSentences += 1;
+      result->exactSentences += loss == 0;
+      result->totalLoss += loss;
+      if (callback) {
+        callback(*trainer);
+      }
+    }
+  }
+  resetInput();
+  return Status::Ok();
+}
+
 Status TrainingEnv::trainOneBatch(i32 iterNum) {
   double curLoss = 0;
 
@@ -116,13 +261,25 @@ Status TrainingEnv::loadInput(StringPiece fileName) {
   return Status::Ok();
 }
 
+void TrainingEnv::setAverager(ScwAverager* averager) {
+  averager_ = averager;
+  if (averager != nullptr) {
+    fullReader_.setShard(averager->worker(), averager->numWorkers());
+  } else {
+    fullReader_.setShard(0, 1);
+  }
+}
+
 void TrainingEnv::resetInput() {
+  loader_.stop();
   fullReader_.resetInput(currentFile_.contents());
+  trainers_.rewindCache();
   batchLoss_ = 0;
   totalLoss_ = 0;
 }
 
 Status TrainingEnv::loadInputData(StringPiece data) {
+  loader_.stop();
   auto format = this->args_.trainingConfig.inputFormat;
   if (format == InputFormat::Csv) {
     JPP_RETURN_IF_ERROR(fullReader_.initCsv(data));
@@ -131,6 +288,7 @@ Status TrainingEnv::loadInputData(StringPiece data) {
   } else {
     return Status::InvalidState() << "unsupported input format";
   }
+  trainers_.dropCache();
   fullReader_.setFilename("<memory>");
 
   return Status::Ok();
@@ -155,8 +313,17 @@ Status TrainingEnv::initOther() {
                                          &args_.trainingConfig};
   auto sconf = scw_.scorers();
   JPP_RETURN_IF_ERROR(trainers_.initialize(conf, sconf, args_.batchSize));
+  // cached lattices are read only once, so there is nothing to prefetch
+  if (args_.prefetchBatches > 0 && !args_.trainingConfig.cacheLattices) {
+    JPP_RETURN_IF_ERROR(loader_.initialize(conf, sconf, args_.batchSize,
+                                           args_.prefetchBatches));
+  }
   JPP_RETURN_IF_ERROR(executor_.initialize(sconf, args_.numThreads));
   JPP_RETURN_IF_ERROR(args_.globalBeam.validate());
+  if (args_.warmStart) {
+    JPP_RIE_MSG(scw_.warmStart(env_->modelInfoCopy()),
+                "failed to warm-start from the input model");
+  }
   return Status::Ok();
 }
 
@@ -176,6 +343,9 @@ std::unique_ptr<analysis::Analyzer> TrainingEnv::makeAnalyzer(
 void TrainingEnv::exportScwParams(model::ModelInfo* pInfo,
                                   StringPiece comment) {
   scw_.exportModel(pInfo, comment);
+  if (args_.storeScwState) {
+    scw_.exportState(pInfo);
+  }
 }
 
 void TrainingEnv::warnOnNonMatchingFeatures(const spec::AnalysisSpec& spec) {
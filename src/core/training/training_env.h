@@ -7,7 +7,9 @@
 
 #include "core/analysis/rnn_scorer.h"
 #include "core/input/partial_example_io.h"
+#include "core/training/batch_loader.h"
 #include "core/training/scw.h"
+#include "core/training/scw_averager.h"
 #include "core/training/trainer.h"
 #include "core/training/training_executor.h"
 
@@ -39,6 +41,16 @@ struct TrainingArguments {
   u32 numThreads = 1;
   u32 batchMaxIterations = 1;
   u32 maxEpochs = 1;
+  // number of batches to read in background, 0 disables prefetching
+  u32 prefetchBatches = 1;
+  // data-parallel training: number of worker processes
+  u32 numWorkers = 1;
+  // merge weights of workers every N batches, 0 merges only at epoch end
+  u32 mergeInterval = 0;
+  // continue training from weights (and SCW state) of the input model
+  bool warmStart = false;
+  // store SCW state in the output model for later warm starts
+  bool storeScwState = false;
   float batchLossEpsilon = 1e-3f;
   std::string modelFilename;
   std::string outputFilename;
@@ -51,8 +63,29 @@ struct TrainingArguments {
   core::analysis::rnn::RnnInferenceConfig rnnConfig;
   GlobalBeamParams globalBeam;
   std::string comment;
+  // generated features for the model spec, dynamic ones are used if null
+  const features::StaticFeatureFactory* staticFeatures = nullptr;
 };
 
+struct EvaluationResult {
+  i64 numSentences = 0;
+  i64 exactSentences = 0;
+  double totalLoss = 0;
+  // time spent on scoring lattices
+  double seconds = 0;
+
+  double sentenceAccuracy() const {
+    return numSentences == 0 ? 0 : double(exactSentences) / numSentences;
+  }
+
+  // loss is the weighted ratio of mismatched fields of the top path
+  double fieldAccuracy() const {
+    return numSentences == 0 ? 0 : 1.0 - totalLoss / numSentences;
+  }
+};
+
+using EvaluationCallback = std::function<void(const OwningFullTrainer&)>;
+
 class TrainingEnv {
   const TrainingArguments& args_;
   core::JumanppEnv* env_;
@@ -61,6 +94,7 @@ class TrainingEnv {
   FullExampleReader fullReader_;
   input::PartialExampleReader partReader_;
   TrainerBatch trainers_;
+  PrefetchingBatchLoader loader_;
   SoftConfidenceWeighted scw_;
   TrainingExecutor executor_;
 
@@ -72,6 +106,10 @@ class TrainingEnv {
   bool firstEpoch_ = true;
 
   GlobalBeamTrainConfig globalBeamCfg_;
+  ScwAverager* averager_ = nullptr;
+
+  Status trainEpochImpl();
+  Status mergeWeights(bool epochDone, double* loss);
 
  public:
   TrainingEnv(const TrainingArguments& args, JumanppEnv* env)
@@ -92,7 +130,24 @@ class TrainingEnv {
   Status loadInput(StringPiece fileName);
   void resetInput();
 
-  Status readOneBatch() { return trainers_.readFullBatch(&fullReader_); }
+  /**
+   * Makes this environment a worker of data-parallel training.
+   * It will use only its shard of the input and will merge
+   * weights with other workers.
+   * Epoch loss is the sum over all workers.
+   */
+  void setAverager(ScwAverager* averager);
+
+  Status readOneBatch() {
+    if (!loader_.finished()) {
+      return loader_.nextBatch(&trainers_);
+    }
+    return trainers_.readFullBatch(&fullReader_);
+  }
+
+  bool inputFinished() const {
+    return loader_.finished() && trainers_.inputFinished(fullReader_);
+  }
 
   void prepareTrainers() { trainers_.shuffleData(!firstEpoch_); }
 
@@ -106,7 +161,21 @@ class TrainingEnv {
 
   Status trainOneEpoch();
 
+  /**
+   * Analyzes the whole input with the given scorers
+   * and compares the results with the gold data.
+   * Sentences are analyzed without gold nodes, as in the real use.
+   * Weights are not updated.
+   * Callback is called for each processed example, with the example
+   * scored in the lattice of the trainer where gold nodes are present.
+   */
+  Status evaluate(const analysis::ScorerDef* sconf, EvaluationResult* result,
+                  const EvaluationCallback& callback = {});
+
+  const SoftConfidenceWeighted& scw() const { return scw_; }
+
   i32 numTrainers() const { return trainers_.totalTrainers(); }
+  i32 cachedExamples() const { return trainers_.cachedExamples(); }
   ITrainer* trainer(i32 idx) { return trainers_.trainer(idx); }
 
   std::unique_ptr<analysis::Analyzer> makeAnalyzer(i32 beamSize = -1) const;
@@ -39,6 +39,10 @@ struct TrainingConfig {
   ScwConfig scw;
   u32 randomSeed = 0xdeadbeef;
   i32 beamSize = 1;
+  // keep built lattices of all examples between epochs
+  bool cacheLattices = false;
+  // lattices are not cached when they need more memory (bytes), 0 is no limit
+  u64 latticeCacheLimit = u64{4} << 30;
 
   u32 numFeatures() const {
     JPP_DCHECK_LT(featureNumberExponent, 31);
@@ -0,0 +1,171 @@
+#include "weight_pruning.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "core/impl/perceptron_io.h"
+#include "util/memory.hpp"
+#include "util/serialization.h"
+
+namespace jumanpp {
+namespace core {
+namespace training {
+
+namespace {
+
+u32 exponentOf(size_t size) {
+  u32 exp = 0;
+  while ((size_t{1} << exp) < size) {
+    exp += 1;
+  }
+  return exp;
+}
+
+u64 countNonzero(util::ArraySlice<float> weights) {
+  u64 result = 0;
+  for (auto w : weights) {
+    result += w != 0;
+  }
+  return result;
+}
+
+}  // namespace
+
+WeightPruner::WeightPruner(util::ArraySlice<float> weights)
+    : weights_{weights.begin(), weights.end()} {}
+
+float WeightPruner::thresholdForRatio(float ratio) const {
+  std::vector<float> magnitudes;
+  for (auto w : weights_) {
+    if (w != 0) {
+      magnitudes.push_back(std::abs(w));
+    }
+  }
+  auto toPrune = static_cast<size_t>(ratio * magnitudes.size());
+  if (toPrune == 0) {
+    return 0;
+  }
+  if (toPrune >= magnitudes.size()) {
+    return std::numeric_limits<float>::infinity();
+  }
+  std::nth_element(magnitudes.begin(), magnitudes.begin() + toPrune,
+                   magnitudes.end());
+  return magnitudes[toPrune];
+}
+
+u64 WeightPruner::countCollisions(u32 exponent) const {
+  u32 mask = (u32{1} << exponent) - 1;
+  std::vector<u8> counts(size_t{1} << exponent, 0);
+  for (u32 i = 0; i < weights_.size(); ++i) {
+    if (weights_[i] != 0) {
+      auto& cnt = counts[i & mask];
+      cnt = std::min<u8>(cnt + 1, 2);
+    }
+  }
+  u64 result = 0;
+  for (u32 i = 0; i < weights_.size(); ++i) {
+    if (weights_[i] != 0 && counts[i & mask] > 1) {
+      result += 1;
+    }
+  }
+  return result;
+}
+
+u32 WeightPruner::selectExponent(float maxCollisionRatio) const {
+  auto maxExponent = exponentOf(weights_.size());
+  auto nonzero = countNonzero(weights_);
+  auto allowed = static_cast<u64>(maxCollisionRatio * nonzero);
+  // a table smaller than the number of weights always has collisions
+  auto exp = std::max<u32>(exponentOf(nonzero), 1);
+  for (; exp < maxExponent; ++exp) {
+    if (countCollisions(exp) <= allowed) {
+      break;
+    }
+  }
+  return std::min(exp, maxExponent);
+}
+
+Status WeightPruner::prune(const WeightPruningConfig& config) {
+  if (!util::memory::IsPowerOf2(weights_.size()) || weights_.empty()) {
+    return JPPS_INVALID_STATE << "weight table size must be a power of 2, was "
+                              << weights_.size();
+  }
+
+  stats_ = WeightPruningStats{};
+  stats_.originalSize = weights_.size();
+  stats_.nonzeroBefore = countNonzero(weights_);
+
+  float threshold = config.threshold;
+  if (config.pruneRatio > 0) {
+    threshold = thresholdForRatio(config.pruneRatio);
+  }
+  stats_.threshold = threshold;
+  for (auto& w : weights_) {
+    if (std::abs(w) < threshold) {
+      w = 0;
+    }
+  }
+  stats_.nonzeroAfter = countNonzero(weights_);
+
+  auto maxExponent = exponentOf(weights_.size());
+  u32 exponent;
+  if (config.targetExponent < 0) {
+    exponent = selectExponent(config.maxCollisionRatio);
+  } else if (config.targetExponent > maxExponent) {
+    return JPPS_INVALID_PARAMETER
+           << "target size exponent " << config.targetExponent
+           << " is larger than the current one: " << maxExponent;
+  } else {
+    exponent = static_cast<u32>(config.targetExponent);
+  }
+
+  stats_.collisions = countCollisions(exponent);
+
+  auto newSize = size_t{1} << exponent;
+  u32 mask = static_cast<u32>(newSize - 1);
+  std::vector<float> folded(newSize, 0.0f);
+  for (u32 i = 0; i < weights_.size(); ++i) {
+    folded[i & mask] += weights_[i];
+  }
+  weights_.swap(folded);
+  stats_.resultSize = newSize;
+  return Status::Ok();
+}
+
+void WeightPruner::exportModel(model::ModelInfo* model) {
+  auto& parts = model->parts;
+  std::string comment;
+  for (auto& p : parts) {
+    if (p.kind == model::ModelPartKind::Perceprton) {
+      comment = p.comment;
+    }
+  }
+  // SCW state is for the original table and can not be used with this one
+  parts.erase(std::remove_if(parts.begin(), parts.end(),
+                             [](const model::ModelPart& p) {
+                               return p.kind ==
+                                          model::ModelPartKind::Perceprton ||
+                                      p.kind == model::ModelPartKind::ScwDump;
+                             }),
+              parts.end());
+
+  header_.reset();
+  util::serialization::Saver svr{&header_};
+  PerceptronInfo pi;
+  pi.modelSizeExponent = exponentOf(weights_.size());
+  svr.save(pi);
+
+  model::ModelPart part;
+  part.kind = model::ModelPartKind::Perceprton;
+  part.comment = comment;
+  part.data.push_back(header_.contents());
+
+  auto charPtr = reinterpret_cast<const char*>(weights_.data());
+  StringPiece weightsMemory{charPtr, charPtr + weights_.size() * sizeof(float)};
+  part.data.push_back(weightsMemory);
+
+  parts.push_back(std::move(part));
+}
+
+}  // namespace training
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,75 @@
+#ifndef JUMANPP_WEIGHT_PRUNING_H
+#define JUMANPP_WEIGHT_PRUNING_H
+
+#include <vector>
+#include "core/impl/model_format.h"
+#include "util/array_slice.h"
+#include "util/coded_io.h"
+#include "util/status.hpp"
+
+namespace jumanpp {
+namespace core {
+namespace training {
+
+struct WeightPruningConfig {
+  // weights with absolute value lesser than this are zeroed
+  float threshold = 0;
+  // ratio of non-zero weights with smallest magnitudes to zero,
+  // is used instead of threshold if positive
+  float pruneRatio = 0;
+  // exponent of the compact table, -1 selects it automatically
+  i32 targetExponent = -1;
+  // automatic selection picks the smallest table where the ratio of
+  // non-zero weights which share a slot with other ones is not larger
+  float maxCollisionRatio = 0.01f;
+};
+
+struct WeightPruningStats {
+  u64 originalSize = 0;
+  u64 resultSize = 0;
+  u64 nonzeroBefore = 0;
+  u64 nonzeroAfter = 0;
+  u64 collisions = 0;
+  float threshold = 0;
+};
+
+/**
+ * Post-training compaction of the hashed perceptron weights.
+ *
+ * Features are hashed into the weight table with hash & (size - 1),
+ * so a table of 2^k weights can be folded into 2^j (j < k) weights:
+ * the weight of slot i goes to slot i & (2^j - 1).
+ * Zeroing small weights first leaves fewer non-zero weights and
+ * makes collisions on folding rarer. Weights are selected by magnitude
+ * only, how often features are used on a corpus is not measured.
+ * Colliding weights are added together.
+ */
+class WeightPruner {
+  std::vector<float> weights_;
+  WeightPruningStats stats_;
+  util::CodedBuffer header_;
+
+ public:
+  explicit WeightPruner(util::ArraySlice<float> weights);
+
+  Status prune(const WeightPruningConfig& config);
+
+  float thresholdForRatio(float ratio) const;
+  u64 countCollisions(u32 exponent) const;
+  u32 selectExponent(float maxCollisionRatio) const;
+
+  util::ArraySlice<float> weights() const { return weights_; }
+  const WeightPruningStats& stats() const { return stats_; }
+
+  /**
+   * Replaces the perceptron in the model with pruned weights.
+   * Model will reference memory of this object.
+   */
+  void exportModel(model::ModelInfo* model);
+};
+
+}  // namespace training
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_WEIGHT_PRUNING_H
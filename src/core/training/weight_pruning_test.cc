@@ -0,0 +1,94 @@
+#include "weight_pruning.h"
+#include "core/analysis/perceptron.h"
+#include "testing/standalone_test.h"
+
+using namespace jumanpp;
+using namespace jumanpp::core::training;
+
+TEST_CASE("pruning zeroes weights below the threshold") {
+  std::vector<float> weights{0.5f, -0.01f, 0.02f, -0.7f,
+                             0.0f, 0.03f,  -0.2f, 0.001f};
+  WeightPruner pruner{weights};
+  WeightPruningConfig conf;
+  conf.threshold = 0.1f;
+  conf.targetExponent = 3;
+  REQUIRE(pruner.prune(conf));
+  auto& stats = pruner.stats();
+  CHECK(stats.nonzeroBefore == 7);
+  CHECK(stats.nonzeroAfter == 3);
+  CHECK(stats.resultSize == 8);
+  CHECK(stats.collisions == 0);
+  std::vector<float> expected{0.5f, 0, 0, -0.7f, 0, 0, -0.2f, 0};
+  CHECK(std::vector<float>(pruner.weights().begin(), pruner.weights().end()) ==
+        expected);
+}
+
+TEST_CASE("pruning ratio selects a threshold") {
+  std::vector<float> weights{0.5f, -0.01f, 0.02f, -0.7f, 0, 0, 0, 0};
+  WeightPruner pruner{weights};
+  CHECK(pruner.thresholdForRatio(0.5f) == Approx(0.5f));
+  CHECK(pruner.thresholdForRatio(0) == 0);
+  WeightPruningConfig conf;
+  conf.pruneRatio = 0.5f;
+  conf.targetExponent = 3;
+  REQUIRE(pruner.prune(conf));
+  CHECK(pruner.stats().nonzeroAfter == 2);
+}
+
+TEST_CASE("folded table gives the same scores for non-colliding features") {
+  std::vector<float> weights(64, 0.0f);
+  weights[3] = 1.0f;
+  weights[17] = 2.0f;
+  weights[40] = -1.5f;
+  WeightPruner pruner{weights};
+  WeightPruningConfig conf;
+  REQUIRE(pruner.prune(conf));
+  CHECK(pruner.stats().collisions == 0);
+  CHECK(pruner.stats().resultSize == 4);
+  CHECK(pruner.selectExponent(0) == 2);
+
+  core::analysis::HashedFeaturePerceptron full{weights};
+  core::analysis::HashedFeaturePerceptron folded{pruner.weights()};
+  std::vector<u32> features{0xdead0003, 0xbeef0011, 0x12340028, 0x55550003};
+  util::ConstSliceable<u32> ngrams{features, 4, 1};
+  float r1 = 0;
+  float r2 = 0;
+  full.compute({&r1, 1}, ngrams);
+  folded.compute({&r2, 1}, ngrams);
+  CHECK(r1 == Approx(2.5f));
+  CHECK(r2 == Approx(r1));
+}
+
+TEST_CASE("colliding weights are added") {
+  std::vector<float> weights{1.0f, 0, 0.5f, 0, 2.0f, 0, 0, 0};
+  WeightPruner pruner{weights};
+  CHECK(pruner.countCollisions(2) == 2);
+  CHECK(pruner.countCollisions(3) == 0);
+  WeightPruningConfig conf;
+  conf.targetExponent = 2;
+  REQUIRE(pruner.prune(conf));
+  CHECK(pruner.stats().collisions == 2);
+  std::vector<float> expected{3.0f, 0, 0.5f, 0};
+  CHECK(std::vector<float>(pruner.weights().begin(), pruner.weights().end()) ==
+        expected);
+}
+
+TEST_CASE("pruned weights replace perceptron in the model") {
+  std::vector<float> weights{1.0f, 0, 0.5f, 0, 2.0f, 0, 0, 0};
+  WeightPruner pruner{weights};
+  WeightPruningConfig conf;
+  conf.targetExponent = 2;
+  REQUIRE(pruner.prune(conf));
+  core::model::ModelInfo info;
+  core::model::ModelPart part;
+  part.kind = core::model::ModelPartKind::Perceprton;
+  info.parts.push_back(part);
+  part.kind = core::model::ModelPartKind::ScwDump;
+  info.parts.push_back(part);
+  pruner.exportModel(&info);
+  REQUIRE(info.parts.size() == 1);
+  core::analysis::HashedFeaturePerceptron perc;
+  REQUIRE(perc.load(info));
+  CHECK(perc.weights().size() == 4);
+  CHECK(perc.weights().at(0) == 3.0f);
+}
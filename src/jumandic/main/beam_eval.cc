@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <regex>
+#include "args.h"
+#include "core/analysis/analyzer_impl.h"
+#include "jpp_jumandic_cg.h"
+#include "jumandic/shared/jumandic_env.h"
+
+using namespace jumanpp;
+
+struct BeamSpec {
+  std::string name;
+  i32 globalBeam = 0;
+  i32 rightCheck = 0;
+  i32 rightBeam = 0;
+  float margin = 0;
+  i32 minBeam = 1;
+
+  // LEFT:CHECK:RIGHT for fixed beams,
+  // LEFT:CHECK:RIGHT:MARGIN:MIN for margin-based ones
+  static Status parse(const std::string& s, BeamSpec* result) {
+    std::regex fixedRegex{R"(^(\d+):(\d+):(\d+)$)"};
+    std::regex marginRegex{R"(^(\d+):(\d+):(\d+):([0-9.]+):(\d+)$)"};
+    std::smatch m;
+    if (std::regex_search(s, m, fixedRegex) ||
+        std::regex_search(s, m, marginRegex)) {
+      result->name = s;
+      result->globalBeam = std::stoi(m[1]);
+      result->rightCheck = std::stoi(m[2]);
+      result->rightBeam = std::stoi(m[3]);
+      if (m.size() > 4 && m[4].matched) {
+        result->margin = std::stof(m[4]);
+        result->minBeam = std::stoi(m[5]);
+      }
+      return Status::Ok();
+    }
+    return JPPS_INVALID_PARAMETER << "invalid beam spec: " << s;
+  }
+};
+
+struct BeamEvalConf {
+  std::string modelFile;
+  std::string inputFile;
+  i32 beamSize;
+  i32 referenceBeam;
+  i32 repeats;
+  float pruneMargin;
+  std::vector<BeamSpec> specs;
+
+  static BeamEvalConf parse(int argc, const char* argv[]) {
+    args::ArgumentParser parser{
+        "Evaluates speed and accuracy of global beam configurations "
+        "against the full beam analysis"};
+    args::Positional<std::string> model{parser, "model", "model"};
+    args::Positional<std::string> input{
+        parser, "input", "raw input, one sentence per line"};
+    args::ValueFlag<i32> beamSize{
+        parser, "N", "Local beam size (5 default)", {"beam"}, 5};
+    args::ValueFlag<i32> referenceBeam{
+        parser,
+        "N",
+        "Local beam size of the reference analysis (10 default)",
+        {"reference-beam"},
+        10};
+    args::ValueFlag<i32> repeats{
+        parser, "N", "Number of passes over the input", {"repeat"}, 1};
+    args::ValueFlagList<std::string> specs{
+        parser,
+        "SPEC",
+        "Global beam to evaluate: LEFT:CHECK:RIGHT or "
+        "LEFT:CHECK:RIGHT:MARGIN:MIN for score margin based beams",
+        {"gbeam"}};
+    args::ValueFlag<float> pruneMargin{
+        parser,
+        "SCORE",
+        "Experimental lattice pre-pruning margin for evaluated "
+        "configurations (0 default)",
+        {"prune-margin"},
+        0.0f};
+
+    try {
+      parser.ParseCLI(argc, argv);
+    } catch (args::Help&) {
+      std::cerr << parser;
+      exit(1);
+    } catch (std::exception& e) {
+      std::cerr << e.what() << "\n" << parser;
+      exit(1);
+    }
+
+    BeamEvalConf inst;
+    inst.modelFile = model.Get();
+    inst.inputFile = input.Get();
+    inst.beamSize = beamSize.Get();
+    inst.referenceBeam = referenceBeam.Get();
+    inst.repeats = std::max(repeats.Get(), 1);
+    inst.pruneMargin = pruneMargin.Get();
+    for (auto& s : specs.Get()) {
+      BeamSpec spec;
+      Status st = BeamSpec::parse(s, &spec);
+      if (!st) {
+        std::cerr << st.message() << "\n";
+        exit(1);
+      }
+      inst.specs.push_back(spec);
+    }
+    return inst;
+  }
+};
+
+struct EvalResult {
+  i64 sentences = 0;
+  i64 matchedSentences = 0;
+  i64 refNodes = 0;
+  i64 sysNodes = 0;
+  i64 matchedNodes = 0;
+  i64 gbeamElements = 0;
+  i64 gbeamBoundaries = 0;
+  i64 nodesBefore = 0;
+  i64 nodesAfter = 0;
+  double seconds = 0;
+
+  void print(std::ostream& os, StringPiece name) const {
+    double precision = sysNodes == 0 ? 0 : (double)matchedNodes / sysNodes;
+    double recall = refNodes == 0 ? 0 : (double)matchedNodes / refNodes;
+    double f1 = precision + recall == 0
+                    ? 0
+                    : 2 * precision * recall / (precision + recall);
+    double sentAcc = sentences == 0 ? 0 : (double)matchedSentences / sentences;
+    double avgGbeam =
+        gbeamBoundaries == 0 ? 0 : (double)gbeamElements / gbeamBoundaries;
+    double nodesKept =
+        nodesBefore == 0 ? 100 : 100.0 * nodesAfter / nodesBefore;
+    os << std::left << std::setw(24) << name.str() << std::right << std::fixed
+       << std::setprecision(2) << std::setw(10) << seconds * 1000
+       << std::setw(12) << sentences / std::max(seconds, 1e-9)
+       << std::setprecision(4) << std::setw(10) << sentAcc << std::setw(10)
+       << f1 << std::setprecision(2) << std::setw(10) << avgGbeam
+       << std::setw(10) << nodesKept << "\n";
+  }
+
+  static void printHeader(std::ostream& os) {
+    os << std::left << std::setw(24) << "config" << std::right << std::setw(10)
+       << "time(ms)" << std::setw(12) << "sent/s" << std::setw(10) << "sent-acc"
+       << std::setw(10) << "node-f1" << std::setw(10) << "avg-gbeam"
+       << std::setw(10) << "nodes(%)"
+       << "\n";
+  }
+};
+
+using NodeSet = std::vector<u64>;
+
+class BeamEvaluator {
+  core::JumanppEnv env_;
+  std::vector<std::string> sentences_;
+  std::vector<NodeSet> reference_;
+
+  static void topPath(const core::analysis::Lattice* l, NodeSet* result) {
+    result->clear();
+    auto eos = l->boundary(l->createdBoundaryCount() - 1);
+    auto top = eos->starts()->beamData().at(0);
+    auto ptr = top.ptr.previous;
+    while (ptr != nullptr && ptr->boundary >= 2) {
+      // node positions change when lattice is pruned, so we use content
+      auto& info = l->boundary(ptr->boundary)->starts()->nodeInfo().at(
+          ptr->right);
+      u64 entry = static_cast<u32>(info.entryPtr().rawValue());
+      result->push_back((static_cast<u64>(info.start()) << 48) |
+                        (static_cast<u64>(info.end()) << 32) | entry);
+      ptr = ptr->previous;
+    }
+    std::sort(result->begin(), result->end());
+  }
+
+  static void gbeamStats(const core::analysis::Lattice* l, EvalResult* res) {
+    for (u32 i = 2; i < l->createdBoundaryCount(); ++i) {
+      auto bnd = l->boundary(i);
+      if (bnd->localNodeCount() == 0) {
+        continue;
+      }
+      res->gbeamElements += bnd->ends()->globalBeam().size();
+      res->gbeamBoundaries += 1;
+    }
+  }
+
+ public:
+  Status init(const BeamEvalConf& conf) {
+    JPP_RETURN_IF_ERROR(env_.loadModel(conf.modelFile));
+    jumanpp_generated::JumandicStatic staticFeatures;
+    JPP_RETURN_IF_ERROR(env_.initFeatures(&staticFeatures));
+
+    std::ifstream ifs{conf.inputFile};
+    if (!ifs) {
+      return JPPS_INVALID_PARAMETER << "failed to open " << conf.inputFile;
+    }
+    std::string line;
+    while (std::getline(ifs, line)) {
+      if (line.empty() || (line.size() > 1 && line[0] == '#')) {
+        continue;
+      }
+      sentences_.push_back(line);
+    }
+    return Status::Ok();
+  }
+
+  Status makeReference(i32 beamSize, EvalResult* result) {
+    core::analysis::Analyzer ana;
+    env_.setBeamSize(beamSize);
+    env_.setGlobalBeam(0, 0, 0);
+    env_.setGlobalBeamMargin(0, 1);
+    env_.setPrepruneMargin(0);
+    JPP_RETURN_IF_ERROR(env_.makeAnalyzer(&ana));
+    reference_.resize(sentences_.size());
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < sentences_.size(); ++i) {
+      JPP_RIE_MSG(ana.analyze(sentences_[i]), sentences_[i]);
+      topPath(ana.impl()->lattice(), &reference_[i]);
+      result->refNodes += reference_[i].size();
+    }
+    auto end = std::chrono::steady_clock::now();
+    result->seconds = std::chrono::duration<double>(end - start).count();
+    result->sentences = sentences_.size();
+    result->matchedSentences = sentences_.size();
+    result->sysNodes = result->matchedNodes = result->refNodes;
+    return Status::Ok();
+  }
+
+  Status evaluate(i32 beamSize, const BeamSpec& spec, i32 repeats,
+                  float pruneMargin, EvalResult* result) {
+    core::analysis::Analyzer ana;
+    env_.setBeamSize(beamSize);
+    env_.setGlobalBeam(spec.globalBeam, spec.rightCheck, spec.rightBeam);
+    env_.setGlobalBeamMargin(spec.margin, spec.minBeam);
+    env_.setPrepruneMargin(pruneMargin);
+    JPP_RETURN_IF_ERROR(env_.makeAnalyzer(&ana));
+
+    NodeSet path;
+    NodeSet common;
+    for (i32 rep = 0; rep < repeats; ++rep) {
+      for (size_t i = 0; i < sentences_.size(); ++i) {
+        auto start = std::chrono::steady_clock::now();
+        JPP_RIE_MSG(ana.analyze(sentences_[i]), sentences_[i]);
+        auto end = std::chrono::steady_clock::now();
+        result->seconds += std::chrono::duration<double>(end - start).count();
+        if (rep != 0) {
+          continue;
+        }
+
+        auto lattice = ana.impl()->lattice();
+        topPath(lattice, &path);
+        gbeamStats(lattice, result);
+        auto& prune = ana.pruneStats();
+        result->nodesBefore += prune.nodesBefore;
+        result->nodesAfter += prune.nodesAfter;
+        auto& ref = reference_[i];
+        common.clear();
+        std::set_intersection(path.begin(), path.end(), ref.begin(), ref.end(),
+                              std::back_inserter(common));
+        result->sentences += 1;
+        result->matchedSentences += path == ref;
+        result->refNodes += ref.size();
+        result->sysNodes += path.size();
+        result->matchedNodes += common.size();
+      }
+    }
+    result->seconds /= repeats;
+    return Status::Ok();
+  }
+};
+
+int main(int argc, const char* argv[]) {
+  auto conf = BeamEvalConf::parse(argc, argv);
+
+  BeamEvaluator eval;
+  Status s = eval.init(conf);
+  if (!s) {
+    std::cerr << s;
+    return 1;
+  }
+
+  EvalResult::printHeader(std::cout);
+
+  EvalResult ref;
+  s = eval.makeReference(conf.referenceBeam, &ref);
+  if (!s) {
+    std::cerr << "failed to compute the reference: " << s;
+    return 1;
+  }
+  ref.print(std::cout, "reference");
+
+  for (auto& spec : conf.specs) {
+    EvalResult res;
+    s = eval.evaluate(conf.beamSize, spec, conf.repeats, conf.pruneMargin,
+                      &res);
+    if (!s) {
+      std::cerr << "failed to evaluate " << spec.name << ": " << s;
+      return 1;
+    }
+    res.print(std::cout, spec.name);
+  }
+
+  return 0;
+}
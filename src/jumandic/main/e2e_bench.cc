@@ -0,0 +1,502 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include "args.h"
+#include "core/analysis/analysis_profiler.h"
+#include "core/analysis/analyzer_impl.h"
+#include "core/analysis/batch_analyzer.h"
+#include "core/dic/dic_builder.h"
+#include "core/env.h"
+#include "core/impl/model_io.h"
+#include "core/training/full_example.h"
+#include "core/training/training_env.h"
+#include "jpp_jumandic_cg.h"
+#include "jumandic/shared/juman_format.h"
+#include "jumandic/shared/jumandic_spec.h"
+#include "util/logging.hpp"
+#include "util/mmap.h"
+#include "util/perf_counters.h"
+
+using namespace jumanpp;
+
+struct E2eBenchConf {
+  std::string modelFile;
+  std::string dicFile;
+  std::string corpusFile;
+  std::string inputFile;
+  std::string savedModel;
+  i32 epochs;
+  i32 beamSize;
+  i32 globalBeam;
+  i32 rightCheck;
+  i32 rightBeam;
+  i32 iterations;
+  i32 featureExponent;
+  i32 batchSize;
+  bool perfCounters;
+  std::vector<i32> joinLengths;
+
+  static E2eBenchConf parse(int argc, const char* argv[]) {
+    args::ArgumentParser parser{
+        "Benchmarks the full analysis pipeline on fixed corpora and prints "
+        "results as JSON, one line per corpus.",
+        "Without --model a small model is trained from the dictionary and the "
+        "corpus first, e.g. --dic=test/jumandic/jumanpp_minimal.mdic "
+        "--corpus=test/jumandic/train_mini_01.txt"};
+    args::HelpFlag help{parser, "HELP", "Print help", {"help", 'h'}};
+    args::ValueFlag<std::string> model{
+        parser, "FILE", "Trained model to benchmark", {"model"}};
+    args::ValueFlag<std::string> dic{
+        parser,
+        "FILE",
+        "Raw jumandic dictionary to train a model from",
+        {"dic"}};
+    args::ValueFlag<std::string> corpus{
+        parser,
+        "FILE",
+        "Annotated corpus to train a model from, its sentences are "
+        "benchmarked if there is no --input",
+        {"corpus"}};
+    args::ValueFlag<std::string> input{
+        parser, "FILE", "Raw input, one sentence per line", {"input"}};
+    args::ValueFlag<std::string> savedModel{
+        parser,
+        "FILE",
+        "Trained model is saved here (e2e_bench.model default)",
+        {"save-model"},
+        "e2e_bench.model"};
+    args::ValueFlag<i32> epochs{
+        parser, "N", "Training epochs (3 default)", {"epochs"}, 3};
+    args::ValueFlag<i32> beamSize{
+        parser, "N", "Local beam size (5 default)", {"beam"}, 5};
+    args::ValueFlag<i32> globalBeam{
+        parser, "N", "Global beam size (0 default)", {"global-beam"}, 0};
+    args::ValueFlag<i32> rightCheck{
+        parser, "N", "Global beam right check (0 default)", {"right-check"},
+        0};
+    args::ValueFlag<i32> rightBeam{
+        parser, "N", "Global beam right beam (0 default)", {"right-beam"}, 0};
+    args::ValueFlag<i32> iterations{
+        parser,
+        "N",
+        "Timed passes over each corpus after a warmup pass (10 default)",
+        {"iterations"},
+        10};
+    args::ValueFlag<i32> featureExponent{
+        parser,
+        "N",
+        "Trained model has 2^N feature weights (16 default)",
+        {"size"},
+        16};
+    args::ValueFlag<i32> batchSize{
+        parser,
+        "N",
+        "Analyze N sentences at once with the batch analyzer "
+        "(0 default: one by one). Stages are not profiled then",
+        {"batch"},
+        0};
+    args::Flag perf{parser,
+                    "PERF",
+                    "Measure hardware performance counters of every stage "
+                    "(cycles, instructions, LLC, branch and dTLB misses)",
+                    {"perf"}};
+    args::ValueFlagList<i32> joinLengths{
+        parser,
+        "N",
+        "Also benchmark a corpus where consecutive sentences are joined until "
+        "they have at least N codepoints (64 and 256 default)",
+        {"join"}};
+
+    try {
+      parser.ParseCLI(argc, argv);
+    } catch (args::Help&) {
+      std::cerr << parser;
+      exit(1);
+    } catch (std::exception& e) {
+      std::cerr << e.what() << "\n" << parser;
+      exit(1);
+    }
+
+    E2eBenchConf inst;
+    inst.modelFile = model.Get();
+    inst.dicFile = dic.Get();
+    inst.corpusFile = corpus.Get();
+    inst.inputFile = input.Get();
+    inst.savedModel = savedModel.Get();
+    inst.epochs = std::max(epochs.Get(), 1);
+    inst.beamSize = beamSize.Get();
+    inst.globalBeam = globalBeam.Get();
+    inst.rightCheck = rightCheck.Get();
+    inst.rightBeam = rightBeam.Get();
+    inst.iterations = std::max(iterations.Get(), 1);
+    inst.featureExponent = featureExponent.Get();
+    inst.batchSize = std::max(batchSize.Get(), 0);
+    inst.perfCounters = perf.Get();
+    inst.joinLengths = joinLengths.Get();
+    if (!joinLengths) {
+      inst.joinLengths = {64, 256};
+    }
+
+    if (inst.modelFile.empty() &&
+        (inst.dicFile.empty() || inst.corpusFile.empty())) {
+      std::cerr << "specify either --model or both --dic and --corpus\n"
+                << parser;
+      exit(1);
+    }
+    if (inst.corpusFile.empty() && inst.inputFile.empty()) {
+      std::cerr << "specify --corpus or --input\n" << parser;
+      exit(1);
+    }
+    return inst;
+  }
+};
+
+namespace t = ::jumanpp::core::training;
+
+Status buildSeedModel(const E2eBenchConf& conf, StringPiece output) {
+  core::spec::AnalysisSpec spec;
+  JPP_RETURN_IF_ERROR(jumandic::SpecFactory::makeSpec(&spec));
+
+  util::FullyMappedFile file;
+  JPP_RETURN_IF_ERROR(file.open(conf.dicFile, util::MMapType::ReadOnly));
+  core::dic::DictionaryBuilder builder;
+  JPP_RETURN_IF_ERROR(builder.importSpec(&spec));
+  JPP_RETURN_IF_ERROR(builder.importCsv(conf.dicFile, file.contents()));
+
+  core::model::ModelInfo minfo{};
+  minfo.parts.emplace_back();
+  JPP_RETURN_IF_ERROR(builder.fillModelPart(&minfo.parts.back(), "e2e"));
+
+  core::model::ModelSaver saver;
+  JPP_RETURN_IF_ERROR(saver.open(output));
+  return saver.save(minfo);
+}
+
+Status trainModel(const E2eBenchConf& conf) {
+  auto seedFile = conf.savedModel + ".seed";
+  JPP_RIE_MSG(buildSeedModel(conf, seedFile), "dic=" << conf.dicFile);
+
+  core::JumanppEnv env;
+  JPP_RETURN_IF_ERROR(env.loadModel(seedFile));
+  env.setBeamSize(static_cast<u32>(conf.beamSize));
+
+  t::TrainingArguments args;
+  args.trainingConfig.beamSize = conf.beamSize;
+  args.trainingConfig.featureNumberExponent = conf.featureExponent;
+  args.batchSize = 10;
+
+  t::TrainingEnv exec{args, &env};
+  JPP_RETURN_IF_ERROR(exec.initFeatures(nullptr));
+  JPP_RETURN_IF_ERROR(exec.initOther());
+  JPP_RETURN_IF_ERROR(exec.loadInput(conf.corpusFile));
+  for (i32 epoch = 0; epoch < conf.epochs; ++epoch) {
+    exec.resetInput();
+    JPP_RETURN_IF_ERROR(exec.trainOneEpoch());
+    LOG_INFO() << "E#" << epoch << " loss=" << exec.epochLoss();
+  }
+
+  auto model = env.modelInfoCopy();
+  exec.exportScwParams(&model, "e2e benchmark");
+  core::model::ModelSaver saver;
+  JPP_RETURN_IF_ERROR(saver.open(conf.savedModel));
+  JPP_RETURN_IF_ERROR(saver.save(model));
+  std::remove(seedFile.c_str());
+  return Status::Ok();
+}
+
+i64 countCodepoints(StringPiece s) {
+  i64 result = 0;
+  for (char c : s) {
+    result += (static_cast<u8>(c) & 0xc0) != 0x80;
+  }
+  return result;
+}
+
+struct BenchCorpus {
+  std::string name;
+  std::vector<std::string> sentences;
+  i64 codepoints = 0;
+
+  void add(StringPiece sentence) {
+    sentences.emplace_back(sentence.str());
+    codepoints += countCodepoints(sentence);
+  }
+};
+
+Status readGoldSurfaces(const core::JumanppEnv& env, StringPiece filename,
+                        BenchCorpus* result) {
+  core::input::TrainFieldsIndex tio;
+  JPP_RETURN_IF_ERROR(tio.initialize(*env.coreHolder()));
+  util::FullyMappedFile file;
+  JPP_RETURN_IF_ERROR(file.open(filename));
+  t::FullExampleReader reader;
+  reader.setTrainingIo(&tio);
+  JPP_RETURN_IF_ERROR(reader.initDoubleCsv(file.contents()));
+  t::FullyAnnotatedExample ex;
+  while (!reader.finished()) {
+    ex.reset();
+    JPP_RETURN_IF_ERROR(reader.readFullExample(&ex));
+    if (ex.numNodes() != 0) {
+      result->add(ex.surface());
+    }
+  }
+  return Status::Ok();
+}
+
+Status readRawInput(StringPiece filename, BenchCorpus* result) {
+  std::ifstream in{filename.str()};
+  if (!in) {
+    return JPPS_INVALID_PARAMETER << "failed to open input: " << filename;
+  }
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty()) {
+      result->add(line);
+    }
+  }
+  return Status::Ok();
+}
+
+// consecutive sentences are joined, the tail which is too short is dropped
+BenchCorpus joinSentences(const BenchCorpus& base, i32 minLength) {
+  BenchCorpus result;
+  result.name = "joined-" + std::to_string(minLength);
+  std::string current;
+  for (auto& s : base.sentences) {
+    current += s;
+    if (countCodepoints(current) >= minLength) {
+      result.add(current);
+      current.clear();
+    }
+  }
+  return result;
+}
+
+struct BenchResult {
+  i64 sentences = 0;
+  i64 codepoints = 0;
+  u64 arenaBytes = 0;
+  u64 arenaPeak = 0;
+  // the batch analyzer is timed only as a whole
+  double batchSeconds = 0;
+};
+
+Status benchmarkBatch(const core::JumanppEnv& env, const E2eBenchConf& conf,
+                      const BenchCorpus& corpus, BenchResult* result) {
+  core::analysis::BatchAnalyzerConfig bconf;
+  bconf.batchSize = conf.batchSize;
+  core::analysis::BatchAnalyzer batch;
+  JPP_RETURN_IF_ERROR(env.makeBatchAnalyzer(&batch, bconf));
+  jumandic::output::JumanFormat format;
+  JPP_RETURN_IF_ERROR(format.initialize(batch.analyzer(0).output()));
+
+  std::vector<StringPiece> inputs;
+  for (i32 iter = 0; iter <= conf.iterations; ++iter) {
+    // the first pass is a warmup
+    auto start = std::chrono::steady_clock::now();
+    auto& sents = corpus.sentences;
+    for (size_t pos = 0; pos < sents.size(); pos += conf.batchSize) {
+      inputs.clear();
+      auto end = std::min(sents.size(), pos + conf.batchSize);
+      for (auto i = pos; i < end; ++i) {
+        inputs.emplace_back(sents[i]);
+      }
+      JPP_RETURN_IF_ERROR(batch.analyze(inputs));
+      for (i32 i = 0; i < batch.numActive(); ++i) {
+        if (!batch.status(i)) {
+          return JPPS_INVALID_STATE << "failed to analyze [" << inputs[i]
+                                    << "]: " << batch.status(i).message();
+        }
+        JPP_RETURN_IF_ERROR(format.format(batch.analyzer(i), ""));
+      }
+    }
+    if (iter == 0) {
+      continue;
+    }
+    auto time = std::chrono::steady_clock::now() - start;
+    result->batchSeconds +=
+        std::chrono::duration_cast<std::chrono::duration<double>>(time)
+            .count();
+    result->sentences += sents.size();
+    result->codepoints += corpus.codepoints;
+  }
+  return Status::Ok();
+}
+
+Status benchmark(const core::JumanppEnv& env, const E2eBenchConf& conf,
+                 const BenchCorpus& corpus,
+                 core::analysis::AnalysisProfiler* prof, BenchResult* result) {
+  core::analysis::Analyzer ana;
+  JPP_RETURN_IF_ERROR(env.makeAnalyzer(&ana));
+  jumandic::output::JumanFormat format;
+  JPP_RETURN_IF_ERROR(format.initialize(ana.output()));
+
+  for (i32 iter = 0; iter <= conf.iterations; ++iter) {
+    // the first pass is a warmup
+    ana.setProfiler(iter == 0 ? nullptr : prof);
+    for (auto& s : corpus.sentences) {
+      JPP_RIE_MSG(ana.analyze(s), s);
+      JPP_RETURN_IF_ERROR(format.format(ana, ""));
+      if (iter == 0) {
+        continue;
+      }
+      prof->finish(core::analysis::AnalysisStage::Output);
+      auto impl = ana.impl();
+      result->arenaBytes += impl->alloc()->allocatedBytes();
+      result->arenaPeak =
+          std::max<u64>(result->arenaPeak, impl->memoryManager().used());
+    }
+    if (iter != 0) {
+      result->sentences += corpus.sentences.size();
+      result->codepoints += corpus.codepoints;
+    }
+  }
+  return Status::Ok();
+}
+
+template <typename Fn>
+void printStages(std::ostream& os,
+                 const core::analysis::AnalysisProfiler& prof, Fn fn) {
+  os << "{";
+  for (int i = 0; i < core::analysis::NumAnalysisStages; ++i) {
+    auto stage = static_cast<core::analysis::AnalysisStage>(i);
+    if (i != 0) {
+      os << ",";
+    }
+    os << "\"" << core::analysis::stageName(stage) << "\":";
+    fn(prof.stage(stage));
+  }
+  os << "}";
+}
+
+void printJson(std::ostream& os, const E2eBenchConf& conf,
+               const BenchCorpus& corpus,
+               const core::analysis::AnalysisProfiler& prof,
+               const BenchResult& r) {
+  using util::perf::Counter;
+  double seconds = 0;
+  for (int i = 0; i < core::analysis::NumAnalysisStages; ++i) {
+    auto stage = static_cast<core::analysis::AnalysisStage>(i);
+    seconds += prof.stage(stage).seconds;
+  }
+  if (conf.batchSize > 0) {
+    seconds = r.batchSeconds;
+  }
+  seconds = std::max(seconds, 1e-9);
+  double sentences = std::max<i64>(r.sentences, 1);
+  os << "{\"corpus\":\"" << corpus.name << "\""
+     << ",\"corpus_sentences\":" << corpus.sentences.size()
+     << ",\"beam\":" << conf.beamSize
+     << ",\"global_beam\":" << conf.globalBeam
+     << ",\"right_check\":" << conf.rightCheck
+     << ",\"right_beam\":" << conf.rightBeam
+     << ",\"batch\":" << conf.batchSize
+     << ",\"iterations\":" << conf.iterations
+     << ",\"sentences\":" << r.sentences
+     << ",\"codepoints\":" << r.codepoints
+     << ",\"seconds\":" << seconds
+     << ",\"sentences_per_second\":" << r.sentences / seconds
+     << ",\"ns_per_codepoint\":"
+     << seconds * 1e9 / std::max<i64>(r.codepoints, 1)
+     << ",\"stage_ns_per_sentence\":";
+  printStages(os, prof, [&](const core::analysis::StageProfile& p) {
+    os << p.seconds * 1e9 / sentences;
+  });
+
+  auto counters = prof.counters();
+  if (counters != nullptr && counters->anyAvailable()) {
+    os << ",\"stage_counters_per_sentence\":";
+    printStages(os, prof, [&](const core::analysis::StageProfile& p) {
+      os << "{";
+      bool first = true;
+      for (int i = 0; i < util::perf::NumCounters; ++i) {
+        auto c = static_cast<Counter>(i);
+        if (!counters->available(c)) {
+          continue;
+        }
+        if (!first) {
+          os << ",";
+        }
+        first = false;
+        os << "\"" << util::perf::counterName(c)
+           << "\":" << p.counters[c] / sentences;
+      }
+      os << "}";
+    });
+  }
+
+  os << ",\"arena_bytes_per_sentence\":" << r.arenaBytes / sentences
+     << ",\"arena_peak_bytes\":" << r.arenaPeak << "}\n";
+}
+
+Status runBenchmarks(const E2eBenchConf& conf) {
+  auto modelFile = conf.modelFile;
+  if (modelFile.empty()) {
+    JPP_RETURN_IF_ERROR(trainModel(conf));
+    modelFile = conf.savedModel;
+  }
+
+  core::JumanppEnv env;
+  JPP_RETURN_IF_ERROR(env.loadModel(modelFile));
+  jumanpp_generated::JumandicStatic features;
+  JPP_RETURN_IF_ERROR(env.initFeatures(&features));
+  env.setBeamSize(static_cast<u32>(conf.beamSize));
+  env.setGlobalBeam(conf.globalBeam, conf.rightCheck, conf.rightBeam);
+
+  std::vector<BenchCorpus> corpora;
+  corpora.emplace_back();
+  auto& natural = corpora.back();
+  natural.name = "natural";
+  if (conf.inputFile.empty()) {
+    JPP_RETURN_IF_ERROR(readGoldSurfaces(env, conf.corpusFile, &natural));
+  } else {
+    JPP_RETURN_IF_ERROR(readRawInput(conf.inputFile, &natural));
+  }
+  if (natural.sentences.empty()) {
+    return JPPS_INVALID_PARAMETER << "benchmark input was empty";
+  }
+  for (auto len : conf.joinLengths) {
+    auto joined = joinSentences(corpora.front(), len);
+    if (joined.sentences.empty()) {
+      LOG_WARN() << "input is too short to make sentences of " << len
+                 << " codepoints";
+      continue;
+    }
+    corpora.push_back(std::move(joined));
+  }
+
+  util::perf::PerfCounters counters;
+  if (conf.perfCounters) {
+    Status s = counters.open();
+    if (!s) {
+      LOG_WARN() << "continuing without performance counters: "
+                 << s.message();
+    }
+  }
+
+  for (auto& corpus : corpora) {
+    BenchResult result;
+    core::analysis::AnalysisProfiler prof{&counters};
+    if (conf.batchSize > 0) {
+      JPP_RIE_MSG(benchmarkBatch(env, conf, corpus, &result),
+                  "corpus=" << corpus.name);
+    } else {
+      JPP_RIE_MSG(benchmark(env, conf, corpus, &prof, &result),
+                  "corpus=" << corpus.name);
+    }
+    printJson(std::cout, conf, corpus, prof, result);
+  }
+  return Status::Ok();
+}
+
+int main(int argc, const char* argv[]) {
+  auto conf = E2eBenchConf::parse(argc, argv);
+  Status s = runBenchmarks(conf);
+  if (!s) {
+    std::cerr << s << "\n";
+    return 1;
+  }
+  return 0;
+}
@@ -3,11 +3,18 @@
 //
 
 #include "jumanpp.h"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include "core/analysis/analysis_profiler.h"
+#include "core/analysis/analyzer_impl.h"
 #include "core/input/pex_stream_reader.h"
+#include "jumandic/shared/analysis_server.h"
+#include "jumandic/shared/binary_format.h"
+#include "jumandic/shared/document_analyzer.h"
 #include "jumandic/shared/jumanpp_args.h"
 #include "util/logging.hpp"
+#include "util/perf_counters.h"
 
 using namespace jumanpp;
 
@@ -61,7 +68,11 @@ struct InputOutput {
     if (conf.outputFile == "-") {
       output_ = &std::cout;
     } else {
-      fileOutput_.reset(new std::ofstream{conf.outputFile});
+      auto mode = std::ios::out;
+      if (conf.outputType == jumandic::OutputType::Binary) {
+        mode |= std::ios::binary;
+      }
+      fileOutput_.reset(new std::ofstream{conf.outputFile, mode});
       output_ = fileOutput_.get();
     }
 
@@ -97,6 +108,103 @@ struct InputOutput {
   }
 };
 
+int runServer(jumandic::JumanppExec* exec, const jumandic::JumanppConf& conf) {
+  jumandic::ServerConfig scfg;
+  scfg.numWorkers = conf.serverThreads;
+  if (scfg.numWorkers <= 0) {
+    scfg.numWorkers = std::max<i32>(1, std::thread::hardware_concurrency());
+  }
+
+  jumandic::AnalysisServer server{exec};
+  Status s = server.initialize(scfg);
+  if (s) {
+    auto& socket = conf.serverSocket.value();
+    if (socket.empty()) {
+      s = server.serve(0, 1);
+    } else {
+      s = server.listen(socket);
+    }
+  }
+  if (!s) {
+    std::cerr << "server failed: " << s << "\n";
+    return 1;
+  }
+  return 0;
+}
+
+int runDocuments(jumandic::JumanppExec* exec, const jumandic::JumanppConf& conf,
+                 InputOutput* io) {
+  jumandic::DocumentConfig dcfg;
+  dcfg.numWorkers = conf.documentThreads;
+  if (dcfg.numWorkers <= 0) {
+    dcfg.numWorkers = std::max<i32>(1, std::thread::hardware_concurrency());
+  }
+  dcfg.splitter.terminators = conf.sentenceEnds.value();
+  dcfg.splitter.splitOnNewline = !conf.joinLines;
+  // longer sentences can not be analyzed
+  dcfg.splitter.maxBytes = exec->analyzerPtr()->impl()->cfg().maxInputBytes;
+
+  jumandic::DocumentAnalyzer analyzer{exec};
+  Status s = analyzer.initialize(dcfg);
+  if (!s) {
+    std::cerr << "failed to initialize document analysis: " << s << "\n";
+    return 1;
+  }
+
+  auto& delimiter = conf.documentDelimiter.value();
+  std::string document;
+  std::string line;
+  std::string output;
+  int result = 0;
+  while (io->hasNext()) {
+    document.clear();
+    while (io->hasNext() && std::getline(*io->input_, line)) {
+      StringPiece content = line;
+      if (!line.empty() && line.back() == '\r') {
+        content = content.take(line.size() - 1);
+      }
+      if (content == delimiter) {
+        break;
+      }
+      document.append(line);
+      document.push_back('\n');
+    }
+
+    output.clear();
+    s = analyzer.analyze(document, &output);
+    if (!s) {
+      std::cerr << s;
+      result = 1;
+    }
+    output.append(delimiter);
+    output.push_back('\n');
+    *io->output_ << output;
+  }
+  return result;
+}
+
+int writeBinaryTable(const jumandic::JumanppExec& exec,
+                     const jumandic::JumanppConf& conf) {
+  util::CodedBuffer buffer;
+  Status s = jumandic::output::writeBinaryDictionaryTable(exec.core().dic(),
+                                                           &buffer);
+  if (!s) {
+    std::cerr << "failed to build the dictionary table: " << s << "\n";
+    return 1;
+  }
+  if (conf.outputFile == "-") {
+    std::cout << buffer.contents();
+  } else {
+    std::ofstream out{conf.outputFile, std::ios::binary};
+    out << buffer.contents();
+    if (!out) {
+      std::cerr << "failed to write " << conf.outputFile.value() << "\n";
+      return 1;
+    }
+  }
+  return 0;
+}
+
 int main(int argc, const char** argv) {
   std::unique_ptr<std::ifstream> filePtr;
 
@@ -143,6 +251,14 @@ int main(int argc, const char** argv) {
     return 0;
   }
 
+  if (conf.outputType == jumandic::OutputType::BinaryTable) {
+    return writeBinaryTable(exec, conf);
+  }
+
+  if (conf.server) {
+    return runServer(&exec, conf);
+  }
+
   InputOutput io;
 
   s = io.initialize(conf, exec.core());
@@ -151,6 +267,20 @@ int main(int argc, const char** argv) {
     return 1;
   }
 
+  if (conf.document) {
+    return runDocuments(&exec, conf, &io);
+  }
+
+  util::perf::PerfCounters counters;
+  core::analysis::AnalysisProfiler profiler{&counters};
+  if (conf.profile) {
+    s = counters.open();
+    if (!s) {
+      LOG_WARN() << "profiling only time: " << s.message();
+    }
+    exec.analyzerPtr()->setProfiler(&profiler);
+  }
+
   int result = 0;
 
   while (io.hasNext()) {
@@ -176,6 +306,14 @@ int main(int argc, const char** argv) {
     } else {
       *io.output_ << exec.format()->result();
     }
+
+    if (conf.profile) {
+      profiler.finish(core::analysis::AnalysisStage::Output);
+    }
+  }
+
+  if (conf.profile) {
+    profiler.report(std::cerr);
   }
 
   return result;
@@ -59,6 +59,11 @@ Status parseArgs(int argc, const char** argv, t::TrainingArguments* args) {
       "Comment to embed in SCW model about corpora",
       {"corpus-comment"},
       ""};
+  args::Flag storeScwState{
+      ioGroup,
+      "Store SCW",
+      "Store SCW state in the output model, it is used by --warm-start",
+      {"store-scw"}};
 
   args::Group trainingParams{parser, "Training parameters"};
   args::ValueFlag<u32> paramSizeExponent{
@@ -100,6 +105,41 @@ Status parseArgs(int argc, const char** argv, t::TrainingArguments* args) {
       trainingParams, "EPOCHS", "max # of epochs (1)", {"max-epochs"}, 1};
   args::ValueFlag<float> epsilon{
       trainingParams, "EPSILON", "stopping epsilon (1e-3)", {"epsilon"}, 1e-3f};
+  args::ValueFlag<u32> prefetchBatches{
+      trainingParams,
+      "N",
+      "# of batches to read in background while training, 1 default",
+      {"prefetch-batches"},
+      1};
+  args::ValueFlag<u32> numWorkers{
+      trainingParams,
+      "N",
+      "# of worker processes for data-parallel training, 1 default",
+      {"workers"},
+      1};
+  args::ValueFlag<u32> mergeInterval{
+      trainingParams,
+      "BATCHES",
+      "Average weights of workers every N batches, only at epoch end if 0",
+      {"merge-every"},
+      0};
+  args::Flag cacheLattices{
+      trainingParams,
+      "Cache lattices",
+      "Keep built lattices of all examples in memory between epochs",
+      {"cache-lattices"}};
+  args::ValueFlag<u32> latticeCacheMb{
+      trainingParams,
+      "MB",
+      "Stop caching lattices when they need more memory, 4096 default, "
+      "0 is no limit",
+      {"lattice-cache-mb"},
+      4096};
+  args::Flag warmStart{trainingParams,
+                       "Warm start",
+                       "Continue training from weights of the input model "
+                       "instead of random ones",
+                       {"warm-start"}};
 
   RnnArgs rnnArgs{parser};
 
@@ -142,8 +182,15 @@ Status parseArgs(int argc, const char** argv, t::TrainingArguments* args) {
   args->trainingConfig.mode = trainMode.Get();
   args->trainingConfig.scw.C = scwC.Get();
   args->trainingConfig.scw.phi = scwPhi.Get();
+  args->trainingConfig.cacheLattices = cacheLattices.Get();
+  args->trainingConfig.latticeCacheLimit = u64{latticeCacheMb.Get()} << 20;
   args->batchMaxIterations = maxBatchIters.Get();
   args->maxEpochs = maxEpochs.Get();
+  args->prefetchBatches = prefetchBatches.Get();
+  args->numWorkers = std::max(numWorkers.Get(), 1u);
+  args->mergeInterval = mergeInterval.Get();
+  args->warmStart = warmStart.Get();
+  args->storeScwState = storeScwState.Get();
   args->batchLossEpsilon = epsilon.Get();
   args->rnnConfig = rnnArgs.config();
   args->scwDumpDirectory = scwDumpDir.Get();
@@ -172,7 +219,7 @@ Status parseArgs(int argc, const char** argv, t::TrainingArguments* args) {
 }
 
 void doTrain(core::training::TrainingEnv& env,
-             const t::TrainingArguments& args) {
+             const t::TrainingArguments& args, u32 worker) {
   float lastLoss = 0.0f;
 
   LOG_INFO() << "Starting SCW model training...";
@@ -192,7 +239,7 @@ void doTrain(core::training::TrainingEnv& env,
 
     LOG_INFO() << "E#" << nepoch << " finished, loss=" << env.epochLoss();
 
-    if (!args.scwDumpDirectory.empty()) {
+    if (!args.scwDumpDirectory.empty() && worker == 0) {
       env.dumpScw(args.scwDumpDirectory, args.scwDumpPrefix, nepoch);
     }
 
@@ -222,11 +269,7 @@ int saveModel(const core::training::TrainingArguments& args,
   return 0;
 }
 
-int doTrainJpp(t::TrainingArguments& args, core::JumanppEnv& env) {
-  env.setBeamSize(args.trainingConfig.beamSize);
-
-  t::TrainingEnv exec{args, &env};
-
+int initTrainingEnv(const t::TrainingArguments& args, t::TrainingEnv& exec) {
   Status s = exec.initFeatures(nullptr);
 
   if (!s) {
@@ -254,7 +297,59 @@ int doTrainJpp(t::TrainingArguments& args, core::JumanppEnv& env) {
     return 1;
   }
 
-  doTrain(exec, args);
+  return 0;
+}
+
+int doTrainJpp(t::TrainingArguments& args, core::JumanppEnv& env) {
+  env.setBeamSize(args.trainingConfig.beamSize);
+
+  // workers must be forked before any threads are started
+  t::ScwSharedSegment shared;
+  u32 worker = 0;
+  std::vector<i64> children;
+  if (args.numWorkers > 1) {
+    Status s = shared.initialize(args.numWorkers,
+                                 args.trainingConfig.numFeatures());
+    if (!s) {
+      LOG_ERROR() << "failed to initialize data-parallel training: " << s;
+      return 1;
+    }
+    s = t::spawnTrainingWorkers(args.numWorkers, &worker, &children);
+    if (!s) {
+      LOG_ERROR() << "failed to start training workers: " << s;
+      t::ScwAverager{&shared, worker}.abort();
+      t::waitTrainingWorkers(children);
+      return 1;
+    }
+  }
+  t::ScwAverager averager{&shared, worker};
+  averager.watchChildren(children);
+
+  t::TrainingEnv exec{args, &env};
+  if (args.numWorkers > 1) {
+    exec.setAverager(&averager);
+    LOG_INFO() << "Training worker #" << worker << " of " << args.numWorkers;
+  }
+
+  if (initTrainingEnv(args, exec) != 0) {
+    if (args.numWorkers > 1) {
+      averager.abort();
+    }
+    return 1;
+  }
+
+  doTrain(exec, args, worker);
+
+  if (worker != 0) {
+    // all workers have the same weights, the first one saves them
+    return 0;
+  }
+
+  Status s = t::waitTrainingWorkers(children);
+  if (!s) {
+    LOG_ERROR() << "data-parallel training has failed: " << s;
+    return 1;
+  }
 
   auto model = env.modelInfoCopy();
   exec.exportScwParams(&model, args.comment);
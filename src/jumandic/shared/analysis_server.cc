@@ -0,0 +1,590 @@
+#include "analysis_server.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include "util/logging.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define JPP_SERVER_POSIX 1
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace jumanpp {
+namespace jumandic {
+
+namespace {
+
+constexpr size_t MaxHeaderSize = 1024;
+
+Status writeAll(int fd, StringPiece data) {
+#if defined(JPP_SERVER_POSIX)
+  auto ptr = data.char_begin();
+  size_t left = data.size();
+  while (left > 0) {
+#if defined(MSG_NOSIGNAL)
+    // a disconnected client must not kill the server with SIGPIPE
+    auto written = ::send(fd, ptr, left, MSG_NOSIGNAL);
+    if (written < 0 && errno == ENOTSOCK) {
+      written = ::write(fd, ptr, left);
+    }
+#else
+    auto written = ::write(fd, ptr, left);
+#endif
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return JPPS_INVALID_STATE << "failed to write a response: "
+                                << std::strerror(errno);
+    }
+    ptr += written;
+    left -= written;
+  }
+  return Status::Ok();
+#else
+  return JPPS_NOT_IMPLEMENTED << "server is not supported on this platform";
+#endif
+}
+
+bool parseLength(StringPiece data, size_t* result) {
+  if (data.empty() || data.size() > 18) {
+    return false;
+  }
+  size_t value = 0;
+  for (auto c : data) {
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    value = value * 10 + (c - '0');
+  }
+  *result = value;
+  return true;
+}
+
+StringPiece trimNewline(StringPiece data) {
+  auto end = data.end();
+  while (end != data.begin() && (end[-1] == '\n' || end[-1] == '\r')) {
+    --end;
+  }
+  return StringPiece{data.begin(), end};
+}
+
+}  // namespace
+
+void appendFrame(std::string* output, StringPiece id, StringPiece kind,
+                 StringPiece payload) {
+  output->append(id.char_begin(), id.size());
+  output->push_back(' ');
+  output->append(kind.char_begin(), kind.size());
+  output->push_back(' ');
+  output->append(std::to_string(payload.size()));
+  output->push_back('\n');
+  output->append(payload.char_begin(), payload.size());
+}
+
+Status FrameReader::fill(bool* eof) {
+#if defined(JPP_SERVER_POSIX)
+  if (start_ > 0) {
+    std::copy(buffer_.begin() + start_, buffer_.begin() + end_,
+              buffer_.begin());
+    end_ -= start_;
+    start_ = 0;
+  }
+  if (end_ == buffer_.size()) {
+    buffer_.resize(std::max<size_t>(4096, buffer_.size() * 2));
+  }
+  while (true) {
+    auto read = ::read(fd_, buffer_.data() + end_, buffer_.size() - end_);
+    if (read < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return JPPS_INVALID_STATE << "failed to read a request: "
+                                << std::strerror(errno);
+    }
+    *eof = read == 0;
+    end_ += read;
+    return Status::Ok();
+  }
+#else
+  return JPPS_NOT_IMPLEMENTED << "server is not supported on this platform";
+#endif
+}
+
+Status FrameReader::next(ServerFrame* frame, bool* eof) {
+  *eof = false;
+  size_t headerSize = 0;
+  while (true) {
+    // allow empty lines between frames
+    while (start_ < end_ &&
+           (buffer_[start_] == '\n' || buffer_[start_] == '\r')) {
+      start_ += 1;
+    }
+    auto begin = buffer_.data() + start_;
+    auto end = buffer_.data() + end_;
+    auto newline = std::find(begin, end, '\n');
+    if (newline != end) {
+      headerSize = newline - begin + 1;
+      break;
+    }
+    if (end_ - start_ > MaxHeaderSize) {
+      return JPPS_INVALID_PARAMETER << "frame header is too long";
+    }
+    bool streamEnd = false;
+    JPP_RETURN_IF_ERROR(fill(&streamEnd));
+    if (streamEnd) {
+      if (start_ == end_) {
+        *eof = true;
+        return Status::Ok();
+      }
+      return JPPS_INVALID_PARAMETER << "input ended inside a frame header";
+    }
+  }
+
+  StringPiece header{buffer_.data() + start_,
+                     buffer_.data() + start_ + headerSize};
+  header = trimNewline(header);
+  StringPiece parts[3];
+  size_t numParts = 0;
+  auto partStart = header.begin();
+  for (auto it = header.begin(); it <= header.end(); ++it) {
+    if (it == header.end() || *it == ' ') {
+      if (numParts == 3 || it == partStart) {
+        return JPPS_INVALID_PARAMETER
+               << "frame header must be <id> <kind> <length>, was: " << header;
+      }
+      parts[numParts++] = StringPiece{partStart, it};
+      partStart = it + 1;
+    }
+  }
+  size_t length = 0;
+  if (numParts != 3 || !parseLength(parts[2], &length)) {
+    return JPPS_INVALID_PARAMETER
+           << "frame header must be <id> <kind> <length>, was: " << header;
+  }
+  if (length > maxPayload_) {
+    return JPPS_INVALID_PARAMETER << "frame payload of " << length
+                                  << " bytes is larger than the limit of "
+                                  << maxPayload_;
+  }
+  frame->id = parts[0].str();
+  frame->kind = parts[1].str();
+
+  while (end_ - start_ < headerSize + length) {
+    bool streamEnd = false;
+    JPP_RETURN_IF_ERROR(fill(&streamEnd));
+    if (streamEnd) {
+      return JPPS_INVALID_PARAMETER << "input ended inside a frame payload";
+    }
+  }
+  auto payload = buffer_.data() + start_ + headerSize;
+  frame->payload.assign(payload, payload + length);
+  start_ += headerSize + length;
+  return Status::Ok();
+}
+
+std::string ServerStats::toJson() const {
+  std::stringstream ss;
+  ss << "{\"workers\":" << workers << ",\"connections\":" << connections
+     << ",\"active_connections\":" << activeConnections
+     << ",\"requests\":" << requests << ",\"analyzed\":" << analyzed
+     << ",\"failed\":" << failed << ",\"queued\":" << queued
+     << ",\"input_bytes\":" << inputBytes
+     << ",\"analysis_seconds\":" << analysisSeconds
+     << ",\"uptime_seconds\":" << uptimeSeconds << "}\n";
+  return ss.str();
+}
+
+struct AnalysisServer::Connection {
+  int outFd;
+  // accessed only by the writer thread until it is joined
+  Status writeStatus = Status::Ok();
+
+  std::mutex mutex;
+  std::condition_variable outputReady;
+  std::condition_variable changed;
+  std::string output;
+  // number of requests answered by the buffered output
+  i64 outputCount = 0;
+  // requests which are analyzed or whose responses are not written yet
+  i64 pending = 0;
+  bool closing = false;
+  std::thread writer;
+
+  explicit Connection(int fd) : outFd{fd} {
+    writer = std::thread{[this]() { writeLoop(); }};
+  }
+
+  /**
+   * Buffers responses to count requests for the writer thread,
+   * so a slow client does not block analysis threads.
+   */
+  void write(StringPiece data, i64 count) {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      output.append(data.char_begin(), data.size());
+      outputCount += count;
+    }
+    outputReady.notify_one();
+  }
+
+  void writeLoop() {
+    std::string data;
+    std::unique_lock<std::mutex> lock{mutex};
+    while (true) {
+      outputReady.wait(lock, [this]() { return closing || !output.empty(); });
+      if (output.empty()) {
+        return;
+      }
+      data.clear();
+      data.swap(output);
+      i64 count = outputCount;
+      outputCount = 0;
+      lock.unlock();
+      // responses of a disconnected client are dropped
+      if (writeStatus) {
+        writeStatus = writeAll(outFd, data);
+      }
+      lock.lock();
+      pending -= count;
+      changed.notify_all();
+    }
+  }
+
+  void started() {
+    std::lock_guard<std::mutex> lock{mutex};
+    pending += 1;
+  }
+
+  void waitBelow(i64 limit) {
+    std::unique_lock<std::mutex> lock{mutex};
+    changed.wait(lock, [this, limit]() { return pending < limit; });
+  }
+
+  /**
+   * Waits until all requests are answered and stops the writer thread.
+   */
+  void close() {
+    {
+      std::unique_lock<std::mutex> lock{mutex};
+      changed.wait(lock, [this]() { return pending == 0; });
+      closing = true;
+    }
+    outputReady.notify_one();
+    writer.join();
+  }
+};
+
+struct AnalysisServer::Worker {
+  core::analysis::Analyzer analyzer;
+  std::unique_ptr<core::OutputFormat> format;
+};
+
+struct AnalysisServer::ClientThread {
+  std::thread thread;
+  std::atomic<bool> done{false};
+};
+
+AnalysisServer::AnalysisServer(JumanppExec* exec) : exec_{exec} {}
+
+AnalysisServer::~AnalysisServer() {
+  stop();
+  for (auto& t : threads_) {
+    t.join();
+  }
+  for (auto& c : clients_) {
+    c->thread.join();
+  }
+}
+
+Status AnalysisServer::initialize(const ServerConfig& config) {
+#if !defined(JPP_SERVER_POSIX)
+  return JPPS_NOT_IMPLEMENTED << "server is not supported on this platform";
+#endif
+  if (config.numWorkers <= 0 || config.maxBatch <= 0 ||
+      config.maxInFlight <= 0) {
+    return JPPS_INVALID_PARAMETER << "number of workers, batch size and "
+                                     "in-flight request limit must be positive";
+  }
+  if (!threads_.empty()) {
+    return JPPS_INVALID_STATE << "server was already initialized";
+  }
+  config_ = config;
+  for (i32 i = 0; i < config.numWorkers; ++i) {
+    std::unique_ptr<Worker> worker{new Worker};
+    JPP_RETURN_IF_ERROR(exec_->initAnalyzer(&worker->analyzer));
+    JPP_RETURN_IF_ERROR(exec_->makeFormat(&worker->analyzer, &worker->format));
+    if (!worker->format) {
+      return JPPS_INVALID_PARAMETER
+             << "output type does not produce analysis results";
+    }
+    workers_.push_back(std::move(worker));
+  }
+  startTime_ = std::chrono::steady_clock::now();
+  for (auto& w : workers_) {
+    auto ptr = w.get();
+    threads_.emplace_back([this, ptr]() { workerLoop(ptr); });
+  }
+  return Status::Ok();
+}
+
+void AnalysisServer::workerLoop(Worker* worker) {
+  std::vector<Task> batch;
+  std::string output;
+  while (true) {
+    batch.clear();
+    {
+      std::unique_lock<std::mutex> lock{queueMutex_};
+      queueReady_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      while (!queue_.empty() && batch.size() < config_.maxBatch) {
+        batch.push_back(std::move(queue_.front()));
+        queue_.pop_front();
+      }
+    }
+
+    // responses to a single client are written at once
+    for (size_t i = 0; i < batch.size(); ++i) {
+      auto conn = batch[i].connection;
+      if (!conn) {
+        continue;
+      }
+      output.clear();
+      i64 count = 0;
+      for (size_t j = i; j < batch.size(); ++j) {
+        if (batch[j].connection == conn) {
+          process(worker, &batch[j], &output);
+          batch[j].connection.reset();
+          count += 1;
+        }
+      }
+      conn->write(output, count);
+    }
+  }
+}
+
+void AnalysisServer::process(Worker* worker, Task* task, std::string* output) {
+  auto start = std::chrono::steady_clock::now();
+  auto input = trimNewline(task->sentence);
+  Status s = Status::Ok();
+  try {
+    s = worker->analyzer.analyze(input);
+    if (s) {
+      s = worker->format->format(worker->analyzer, EMPTY_SP);
+    }
+  } catch (std::exception& e) {
+    s = JPPS_INVALID_STATE << "failed to analyze [" << input
+                           << "]: " << e.what();
+  }
+  auto time = std::chrono::steady_clock::now() - start;
+  analysisNanos_ +=
+      std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+
+  if (s) {
+    appendFrame(output, task->id, "ok", worker->format->result());
+    numAnalyzed_ += 1;
+  } else {
+    appendFrame(output, task->id, "error", s.message());
+    numFailed_ += 1;
+  }
+}
+
+Status AnalysisServer::serve(int inFd, int outFd) {
+  auto conn = std::make_shared<Connection>(outFd);
+  numConnections_ += 1;
+  activeConnections_ += 1;
+  FrameReader reader{inFd, config_.maxRequestBytes};
+  ServerFrame frame;
+  Status result = Status::Ok();
+  std::string response;
+
+  while (true) {
+    bool eof = false;
+    Status s = reader.next(&frame, &eof);
+    if (!s) {
+      // frame boundaries are lost, the client can not be served anymore
+      response.clear();
+      appendFrame(&response, "-", "error", s.message());
+      conn->write(response, 0);
+      result = std::move(s);
+      break;
+    }
+    if (eof) {
+      break;
+    }
+    numRequests_ += 1;
+
+    response.clear();
+    if (frame.kind == "analyze") {
+      numInputBytes_ += frame.payload.size();
+      // the client is not read until some of its requests are answered
+      conn->waitBelow(config_.maxInFlight);
+      std::unique_lock<std::mutex> lock{queueMutex_};
+      if (!stopping_) {
+        conn->started();
+        queue_.push_back(
+            Task{conn, std::move(frame.id), std::move(frame.payload)});
+        lock.unlock();
+        queueReady_.notify_one();
+        continue;
+      }
+      lock.unlock();
+      appendFrame(&response, frame.id, "error", "server is stopping");
+    } else if (frame.kind == "stats") {
+      appendFrame(&response, frame.id, "ok", stats().toJson());
+    } else {
+      appendFrame(&response, frame.id, "error",
+                  "unknown request kind: " + frame.kind);
+    }
+    conn->write(response, 0);
+  }
+
+  conn->close();
+  activeConnections_ -= 1;
+  if (result) {
+    result = std::move(conn->writeStatus);
+  }
+  return result;
+}
+
+Status AnalysisServer::listen(StringPiece socketPath) {
+#if defined(JPP_SERVER_POSIX)
+  if (threads_.empty()) {
+    return JPPS_INVALID_STATE << "server was not initialized";
+  }
+  sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (socketPath.size() >= sizeof(addr.sun_path)) {
+    return JPPS_INVALID_PARAMETER << "socket path is too long: " << socketPath;
+  }
+  std::copy(socketPath.begin(), socketPath.end(), addr.sun_path);
+
+  // remove a stale socket of a previous server
+  struct stat st;
+  if (::stat(addr.sun_path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+    ::unlink(addr.sun_path);
+  }
+
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return JPPS_INVALID_STATE << "failed to create a socket: "
+                              << std::strerror(errno);
+  }
+  if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      ::listen(fd, 128) != 0) {
+    auto error = errno;
+    ::close(fd);
+    return JPPS_INVALID_STATE << "failed to listen on " << socketPath << ": "
+                              << std::strerror(error);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{connMutex_};
+    listenFd_ = fd;
+  }
+
+  Status result = Status::Ok();
+  while (!isStopping()) {
+    int client = ::accept(fd, nullptr, nullptr);
+    if (client < 0) {
+      if (errno == EINTR || isStopping()) {
+        continue;
+      }
+      result = JPPS_INVALID_STATE << "failed to accept a client: "
+                                  << std::strerror(errno);
+      break;
+    }
+
+    std::lock_guard<std::mutex> lock{connMutex_};
+    reapClients();
+    clientFds_.push_back(client);
+    std::unique_ptr<ClientThread> ct{new ClientThread};
+    auto ctp = ct.get();
+    ct->thread = std::thread{[this, client, ctp]() {
+      Status s = serve(client, client);
+      if (!s) {
+        LOG_WARN() << "failed to serve a client: " << s.message();
+      }
+      std::lock_guard<std::mutex> lock{connMutex_};
+      auto it = std::find(clientFds_.begin(), clientFds_.end(), client);
+      clientFds_.erase(it);
+      ::close(client);
+      ctp->done = true;
+    }};
+    clients_.push_back(std::move(ct));
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{connMutex_};
+    listenFd_ = -1;
+  }
+  ::close(fd);
+  ::unlink(addr.sun_path);
+  return result;
+#else
+  return JPPS_NOT_IMPLEMENTED << "server is not supported on this platform";
+#endif
+}
+
+void AnalysisServer::reapClients() {
+  auto it = std::remove_if(clients_.begin(), clients_.end(),
+                           [](std::unique_ptr<ClientThread>& c) {
+                             if (!c->done) {
+                               return false;
+                             }
+                             c->thread.join();
+                             return true;
+                           });
+  clients_.erase(it, clients_.end());
+}
+
+bool AnalysisServer::isStopping() {
+  std::lock_guard<std::mutex> lock{queueMutex_};
+  return stopping_;
+}
+
+void AnalysisServer::stop() {
+  {
+    std::lock_guard<std::mutex> lock{queueMutex_};
+    stopping_ = true;
+  }
+  queueReady_.notify_all();
+#if defined(JPP_SERVER_POSIX)
+  std::lock_guard<std::mutex> lock{connMutex_};
+  if (listenFd_ != -1) {
+    ::shutdown(listenFd_, SHUT_RDWR);
+  }
+  for (auto fd : clientFds_) {
+    ::shutdown(fd, SHUT_RD);
+  }
+#endif
+}
+
+ServerStats AnalysisServer::stats() {
+  ServerStats result;
+  result.workers = static_cast<i32>(workers_.size());
+  result.connections = numConnections_;
+  result.activeConnections = activeConnections_;
+  result.requests = numRequests_;
+  result.analyzed = numAnalyzed_;
+  result.failed = numFailed_;
+  result.inputBytes = numInputBytes_;
+  result.analysisSeconds = analysisNanos_ * 1e-9;
+  auto uptime = std::chrono::steady_clock::now() - startTime_;
+  result.uptimeSeconds =
+      std::chrono::duration_cast<std::chrono::duration<double>>(uptime)
+          .count();
+  std::lock_guard<std::mutex> lock{queueMutex_};
+  result.queued = static_cast<i64>(queue_.size());
+  return result;
+}
+
+}  // namespace jumandic
+}  // namespace jumanpp
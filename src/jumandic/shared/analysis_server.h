@@ -0,0 +1,168 @@
+#ifndef JUMANPP_ANALYSIS_SERVER_H
+#define JUMANPP_ANALYSIS_SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "jumandic/shared/jumandic_env.h"
+
+namespace jumanpp {
+namespace jumandic {
+
+/**
+ * Server protocol frame.
+ *
+ * Every frame is a header line followed by a payload:
+ * "<id> <kind> <payload length in bytes>\n<payload>".
+ * Ids are opaque tokens without whitespace chosen by the client.
+ *
+ * Request kinds are "analyze" (payload is a sentence)
+ * and "stats" (payload is ignored).
+ * Response kinds are "ok" (payload is the formatted analysis result
+ * or the statistics json) and "error" (payload is an error message).
+ * Responses are sent as soon as they are ready, so they can come
+ * in a different order from the requests.
+ */
+struct ServerFrame {
+  std::string id;
+  std::string kind;
+  std::string payload;
+};
+
+void appendFrame(std::string* output, StringPiece id, StringPiece kind,
+                 StringPiece payload);
+
+/**
+ * Reads frames from a file descriptor (a pipe or a socket).
+ */
+class FrameReader {
+  int fd_;
+  size_t maxPayload_;
+  std::vector<char> buffer_;
+  size_t start_ = 0;
+  size_t end_ = 0;
+
+  Status fill(bool* eof);
+
+ public:
+  FrameReader(int fd, size_t maxPayload) : fd_{fd}, maxPayload_{maxPayload} {}
+
+  /**
+   * Reads the next frame.
+   * eof is set to true if the stream ended cleanly before a frame.
+   */
+  Status next(ServerFrame* frame, bool* eof);
+};
+
+struct ServerConfig {
+  // Number of analysis threads, each has its own analyzer
+  i32 numWorkers = 1;
+  // Number of queued requests which are taken by a worker at once.
+  // Responses of a batch are written together.
+  i32 maxBatch = 16;
+  // Number of requests of a connection which are being analyzed or whose
+  // responses are not written yet. The client is not read while it has
+  // this many, so a client which does not read responses can not make
+  // the server queue an unbounded amount of work.
+  i32 maxInFlight = 1024;
+  size_t maxRequestBytes = 1024 * 1024;
+};
+
+struct ServerStats {
+  i32 workers = 0;
+  i64 connections = 0;
+  i64 activeConnections = 0;
+  i64 requests = 0;
+  i64 analyzed = 0;
+  i64 failed = 0;
+  i64 queued = 0;
+  i64 inputBytes = 0;
+  double analysisSeconds = 0;
+  double uptimeSeconds = 0;
+
+  std::string toJson() const;
+};
+
+/**
+ * Analyzes requests of any number of clients with a pool of analyzers.
+ *
+ * Clients are served either over a pair of file descriptors
+ * (stdin/stdout for a child process) or over a Unix domain socket.
+ * Requests of a client are analyzed concurrently.
+ */
+class AnalysisServer {
+  struct Connection;
+  struct Worker;
+  struct ClientThread;
+
+  struct Task {
+    std::shared_ptr<Connection> connection;
+    std::string id;
+    std::string sentence;
+  };
+
+  JumanppExec* exec_;
+  ServerConfig config_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+
+  std::mutex queueMutex_;
+  std::condition_variable queueReady_;
+  std::deque<Task> queue_;
+  bool stopping_ = false;
+
+  std::mutex connMutex_;
+  std::vector<int> clientFds_;
+  std::vector<std::unique_ptr<ClientThread>> clients_;
+  int listenFd_ = -1;
+
+  std::atomic<i64> numConnections_{0};
+  std::atomic<i64> activeConnections_{0};
+  std::atomic<i64> numRequests_{0};
+  std::atomic<i64> numAnalyzed_{0};
+  std::atomic<i64> numFailed_{0};
+  std::atomic<i64> numInputBytes_{0};
+  std::atomic<i64> analysisNanos_{0};
+  std::chrono::steady_clock::time_point startTime_;
+
+  void workerLoop(Worker* worker);
+  void process(Worker* worker, Task* task, std::string* output);
+  void reapClients();
+  bool isStopping();
+
+ public:
+  explicit AnalysisServer(JumanppExec* exec);
+  ~AnalysisServer();
+
+  Status initialize(const ServerConfig& config);
+
+  /**
+   * Serves a single client until its input ends
+   * and all of its requests are answered.
+   */
+  Status serve(int inFd, int outFd);
+
+  /**
+   * Accepts clients on a Unix domain socket until stop() is called.
+   */
+  Status listen(StringPiece socketPath);
+
+  /**
+   * Stops accepting clients and disconnects the current ones.
+   * Can be called from any thread.
+   */
+  void stop();
+
+  ServerStats stats();
+};
+
+}  // namespace jumandic
+}  // namespace jumanpp
+
+#endif  // JUMANPP_ANALYSIS_SERVER_H
@@ -0,0 +1,158 @@
+#include "binary_format.h"
+#include "core/analysis/analyzer_impl.h"
+#include "util/flatmap.h"
+
+namespace jumanpp {
+namespace jumandic {
+namespace output {
+
+namespace {
+
+// Field names of string ids in a token record
+constexpr u32 NumIdFields = 6;
+const StringPiece idFieldNames[NumIdFields] = {
+    "pos", "subpos", "conjtype", "conjform", "baseform", "reading"};
+
+void writeBytes(util::CodedBuffer* buf, StringPiece data) {
+  buf->writeFixed32(static_cast<u32>(data.size()));
+  buf->writeStringDataWithoutLengthPrefix(data);
+}
+
+u32 stringId(const core::analysis::StringField& fld,
+             const core::analysis::NodeWalker& walker) {
+  auto ptr = fld.pointer(walker);
+  if (ptr < 0) {
+    return BinaryFormat::SameAsSurface;
+  }
+  return static_cast<u32>(ptr);
+}
+
+}  // namespace
+
+Status BinaryFormat::initialize(const core::analysis::OutputManager& om) {
+  return flds_.initialize(om);
+}
+
+Status BinaryFormat::format(const core::analysis::Analyzer& analyzer,
+                            StringPiece comment) {
+  buffer_.reset();
+  records_.clear();
+  JPP_RETURN_IF_ERROR(analysisResult_.reset(analyzer));
+  JPP_RETURN_IF_ERROR(analysisResult_.fillTop1(&top1_));
+
+  u32 numTokens = 0;
+  while (top1_.nextBoundary()) {
+    core::analysis::ConnectionPtr connPtr;
+    if (!top1_.nextNode(&connPtr)) {
+      return Status::InvalidState() << "failed to load a node";
+    }
+    JPP_RETURN_IF_ERROR(appendNode(analyzer, connPtr, true, &numTokens));
+    while (top1_.nextNode(&connPtr)) {
+      JPP_RETURN_IF_ERROR(appendNode(analyzer, connPtr, false, &numTokens));
+    }
+  }
+
+  auto commentPadding = (4 - comment.size() % 4) % 4;
+  auto frameLength = sizeof(u32) * (2 + records_.size()) + comment.size() +
+                     commentPadding;
+  buffer_.writeFixed32(static_cast<u32>(frameLength));
+  buffer_.writeFixed32(numTokens);
+  writeBytes(&buffer_, comment);
+  for (int i = 0; i < commentPadding; ++i) {
+    buffer_.writeVarint(0);
+  }
+  for (auto v : records_) {
+    buffer_.writeFixed32(v);
+  }
+  return Status::Ok();
+}
+
+Status BinaryFormat::appendNode(const core::analysis::Analyzer& analyzer,
+                                const core::analysis::ConnectionPtr& ptr,
+                                bool first, u32* numTokens) {
+  auto ai = analyzer.impl();
+  auto& input = ai->input();
+  auto& codepoints = input.codepoints();
+  auto base = input.surface().begin();
+  auto& info =
+      ai->lattice()->boundary(ptr.boundary)->starts()->nodeInfo().at(ptr.right);
+  auto begin =
+      static_cast<u32>(codepoints[info.start()].bytes.begin() - base);
+  auto end = static_cast<u32>(codepoints[info.end() - 1].bytes.end() - base);
+
+  core::analysis::LatticeNodePtr nodePtr{ptr.boundary, ptr.right};
+  if (!analyzer.output().locate(nodePtr, &walker_)) {
+    return JPPS_INVALID_STATE << "failed to locate a node " << ptr.boundary
+                              << ":" << ptr.right;
+  }
+  while (walker_.next()) {
+    records_.push_back(begin);
+    records_.push_back(end);
+    records_.push_back(first ? 0 : FlagAlternative);
+    records_.push_back(stringId(flds_.pos, walker_));
+    records_.push_back(stringId(flds_.subpos, walker_));
+    records_.push_back(stringId(flds_.conjType, walker_));
+    records_.push_back(stringId(flds_.conjForm, walker_));
+    records_.push_back(stringId(flds_.baseform, walker_));
+    records_.push_back(stringId(flds_.reading, walker_));
+    *numTokens += 1;
+    first = false;
+  }
+  return Status::Ok();
+}
+
+Status writeBinaryDictionaryTable(const core::dic::DictionaryHolder& dic,
+                                  util::CodedBuffer* result) {
+  result->writeStringDataWithoutLengthPrefix("JPPBDT01");
+
+  std::vector<const core::dic::DictionaryField*> storages;
+  util::FlatMap<i32, u32> storageIndex;
+  result->writeFixed32(NumIdFields);
+  for (auto name : idFieldNames) {
+    auto fld = dic.fieldByName(name);
+    if (fld == nullptr) {
+      return JPPS_INVALID_PARAMETER << "dictionary did not have field "
+                                    << name;
+    }
+    if (fld->columnType != core::spec::FieldType::String) {
+      return JPPS_INVALID_PARAMETER << "field " << name
+                                    << " was not a string field";
+    }
+    auto it = storageIndex.find(fld->stringStorageIdx);
+    if (it == storageIndex.end()) {
+      auto idx = static_cast<u32>(storages.size());
+      storageIndex[fld->stringStorageIdx] = idx;
+      storages.push_back(fld);
+      it = storageIndex.find(fld->stringStorageIdx);
+    }
+    writeBytes(result, name);
+    result->writeFixed32(it->second);
+  }
+
+  result->writeFixed32(static_cast<u32>(storages.size()));
+  util::CodedBuffer strings;
+  for (auto fld : storages) {
+    core::dic::impl::StringStorageTraversal traversal{fld->strings};
+    u32 numStrings = 0;
+    strings.reset();
+    StringPiece value;
+    while (traversal.hasNext()) {
+      if (!traversal.next(&value)) {
+        return JPPS_INVALID_STATE << "string storage of field " << fld->name
+                                  << " is corrupted at "
+                                  << traversal.position();
+      }
+      strings.writeFixed32(static_cast<u32>(traversal.position()));
+      writeBytes(&strings, value);
+      numStrings += 1;
+    }
+    result->writeFixed32(numStrings);
+    result->writeStringDataWithoutLengthPrefix(strings.contents());
+  }
+
+  return Status::Ok();
+}
+
+}  // namespace output
+}  // namespace jumandic
+}  // namespace jumanpp
@@ -0,0 +1,78 @@
+#ifndef JUMANPP_BINARY_FORMAT_H
+#define JUMANPP_BINARY_FORMAT_H
+
+#include <vector>
+#include "jumandic/shared/juman_format.h"
+#include "util/coded_io.h"
+
+namespace jumanpp {
+namespace jumandic {
+namespace output {
+
+/**
+ * Compact binary output for programs which consume Juman++ output.
+ *
+ * All numbers are little-endian u32.
+ * Each sentence is a frame:
+ *
+ * [frame length (excluding this field)] [number of tokens]
+ * [comment length] [comment bytes, zero-padded to 4 bytes]
+ * [token records, each is BinaryFormat::RecordFields numbers]
+ *
+ * A token record contains the token byte offsets in the input sentence,
+ * flags and interned dictionary string ids of its fields.
+ * Strings of ids are stored in a dictionary table
+ * (see writeBinaryDictionaryTable), which clients load once per model.
+ */
+class BinaryFormat : public core::OutputFormat {
+  JumandicFields flds_;
+  util::CodedBuffer buffer_;
+  std::vector<u32> records_;
+  core::analysis::AnalysisResult analysisResult_;
+  core::analysis::AnalysisPath top1_;
+  core::analysis::NodeWalker walker_;
+
+  Status appendNode(const core::analysis::Analyzer& analyzer,
+                    const core::analysis::ConnectionPtr& ptr, bool first,
+                    u32* numTokens);
+
+ public:
+  // Record fields: byte begin, byte end, flags, pos, subpos,
+  // conjugation type, conjugation form, baseform, reading
+  static constexpr u32 RecordFields = 9;
+  // The token has the same segmentation and features as the previous one
+  // (a "@" line of the Juman format)
+  static constexpr u32 FlagAlternative = 1;
+  // Used instead of a string id for unknown words
+  // whose field value is equal to the surface
+  static constexpr u32 SameAsSurface = 0xffffffffu;
+
+  BinaryFormat() { records_.reserve(RecordFields * 256); }
+  Status initialize(const core::analysis::OutputManager& om);
+  Status format(const core::analysis::Analyzer& analyzer,
+                StringPiece comment) override;
+  StringPiece result() const override { return buffer_.contents(); }
+};
+
+/**
+ * Writes the table of dictionary strings which are referenced by ids
+ * of BinaryFormat.
+ *
+ * Fields can share string storages, so the table lists fields
+ * and then storages. Layout (numbers are little-endian u32):
+ *
+ * "JPPBDT01" [number of fields]
+ * [name length] [name] [storage index] for every field,
+ * [number of storages]
+ * [number of strings] ([id] [length] [bytes])* for every storage.
+ *
+ * Fields are in the same order as string ids in a token record.
+ */
+Status writeBinaryDictionaryTable(const core::dic::DictionaryHolder& dic,
+                                  util::CodedBuffer* result);
+
+}  // namespace output
+}  // namespace jumandic
+}  // namespace jumanpp
+
+#endif  // JUMANPP_BINARY_FORMAT_H
@@ -0,0 +1,139 @@
+#include "document_analyzer.h"
+
+namespace jumanpp {
+namespace jumandic {
+
+struct DocumentAnalyzer::Worker {
+  core::analysis::Analyzer analyzer;
+  std::unique_ptr<core::OutputFormat> format;
+};
+
+DocumentAnalyzer::DocumentAnalyzer(JumanppExec* exec) : exec_{exec} {}
+
+DocumentAnalyzer::~DocumentAnalyzer() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stopping_ = true;
+  }
+  started_.notify_all();
+  for (auto& t : threads_) {
+    t.join();
+  }
+}
+
+Status DocumentAnalyzer::initialize(const DocumentConfig& config) {
+  if (config.numWorkers <= 0) {
+    return JPPS_INVALID_PARAMETER << "number of workers must be positive";
+  }
+  if (!workers_.empty()) {
+    return JPPS_INVALID_STATE << "document analyzer was already initialized";
+  }
+  JPP_RETURN_IF_ERROR(splitter_.initialize(config.splitter));
+  for (i32 i = 0; i < config.numWorkers; ++i) {
+    std::unique_ptr<Worker> worker{new Worker};
+    JPP_RETURN_IF_ERROR(exec_->initAnalyzer(&worker->analyzer));
+    JPP_RETURN_IF_ERROR(exec_->makeFormat(&worker->analyzer, &worker->format));
+    if (!worker->format) {
+      return JPPS_INVALID_PARAMETER
+             << "output type does not produce analysis results";
+    }
+    workers_.push_back(std::move(worker));
+  }
+  // the first worker belongs to the calling thread
+  for (size_t i = 1; i < workers_.size(); ++i) {
+    auto ptr = workers_[i].get();
+    threads_.emplace_back([this, ptr]() { helperLoop(ptr); });
+  }
+  return Status::Ok();
+}
+
+void DocumentAnalyzer::helperLoop(Worker* worker) {
+  u64 seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      started_.wait(
+          lock, [this, seen]() { return stopping_ || generation_ != seen; });
+      if (stopping_) {
+        return;
+      }
+      seen = generation_;
+    }
+    work(worker);
+    std::lock_guard<std::mutex> lock{mutex_};
+    running_ -= 1;
+    if (running_ == 0) {
+      finished_.notify_one();
+    }
+  }
+}
+
+void DocumentAnalyzer::work(Worker* worker) {
+  while (true) {
+    auto idx = nextSentence_.fetch_add(1);
+    if (idx >= sentences_.size()) {
+      return;
+    }
+    auto sentence = sentences_[idx];
+    auto& result = results_[idx];
+    Status s = Status::Ok();
+    try {
+      s = worker->analyzer.analyze(sentence);
+      if (s) {
+        s = worker->format->format(worker->analyzer, EMPTY_SP);
+      }
+    } catch (std::exception& e) {
+      s = JPPS_INVALID_STATE << "failed to analyze [" << sentence
+                             << "]: " << e.what();
+    }
+
+    if (s) {
+      auto formatted = worker->format->result();
+      result.assign(formatted.char_begin(), formatted.size());
+    } else {
+      auto empty = exec_->emptyResult();
+      result.assign(empty.char_begin(), empty.size());
+      std::lock_guard<std::mutex> lock{mutex_};
+      if (error_.isOk() || idx < errorIndex_) {
+        errorIndex_ = idx;
+        error_ = std::move(s);
+      }
+    }
+  }
+}
+
+Status DocumentAnalyzer::analyze(StringPiece document, std::string* output) {
+  if (workers_.empty()) {
+    return JPPS_INVALID_STATE << "document analyzer was not initialized";
+  }
+  splitter_.split(document, &sentences_);
+  if (results_.size() < sentences_.size()) {
+    results_.resize(sentences_.size());
+  }
+  error_ = Status::Ok();
+  nextSentence_ = 0;
+
+  // a single sentence is not worth waking up the helpers
+  bool parallel = !threads_.empty() && sentences_.size() > 1;
+  if (parallel) {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      generation_ += 1;
+      running_ = static_cast<i32>(threads_.size());
+    }
+    started_.notify_all();
+  }
+  work(workers_[0].get());
+  if (parallel) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    finished_.wait(lock, [this]() { return running_ == 0; });
+  }
+
+  for (size_t i = 0; i < sentences_.size(); ++i) {
+    output->append(results_[i]);
+  }
+  return std::move(error_);
+}
+
+}  // namespace jumandic
+}  // namespace jumanpp
@@ -0,0 +1,78 @@
+#ifndef JUMANPP_DOCUMENT_ANALYZER_H
+#define JUMANPP_DOCUMENT_ANALYZER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "core/input/sentence_splitter.h"
+#include "jumandic/shared/jumandic_env.h"
+
+namespace jumanpp {
+namespace jumandic {
+
+struct DocumentConfig {
+  // Number of analyzers, the calling thread uses one of them
+  i32 numWorkers = 1;
+  core::input::SentenceSplitterConfig splitter;
+};
+
+/**
+ * Analyzes a whole document at once.
+ *
+ * The document is split into sentences which are analyzed
+ * in parallel by a pool of analyzers.
+ * Formatted results are joined in the order of sentences,
+ * so the output is the same as the one of the sequential analysis.
+ */
+class DocumentAnalyzer {
+  struct Worker;
+
+  JumanppExec* exec_;
+  core::input::SentenceSplitter splitter_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable started_;
+  std::condition_variable finished_;
+  // incremented for every document, wakes the helper threads
+  u64 generation_ = 0;
+  i32 running_ = 0;
+  bool stopping_ = false;
+
+  std::vector<StringPiece> sentences_;
+  std::vector<std::string> results_;
+  // the error of the first failed sentence
+  size_t errorIndex_ = 0;
+  Status error_ = Status::Ok();
+  std::atomic<size_t> nextSentence_{0};
+
+  void helperLoop(Worker* worker);
+  void work(Worker* worker);
+
+ public:
+  explicit DocumentAnalyzer(JumanppExec* exec);
+  ~DocumentAnalyzer();
+
+  Status initialize(const DocumentConfig& config);
+
+  /**
+   * Appends formatted results of all sentences of the document
+   * to the output.
+   * A sentence which can not be analyzed produces the error result
+   * of the output format and the first error is returned
+   * after the whole document is analyzed.
+   */
+  Status analyze(StringPiece document, std::string* output);
+
+  size_t numSentences() const { return sentences_.size(); }
+};
+
+}  // namespace jumandic
+}  // namespace jumanpp
+
+#endif  // JUMANPP_DOCUMENT_ANALYZER_H
@@ -9,6 +9,7 @@
 #include "core/impl/segmented_format.h"
 #include "core_version.h"
 #include "jpp_jumandic_cg.h"
+#include "jumandic/shared/binary_format.h"
 #include "jumandic/shared/lattice_format.h"
 #include "jumandic/shared/morph_format.h"
 #include "jumandic/shared/subset_format.h"
@@ -31,6 +32,11 @@ Status JumanppExec::init() {
   JPP_RETURN_IF_ERROR(env.loadModel(conf.modelFile.value()));
   env.setBeamSize(conf.beamSize);
   env.setGlobalBeam(conf.globalBeam, conf.rightCheck, conf.rightBeam);
+  env.setGlobalBeamMargin(conf.globalBeamMargin, conf.globalBeamMin);
+  env.setPrepruneMargin(conf.prepruneMargin);
+  core::analysis::UnkSpanLimits unkLimits;
+  unkLimits.maxLength = conf.maxUnkLength;
+  env.setUnkLimits(unkLimits);
   if (conf.autoStep.defined()) {
     env.setAutoBeam(conf.beamSize, conf.autoStep, conf.globalBeam);
   }
@@ -56,30 +62,34 @@ Status JumanppExec::init() {
   return Status::Ok();
 }
 
-Status JumanppExec::initOutput() {
+Status JumanppExec::initOutput() { return makeFormat(&analyzer_, &format_); }
+
+Status JumanppExec::makeFormat(
+    core::analysis::Analyzer *analyzer,
+    std::unique_ptr<core::OutputFormat> *result) {
   switch (conf.outputType.value()) {
     case jumandic::OutputType::Juman: {
       auto jfmt = new jumandic::output::JumanFormat;
-      format_.reset(jfmt);
-      JPP_RETURN_IF_ERROR(jfmt->initialize(analyzer_.output()));
+      result->reset(jfmt);
+      JPP_RETURN_IF_ERROR(jfmt->initialize(analyzer->output()));
       break;
     }
     case jumandic::OutputType::Morph: {
       auto mfmt = new jumandic::output::MorphFormat(false);
-      format_.reset(mfmt);
-      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer_.output()));
+      result->reset(mfmt);
+      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer->output()));
       break;
     }
     case jumandic::OutputType::FullMorph: {
       auto mfmt = new jumandic::output::MorphFormat(true);
-      format_.reset(mfmt);
-      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer_.output()));
+      result->reset(mfmt);
+      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer->output()));
       break;
     }
     case OutputType::DicSubset: {
       auto mfmt = new jumandic::output::SubsetFormat{};
-      format_.reset(mfmt);
-      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer_.output()));
+      result->reset(mfmt);
+      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer->output()));
       break;
     }
     case OutputType::Lattice: {
@@ -90,40 +100,47 @@ Status JumanppExec::initOutput() {
         numOutput = conf.beamSize;
       }
       auto mfmt = new jumandic::output::LatticeFormat{numOutput};
-      format_.reset(mfmt);
-      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer_.output()));
+      result->reset(mfmt);
+      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer->output()));
       break;
     }
     case OutputType::Segmentation: {
       auto mfmt = new core::output::SegmentedFormat{};
-      format_.reset(mfmt);
-      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer_.output(),
+      result->reset(mfmt);
+      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer->output(),
                                            *env.coreHolder(),
                                            conf.segmentSeparator.value()));
       break;
     }
+    case OutputType::Binary: {
+      auto mfmt = new jumandic::output::BinaryFormat{};
+      result->reset(mfmt);
+      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer->output()));
+      break;
+    }
     case OutputType::Version:
     case OutputType::ModelInfo:
+    case OutputType::BinaryTable:
       return Status::Ok();
 #if defined(JPP_USE_PROTOBUF)
     case OutputType::FullLatticeDump: {
       auto mfmt = new core::output::LatticeDumpOutput{true, true};
-      format_.reset(mfmt);
+      result->reset(mfmt);
       JPP_RETURN_IF_ERROR(
-          mfmt->initialize(analyzer_.impl(), &env.featureScorer()->weights()));
-      analyzer_.impl()->setStoreAllPatterns(true);
+          mfmt->initialize(analyzer->impl(), &env.featureScorer()->weights()));
+      analyzer->impl()->setStoreAllPatterns(true);
       break;
     }
     case OutputType::JumanPb: {
       auto mfmt = new jumandic::JumanPbFormat();
-      format_.reset(mfmt);
+      result->reset(mfmt);
       JPP_RETURN_IF_ERROR(
-          mfmt->initialize(analyzer_.output(), &idResolver_, true));
+          mfmt->initialize(analyzer->output(), &idResolver_, true));
       break;
     }
     case OutputType::LatticePb: {
       auto mfmt = new jumandic::JumanppProtobufOutput();
-      format_.reset(mfmt);
+      result->reset(mfmt);
       i32 numOutput = conf.beamOutput;
       if (numOutput == -1) {
         LOG_TRACE() << "Using beam width for lattice output format instead of "
@@ -131,15 +148,15 @@ Status JumanppExec::initOutput() {
         numOutput = conf.beamSize;
       }
       JPP_RETURN_IF_ERROR(
-          mfmt->initialize(analyzer_.output(), &idResolver_, numOutput, true));
+          mfmt->initialize(analyzer->output(), &idResolver_, numOutput, true));
       break;
     }
 #endif
 #ifdef JPP_ENABLE_DEV_TOOLS
     case OutputType::GlobalBeamPos: {
       auto mfmt = new core::output::GlobalBeamPositionFormat{conf.globalBeam};
-      format_.reset(mfmt);
-      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer_));
+      result->reset(mfmt);
+      JPP_RETURN_IF_ERROR(mfmt->initialize(*analyzer));
       break;
     }
 #endif
@@ -39,6 +39,13 @@ class JumanppExec {
 
   virtual Status initOutput();
 
+  /**
+   * Creates a formatter of the configured output type for an analyzer
+   * which was created by initAnalyzer.
+   */
+  Status makeFormat(core::analysis::Analyzer* analyzer,
+                    std::unique_ptr<core::OutputFormat>* result);
+
   virtual Status init(const jumandic::JumanppConf& conf) {
     this->conf.mergeWith(conf);
     return init();
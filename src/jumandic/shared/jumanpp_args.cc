@@ -54,6 +54,8 @@ struct JppArgsParser {
       instance["morph"] = OutputType::Morph;
       instance["full-morph"] = OutputType::FullMorph;
       instance["dic-subset"] = OutputType::DicSubset;
+      instance["binary"] = OutputType::Binary;
+      instance["binary-table"] = OutputType::BinaryTable;
 #if defined(JPP_USE_PROTOBUF)
       instance["juman-pb"] = OutputType::JumanPb;
       instance["lattice-pb"] = OutputType::LatticePb;
@@ -138,11 +140,82 @@ struct JppArgsParser {
       analysisParams, "N", "Right check size", {"right-check"}};
   args::ValueFlag<i32> rightBeamSize{
       analysisParams, "N", "Right beam size", {"right-beam"}};
+  args::ValueFlag<float> globalBeamMargin{
+      analysisParams,
+      "SCORE",
+      "Keep only global beam elements within this score margin of the best",
+      {"global-beam-margin"}};
+  args::ValueFlag<i32> globalBeamMin{analysisParams,
+                                     "N",
+                                     "Minimum global beam size with margin",
+                                     {"global-beam-min"}};
+  args::ValueFlag<float> prepruneMargin{
+      analysisParams,
+      "SCORE",
+      "Experimental, off by default: before scoring, remove nodes with "
+      "unigram score lower than the best node of the same span minus this "
+      "margin. It has not made analysis faster on measured corpora",
+      {"prune-margin"}};
+  args::ValueFlag<i32> maxUnkLength{
+      analysisParams,
+      "N",
+      "Unknown words longer than N characters are created only when they "
+      "end at a character class boundary or span a whole number "
+      "(default: unlimited)",
+      {"max-unk-length"}};
   args::ValueFlag<std::string> autoBeam{
       analysisParams,
       "BASE:STEP:MAX",
       "Automatic beam size (from length). Sets local and global left beams.",
       {"auto-nbest"}};
+  args::Flag profile{analysisParams,
+                     "profile",
+                     "Print time and hardware counters spent in every "
+                     "analysis stage to stderr",
+                     {"profile"}};
+  args::Group serverParams{parser, "Server mode"};
+  args::Flag server{serverParams,
+                    "server",
+                    "Serve length-prefixed requests "
+                    "(see docs/server.md) from stdin or a socket",
+                    {"server"}};
+  args::ValueFlag<std::string> serverSocket{
+      serverParams,
+      "PATH",
+      "Listen on this Unix domain socket instead of stdin",
+      {"server-socket"}};
+  args::ValueFlag<i32> serverThreads{
+      serverParams,
+      "N",
+      "Number of analysis threads (default: number of cores)",
+      {"server-threads"}};
+  args::Group documentParams{parser, "Document mode"};
+  args::Flag document{documentParams,
+                      "document",
+                      "Input is a document which ends with a delimiter line "
+                      "(or the end of input). Its sentences are analyzed "
+                      "in parallel",
+                      {"document"}};
+  args::ValueFlag<i32> documentThreads{
+      documentParams,
+      "N",
+      "Number of analysis threads (default: number of cores)",
+      {"document-threads"}};
+  args::ValueFlag<std::string> sentenceEnds{
+      documentParams,
+      "CHARS",
+      "Characters which end a sentence (default: 。！？)",
+      {"sentence-ends"}};
+  args::Flag joinLines{documentParams,
+                       "joinLines",
+                       "Newlines do not end sentences and are removed",
+                       {"join-lines"}};
+  args::ValueFlag<std::string> documentDelimiter{
+      documentParams,
+      "LINE",
+      "Line which ends a document in the input and the output "
+      "(default: EOD)",
+      {"document-delimiter"}};
 #ifdef JPP_ENABLE_DEV_TOOLS
   args::Group devParams{parser, "Dev options"};
   args::Flag globalBeamPos{devParams,
@@ -266,6 +339,19 @@ struct JppArgsParser {
     result->globalBeam.set(globalBeamSize);
     result->rightCheck.set(rightCheckBeam);
     result->rightBeam.set(rightBeamSize);
+    result->globalBeamMargin.set(globalBeamMargin);
+    result->globalBeamMin.set(globalBeamMin);
+    result->prepruneMargin.set(prepruneMargin);
+    result->maxUnkLength.set(maxUnkLength);
+    result->profile.set(profile, true);
+    result->server.set(server, true);
+    result->serverSocket.set(serverSocket);
+    result->serverThreads.set(serverThreads);
+    result->document.set(document, true);
+    result->documentThreads.set(documentThreads);
+    result->sentenceEnds.set(sentenceEnds);
+    result->joinLines.set(joinLines, true);
+    result->documentDelimiter.set(documentDelimiter);
 
     if (autoBeam) {
       std::regex autoBeamRegex(R"(^(\d+):(\d+):(\d+)$)");
@@ -415,8 +501,20 @@ std::ostream& operator<<(std::ostream& os, const JumanppConf& conf) {
      << "\nbeamOutput: " << conf.beamOutput
      << "\nglobalBeam: " << conf.globalBeam << "\nrightBeam: " << conf.rightBeam
      << "\nrightCheck: " << conf.rightCheck
+     << "\nglobalBeamMargin: " << conf.globalBeamMargin
+     << "\nglobalBeamMin: " << conf.globalBeamMin
+     << "\nprepruneMargin: " << conf.prepruneMargin
+     << "\nmaxUnkLength: " << conf.maxUnkLength
      << "\nsegmentSeparator: " << conf.segmentSeparator
-     << "\nautoStep: " << conf.autoStep << "\nlogLevel: " << conf.logLevel;
+     << "\nautoStep: " << conf.autoStep << "\nlogLevel: " << conf.logLevel
+     << "\nprofile: " << conf.profile << "\nserver: " << conf.server
+     << "\nserverSocket: " << conf.serverSocket
+     << "\nserverThreads: " << conf.serverThreads
+     << "\ndocument: " << conf.document
+     << "\ndocumentThreads: " << conf.documentThreads
+     << "\nsentenceEnds: " << conf.sentenceEnds
+     << "\njoinLines: " << conf.joinLines
+     << "\ndocumentDelimiter: " << conf.documentDelimiter;
   return os;
 }
 }  // namespace jumandic
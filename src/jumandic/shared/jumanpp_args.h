@@ -25,6 +25,8 @@ enum class OutputType {
   FullMorph,
   DicSubset,
   Lattice,
+  Binary,
+  BinaryTable,
 #if defined(JPP_USE_PROTOBUF)
   JumanPb,
   LatticePb,
@@ -52,9 +54,22 @@ struct JumanppConf {
   util::Cfg<i32> globalBeam = 6;
   util::Cfg<i32> rightBeam = 5;
   util::Cfg<i32> rightCheck = 1;
+  util::Cfg<float> globalBeamMargin = 0.0f;
+  util::Cfg<i32> globalBeamMin = 1;
+  util::Cfg<float> prepruneMargin = 0.0f;
+  util::Cfg<i32> maxUnkLength = 0;
   util::Cfg<i32> logLevel = 0;
   util::Cfg<i32> autoStep = 0;
   util::Cfg<std::string> segmentSeparator{" "};
+  util::Cfg<bool> profile = false;
+  util::Cfg<bool> server = false;
+  util::Cfg<std::string> serverSocket;
+  util::Cfg<i32> serverThreads = 0;
+  util::Cfg<bool> document = false;
+  util::Cfg<i32> documentThreads = 0;
+  util::Cfg<std::string> sentenceEnds{"。！？"};
+  util::Cfg<bool> joinLines = false;
+  util::Cfg<std::string> documentDelimiter{"EOD"};
 
   void mergeWith(const JumanppConf& o) {
     configFile.mergeWith(o.configFile);
@@ -71,9 +86,22 @@ struct JumanppConf {
     globalBeam.mergeWith(o.globalBeam);
     rightBeam.mergeWith(o.rightBeam);
     rightCheck.mergeWith(o.rightCheck);
+    globalBeamMargin.mergeWith(o.globalBeamMargin);
+    globalBeamMin.mergeWith(o.globalBeamMin);
+    prepruneMargin.mergeWith(o.prepruneMargin);
+    maxUnkLength.mergeWith(o.maxUnkLength);
     logLevel.mergeWith(o.logLevel);
     autoStep.mergeWith(o.autoStep);
     segmentSeparator.mergeWith(o.segmentSeparator);
+    profile.mergeWith(o.profile);
+    server.mergeWith(o.server);
+    serverSocket.mergeWith(o.serverSocket);
+    serverThreads.mergeWith(o.serverThreads);
+    document.mergeWith(o.document);
+    documentThreads.mergeWith(o.documentThreads);
+    sentenceEnds.mergeWith(o.sentenceEnds);
+    joinLines.mergeWith(o.joinLines);
+    documentDelimiter.mergeWith(o.documentDelimiter);
   }
 
   friend std::ostream& operator<<(std::ostream& os, const JumanppConf& conf);
@@ -28,4 +28,24 @@ TEST_CASE("jumanpp can learn with minidic") {
   env.singleEpochFrom("jumandic/train_mini_01.txt");
   env.singleEpochFrom("jumandic/train_mini_01.txt");
   env.singleEpochFrom("jumandic/train_mini_01.txt");
-}
\ No newline at end of file
+}
+TEST_CASE("prefetching batches does not change training") {
+  std::vector<double> losses[2];
+  for (int i = 0; i < 2; ++i) {
+    JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+    // weights are updated while the other trainers of a batch are
+    // computed, so only batches of a single example train deterministically
+    env.trainArgs.batchSize = 1;
+    env.trainArgs.prefetchBatches = i * 2;
+    env.initialize();
+    auto& te = env.trainEnv.value();
+    REQUIRE_OK(te.loadInput("jumandic/train_mini_01.txt"));
+    for (int epoch = 0; epoch < 3; ++epoch) {
+      te.resetInput();
+      REQUIRE_OK(te.trainOneEpoch());
+      losses[i].push_back(te.epochLoss());
+    }
+  }
+  CHECK(losses[0][0] > 0);
+  CHECK(losses[0] == losses[1]);
+}
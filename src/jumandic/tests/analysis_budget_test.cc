@@ -0,0 +1,151 @@
+#include "core/analysis/analyzer_impl.h"
+#include "core/analysis/score_api.h"
+#include "jumandic/shared/jumandic_test_env.h"
+#include "jumandic/shared/lattice_format.h"
+
+using namespace jumanpp::core::analysis;
+
+namespace {
+
+std::string formatLattice(const Analyzer& ana) {
+  jumanpp::jumandic::output::LatticeFormat fmt{3};
+  REQUIRE_OK(fmt.initialize(ana.output()));
+  REQUIRE_OK(fmt.format(ana, ""));
+  return fmt.result().str();
+}
+
+// Additional scorer which gives zero scores and counts its calls
+class CountingScorer : public ScoreComputer {
+  i32* calls_;
+
+ public:
+  explicit CountingScorer(i32* calls) : calls_{calls} {}
+
+  jumanpp::Status scoreLattice(Lattice* l, const ExtraNodesContext* xtra,
+                               jumanpp::u32 scorerIdx) override {
+    *calls_ += 1;
+    for (jumanpp::u32 idx = 2; idx < l->createdBoundaryCount(); ++idx) {
+      auto bnd = l->boundary(idx);
+      for (jumanpp::u32 node = 0; node < bnd->localNodeCount(); ++node) {
+        auto scores = bnd->scores()->nodeScores(node);
+        for (jumanpp::u32 beam = 0; beam < scores.beam(); ++beam) {
+          for (jumanpp::u32 left = 0; left < scores.left(); ++left) {
+            scores.beamLeft(beam, left).at(scorerIdx) = 0;
+          }
+        }
+      }
+    }
+    return jumanpp::Status::Ok();
+  }
+};
+
+class CountingScorerFactory : public ScorerFactory {
+ public:
+  i32 calls = 0;
+
+  jumanpp::Status load(const jumanpp::core::model::ModelInfo& model) override {
+    return jumanpp::Status::Ok();
+  }
+
+  jumanpp::Status makeInstance(
+      std::unique_ptr<ScoreComputer>* result) override {
+    result->reset(new CountingScorer{&calls});
+    return jumanpp::Status::Ok();
+  }
+};
+
+}  // namespace
+
+TEST_CASE("analysis with expired budget uses minimum beams", "[gbeam]") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.globalBeam(3, 1, 3);
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 3);
+  auto ana = env.trainEnv.value().makeAnalyzer(5);
+  REQUIRE(ana);
+  ana->impl()->setGlobalBeam(6, 2, 4);
+
+  auto budget = AnalysisBudget::after(std::chrono::microseconds{0});
+  budget.minRightBeam = 2;
+  REQUIRE_OK(ana->analyze("大阪の田舎で住む人", budget));
+  auto& deg = ana->degradation();
+  CHECK(deg.degraded());
+  // the deadline has passed before scoring started
+  CHECK(deg.boundary == 2);
+  CHECK(deg.numShrinks == 1);
+  CHECK(deg.globalBeamSize == budget.minGlobalBeam);
+  CHECK(deg.rightGbeamSize == budget.minRightBeam);
+  CHECK_FALSE(deg.skippedScorers);
+}
+
+TEST_CASE("analysis without global beam shrinks beam on expired budget") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 3);
+  auto ana = env.trainEnv.value().makeAnalyzer(5);
+  REQUIRE(ana);
+
+  StringPiece input = "大阪の田舎で住む人";
+  REQUIRE_OK(ana->analyze(input, AnalysisBudget{}));
+  CHECK_FALSE(ana->degradation().degraded());
+  auto expected = formatLattice(*ana);
+
+  auto budget = AnalysisBudget::after(std::chrono::microseconds{0});
+  budget.minBeam = 2;
+  REQUIRE_OK(ana->analyze(input, budget));
+  auto& deg = ana->degradation();
+  CHECK(deg.degraded());
+  CHECK(deg.boundary == 2);
+  CHECK(deg.beamSize == 2);
+  CHECK(deg.globalBeamSize == 0);
+  auto degraded = formatLattice(*ana);
+  CHECK_FALSE(degraded.empty());
+  CHECK(degraded != expected);
+}
+
+TEST_CASE("analysis with expired budget skips additional scorers",
+          "[gbeam]") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.globalBeam(3, 1, 3);
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 3);
+  auto& trainEnv = env.trainEnv.value();
+
+  CountingScorerFactory counter;
+  ScorerDef sdef = *trainEnv.scorerDef();
+  sdef.others.push_back(&counter);
+  sdef.scoreWeights.push_back(1.0f);
+
+  AnalyzerConfig acfg;
+  acfg.globalBeamSize = 6;
+  acfg.rightGbeamCheck = 2;
+  acfg.rightGbeamSize = 4;
+  Analyzer ana;
+  REQUIRE_OK(ana.initialize(env.jppEnv.coreHolder(), acfg,
+                            jumanpp::core::ScoringConfig{5, 2}, &sdef));
+
+  StringPiece input = "大阪の田舎で住む人";
+  REQUIRE_OK(ana.analyze(input, AnalysisBudget{}));
+  CHECK(counter.calls == 1);
+  CHECK_FALSE(ana.degradation().degraded());
+
+  auto budget = AnalysisBudget::after(std::chrono::microseconds{0});
+  REQUIRE_OK(ana.analyze(input, budget));
+  CHECK(counter.calls == 1);
+  auto& deg = ana.degradation();
+  CHECK(deg.skippedScorers);
+  CHECK(deg.globalBeamSize == budget.minGlobalBeam);
+}
+
+TEST_CASE("analysis with unlimited budget is not degraded", "[gbeam]") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.globalBeam(3, 1, 3);
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 3);
+  auto ana = env.trainEnv.value().makeAnalyzer(5);
+  REQUIRE(ana);
+  ana->impl()->setGlobalBeam(6, 2, 4);
+
+  StringPiece input = "大阪の田舎で住む人";
+  REQUIRE_OK(ana->analyze(input));
+  auto expected = formatLattice(*ana);
+  REQUIRE_OK(ana->analyze(input, AnalysisBudget{}));
+  CHECK_FALSE(ana->degradation().degraded());
+  CHECK(formatLattice(*ana) == expected);
+}
@@ -0,0 +1,250 @@
+#include "jumandic/shared/analysis_server.h"
+#include "jumandic/shared/jumandic_test_env.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstring>
+#include <map>
+#include <thread>
+
+using namespace jumanpp::jumandic;
+
+namespace {
+
+class ServerTestEnv {
+  TempFile modelFile_;
+
+ public:
+  std::unique_ptr<JumanppExec> exec;
+
+  ServerTestEnv() {
+    JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+    env.trainNepochsFrom("jumandic/train_mini_01.txt", 1);
+    auto model = env.jppEnv.modelInfoCopy();
+    env.trainEnv.value().exportScwParams(&model);
+    core::model::ModelSaver saver;
+    REQUIRE_OK(saver.open(modelFile_.name()));
+    REQUIRE_OK(saver.save(model));
+
+    JumanppConf conf;
+    conf.modelFile = modelFile_.name();
+    exec.reset(new JumanppExec{conf});
+    REQUIRE_OK(exec->init());
+  }
+
+  std::string analyze(StringPiece sentence) {
+    REQUIRE_OK(exec->analyze(sentence));
+    return exec->output().str();
+  }
+
+  std::string socketPath() const { return modelFile_.name() + ".sock"; }
+};
+
+void writeAll(int fd, const std::string& data) {
+  size_t written = 0;
+  while (written < data.size()) {
+    auto res = ::write(fd, data.data() + written, data.size() - written);
+    REQUIRE(res > 0);
+    written += res;
+  }
+}
+
+std::map<std::string, ServerFrame> readResponses(int fd) {
+  std::map<std::string, ServerFrame> result;
+  FrameReader reader{fd, 1024 * 1024};
+  ServerFrame frame;
+  bool eof = false;
+  while (true) {
+    REQUIRE_OK(reader.next(&frame, &eof));
+    if (eof) {
+      break;
+    }
+    result[frame.id] = frame;
+  }
+  return result;
+}
+
+std::string analyzeRequest(StringPiece id, StringPiece sentence) {
+  std::string result;
+  appendFrame(&result, id, "analyze", sentence);
+  return result;
+}
+
+}  // namespace
+
+TEST_CASE("server answers all requests of a client") {
+  ServerTestEnv env;
+  AnalysisServer server{env.exec.get()};
+  ServerConfig conf;
+  conf.numWorkers = 2;
+  conf.maxBatch = 2;
+  REQUIRE_OK(server.initialize(conf));
+
+  int fds[2];
+  REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+  Status serveStatus = Status::Ok();
+  std::thread serving{[&]() {
+    serveStatus = server.serve(fds[0], fds[0]);
+    ::shutdown(fds[0], SHUT_WR);
+  }};
+
+  std::vector<StringPiece> sentences{"大阪の田舎で住む人",
+                                     "かつての重い効果", "知るには必要だ",
+                                     "大阪の田舎"};
+  std::string requests;
+  for (int i = 0; i < sentences.size(); ++i) {
+    requests += analyzeRequest(std::to_string(i), sentences[i]);
+  }
+  appendFrame(&requests, "bad", "unknown", "");
+  requests += analyzeRequest("newline", "知るには必要だ\n");
+  requests += "\n";
+  writeAll(fds[1], requests);
+  ::shutdown(fds[1], SHUT_WR);
+
+  auto responses = readResponses(fds[1]);
+  serving.join();
+  CHECK_OK(serveStatus);
+  ::close(fds[0]);
+  ::close(fds[1]);
+
+  REQUIRE(responses.size() == sentences.size() + 2);
+  for (int i = 0; i < sentences.size(); ++i) {
+    CAPTURE(sentences[i]);
+    auto& resp = responses[std::to_string(i)];
+    CHECK(resp.kind == "ok");
+    CHECK(resp.payload == env.analyze(sentences[i]));
+  }
+  CHECK(responses["bad"].kind == "error");
+  CHECK(responses["newline"].kind == "ok");
+  CHECK(responses["newline"].payload == env.analyze("知るには必要だ"));
+
+  auto stats = server.stats();
+  CHECK(stats.workers == 2);
+  CHECK(stats.connections == 1);
+  CHECK(stats.activeConnections == 0);
+  CHECK(stats.requests == sentences.size() + 2);
+  CHECK(stats.analyzed == sentences.size() + 1);
+  CHECK(stats.failed == 0);
+  CHECK(stats.queued == 0);
+}
+
+TEST_CASE("server answers all requests with a limit of in-flight requests") {
+  ServerTestEnv env;
+  AnalysisServer server{env.exec.get()};
+  ServerConfig conf;
+  conf.numWorkers = 2;
+  conf.maxInFlight = 1;
+  REQUIRE_OK(server.initialize(conf));
+
+  int fds[2];
+  REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+  Status serveStatus = Status::Ok();
+  std::thread serving{[&]() {
+    serveStatus = server.serve(fds[0], fds[0]);
+    ::shutdown(fds[0], SHUT_WR);
+  }};
+
+  std::string requests;
+  for (int i = 0; i < 20; ++i) {
+    requests += analyzeRequest(std::to_string(i), "大阪の田舎");
+  }
+  appendFrame(&requests, "s", "stats", "");
+  writeAll(fds[1], requests);
+  ::shutdown(fds[1], SHUT_WR);
+
+  auto responses = readResponses(fds[1]);
+  serving.join();
+  CHECK_OK(serveStatus);
+  ::close(fds[0]);
+  ::close(fds[1]);
+
+  REQUIRE(responses.size() == 21);
+  auto expected = env.analyze("大阪の田舎");
+  for (int i = 0; i < 20; ++i) {
+    CAPTURE(i);
+    CHECK(responses[std::to_string(i)].payload == expected);
+  }
+  CHECK(responses["s"].kind == "ok");
+  CHECK(server.stats().analyzed == 20);
+
+  AnalysisServer unlimited{env.exec.get()};
+  conf.maxInFlight = 0;
+  CHECK_FALSE(unlimited.initialize(conf));
+}
+
+TEST_CASE("server stops reading a client after a malformed frame") {
+  ServerTestEnv env;
+  AnalysisServer server{env.exec.get()};
+  REQUIRE_OK(server.initialize(ServerConfig{}));
+
+  int fds[2];
+  REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+  std::string requests = analyzeRequest("1", "大阪の田舎");
+  requests += "2 analyze many\n";
+  requests += analyzeRequest("3", "大阪の田舎");
+  writeAll(fds[1], requests);
+  ::shutdown(fds[1], SHUT_WR);
+  Status s = server.serve(fds[0], fds[0]);
+  CHECK_FALSE(s.isOk());
+  ::shutdown(fds[0], SHUT_WR);
+
+  auto responses = readResponses(fds[1]);
+  ::close(fds[0]);
+  ::close(fds[1]);
+  CHECK(responses.size() == 2);
+  CHECK(responses["1"].kind == "ok");
+  CHECK(responses["-"].kind == "error");
+  CHECK(responses.count("3") == 0);
+}
+
+TEST_CASE("server accepts clients on a unix socket") {
+  ServerTestEnv env;
+  AnalysisServer server{env.exec.get()};
+  REQUIRE_OK(server.initialize(ServerConfig{}));
+  auto path = env.socketPath();
+
+  Status listenStatus = Status::Ok();
+  std::thread listening{[&]() { listenStatus = server.listen(path); }};
+
+  sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  std::copy(path.begin(), path.end(), addr.sun_path);
+
+  for (int client = 0; client < 2; ++client) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    REQUIRE(fd >= 0);
+    bool connected = false;
+    for (int attempt = 0; attempt < 500 && !connected; ++attempt) {
+      connected = ::connect(fd, reinterpret_cast<sockaddr*>(&addr),
+                            sizeof(addr)) == 0;
+      if (!connected) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+    }
+    REQUIRE(connected);
+
+    std::string requests = analyzeRequest("a", "かつての重い効果");
+    appendFrame(&requests, "s", "stats", "");
+    writeAll(fd, requests);
+    ::shutdown(fd, SHUT_WR);
+    auto responses = readResponses(fd);
+    ::close(fd);
+
+    CHECK(responses["a"].kind == "ok");
+    CHECK(responses["a"].payload == env.analyze("かつての重い効果"));
+    CHECK(responses["s"].kind == "ok");
+    CHECK(responses["s"].payload.find("\"workers\":1") != std::string::npos);
+  }
+
+  server.stop();
+  listening.join();
+  CHECK_OK(listenStatus);
+  CHECK(server.stats().connections == 2);
+  CHECK(::access(path.c_str(), F_OK) != 0);
+}
+
+#endif  // defined(__unix__) || defined(__APPLE__)
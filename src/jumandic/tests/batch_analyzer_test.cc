@@ -0,0 +1,87 @@
+#include "core/analysis/batch_analyzer.h"
+#include "core/analysis/analyzer_impl.h"
+#include "jumandic/shared/jumandic_test_env.h"
+#include "jumandic/shared/lattice_format.h"
+
+using namespace jumanpp::core::analysis;
+
+namespace {
+
+std::string formatLattice(const Analyzer& ana) {
+  jumanpp::jumandic::output::LatticeFormat fmt{3};
+  REQUIRE_OK(fmt.initialize(ana.output()));
+  REQUIRE_OK(fmt.format(ana, ""));
+  return fmt.result().str();
+}
+
+void checkBatchIsSameAsSequential(JumandicTrainingTestEnv& env,
+                                  const AnalyzerConfig& acfg) {
+  auto& trainEnv = env.trainEnv.value();
+  auto single = trainEnv.makeAnalyzer(5);
+  REQUIRE(single);
+  single->impl()->setGlobalBeam(acfg.globalBeamSize, acfg.rightGbeamCheck,
+                                acfg.rightGbeamSize);
+
+  BatchAnalyzerConfig bconf;
+  bconf.batchSize = 3;
+  BatchAnalyzer batch;
+  REQUIRE_OK(batch.initialize(env.jppEnv.coreHolder(), acfg,
+                              jumanpp::core::ScoringConfig{5, 1}, trainEnv.scorerDef(),
+                              bconf));
+
+  std::vector<StringPiece> inputs{"大阪の田舎で住む人", "かつての重い効果",
+                                  "知るには必要だ"};
+  REQUIRE_OK(batch.analyze(inputs));
+  CHECK(batch.numActive() == 3);
+  for (int i = 0; i < inputs.size(); ++i) {
+    CAPTURE(inputs[i]);
+    CHECK_OK(batch.status(i));
+    REQUIRE_OK(single->analyze(inputs[i]));
+    CHECK(formatLattice(batch.analyzer(i)) == formatLattice(*single));
+  }
+
+  // smaller batches reuse slots
+  REQUIRE_OK(batch.analyze({inputs[2]}));
+  CHECK(batch.numActive() == 1);
+  CHECK(formatLattice(batch.analyzer(0)) == formatLattice(*single));
+}
+
+}  // namespace
+
+TEST_CASE("batch analyzer produces same results as sequential one",
+          "[gbeam]") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.globalBeam(3, 1, 3);
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 3);
+
+  AnalyzerConfig acfg;
+  acfg.storeAllPatterns = true;
+  acfg.globalBeamSize = 3;
+  acfg.rightGbeamCheck = 1;
+  acfg.rightGbeamSize = 3;
+  checkBatchIsSameAsSequential(env, acfg);
+  acfg.rightGbeamCheck = 0;
+  acfg.rightGbeamSize = 0;
+  checkBatchIsSameAsSequential(env, acfg);
+}
+
+TEST_CASE("batch analyzer works without global beam") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 3);
+  AnalyzerConfig acfg;
+  acfg.storeAllPatterns = true;
+  checkBatchIsSameAsSequential(env, acfg);
+}
+
+TEST_CASE("batch analyzer rejects too many inputs") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 1);
+  BatchAnalyzerConfig bconf;
+  bconf.batchSize = 1;
+  BatchAnalyzer batch;
+  auto& trainEnv = env.trainEnv.value();
+  REQUIRE_OK(batch.initialize(env.jppEnv.coreHolder(), AnalyzerConfig{},
+                              jumanpp::core::ScoringConfig{5, 1}, trainEnv.scorerDef(),
+                              bconf));
+  CHECK_FALSE(batch.analyze({"知る", "人"}));
+}
@@ -0,0 +1,212 @@
+#include "jumandic/shared/binary_format.h"
+#include <map>
+#include "jumandic/shared/jumandic_env.h"
+#include "jumandic/shared/jumandic_test_env.h"
+
+using namespace jumanpp::jumandic;
+using jumanpp::jumandic::output::BinaryFormat;
+
+namespace {
+
+class BinaryTestEnv {
+  TempFile modelFile_;
+
+ public:
+  std::unique_ptr<JumanppExec> juman;
+  std::unique_ptr<JumanppExec> binary;
+
+  BinaryTestEnv() {
+    JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+    env.trainNepochsFrom("jumandic/train_mini_01.txt", 1);
+    auto model = env.jppEnv.modelInfoCopy();
+    env.trainEnv.value().exportScwParams(&model);
+    core::model::ModelSaver saver;
+    REQUIRE_OK(saver.open(modelFile_.name()));
+    REQUIRE_OK(saver.save(model));
+
+    JumanppConf conf;
+    conf.modelFile = modelFile_.name();
+    juman.reset(new JumanppExec{conf});
+    REQUIRE_OK(juman->init());
+    conf.outputType = OutputType::Binary;
+    binary.reset(new JumanppExec{conf});
+    REQUIRE_OK(binary->init());
+  }
+};
+
+class Reader {
+  StringPiece data_;
+  size_t position_ = 0;
+
+ public:
+  explicit Reader(StringPiece data) : data_{data} {}
+
+  u32 u32le() {
+    REQUIRE(remaining() >= 4);
+    u32 value = 0;
+    for (int i = 0; i < 4; ++i) {
+      value |= static_cast<u32>(static_cast<u8>(data_[position_ + i]))
+               << (8 * i);
+    }
+    position_ += 4;
+    return value;
+  }
+
+  StringPiece bytes(size_t length) {
+    REQUIRE(remaining() >= length);
+    auto result = data_.slice(position_, position_ + length);
+    position_ += length;
+    return result;
+  }
+
+  StringPiece lengthPrefixed() { return bytes(u32le()); }
+
+  size_t remaining() const { return data_.size() - position_; }
+};
+
+struct DicTable {
+  std::vector<u32> fieldStorage;
+  std::vector<std::map<u32, std::string>> storages;
+
+  void load(StringPiece data) {
+    Reader rdr{data};
+    REQUIRE(rdr.bytes(8) == "JPPBDT01");
+    auto numFields = rdr.u32le();
+    REQUIRE(numFields == BinaryFormat::RecordFields - 3);
+    std::vector<std::string> names;
+    for (u32 i = 0; i < numFields; ++i) {
+      names.push_back(rdr.lengthPrefixed().str());
+      fieldStorage.push_back(rdr.u32le());
+    }
+    CHECK(names[0] == "pos");
+    CHECK(names[5] == "reading");
+    auto numStorages = rdr.u32le();
+    storages.resize(numStorages);
+    for (auto& storage : storages) {
+      auto numStrings = rdr.u32le();
+      for (u32 i = 0; i < numStrings; ++i) {
+        auto id = rdr.u32le();
+        storage[id] = rdr.lengthPrefixed().str();
+      }
+    }
+    CHECK(rdr.remaining() == 0);
+  }
+
+  std::string resolve(u32 field, u32 id, StringPiece surface) {
+    if (id == BinaryFormat::SameAsSurface) {
+      return surface.str();
+    }
+    auto& storage = storages.at(fieldStorage.at(field));
+    auto it = storage.find(id);
+    REQUIRE(it != storage.end());
+    if (it->second.empty()) {
+      return "*";
+    }
+    return it->second;
+  }
+};
+
+std::string renderBinary(StringPiece sentence, StringPiece frame,
+                         DicTable* table) {
+  Reader rdr{frame};
+  auto frameLength = rdr.u32le();
+  CHECK(frameLength + 4 == frame.size());
+  auto numTokens = rdr.u32le();
+  CHECK(rdr.lengthPrefixed().empty());
+  CHECK(rdr.remaining() == numTokens * BinaryFormat::RecordFields * 4);
+
+  std::string result;
+  u32 prevEnd = 0;
+  for (u32 i = 0; i < numTokens; ++i) {
+    u32 record[BinaryFormat::RecordFields];
+    for (auto& v : record) {
+      v = rdr.u32le();
+    }
+    auto surface = sentence.slice(record[0], record[1]);
+    if (record[2] & BinaryFormat::FlagAlternative) {
+      result += "@ ";
+    } else {
+      CHECK(record[0] == prevEnd);
+    }
+    prevEnd = record[1];
+    result += surface.str();
+    result += " " + table->resolve(5, record[8], surface);
+    result += " " + table->resolve(4, record[7], surface);
+    for (u32 fld = 0; fld < 4; ++fld) {
+      result += " " + table->resolve(fld, record[3 + fld], surface);
+    }
+    result += "\n";
+  }
+  CHECK(prevEnd == sentence.size());
+  return result;
+}
+
+// Leaves only surface, reading, baseform and string POS fields
+std::string stripJuman(StringPiece output) {
+  std::string result;
+  std::stringstream ss{output.str()};
+  std::string line;
+  while (std::getline(ss, line)) {
+    if (line == "EOS") {
+      break;
+    }
+    std::stringstream ls{line};
+    std::string part;
+    std::vector<std::string> parts;
+    while (ls >> part) {
+      parts.push_back(part);
+    }
+    auto offset = parts[0] == "@" ? 1 : 0;
+    if (offset == 1) {
+      result += "@ ";
+    }
+    result += parts[offset] + " " + parts[offset + 1] + " " +
+              parts[offset + 2] + " " + parts[offset + 3] + " " +
+              parts[offset + 5] + " " + parts[offset + 7] + " " +
+              parts[offset + 9] + "\n";
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST_CASE("binary format has the same analysis as juman format") {
+  BinaryTestEnv env;
+  util::CodedBuffer tableData;
+  REQUIRE_OK(
+      output::writeBinaryDictionaryTable(env.binary->core().dic(), &tableData));
+  DicTable table;
+  table.load(tableData.contents());
+
+  std::vector<StringPiece> sentences{"大阪の田舎で住む人", "かつての重い効果",
+                                     "知るには必要だ", "ぽぽぽぽーん"};
+  for (auto sentence : sentences) {
+    CAPTURE(sentence);
+    REQUIRE_OK(env.juman->analyze(sentence));
+    REQUIRE_OK(env.binary->analyze(sentence));
+    auto expected = stripJuman(env.juman->output());
+    auto actual = renderBinary(sentence, env.binary->output(), &table);
+    CHECK(actual == expected);
+  }
+}
+
+TEST_CASE("binary format writes comments padded to 4 bytes") {
+  BinaryTestEnv env;
+  REQUIRE_OK(env.binary->analyze("大阪の田舎", "test"));
+  auto frame = env.binary->output();
+  Reader rdr{frame};
+  CHECK(rdr.u32le() + 4 == frame.size());
+  auto numTokens = rdr.u32le();
+  CHECK(numTokens > 0);
+  CHECK(rdr.lengthPrefixed() == "test");
+  CHECK(rdr.remaining() == numTokens * BinaryFormat::RecordFields * 4);
+
+  REQUIRE_OK(env.binary->analyze("大阪の田舎", "comment"));
+  frame = env.binary->output();
+  Reader rdr2{frame};
+  CHECK(rdr2.u32le() + 4 == frame.size());
+  CHECK(rdr2.u32le() == numTokens);
+  CHECK(rdr2.lengthPrefixed() == "comment");
+  CHECK(rdr2.bytes(1) == StringPiece{"\0", 1});
+  CHECK(rdr2.remaining() == numTokens * BinaryFormat::RecordFields * 4);
+}
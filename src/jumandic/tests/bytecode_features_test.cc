@@ -0,0 +1,72 @@
+#include "core/impl/feature_impl_bytecode.h"
+#include "jumandic/shared/jumandic_test_env.h"
+
+using namespace jumanpp::core::features::impl;
+
+namespace {
+
+template <typename Fn>
+std::vector<u64> computePatterns(core::analysis::LatticeBoundary* bnd,
+                                 size_t numPatterns, Fn fn) {
+  auto nodes = bnd->starts();
+  auto numNodes = nodes->nodeInfo().size();
+  std::vector<u64> result(numNodes * numPatterns, 0);
+  util::Sliceable<u64> patterns{{result.data(), result.size()},
+                                numPatterns,
+                                numNodes};
+  PrimitiveFeatureData pfd{nodes->nodeInfo(), nodes->entryData(), patterns};
+  fn(&pfd);
+  return result;
+}
+
+}  // namespace
+
+TEST_CASE("bytecode pattern features are equal to dynamic ones") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  auto& core = *env.testEnv.core;
+  auto& spec = core.spec().features;
+  FeatureConstructionContext fcc{&core.dic().fields()};
+  PatternDynamicApplyImpl dynamic;
+  REQUIRE_OK(dynamic.initialize(&fcc, spec));
+  PatternBytecodeApplyImpl bytecode;
+  REQUIRE_OK(bytecode.initialize(&fcc, spec));
+  REQUIRE_FALSE(bytecode.usesFallback());
+  auto numPatterns = spec.pattern.size();
+
+  auto& analyzer = *env.testEnv.analyzer;
+
+  std::vector<StringPiece> sentences{
+      "大阪の田舎で住む人", "かつての重い効果", "知るには必要だ",
+      "ぽぽぽぽーん", "ＡＢＣは123個あります"};
+  for (auto sentence : sentences) {
+    CAPTURE(sentence);
+    REQUIRE_OK(analyzer.resetForInput(sentence));
+    REQUIRE_OK(analyzer.prepareNodeSeeds());
+    REQUIRE_OK(analyzer.buildLattice());
+    PrimitiveFeatureContext pfc{analyzer.extraNodesContext(),
+                                core.dic().fields(), core.dic().entries(),
+                                analyzer.input().codepoints()};
+    auto lattice = analyzer.lattice();
+    i32 numNodes = 0;
+    for (u32 b = 2; b < lattice->createdBoundaryCount(); ++b) {
+      CAPTURE(b);
+      auto bnd = lattice->boundary(b);
+      auto expected = computePatterns(bnd, numPatterns, [&](auto pfd) {
+        dynamic.applyBatch(&pfc, pfd);
+      });
+      auto actual = computePatterns(bnd, numPatterns, [&](auto pfd) {
+        bytecode.applyBatch(&pfc, pfd);
+      });
+      CHECK(actual == expected);
+      expected = computePatterns(bnd, numPatterns, [&](auto pfd) {
+        dynamic.applyUniOnly(&pfc, pfd);
+      });
+      actual = computePatterns(bnd, numPatterns, [&](auto pfd) {
+        bytecode.applyUniOnly(&pfc, pfd);
+      });
+      CHECK(actual == expected);
+      numNodes += bnd->starts()->nodeInfo().size();
+    }
+    CHECK(numNodes > PatternBytecodeApplyImpl::BlockSize);
+  }
+}
@@ -0,0 +1,96 @@
+#include "jumandic/shared/document_analyzer.h"
+#include "jumandic/shared/jumandic_test_env.h"
+
+using namespace jumanpp::jumandic;
+
+namespace {
+
+class DocumentTestEnv {
+  TempFile modelFile_;
+
+ public:
+  std::unique_ptr<JumanppExec> exec;
+
+  DocumentTestEnv() {
+    JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+    env.trainNepochsFrom("jumandic/train_mini_01.txt", 1);
+    auto model = env.jppEnv.modelInfoCopy();
+    env.trainEnv.value().exportScwParams(&model);
+    core::model::ModelSaver saver;
+    REQUIRE_OK(saver.open(modelFile_.name()));
+    REQUIRE_OK(saver.save(model));
+
+    JumanppConf conf;
+    conf.modelFile = modelFile_.name();
+    exec.reset(new JumanppExec{conf});
+    REQUIRE_OK(exec->init());
+  }
+
+  std::string analyzeAll(const std::vector<StringPiece>& sentences) {
+    std::string result;
+    for (auto& s : sentences) {
+      REQUIRE_OK(exec->analyze(s));
+      result += exec->output().str();
+    }
+    return result;
+  }
+};
+
+}  // namespace
+
+TEST_CASE("document analysis is the same as the sequential one",
+          "[document]") {
+  DocumentTestEnv env;
+  DocumentAnalyzer analyzer{env.exec.get()};
+  DocumentConfig conf;
+  conf.numWorkers = 3;
+  REQUIRE_OK(analyzer.initialize(conf));
+
+  std::vector<StringPiece> sentences{
+      "大阪の田舎で住む人。", "かつての重い効果！", "知るには必要だ",
+      "大阪の田舎", "「知るには必要だ。」"};
+  std::string document = "大阪の田舎で住む人。かつての重い効果！知るには必要だ"
+                         "\n\n大阪の田舎\r\n「知るには必要だ。」\n";
+  auto expected = env.analyzeAll(sentences);
+
+  // results are reused between documents
+  for (int i = 0; i < 3; ++i) {
+    std::string output;
+    REQUIRE_OK(analyzer.analyze(document, &output));
+    CHECK(analyzer.numSentences() == sentences.size());
+    CHECK(output == expected);
+  }
+
+  std::string output;
+  REQUIRE_OK(analyzer.analyze("知るには必要だ", &output));
+  CHECK(output == env.analyzeAll({"知るには必要だ"}));
+  output.clear();
+  REQUIRE_OK(analyzer.analyze("", &output));
+  CHECK(output.empty());
+}
+
+TEST_CASE("document analysis reports failed sentences in place",
+          "[document]") {
+  DocumentTestEnv env;
+  DocumentAnalyzer analyzer{env.exec.get()};
+  DocumentConfig conf;
+  conf.numWorkers = 2;
+  REQUIRE_OK(analyzer.initialize(conf));
+
+  std::string output;
+  CHECK_FALSE(analyzer.analyze("大阪の田舎\n\xff\xfe\n知るには必要だ", &output));
+  auto expected = env.analyzeAll({"大阪の田舎"});
+  expected += env.exec->emptyResult().str();
+  expected += env.analyzeAll({"知るには必要だ"});
+  CHECK(output == expected);
+}
+
+TEST_CASE("document analyzer checks the config", "[document]") {
+  DocumentTestEnv env;
+  DocumentAnalyzer analyzer{env.exec.get()};
+  DocumentConfig conf;
+  conf.numWorkers = 0;
+  CHECK_FALSE(analyzer.initialize(conf));
+  std::string output;
+  CHECK_FALSE(analyzer.analyze("大阪", &output));
+}
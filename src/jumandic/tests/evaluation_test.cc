@@ -0,0 +1,29 @@
+#include "jumandic/shared/jumandic_test_env.h"
+
+using namespace jumanpp::core::training;
+
+TEST_CASE("evaluation analyzes sentences without gold nodes") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 3);
+  auto& te = env.trainEnv.value();
+
+  EvaluationResult plain;
+  REQUIRE_OK(te.evaluate(te.scorerDef(), &plain));
+  CHECK(plain.numSentences == 7);
+  CHECK(plain.fieldAccuracy() > 0);
+  CHECK(plain.fieldAccuracy() <= 1);
+
+  // callback gets trainers which have scored the lattice with gold nodes,
+  // this does not change the evaluation
+  EvaluationResult withCallback;
+  i32 calls = 0;
+  REQUIRE_OK(te.evaluate(te.scorerDef(), &withCallback,
+                         [&](const OwningFullTrainer& trainer) {
+                           CHECK(trainer.trainer().goldenPath().nodes().size() >
+                                 0);
+                           calls += 1;
+                         }));
+  CHECK(calls == 7);
+  CHECK(withCallback.exactSentences == plain.exactSentences);
+  CHECK(withCallback.totalLoss == plain.totalLoss);
+}
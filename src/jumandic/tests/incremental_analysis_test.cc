@@ -0,0 +1,136 @@
+#include "core/analysis/analyzer_impl.h"
+#include "jumandic/shared/jumandic_test_env.h"
+#include "jumandic/shared/lattice_format.h"
+
+using namespace jumanpp::core::analysis;
+
+namespace {
+
+std::string formatLattice(const Analyzer& ana) {
+  jumanpp::jumandic::output::LatticeFormat fmt{3};
+  REQUIRE_OK(fmt.initialize(ana.output()));
+  REQUIRE_OK(fmt.format(ana, ""));
+  return fmt.result().str();
+}
+
+// analyzes inputs one after another as edits of the previous one,
+// returns the total number of reused boundaries
+i32 checkEdits(Analyzer* edited, Analyzer* full,
+               const std::vector<StringPiece>& inputs) {
+  i32 reused = 0;
+  REQUIRE_OK(edited->analyze(inputs[0]));
+  for (size_t i = 1; i < inputs.size(); ++i) {
+    CAPTURE(inputs[i]);
+    auto edit = InputEdit::between(inputs[i - 1], inputs[i]);
+    REQUIRE_OK(edited->analyzeEdited(inputs[i], edit));
+    REQUIRE_OK(full->analyze(inputs[i]));
+    CHECK(formatLattice(*edited) == formatLattice(*full));
+    auto stats = edited->incrementalStats();
+    CHECK(stats.totalBoundaries ==
+          full->impl()->input().codepoints().size());
+    reused += stats.reusedBoundaries;
+  }
+  return reused;
+}
+
+const std::vector<StringPiece> typedInputs{
+    "大阪",
+    "大阪の",
+    "大阪の田",
+    "大阪の田舎",
+    "大阪の田舎で",
+    "大阪の田舎で住",
+    "大阪の田舎で住む",
+    "大阪の田舎で住む人",
+    "大阪の都会で住む人",
+    "大阪の都会で住む人です",
+    "大阪の都会で住む",
+    "ＡＢＣは123個あります",
+    "ＡＢＣは1234個あります"};
+
+}  // namespace
+
+TEST_CASE("InputEdit contains only changed bytes") {
+  auto edit = InputEdit::between("abcdef", "abXYef");
+  CHECK(edit.start == 2);
+  CHECK(edit.removed == 2);
+  CHECK(edit.inserted == 2);
+  edit = InputEdit::between("abc", "abcd");
+  CHECK(edit.start == 3);
+  CHECK(edit.removed == 0);
+  CHECK(edit.inserted == 1);
+  edit = InputEdit::between("aaa", "aa");
+  CHECK(edit.start == 2);
+  CHECK(edit.removed == 1);
+  CHECK(edit.inserted == 0);
+}
+
+TEST_CASE("edited input analysis is the same as the full one",
+          "[incremental]") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 3);
+  auto edited = env.trainEnv.value().makeAnalyzer(5);
+  auto full = env.trainEnv.value().makeAnalyzer(5);
+  REQUIRE(edited);
+  REQUIRE(full);
+  CHECK(checkEdits(edited.get(), full.get(), typedInputs) > 0);
+}
+
+TEST_CASE("edited input analysis with global beam is the same as the full one",
+          "[incremental][gbeam]") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.globalBeam(3, 1, 3);
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 3);
+  auto edited = env.trainEnv.value().makeAnalyzer(5);
+  auto full = env.trainEnv.value().makeAnalyzer(5);
+  REQUIRE(edited);
+  REQUIRE(full);
+  CHECK(checkEdits(edited.get(), full.get(), typedInputs) > 0);
+}
+
+TEST_CASE("edited input analysis falls back to the full one",
+          "[incremental]") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 3);
+  auto ana = env.trainEnv.value().makeAnalyzer(5);
+  REQUIRE(ana);
+
+  StringPiece before = "大阪の田舎で住む人";
+  StringPiece after = "大阪の田舎で住む人です";
+  auto edit = InputEdit::between(before, after);
+
+  // the previous input was different
+  REQUIRE_OK(ana->analyze("東京の田舎で住む人"));
+  REQUIRE_OK(ana->analyzeEdited(after, edit));
+  CHECK_FALSE(ana->incrementalStats().reused());
+
+  REQUIRE_OK(ana->analyze(before));
+  REQUIRE_OK(ana->analyzeEdited(after, edit));
+  CHECK(ana->incrementalStats().reused());
+
+  // pruning can change the lattice left of the edit
+  ana->impl()->setPrepruneMargin(1e6f);
+  REQUIRE_OK(ana->analyze(before));
+  REQUIRE_OK(ana->analyzeEdited(after, edit));
+  CHECK_FALSE(ana->incrementalStats().reused());
+  ana->impl()->setPrepruneMargin(0);
+
+  // edit does not match the input
+  REQUIRE_OK(ana->analyze(before));
+  CHECK_FALSE(ana->analyzeEdited("大阪", edit));
+}
+
+TEST_CASE("edited input analysis keeps surfaces of reused unknown words",
+          "[incremental]") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 3);
+  auto edited = env.trainEnv.value().makeAnalyzer(5);
+  auto full = env.trainEnv.value().makeAnalyzer(5);
+  REQUIRE(edited);
+  REQUIRE(full);
+  std::vector<StringPiece> inputs{"ジュマンは大阪の", "ジュマンは大阪の田舎で",
+                                  "ジュマンは大阪の田舎で住む人です"};
+  // the unknown word takes the first four codepoints
+  CHECK(checkEdits(edited.get(), full.get(), inputs) >= 4);
+  CHECK(formatLattice(*edited).find("ジュマン") != std::string::npos);
+}
@@ -0,0 +1,87 @@
+#include "jumandic/shared/jumandic_test_env.h"
+
+namespace {
+
+std::vector<double> trainEpochs(JumandicTrainingTestEnv& env, i32 epochs) {
+  env.initialize();
+  auto& te = env.trainEnv.value();
+  REQUIRE_OK(te.loadInput("jumandic/train_mini_01.txt"));
+  std::vector<double> losses;
+  for (int i = 0; i < epochs; ++i) {
+    te.resetInput();
+    te.changeGlobalBeam(static_cast<float>(i) / epochs);
+    REQUIRE_OK(te.trainOneEpoch());
+    losses.push_back(te.epochLoss());
+  }
+  return losses;
+}
+
+}  // namespace
+
+TEST_CASE("training with cached lattices has the same losses", "[cache]") {
+  JumandicTrainingTestEnv plain{"jumandic/jumanpp_minimal.mdic"};
+  plain.trainArgs.batchSize = 1;
+  auto expected = trainEpochs(plain, 4);
+  CHECK(plain.trainEnv.value().cachedExamples() == 0);
+
+  JumandicTrainingTestEnv cached{"jumandic/jumanpp_minimal.mdic"};
+  cached.trainArgs.batchSize = 1;
+  cached.trainArgs.trainingConfig.cacheLattices = true;
+  auto losses = trainEpochs(cached, 4);
+  CHECK(cached.trainEnv.value().cachedExamples() == 7);
+  CHECK(losses == expected);
+}
+
+TEST_CASE("training with cached lattices and gbeam has the same losses",
+          "[cache][gbeam]") {
+  JumandicTrainingTestEnv plain{"jumandic/jumanpp_minimal.mdic"};
+  plain.trainArgs.batchSize = 1;
+  plain.globalBeam(3, 1, 3);
+  auto expected = trainEpochs(plain, 4);
+
+  JumandicTrainingTestEnv cached{"jumandic/jumanpp_minimal.mdic"};
+  cached.trainArgs.batchSize = 1;
+  cached.trainArgs.trainingConfig.cacheLattices = true;
+  cached.globalBeam(3, 1, 3);
+  auto losses = trainEpochs(cached, 4);
+  CHECK(losses == expected);
+}
+
+TEST_CASE("cached lattices are kept when gbeam changes between iterations",
+          "[cache][gbeam]") {
+  JumandicTrainingTestEnv plain{"jumandic/jumanpp_minimal.mdic"};
+  plain.trainArgs.batchSize = 1;
+  plain.trainArgs.batchMaxIterations = 2;
+  plain.trainArgs.batchLossEpsilon = 0;
+  plain.trainArgs.globalBeam.fullFirstIter = true;
+  plain.globalBeam(3, 1, 3);
+  auto expected = trainEpochs(plain, 3);
+
+  JumandicTrainingTestEnv cached{"jumandic/jumanpp_minimal.mdic"};
+  cached.trainArgs.batchSize = 1;
+  cached.trainArgs.batchMaxIterations = 2;
+  cached.trainArgs.batchLossEpsilon = 0;
+  cached.trainArgs.globalBeam.fullFirstIter = true;
+  cached.trainArgs.trainingConfig.cacheLattices = true;
+  cached.globalBeam(3, 1, 3);
+  auto losses = trainEpochs(cached, 3);
+  CHECK(cached.trainEnv.value().cachedExamples() == 7);
+  CHECK(losses == expected);
+}
+
+TEST_CASE("lattice cache falls back to shared trainers over the limit",
+          "[cache][gbeam]") {
+  JumandicTrainingTestEnv plain{"jumandic/jumanpp_minimal.mdic"};
+  plain.trainArgs.batchSize = 1;
+  plain.globalBeam(3, 1, 3);
+  auto expected = trainEpochs(plain, 3);
+
+  JumandicTrainingTestEnv cached{"jumandic/jumanpp_minimal.mdic"};
+  cached.trainArgs.batchSize = 1;
+  cached.trainArgs.trainingConfig.cacheLattices = true;
+  cached.trainArgs.trainingConfig.latticeCacheLimit = 1;
+  cached.globalBeam(3, 1, 3);
+  auto losses = trainEpochs(cached, 3);
+  CHECK(cached.trainEnv.value().cachedExamples() == 0);
+  CHECK(losses == expected);
+}
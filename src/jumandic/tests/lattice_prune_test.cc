@@ -0,0 +1,67 @@
+#include "core/analysis/analyzer_impl.h"
+#include "jumandic/shared/jumandic_test_env.h"
+#include "jumandic/shared/lattice_format.h"
+
+using namespace jumanpp::core::analysis;
+
+namespace {
+
+std::string formatLattice(const Analyzer& ana) {
+  jumanpp::jumandic::output::LatticeFormat fmt{3};
+  REQUIRE_OK(fmt.initialize(ana.output()));
+  REQUIRE_OK(fmt.format(ana, ""));
+  return fmt.result().str();
+}
+
+i32 latticeNodes(const Lattice* l) {
+  i32 result = 0;
+  for (u32 i = 2; i < l->createdBoundaryCount() - 1; ++i) {
+    result += l->boundary(i)->localNodeCount();
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST_CASE("lattice pruning with a large margin keeps the lattice", "[prune]") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.globalBeam(3, 1, 3);
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 3);
+  auto ana = env.trainEnv.value().makeAnalyzer(5);
+  REQUIRE(ana);
+
+  StringPiece input = "大阪の田舎で住む人";
+  REQUIRE_OK(ana->analyze(input));
+  auto expected = formatLattice(*ana);
+  auto numNodes = latticeNodes(ana->impl()->lattice());
+  CHECK(ana->pruneStats().nodesBefore == 0);
+
+  ana->impl()->setPrepruneMargin(1e6f);
+  REQUIRE_OK(ana->analyze(input));
+  auto& stats = ana->pruneStats();
+  CHECK(stats.nodesBefore == numNodes);
+  CHECK(stats.numPruned() == 0);
+  CHECK(formatLattice(*ana) == expected);
+}
+
+TEST_CASE("lattice pruning with a small margin removes nodes", "[prune]") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.globalBeam(3, 1, 3);
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 3);
+  auto ana = env.trainEnv.value().makeAnalyzer(5);
+  REQUIRE(ana);
+
+  StringPiece input = "大阪の田舎で住む人";
+  REQUIRE_OK(ana->analyze(input));
+  auto numNodes = latticeNodes(ana->impl()->lattice());
+
+  ana->impl()->setPrepruneMargin(1e-3f);
+  REQUIRE_OK(ana->analyze(input));
+  auto& stats = ana->pruneStats();
+  CHECK(stats.nodesBefore == numNodes);
+  CHECK(stats.numPruned() > 0);
+  auto lattice = ana->impl()->lattice();
+  CHECK(latticeNodes(lattice) == stats.nodesAfter);
+  auto eos = lattice->boundary(lattice->createdBoundaryCount() - 1);
+  CHECK_FALSE(EntryBeam::isFake(eos->starts()->beamData().at(0)));
+}
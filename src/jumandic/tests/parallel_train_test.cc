@@ -0,0 +1,116 @@
+#include <thread>
+#include "core/training/scw_averager.h"
+#include "jumandic/shared/jumandic_test_env.h"
+
+#if !defined(_WIN32_WINNT)
+#include <unistd.h>
+#endif
+
+using namespace jumanpp::core::training;
+
+namespace {
+
+struct ParallelRun {
+  std::vector<std::vector<float>> weights;
+  std::vector<std::vector<double>> losses;
+};
+
+// workers share the segment in the same way as forked processes do
+ParallelRun trainInParallel(u32 numWorkers, u32 mergeInterval, i32 epochs) {
+  std::vector<std::unique_ptr<JumandicTrainingTestEnv>> envs;
+  ScwSharedSegment segment;
+  std::vector<std::unique_ptr<ScwAverager>> averagers;
+  for (u32 i = 0; i < numWorkers; ++i) {
+    envs.emplace_back(
+        new JumandicTrainingTestEnv{"jumandic/jumanpp_minimal.mdic"});
+    auto& env = *envs.back();
+    env.trainArgs.batchSize = 2;
+    env.trainArgs.mergeInterval = mergeInterval;
+    env.initialize();
+    if (i == 0) {
+      REQUIRE_OK(segment.initialize(
+          numWorkers, env.trainArgs.trainingConfig.numFeatures()));
+    }
+    averagers.emplace_back(new ScwAverager{&segment, i});
+    env.trainEnv.value().setAverager(averagers.back().get());
+    REQUIRE_OK(env.trainEnv.value().loadInput("jumandic/train_mini_01.txt"));
+  }
+
+  ParallelRun result;
+  result.losses.resize(numWorkers);
+  std::vector<Status> statuses;
+  for (u32 i = 0; i < numWorkers; ++i) {
+    statuses.emplace_back(Status::Ok());
+  }
+  std::vector<std::thread> threads;
+  for (u32 i = 0; i < numWorkers; ++i) {
+    threads.emplace_back([&, i]() {
+      auto& te = envs[i]->trainEnv.value();
+      for (i32 epoch = 0; epoch < epochs; ++epoch) {
+        te.resetInput();
+        statuses[i] = te.trainOneEpoch();
+        if (!statuses[i]) {
+          return;
+        }
+        result.losses[i].push_back(te.epochLoss());
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  for (u32 i = 0; i < numWorkers; ++i) {
+    REQUIRE_OK(statuses[i]);
+    auto w = envs[i]->trainEnv.value().scw().weights();
+    result.weights.emplace_back(w.data(), w.data() + w.size());
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST_CASE("data-parallel workers end up with the same weights",
+          "[parallel]") {
+  auto run = trainInParallel(3, 0, 3);
+  REQUIRE(run.weights.size() == 3);
+  CHECK(run.weights[0] == run.weights[1]);
+  CHECK(run.weights[0] == run.weights[2]);
+  CHECK(run.losses[0] == run.losses[1]);
+  CHECK(run.losses[0] == run.losses[2]);
+  CHECK(run.losses[0][0] > 0);
+}
+
+TEST_CASE("workers stay in sync when merging every batch", "[parallel]") {
+  auto run = trainInParallel(2, 1, 2);
+  REQUIRE(run.weights.size() == 2);
+  CHECK(run.weights[0] == run.weights[1]);
+  CHECK(run.losses[0] == run.losses[1]);
+  CHECK(run.losses[0].size() == 2);
+}
+
+#if !defined(_WIN32_WINNT)
+TEST_CASE("merge fails when a forked worker has exited", "[parallel]") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.trainArgs.batchSize = 2;
+  env.trainArgs.mergeInterval = 1;
+  env.initialize();
+  ScwSharedSegment segment;
+  REQUIRE_OK(
+      segment.initialize(2, env.trainArgs.trainingConfig.numFeatures()));
+  u32 worker = 0;
+  std::vector<i64> children;
+  REQUIRE_OK(spawnTrainingWorkers(2, &worker, &children));
+  if (worker != 0) {
+    // the worker crashes before its first merge
+    _exit(1);
+  }
+  ScwAverager averager{&segment, 0};
+  averager.watchChildren(children);
+  auto& te = env.trainEnv.value();
+  te.setAverager(&averager);
+  REQUIRE_OK(te.loadInput("jumandic/train_mini_01.txt"));
+  CHECK_FALSE(te.trainOneEpoch());
+  CHECK_FALSE(waitTrainingWorkers(children));
+}
+#endif
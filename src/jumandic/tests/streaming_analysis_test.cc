@@ -0,0 +1,215 @@
+#include "core/analysis/streaming_analyzer.h"
+#include "core/analysis/analysis_result.h"
+#include "core/analysis/analyzer_impl.h"
+#include "jumandic/shared/jumandic_test_env.h"
+
+using namespace jumanpp::core::analysis;
+
+namespace {
+
+struct StreamResult {
+  std::vector<std::string> surfaces;
+  // tokens which were emitted before the end of the stream
+  size_t early = 0;
+};
+
+void consume(StreamingAnalyzer* stream, StreamResult* result) {
+  while (true) {
+    REQUIRE_OK(stream->next());
+    auto tokens = stream->tokens();
+    if (tokens.size() == 0) {
+      return;
+    }
+    for (auto& tok : tokens) {
+      i64 offset = 0;
+      for (auto& s : result->surfaces) {
+        offset += jumanpp::chars::numCodepoints(s);
+      }
+      CHECK(tok.offset == offset);
+      result->surfaces.push_back(tok.surface.str());
+    }
+  }
+}
+
+// pushes input by parts of chunk bytes, a part can end inside a codepoint
+StreamResult analyzeStream(StreamingAnalyzer* stream, StringPiece input,
+                           size_t chunk) {
+  StreamResult result;
+  for (size_t pos = 0; pos < input.size(); pos += chunk) {
+    stream->push(input.slice(pos, pos + chunk));
+    consume(stream, &result);
+  }
+  result.early = result.surfaces.size();
+  stream->finish();
+  consume(stream, &result);
+  return result;
+}
+
+std::string join(const std::vector<std::string>& parts) {
+  std::string result;
+  for (auto& p : parts) {
+    result += p;
+  }
+  return result;
+}
+
+std::string repeat(StringPiece s, int times) {
+  std::string result;
+  for (int i = 0; i < times; ++i) {
+    result.append(s.begin(), s.end());
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST_CASE("streaming analyzer emits tokens before the end of input",
+          "[streaming]") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 3);
+  auto ana = env.trainEnv.value().makeAnalyzer(5);
+  REQUIRE(ana);
+  StreamingAnalyzer stream;
+  StreamingConfig conf;
+  conf.rightContext = 6;
+  conf.maxBuffered = 40;
+  REQUIRE_OK(stream.initialize(ana.get(), conf));
+
+  auto input = repeat("大阪の田舎で住む人は知るには必要だ", 20);
+  auto result = analyzeStream(&stream, input, 4);
+  CHECK(join(result.surfaces) == input);
+  CHECK(result.early > 0);
+  CHECK(result.early < result.surfaces.size());
+  auto& stats = stream.stats();
+  CHECK(stats.confluences > 0);
+  CHECK(stats.maxBufferedCodepoints <= conf.maxBuffered);
+  CHECK(stats.emittedTokens == result.surfaces.size());
+  CHECK(stats.emittedCodepoints == jumanpp::chars::numCodepoints(input));
+  CHECK(stream.bufferedCodepoints() == 0);
+}
+
+TEST_CASE("streaming analyzer with global beam keeps the buffer bounded",
+          "[streaming][gbeam]") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.globalBeam(3, 1, 3);
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 3);
+  auto ana = env.trainEnv.value().makeAnalyzer(5);
+  REQUIRE(ana);
+  StreamingAnalyzer stream;
+  StreamingConfig conf;
+  conf.rightContext = 4;
+  conf.maxBuffered = 10;
+  REQUIRE_OK(stream.initialize(ana.get(), conf));
+
+  // a single long pushed part is split by the buffer size
+  auto input = repeat("アイウエオカキクケコ", 30);
+  auto result = analyzeStream(&stream, input, input.size());
+  CHECK(join(result.surfaces) == input);
+  CHECK(result.early > 0);
+  CHECK(stream.stats().maxBufferedCodepoints <= conf.maxBuffered);
+  CHECK(stream.stats().forcedCuts + stream.stats().confluences > 0);
+}
+
+TEST_CASE("streaming analyzer emits the best path of a short input",
+          "[streaming]") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 3);
+  auto ana = env.trainEnv.value().makeAnalyzer(5);
+  auto full = env.trainEnv.value().makeAnalyzer(5);
+  REQUIRE(ana);
+  REQUIRE(full);
+  StreamingAnalyzer stream;
+  REQUIRE_OK(stream.initialize(ana.get(), StreamingConfig{}));
+
+  StringPiece input = "大阪の田舎で住む人";
+  auto result = analyzeStream(&stream, input, 3);
+  CHECK(result.early == 0);
+
+  REQUIRE_OK(full->analyze(input));
+  AnalysisResult ares;
+  REQUIRE_OK(ares.reset(*full));
+  AnalysisPath path;
+  REQUIRE_OK(ares.fillTop1(&path));
+  std::vector<std::string> expected;
+  auto& fullInput = full->impl()->input();
+  while (path.nextBoundary()) {
+    ConnectionPtr ptr;
+    REQUIRE(path.nextNode(&ptr));
+    auto& info = full->impl()
+                     ->lattice()
+                     ->boundary(ptr.boundary)
+                     ->starts()
+                     ->nodeInfo()
+                     .at(ptr.right);
+    expected.push_back(fullInput.surface(info.start(), info.end()).str());
+  }
+  CHECK(result.surfaces == expected);
+
+  // the stream can be restarted
+  stream.reset();
+  result = analyzeStream(&stream, input, input.size());
+  CHECK(result.surfaces == expected);
+}
+
+TEST_CASE("streaming analyzer does not cut open unknown words",
+          "[streaming]") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 3);
+  auto ana = env.trainEnv.value().makeAnalyzer(5);
+  REQUIRE(ana);
+  StreamingAnalyzer stream;
+  StreamingConfig conf;
+  conf.rightContext = 3;
+  conf.maxBuffered = 100;
+  REQUIRE_OK(stream.initialize(ana.get(), conf));
+
+  // the unknown word is longer than the right context
+  auto input = repeat("大阪の田舎で" + repeat("ジュマン", 3) + "は住む人だ", 3);
+  auto whole = analyzeStream(&stream, input, input.size());
+  stream.reset();
+  // one codepoint at a time
+  auto parts = analyzeStream(&stream, input, 3);
+  CHECK(parts.early > 0);
+  CHECK(parts.surfaces == whole.surfaces);
+}
+
+TEST_CASE("streaming analyzer does not emit open unknown words",
+          "[streaming]") {
+  JumandicTrainingTestEnv env{"jumandic/jumanpp_minimal.mdic"};
+  env.trainNepochsFrom("jumandic/train_mini_01.txt", 3);
+  auto ana = env.trainEnv.value().makeAnalyzer(5);
+  REQUIRE(ana);
+  StreamingAnalyzer stream;
+  StreamingConfig conf;
+  conf.rightContext = 2;
+  conf.maxBuffered = 100;
+  REQUIRE_OK(stream.initialize(ana.get(), conf));
+
+  // the katakana run is longer than the right context
+  StringPiece prefix = "大阪の田舎で住む人は";
+  auto input = prefix.str() + repeat("ジュマン", 5);
+  StreamResult result;
+  // one codepoint at a time
+  for (size_t pos = 0; pos < input.size(); pos += 3) {
+    stream.push(StringPiece{input}.slice(pos, pos + 3));
+    consume(&stream, &result);
+  }
+  CHECK(result.surfaces.size() > 0);
+  CHECK(prefix.str().find(join(result.surfaces)) == 0);
+
+  stream.push("です");
+  consume(&stream, &result);
+  stream.finish();
+  consume(&stream, &result);
+  CHECK(join(result.surfaces) == input + "です");
+}
+
+TEST_CASE("streaming analyzer checks the config", "[streaming]") {
+  StreamingAnalyzer stream;
+  StreamingConfig conf;
+  conf.rightContext = 10;
+  conf.maxBuffered = 10;
+  CHECK_FALSE(stream.initialize(nullptr, conf));
+  conf.rightContext = -1;
+  CHECK_FALSE(stream.initialize(nullptr, conf));
+}
@@ -74,6 +74,15 @@ class RnnArgs {
       "Separator for field values in RNN dictionary (default _)",
       {"rnn-separator"}};
 
+  args::ValueFlag<float> ambiguityMargin{
+      rnnGrp,
+      "VALUE",
+      "Rescore only paths within this perceptron score margin of the best "
+      "one, 0 (default) rescores all global beam paths. Other paths are "
+      "kept for N-best output after the rescored ones, ranked by their "
+      "perceptron scores",
+      {"rnn-ambiguity-margin"}};
+
  public:
   explicit RnnArgs(args::Group& parent) { parent.Add(rnnGrp); }
 
@@ -87,6 +96,7 @@ class RnnArgs {
     copy.unkSymbol.set(rnnUnk);
     copy.eosSymbol.set(rnnEos);
     copy.fieldSeparator.set(rnnFieldSeparator);
+    copy.ambiguityMargin.set(ambiguityMargin);
     if (rnnFields) {
       std::vector<std::string> values;
       auto& data = rnnFields.Get();
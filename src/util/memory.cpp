@@ -46,6 +46,7 @@ static int posix_memalign(void **dst, size_t alignment, size_t size) {
 #if JUMANPP_USE_DEFAULT_ALLOCATION
 void *PoolAlloc::allocate_memory(size_t size, size_t alignment) {
   assert(IsPowerOf2(alignment) && "alignment should be a power of 2");
+  allocated_ += size;
   return mgr_->allocate(size, std::max<size_t>(alignment, 8));
 }
 
@@ -84,6 +85,7 @@ void* PoolAlloc::allocate_memory(size_t size, size_t alignment) {
     return allocate_memory(size, alignment);
   }
   offset_ = objEnd;
+  allocated_ += size;
   // LOG_DEBUG() << "allocated " << requiredSize << " bytes";
   return base_ + address;
 }
@@ -166,6 +168,7 @@ void PoolAlloc::reset() {
   base_ = nullptr;
   offset_ = 0;
   end_ = 0;
+  allocated_ = 0;
 }
 
 void *MallocEalloc::Allocate(size_t size, size_t align) {
@@ -65,6 +65,7 @@ class PoolAlloc final : public ErasedAllocator {
   char *base_ = nullptr;
   size_t offset_ = 0;
   size_t end_ = 0;
+  u64 allocated_ = 0;
   bool switchToNewPage(size_t size);
 
  public:
@@ -119,6 +120,11 @@ class PoolAlloc final : public ErasedAllocator {
 
   u64 remaining() const { return end_ - offset_; }
 
+  /**
+   * Number of bytes allocated since the last reset, excluding alignment
+   */
+  u64 allocatedBytes() const { return allocated_; }
+
   void reset();
 
   void *Allocate(size_t size, size_t align) override {
@@ -97,6 +97,21 @@ TEST_CASE("memory is aligned") {
   CHECK(m::IsAligned(reinterpret_cast<size_t>(ptr2), 128));
 }
 
+TEST_CASE("allocator counts allocated bytes until reset") {
+  m::Manager mgr{1024};
+  auto c = mgr.core();
+  CHECK(c->allocatedBytes() == 0);
+  c->allocateArray<int>(200);
+  c->allocateArray<int>(200);
+  CHECK(c->allocatedBytes() == 1600);
+  CHECK(mgr.used() >= 1600);
+  mgr.reset();
+  c->reset();
+  CHECK(c->allocatedBytes() == 0);
+  c->allocate_memory(12, 4);
+  CHECK(c->allocatedBytes() == 12);
+}
+
 TEST_CASE("StlManagedAlloc adheres to stl spec") {
   m::Manager mgr_{1024 * 1024};
   auto core1 = mgr_.core();
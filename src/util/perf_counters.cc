@@ -0,0 +1,171 @@
+#include "perf_counters.h"
+#include <cerrno>
+#include <cstring>
+#include "util/logging.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace jumanpp {
+namespace util {
+namespace perf {
+
+StringPiece counterName(Counter counter) {
+  switch (counter) {
+    case Counter::Cycles:
+      return "cycles";
+    case Counter::Instructions:
+      return "instructions";
+    case Counter::LlcMisses:
+      return "llc-misses";
+    case Counter::BranchMisses:
+      return "branch-misses";
+    case Counter::DtlbMisses:
+      return "dtlb-misses";
+  }
+  return "unknown";
+}
+
+PerfCounters::PerfCounters() {
+  for (int i = 0; i < NumCounters; ++i) {
+    fds_[i] = -1;
+    groupIdx_[i] = -1;
+  }
+}
+
+PerfCounters::~PerfCounters() { close(); }
+
+#ifdef __linux__
+
+namespace {
+
+struct EventDef {
+  u32 type;
+  u64 config;
+};
+
+constexpr u64 cacheReadMisses(u64 cache) {
+  return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+EventDef eventOf(Counter c) {
+  switch (c) {
+    case Counter::Cycles:
+      return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES};
+    case Counter::Instructions:
+      return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS};
+    case Counter::LlcMisses:
+      return {PERF_TYPE_HW_CACHE, cacheReadMisses(PERF_COUNT_HW_CACHE_LL)};
+    case Counter::BranchMisses:
+      return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES};
+    case Counter::DtlbMisses:
+      return {PERF_TYPE_HW_CACHE, cacheReadMisses(PERF_COUNT_HW_CACHE_DTLB)};
+  }
+  return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES};
+}
+
+int openEvent(const EventDef& def, int groupFd) {
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = def.type;
+  attr.config = def.config;
+  // the group is enabled at once by its leader
+  attr.disabled = groupFd == -1 ? 1 : 0;
+  // user space only counters are allowed with perf_event_paranoid <= 2
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+  return static_cast<int>(
+      syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+
+}  // namespace
+
+Status PerfCounters::open() {
+  close();
+  int lastError = 0;
+  for (int i = 0; i < NumCounters; ++i) {
+    auto counter = static_cast<Counter>(i);
+    int fd = openEvent(eventOf(counter), leader_);
+    if (fd < 0) {
+      lastError = errno;
+      LOG_DEBUG() << "performance counter " << counterName(counter)
+                  << " is not available: " << std::strerror(lastError);
+      continue;
+    }
+    if (leader_ == -1) {
+      leader_ = fd;
+    }
+    fds_[i] = fd;
+    groupIdx_[i] = numOpened_;
+    numOpened_ += 1;
+  }
+
+  if (leader_ == -1) {
+    return JPPS_NOT_IMPLEMENTED
+           << "failed to open hardware performance counters: "
+           << std::strerror(lastError)
+           << " (check /proc/sys/kernel/perf_event_paranoid)";
+  }
+
+  ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return Status::Ok();
+}
+
+void PerfCounters::close() {
+  for (int i = 0; i < NumCounters; ++i) {
+    if (fds_[i] != -1) {
+      ::close(fds_[i]);
+    }
+    fds_[i] = -1;
+    groupIdx_[i] = -1;
+  }
+  leader_ = -1;
+  numOpened_ = 0;
+}
+
+void PerfCounters::read(CounterValues* result) const {
+  *result = CounterValues{};
+  if (leader_ == -1) {
+    return;
+  }
+  // PERF_FORMAT_GROUP layout: number of counters, then their values
+  u64 buffer[NumCounters + 1];
+  auto size = ::read(leader_, buffer, sizeof(buffer));
+  if (size < static_cast<ssize_t>(sizeof(u64))) {
+    return;
+  }
+  auto numValues = static_cast<i32>(buffer[0]);
+  for (int i = 0; i < NumCounters; ++i) {
+    auto idx = groupIdx_[i];
+    if (idx >= 0 && idx < numValues) {
+      result->values[i] = buffer[idx + 1];
+    }
+  }
+}
+
+#else
+
+Status PerfCounters::open() {
+  return JPPS_NOT_IMPLEMENTED
+         << "hardware performance counters are supported only on Linux";
+}
+
+void PerfCounters::close() {}
+
+void PerfCounters::read(CounterValues* result) const {
+  *result = CounterValues{};
+}
+
+#endif  // __linux__
+
+}  // namespace perf
+}  // namespace util
+}  // namespace jumanpp
@@ -0,0 +1,89 @@
+#ifndef JUMANPP_PERF_COUNTERS_H
+#define JUMANPP_PERF_COUNTERS_H
+
+#include "util/status.hpp"
+#include "util/string_piece.h"
+#include "util/types.hpp"
+
+namespace jumanpp {
+namespace util {
+namespace perf {
+
+enum class Counter {
+  Cycles,
+  Instructions,
+  LlcMisses,
+  BranchMisses,
+  DtlbMisses,
+};
+
+constexpr int NumCounters = 5;
+
+StringPiece counterName(Counter counter);
+
+struct CounterValues {
+  u64 values[NumCounters] = {};
+
+  u64 operator[](Counter c) const { return values[static_cast<int>(c)]; }
+  u64& operator[](Counter c) { return values[static_cast<int>(c)]; }
+
+  CounterValues& operator+=(const CounterValues& o) {
+    for (int i = 0; i < NumCounters; ++i) {
+      values[i] += o.values[i];
+    }
+    return *this;
+  }
+};
+
+inline CounterValues operator-(const CounterValues& a, const CounterValues& b) {
+  CounterValues result;
+  for (int i = 0; i < NumCounters; ++i) {
+    result.values[i] = a.values[i] - b.values[i];
+  }
+  return result;
+}
+
+/**
+ * Hardware performance counters of the current thread
+ * (user space only) using perf_event_open.
+ *
+ * Counters which can not be opened (no hardware support, virtual machines,
+ * restrictive kernel.perf_event_paranoid, non-Linux platforms)
+ * are not available and always read as zero.
+ */
+class PerfCounters {
+  int fds_[NumCounters];
+  // position of the counter in the group read, -1 if not available
+  i32 groupIdx_[NumCounters];
+  int leader_ = -1;
+  i32 numOpened_ = 0;
+
+ public:
+  PerfCounters();
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+  ~PerfCounters();
+
+  /**
+   * Opens and starts all counters which are supported.
+   * Returns an error only if no counter could be opened.
+   */
+  Status open();
+  void close();
+
+  bool available(Counter c) const {
+    return groupIdx_[static_cast<int>(c)] >= 0;
+  }
+  bool anyAvailable() const { return numOpened_ > 0; }
+
+  /**
+   * Reads current values of all counters with a single syscall
+   */
+  void read(CounterValues* result) const;
+};
+
+}  // namespace perf
+}  // namespace util
+}  // namespace jumanpp
+
+#endif  // JUMANPP_PERF_COUNTERS_H
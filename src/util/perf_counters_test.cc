@@ -0,0 +1,50 @@
+#include "perf_counters.h"
+#include "testing/standalone_test.h"
+
+using namespace jumanpp::util::perf;
+
+TEST_CASE("counters have names") {
+  CHECK(counterName(Counter::Cycles) == "cycles");
+  CHECK(counterName(Counter::DtlbMisses) == "dtlb-misses");
+}
+
+TEST_CASE("counter values can be subtracted and added") {
+  CounterValues a;
+  CounterValues b;
+  a[Counter::Cycles] = 10;
+  a[Counter::Instructions] = 7;
+  b[Counter::Cycles] = 4;
+  auto diff = a - b;
+  CHECK(diff[Counter::Cycles] == 6);
+  CHECK(diff[Counter::Instructions] == 7);
+  diff += b;
+  CHECK(diff[Counter::Cycles] == 10);
+}
+
+TEST_CASE("perf counters work or degrade gracefully") {
+  PerfCounters counters;
+  CounterValues v1;
+  CounterValues v2;
+  if (!counters.open()) {
+    CHECK_FALSE(counters.anyAvailable());
+    counters.read(&v1);
+    for (auto v : v1.values) {
+      CHECK(v == 0);
+    }
+    return;
+  }
+
+  CHECK(counters.anyAvailable());
+  counters.read(&v1);
+  volatile int sum = 0;
+  for (int i = 0; i < 100000; ++i) {
+    sum += i;
+  }
+  counters.read(&v2);
+  for (int i = 0; i < NumCounters; ++i) {
+    CHECK(v2.values[i] >= v1.values[i]);
+  }
+  if (counters.available(Counter::Instructions)) {
+    CHECK(v2[Counter::Instructions] > v1[Counter::Instructions]);
+  }
+}